@@ -21,6 +21,7 @@
 
 #include "lpc_types.h"
 #include "nand_support_common.h"
+#include "lpc_bbt.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -43,6 +44,23 @@ UNS_32 nand_lb_mlc_read_sector(UNS_32 sector, UNS_8 *readbuff);
 /* Write a NAND sector, returns 0 on failure, or 512 on pass */
 UNS_32 nand_lb_mlc_write_sector(UNS_32 sector, UNS_8 *writebuff);
 
+/* Check is a passed block number is bad */
+INT_32 nand_lb_mlc_is_block_bad(UNS_32 block);
+
+/* Use a bad block table for the bad block checks, or NULL to read
+   the bad block markers */
+void nand_lb_mlc_set_bbt(LPC_BBT_T *bbt);
+
+/* Read a NAND sector with DMA and the Reed-Solomon ECC, returns -1 on
+   failure or >0 on pass */
+INT_32 nand_lb_mlc_read_sector_dma(UNS_32 sector, UNS_8 *readbuff,
+                                   UNS_8 *spare);
+
+/* Write a NAND sector with DMA and the Reed-Solomon ECC, returns -1 on
+   failure or >0 on pass */
+INT_32 nand_lb_mlc_write_sector_dma(UNS_32 sector, UNS_8 *writebuff,
+                                    UNS_8 *spare);
+
 #ifdef __cplusplus
 }
 #endif
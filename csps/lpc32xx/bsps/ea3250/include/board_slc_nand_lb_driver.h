@@ -21,6 +21,7 @@
 
 #include "lpc_types.h"
 #include "nand_support_common.h"
+#include "lpc_bbt.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -43,6 +44,10 @@ void nand_lb_slc_mark_bad_block(UNS_32 block);
 /* Check is a passed block number is bad */
 INT_32 nand_lb_slc_is_block_bad(UNS_32 block);
 
+/* Use a bad block table for the bad block checks, or NULL to read
+   the bad block markers */
+void nand_lb_slc_set_bbt(LPC_BBT_T *bbt);
+
 /* Read a NAND sector using hardware ECC, returns -1 on failure or
    >0 on pass */
 INT_32 nand_lb_slc_read_sector(UNS_32 sector, UNS_8 *readbuff,
@@ -53,6 +58,21 @@ INT_32 nand_lb_slc_read_sector(UNS_32 sector, UNS_8 *readbuff,
 INT_32 nand_lb_slc_write_sector(UNS_32 sector, UNS_8 *writebuff,
                                 UNS_8 *spare);
 
+/* Read a NAND sector and spare area without ECC correction, returns
+   -1 on failure or >0 on pass */
+INT_32 nand_lb_slc_read_sector_raw(UNS_32 sector, UNS_8 *readbuff,
+                                   UNS_8 *spare);
+
+/* Read a run of NAND sectors using hardware ECC and the read cache
+   where supported, returns -1 on failure or >0 on pass */
+INT_32 nand_lb_slc_read_sectors(UNS_32 sector, INT_32 count,
+                                UNS_8 *readbuff);
+
+/* Write a NAND sector and spare area without hardware ECC, returns -1
+   on failure or >0 on pass */
+INT_32 nand_lb_slc_write_sector_raw(UNS_32 sector, UNS_8 *writebuff,
+                                    UNS_8 *spare);
+
 #ifdef __cplusplus
 }
 #endif
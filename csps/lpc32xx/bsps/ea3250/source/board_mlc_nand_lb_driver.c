@@ -19,8 +19,141 @@
 #include "board_mlc_nand_lb_driver.h"
 #include "nand_mlc_common.h"
 #include "lpc32xx_clkpwr_driver.h"
+#include "lpc32xx_dma_driver.h"
 #include "lpc32xx_mlcnand.h"
 #include "board_config.h"
+#include <string.h>
+
+/* Data and spare bytes of each 528 byte sub-page, 4 per page */
+#define MLC_SUBPAGE_DATA       512
+#define MLC_SUBPAGE_SPARE      16
+#define MLC_SUBPAGES           4
+
+/* Status polls before a DMA transfer of a sub-page is abandoned */
+#define MLC_DMA_TIMEOUT        0x100000
+
+/* Bad block table used for the bad block checks, or NULL */
+static LPC_BBT_T *mlcbbt = NULL;
+
+/***********************************************************************
+ *
+ * Function: mlc_start_dma
+ *
+ * Purpose: Start a memory to memory transfer using DMA channel 0
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     src  : Source address
+ *     dest : Destination address
+ *     ctrl : DMA control word, with the transfer size
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void mlc_start_dma(UNS_32 src, UNS_32 dest, UNS_32 ctrl)
+{
+	DMAC_REGS_T *pdmaregs = (DMAC_REGS_T *) DMA_BASE;
+
+	/* We use DMA Channel 0 */
+	pdmaregs->int_tc_clear = _BIT(0);
+	pdmaregs->int_err_clear = _BIT(0);
+	pdmaregs->config = DMAC_CTRL_ENABLE;
+	pdmaregs->dma_chan[0].src_addr = src;
+	pdmaregs->dma_chan[0].dest_addr = dest;
+	pdmaregs->dma_chan[0].lli = 0;
+	pdmaregs->dma_chan[0].control = ctrl;
+	pdmaregs->dma_chan[0].config_ch = (DMAC_CHAN_FLOW_D_M2M |
+		DMAC_CHAN_ENABLE);
+}
+
+/***********************************************************************
+ *
+ * Function: mlc_wait_dma
+ *
+ * Purpose: Wait for the DMA transfer on channel 0 to complete
+ *
+ * Processing:
+ *     Poll the channel 0 terminal count and error statuses. If neither
+ *     is set after MLC_DMA_TIMEOUT polls, disable the channel.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: 0 if the transfer completed, 1 on a DMA error or timeout
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 mlc_wait_dma(void)
+{
+	DMAC_REGS_T *pdmaregs = (DMAC_REGS_T *) DMA_BASE;
+	UNS_32 polls = 0;
+
+	while (!(pdmaregs->raw_tc_stat & 0x1) &&
+		!(pdmaregs->raw_err_stat & 0x1))
+	{
+		polls++;
+		if (polls >= MLC_DMA_TIMEOUT)
+		{
+			/* The transfer never finished, stop the channel */
+			pdmaregs->dma_chan[0].config_ch = 0;
+			return 1;
+		}
+	}
+
+	return (pdmaregs->raw_tc_stat & 0x1) == 0;
+}
+
+/***********************************************************************
+ *
+ * Function: mlc_subpage_erased
+ *
+ * Purpose: Check if a sub-page that failed decode is erased
+ *
+ * Processing:
+ *     An erased sub-page has no valid Reed-Solomon parity, so it
+ *     always fails the decode. Return TRUE if all the data and spare
+ *     bytes read are 0xFF.
+ *
+ * Parameters:
+ *     data  : Sub-page data
+ *     spare : Sub-page spare bytes
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the sub-page is erased, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 mlc_subpage_erased(UNS_8 *data, UNS_32 *spare)
+{
+	UNS_32 idx;
+
+	for (idx = 0; idx < MLC_SUBPAGE_DATA; idx++)
+	{
+		if (data[idx] != 0xFF)
+		{
+			return FALSE;
+		}
+	}
+	for (idx = 0; idx < (MLC_SUBPAGE_SPARE / 4); idx++)
+	{
+		if (spare[idx] != 0xFFFFFFFF)
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
 
 /***********************************************************************
  *
@@ -50,7 +183,7 @@ static void mlc_lb_write_address(UNS_32 block, UNS_32 page)
 	mlc_addr((UNS_8) (((page >> 0) & 0x003F)) |
 	    ((block << 6) & 0x00C0));
 	mlc_addr((UNS_8) ((block >> 2) & 0x00FF));
-	mlc_addr((UNS_8) ((block >> 10) & 0x0001));
+	mlc_addr((UNS_8) ((block >> 10) & 0x0003));
 }
 
 /***********************************************************************
@@ -84,6 +217,9 @@ INT_32 nand_lb_mlc_init(void)
 	clkpwr_setup_nand_ctrlr(0, 0, 0);
 	clkpwr_clk_en_dis(CLKPWR_NAND_MLC_CLK, 1);
 
+	/* Enable DMA clock for the DMA sector functions */
+	clkpwr_clk_en_dis(CLKPWR_DMA_CLK, 1);
+
     /* Configure controller for no software write protection, x8 bus
        width, large block device, and 4 address words */
     MLCNAND->mlc_lock_pr = MLC_UNLOCK_REG_VALUE;
@@ -188,7 +324,7 @@ INT_32 nand_lb_mlc_erase_block(UNS_32 block)
     /* Write block and page address */
 	mlc_addr((UNS_8) ((block << 6) & 0x00C0));
 	mlc_addr((UNS_8) ((block >> 2) & 0x00FF));
-	mlc_addr((UNS_8) ((block >> 10) & 0x0001));
+	mlc_addr((UNS_8) ((block >> 10) & 0x0003));
 
     /* Issue page erase2 command */
     mlc_cmd(LPCNAND_CMD_ERASE2);
@@ -386,3 +522,292 @@ UNS_32 nand_lb_mlc_read_sector(UNS_32 sector, UNS_8 *readbuff)
 
     return bytes;
 }
+
+/***********************************************************************
+ *
+ * Function: nand_lb_mlc_is_block_bad
+ *
+ * Purpose: Check is a passed block number is bad
+ *
+ * Processing:
+ *     With a bad block table, test the bit of the block. Otherwise
+ *     read the factory bad block marker of the first page of the block
+ *     without ECC.
+ *
+ * Parameters:
+ *     block : Block to check
+ *
+ * Outputs: None
+ *
+ * Returns: 0 if Block is good
+ *			1 if Block is bad
+ *
+ * Notes:
+ *     The marker is inside the last sub-page of a page written with
+ *     the MLC layout, so the markers can only be read on blocks that
+ *     have not been written through the MLC.
+ *
+ **********************************************************************/
+INT_32 nand_lb_mlc_is_block_bad(UNS_32 block)
+{
+	INT_32 badblock = 0;
+	UNS_32 tmp;
+
+	/* The bad block table makes this a bit test */
+	if (mlcbbt != NULL)
+	{
+		return lpc_bbt_is_bad(mlcbbt, block);
+	}
+
+    /* Issue page read1 command */
+    mlc_cmd(LPCNAND_CMD_PAGE_READ1);
+
+    /* Write column address of the marker, then block and page */
+	mlc_addr((UNS_8) ((NAND_LB_BADBLOCK_OFFS >> 0) & 0x00FF));
+	mlc_addr((UNS_8) ((NAND_LB_BADBLOCK_OFFS >> 8) & 0x00FF));
+	mlc_addr((UNS_8) ((block << 6) & 0x00C0));
+	mlc_addr((UNS_8) ((block >> 2) & 0x00FF));
+	mlc_addr((UNS_8) ((block >> 10) & 0x0003));
+
+    /* Issue page read2 command */
+    mlc_cmd(LPCNAND_CMD_PAGE_READ2);
+
+	/* Wait for ready */
+	mlc_wait_ready();
+
+	tmp = MLCNAND->mlc_data [0];
+	if ((tmp & 0xFF) != NAND_GOOD_BLOCK_MARKER)
+	{
+		badblock = 1;
+	}
+
+	return badblock;
+}
+
+/***********************************************************************
+ *
+ * Function: nand_lb_mlc_set_bbt
+ *
+ * Purpose: Set the bad block table used for the bad block checks
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     bbt : Bad block table, or NULL to read the bad block markers
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void nand_lb_mlc_set_bbt(LPC_BBT_T *bbt)
+{
+	mlcbbt = bbt;
+}
+
+/***********************************************************************
+ *
+ * Function: nand_lb_mlc_read_sector_dma
+ *
+ * Purpose: Read a NAND sector with DMA and the Reed-Solomon ECC
+ *
+ * Processing:
+ *     For each of the 4 sub-pages of 528 bytes, let the controller
+ *     read and correct the sub-page into its buffer with auto-decode,
+ *     check the decode status, and DMA the 512 data bytes out of the
+ *     buffer. The 16 spare bytes are read by the CPU.
+ *
+ * Parameters:
+ *     sector   : Sector to read
+ *     readbuff : Pointer to 32-bit aligned read buffer >= 2048 bytes
+ *     spare    : Where to place the 64 spare bytes, or NULL
+ *
+ * Outputs: None
+ *
+ * Returns: Returns -1 on failure or >0 on pass
+ *
+ * Notes:
+ *     Up to 4 symbol errors are corrected in each sub-page. A sub-page
+ *     that fails the decode but is erased is not an error. The caller
+ *     must invalidate the cache for the read buffer.
+ *
+ **********************************************************************/
+INT_32 nand_lb_mlc_read_sector_dma(UNS_32 sector, UNS_8 *readbuff,
+								   UNS_8 *spare)
+{
+	INT_32 bytes = LARGE_BLOCK_PAGE_MAIN_AREA_SIZE;
+	UNS_32 idx, idy, block, page, status;
+	UNS_32 tmp[MLC_SUBPAGE_SPARE / 4];
+
+    /* Translate to page/block address */
+    nand_sector_to_bp(sector, &block, &page);
+
+    /* Force nCE for the entire cycle */
+    MLCNAND->mlc_ceh = MLC_NORMAL_NCE;
+
+    /* Issue page read1 command */
+    mlc_cmd(LPCNAND_CMD_PAGE_READ1);
+
+    /* Write block and page address */
+	mlc_lb_write_address(block, page);
+
+    /* Issue page read2 command */
+    mlc_cmd(LPCNAND_CMD_PAGE_READ2);
+
+	/* Wait for ready */
+	mlc_wait_ready();
+
+	for (idx = 0; idx < MLC_SUBPAGES; idx++)
+	{
+		/* Read and correct the sub-page into the controller buffer */
+		MLCNAND->mlc_autodec_dec = 0;
+		do
+		{
+			status = MLCNAND->mlc_isr;
+		} while ((status & MLC_CNTRLLR_RDY_STS) == 0);
+
+		/* Move the data out of the buffer */
+		mlc_start_dma((UNS_32) &MLCNAND->mlc_buff [0], (UNS_32) readbuff,
+			((MLC_SUBPAGE_DATA / 4) |
+			DMAC_CHAN_SRC_BURST_4 |
+			DMAC_CHAN_DEST_BURST_4 |
+			DMAC_CHAN_SRC_WIDTH_32 |
+			DMAC_CHAN_DEST_WIDTH_32 |
+			DMAC_CHAN_DEST_AHB1 |
+			DMAC_CHAN_DEST_AUTOINC));
+		if (mlc_wait_dma())
+		{
+			bytes = -1;
+		}
+
+		/* Spare bytes, the 6 user bytes and the 10 parity bytes */
+		for (idy = 0; idy < (MLC_SUBPAGE_SPARE / 4); idy++)
+		{
+			tmp[idy] = MLCNAND->mlc_buff [0];
+		}
+
+		if (((status & MLC_DECODE_FAIL_STS) != 0) &&
+			(mlc_subpage_erased(readbuff, tmp) == FALSE))
+		{
+			bytes = -1;
+		}
+
+		if (spare != NULL)
+		{
+			memcpy(spare, tmp, MLC_SUBPAGE_SPARE);
+			spare += MLC_SUBPAGE_SPARE;
+		}
+		readbuff += MLC_SUBPAGE_DATA;
+	}
+
+    /* Deassert nCE */
+    MLCNAND->mlc_ceh = 0;
+
+	return bytes;
+}
+
+/***********************************************************************
+ *
+ * Function: nand_lb_mlc_write_sector_dma
+ *
+ * Purpose: Write a NAND sector with DMA and the Reed-Solomon ECC
+ *
+ * Processing:
+ *     For each of the 4 sub-pages, DMA the 512 data bytes into the
+ *     controller buffer, write the 6 user spare bytes, and let the
+ *     controller write the sub-page and its 10 parity bytes with
+ *     auto-encode. Then program the page.
+ *
+ * Parameters:
+ *     sector    : Sector to write
+ *     writebuff : Pointer to 32-bit aligned write buffer of 2048 bytes
+ *     spare     : 64 byte spare area, the first 6 bytes of each 16 are
+ *                 written, or NULL to write 0xFF
+ *
+ * Outputs: None
+ *
+ * Returns: Returns -1 on failure or >0 on pass
+ *
+ * Notes:
+ *     The caller must flush the cache for the write buffer.
+ *
+ **********************************************************************/
+INT_32 nand_lb_mlc_write_sector_dma(UNS_32 sector, UNS_8 *writebuff,
+									UNS_8 *spare)
+{
+	INT_32 bytes = LARGE_BLOCK_PAGE_MAIN_AREA_SIZE;
+	UNS_32 idx, block, page, tmp, tmp16;
+	UNS_8 status;
+
+    /* Translate to page/block address */
+    nand_sector_to_bp(sector, &block, &page);
+
+    /* Force nCE for the entire cycle */
+    MLCNAND->mlc_ceh = MLC_NORMAL_NCE;
+
+    /* Issue page write1 command */
+    mlc_cmd(LPCNAND_CMD_PAGE_WRITE1);
+
+    /* Write block and page address */
+	mlc_lb_write_address(block, page);
+
+	for (idx = 0; idx < MLC_SUBPAGES; idx++)
+	{
+		/* Start encode */
+		MLCNAND->mlc_enc_ecc = 0;
+
+		/* Move the data into the buffer */
+		mlc_start_dma((UNS_32) writebuff, (UNS_32) &MLCNAND->mlc_buff [0],
+			((MLC_SUBPAGE_DATA / 4) |
+			DMAC_CHAN_SRC_BURST_4 |
+			DMAC_CHAN_DEST_BURST_4 |
+			DMAC_CHAN_SRC_WIDTH_32 |
+			DMAC_CHAN_DEST_WIDTH_32 |
+			DMAC_CHAN_SRC_AHB1 |
+			DMAC_CHAN_SRC_AUTOINC));
+		if (mlc_wait_dma())
+		{
+			bytes = -1;
+		}
+		writebuff += MLC_SUBPAGE_DATA;
+
+		/* 6 user spare bytes */
+		tmp = 0xFFFFFFFF;
+		tmp16 = 0xFFFF;
+		if (spare != NULL)
+		{
+			tmp = spare[0] | (spare[1] << 8) | (spare[2] << 16) |
+				(spare[3] << 24);
+			tmp16 = spare[4] | (spare[5] << 8);
+			spare += MLC_SUBPAGE_SPARE;
+		}
+		MLCNAND->mlc_buff [0] = tmp;
+		* (volatile UNS_16 *) &MLCNAND->mlc_buff [0] = (UNS_16) tmp16;
+
+		/* Write the sub-page and its parity */
+		MLCNAND->mlc_autoenc_enc = 0;
+		while ((MLCNAND->mlc_isr & MLC_CNTRLLR_RDY_STS) == 0);
+	}
+
+    /* Issue page write2 command */
+    mlc_cmd(LPCNAND_CMD_PAGE_WRITE2);
+
+    /* Deassert nCE */
+    MLCNAND->mlc_ceh = 0;
+
+	/* Wait for device ready */
+	mlc_wait_ready();
+
+    /* Read status */
+    status = mlc_get_status();
+    if ((status & 0x1) != 0)
+    {
+    	/* Program was not good */
+    	bytes = -1;
+    }
+
+	return bytes;
+}
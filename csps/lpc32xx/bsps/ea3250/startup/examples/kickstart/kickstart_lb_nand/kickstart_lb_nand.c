@@ -25,8 +25,6 @@
 #include "startup.h"
 #include "misc_config.h"
 
-static UNS_8 tmpbuff [2048+64];
-
 /***********************************************************************
  *
  * Function: c_entry
@@ -47,7 +45,7 @@ static UNS_8 tmpbuff [2048+64];
  **********************************************************************/
 void c_entry(void) {
 	UNS_8 *p8, ret;
-	INT_32 toread, idx, blk, page, sector;
+	INT_32 toread, blk, sector;
 	PFV execa = (PFV) STAGE1_LOAD_ADDR;
 
 	/* Initialize NAND FLASH */
@@ -59,27 +57,19 @@ void c_entry(void) {
 	/* Read data into memory */
 	toread = STAGE1_LOAD_SIZE;
 	blk = 1;
-	page = 0;
 	p8 = (UNS_8 *) STAGE1_LOAD_ADDR;
 	while (toread > 0) 
 	{
 		ret = nand_lb_slc_is_block_bad(blk);
 		if (ret == 0)
 		{
-			while(page < nandgeom.pages_per_block)
-			{
-				sector = nand_bp_to_sector(blk, page);
-				nand_lb_slc_read_sector(sector, tmpbuff,NULL);
-				for (idx = 0; idx < 2048; idx++) 
-				{
-					*p8 = tmpbuff [idx];
-					p8++;
-				}
-				page++;
-				toread = toread - 2048;
-			}
+			/* Stream the whole block straight into memory */
+			sector = nand_bp_to_sector(blk, 0);
+			nand_lb_slc_read_sectors(sector, nandgeom.pages_per_block,
+				p8);
+			p8 += nandgeom.pages_per_block * 2048;
+			toread = toread - (nandgeom.pages_per_block * 2048);
 			blk++;
-			page = 0;
 		}
 		else
 		{
@@ -37,6 +37,33 @@
 /* Uncomment this define to disable all NAND FLASH support */
 #define S1L_SUPPORT_NAND
 
+/* Uncomment this define to save the NAND bad block table in the last
+   4 blocks of the device, so S1L does not read the bad block marker
+   of every block at startup. The table blocks are reported as bad and
+   are never used for data. */
+/*
+#define S1L_NAND_BBT
+*/
+
+/* Uncomment this define to use software BCH ECC for NAND FLASH sectors
+   instead of the SLC hardware ECC. The value is the number of bit
+   errors corrected per 512 bytes (4 or 8). Sectors written with one
+   ECC type can't be read with the other, so the kickstart loader must
+   use the same type. */
+/*
+#define S1L_NAND_BCH_T 8
+*/
+
+/* Uncomment this define to read and write NAND FLASH sectors
+   with DMA through the MLC controller and its Reed-Solomon ECC,
+   which corrects 4 symbols per 528 bytes, instead of the SLC. The
+   MLC layout covers the bad block markers, so S1L_NAND_BBT must
+   also be defined. The kickstart loader must load S1L through the
+   MLC. This takes the place of S1L_NAND_BCH_T. */
+/*
+#define S1L_NAND_MLC
+*/
+
 /* Number of blocks plus one dedicated to Stage 1 application. This
    includes one extra block to the kickstart loader, so if 24 blocks
    are needed, set this to 25. The last block is used for saved S1L
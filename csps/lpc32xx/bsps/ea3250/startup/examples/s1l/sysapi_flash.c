@@ -35,11 +35,265 @@
 #include "s1l_sys.h"
 #include "s1l_sys_inf.h"
 #include "board_slc_nand_lb_driver.h"
+#include "board_mlc_nand_lb_driver.h"
 #include "misc_config.h"
 #include "common_funcs.h"
 
+/* The MLC layout covers the bad block markers, so the MLC ECC needs
+   the saved bad block table. It takes the place of the BCH ECC. */
+#if defined (S1L_NAND_MLC) && !defined (S1L_NAND_BBT)
+#undef S1L_NAND_MLC
+#endif
+#ifdef S1L_NAND_MLC
+#undef S1L_NAND_BCH_T
+#endif
+
+#ifdef S1L_NAND_BCH_T
+#include "lpc_bch.h"
+#endif
+
 int erasebadblocks = 0;
 
+#ifdef S1L_NAND_BCH_T
+/* Software BCH codec used for NAND sectors */
+static LPC_BCH_T nandbch;
+
+/* Spare area buffer used when the caller does not pass one */
+static UNS_32 bchspare[LPC_BCH_OOB_SIZE / 4];
+
+/***********************************************************************
+ *
+ * Function: flash_bch_read_sector
+ *
+ * Purpose: Read a NAND sector and correct it with the BCH ECC
+ *
+ * Processing:
+ *     Read the sector and spare area without hardware ECC correction
+ *     and decode each 512 byte block against its ECC in the spare
+ *     area. The decode returns right after the ECC compare when a
+ *     block has no errors.
+ *
+ * Parameters:
+ *     sector : Sector to read
+ *     buff   : Where to place the sector data
+ *     extra  : Where to place the spare area, or NULL
+ *
+ * Outputs: None
+ *
+ * Returns: Returns >0 on success, -1 on fail
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static int flash_bch_read_sector(UNS_32 sector, UNS_8 *buff,
+								 UNS_8 *extra)
+{
+	UNS_8 *spare = (UNS_8 *) bchspare;
+	int idx, ret;
+
+	if (extra != NULL)
+	{
+		spare = extra;
+	}
+
+	ret = nand_lb_slc_read_sector_raw(sector, buff, spare);
+	if (ret > 0)
+	{
+		for (idx = 0; idx < LPC_BCH_OOB_BLOCKS; idx++)
+		{
+			if (lpc_bch_decode(&nandbch, buff + (idx * LPC_BCH_DATA_BYTES),
+				&spare[LPC_BCH_OOB_ECC_OFFS(&nandbch, idx)]) < 0)
+			{
+				ret = -1;
+			}
+		}
+	}
+
+	return ret;
+}
+
+/***********************************************************************
+ *
+ * Function: flash_bch_write_sector
+ *
+ * Purpose: Write a NAND sector with the BCH ECC
+ *
+ * Processing:
+ *     Generate the ECC for each 512 byte block into the spare area and
+ *     write the sector and spare area without hardware ECC.
+ *
+ * Parameters:
+ *     sector : Sector to write
+ *     buff   : Sector data to write
+ *     extra  : Spare area to write, or NULL for an erased spare area
+ *
+ * Outputs: The ECC is placed in the passed spare area.
+ *
+ * Returns: Returns >0 on success, -1 on fail
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static int flash_bch_write_sector(UNS_32 sector, UNS_8 *buff,
+								  UNS_8 *extra)
+{
+	UNS_8 *spare = (UNS_8 *) bchspare;
+	int idx;
+
+	if (extra != NULL)
+	{
+		spare = extra;
+	}
+	else
+	{
+		for (idx = 0; idx < LPC_BCH_OOB_SIZE; idx++)
+		{
+			spare[idx] = 0xFF;
+		}
+	}
+
+	for (idx = 0; idx < LPC_BCH_OOB_BLOCKS; idx++)
+	{
+		lpc_bch_encode(&nandbch, buff + (idx * LPC_BCH_DATA_BYTES),
+			&spare[LPC_BCH_OOB_ECC_OFFS(&nandbch, idx)]);
+	}
+
+	/* Flush the ECC out of the cache as NAND uses DMA */
+	dcache_flush();
+
+	return nand_lb_slc_write_sector_raw(sector, buff, spare);
+}
+#endif
+
+#ifdef S1L_SUPPORT_NAND
+#ifdef S1L_NAND_BBT
+#define BBT_SAVE TRUE
+#else
+#define BBT_SAVE FALSE
+#endif
+
+/* RAM bad block table, bad block checks are a bit test */
+static LPC_BBT_T nandbbt;
+
+/* Page buffer used to load and save the bad block table */
+static UNS_32 bbtpage[LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 4];
+
+/***********************************************************************
+ *
+ * Function: flash_bbt_read_sector
+ *
+ * Purpose: Read a sector of the saved bad block table
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector : Sector to read
+ *     buff   : Where to place the sector data
+ *
+ * Outputs: None
+ *
+ * Returns: Returns >0 on success, -1 on fail
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 flash_bbt_read_sector(UNS_32 sector, UNS_8 *buff)
+{
+	/* Flush and invalidate cache as NAND uses DMA */
+	dcache_flush();
+	dcache_inval();
+
+#ifdef S1L_NAND_MLC
+	return nand_lb_mlc_read_sector_dma(sector, buff, NULL);
+#else
+	return nand_lb_slc_read_sector(sector, buff, NULL);
+#endif
+}
+
+/***********************************************************************
+ *
+ * Function: flash_bbt_write_sector
+ *
+ * Purpose: Write a sector of the saved bad block table
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector : Sector to write
+ *     buff   : Sector data to write
+ *
+ * Outputs: None
+ *
+ * Returns: Returns >0 on success, -1 on fail
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 flash_bbt_write_sector(UNS_32 sector, UNS_8 *buff)
+{
+	/* Flush cache as NAND uses DMA */
+	dcache_flush();
+
+#ifdef S1L_NAND_MLC
+	return nand_lb_mlc_write_sector_dma(sector, buff, NULL);
+#else
+	return nand_lb_slc_write_sector(sector, buff, NULL);
+#endif
+}
+
+/***********************************************************************
+ *
+ * Function: flash_bbt_init
+ *
+ * Purpose: Build the bad block table and hand it to the NAND driver
+ *
+ * Processing:
+ *     Load the saved table, or read the bad block marker of each
+ *     block, while the driver still reads the markers itself. Then
+ *     let the driver use the table for its bad block checks.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void flash_bbt_init(void)
+{
+	LPC_BBT_DEV_T dev;
+
+#ifdef S1L_NAND_MLC
+	nand_lb_mlc_set_bbt(NULL);
+	dev.marker_bad = nand_lb_mlc_is_block_bad;
+	dev.erase_block = nand_lb_mlc_erase_block;
+#else
+	nand_lb_slc_set_bbt(NULL);
+	dev.marker_bad = nand_lb_slc_is_block_bad;
+	dev.erase_block = nand_lb_slc_erase_block;
+#endif
+	dev.num_blocks = nandgeom.num_blocks;
+	dev.pages_per_block = nandgeom.pages_per_block;
+	dev.page_size = nandgeom.data_bytes_per_page;
+	dev.read_sector = flash_bbt_read_sector;
+	dev.write_sector = flash_bbt_write_sector;
+	dev.pagebuff = (UNS_8 *) bbtpage;
+
+	if (lpc_bbt_init(&nandbbt, &dev, BBT_SAVE) == _NO_ERROR)
+	{
+#ifdef S1L_NAND_MLC
+		nand_lb_mlc_set_bbt(&nandbbt);
+#else
+		nand_lb_slc_set_bbt(&nandbbt);
+#endif
+	}
+}
+#endif
+
 /***********************************************************************
  *
  * Function: flash_init
@@ -65,8 +319,16 @@ NAND_GEOM_T *flash_init(void)
 #ifdef S1L_SUPPORT_NAND
 	nand_flash_wp_disable();
 
+#ifdef S1L_NAND_MLC
+	if (nand_lb_mlc_init())
+#else
 	if (nand_lb_slc_init())
+#endif
 	{
+		flash_bbt_init();
+#ifdef S1L_NAND_BCH_T
+		lpc_bch_init(&nandbch, S1L_NAND_BCH_T);
+#endif
 		return &nandgeom;
 	}
 #endif
@@ -121,34 +383,26 @@ int flash_read_sector(UNS_32 sector, void *buff, void *extra)
 {
 #ifdef S1L_SUPPORT_NAND
 	UNS_32 page, block;
-	static UNS_32 lastblock = 0xffffffff;
-	static int lastblockgood = 0;
 	int ret;
 
 	nand_sector_to_bp(sector, &block, &page);
 
-	if (lastblock != block)
-	{
-		if (nand_lb_slc_is_block_bad(block))
-		{
-			lastblockgood = 0;
-		}
-		else
-		{
-			lastblockgood = 1;
-		}
-
-		lastblock = block;
-	}
-
 	/* Flush and invalidate cache as NAND uses DMA */
 	dcache_flush();
 	dcache_inval();
 
+#ifdef S1L_NAND_MLC
+	ret = nand_lb_mlc_read_sector_dma(sector, (UNS_8 *) buff,
+		(UNS_8 *) extra);
+#elif defined (S1L_NAND_BCH_T)
+	ret = flash_bch_read_sector(sector, (UNS_8 *) buff,
+		(UNS_8 *) extra);
+#else
 	ret = nand_lb_slc_read_sector(sector, (UNS_8 *) buff,
 		(UNS_8 *) extra);
+#endif
 
-	if (lastblockgood == 0)
+	if (flash_is_bad_block(block) != FALSE)
 	{
 		return -2;
 	}
@@ -160,6 +414,57 @@ int flash_read_sector(UNS_32 sector, void *buff, void *extra)
 #endif
 }
 
+/***********************************************************************
+ *
+ * Function: flash_read_sectors
+ *
+ * Purpose: Read a run of NAND sectors
+ *
+ * Processing:
+ *     Stream the sectors into the buffer with the multi-sector read.
+ *     With the BCH or MLC ECC, read the sectors one at a time.
+ *
+ * Parameters:
+ *     sector : First sector to read
+ *     count  : Number of sectors to read
+ *     buff   : Where to place the sector data
+ *
+ * Outputs: None
+ *
+ * Returns: Returns >0 on success or -1 on fail
+ *
+ * Notes:
+ *     Bad blocks are not skipped, the caller checks the blocks.
+ *
+ **********************************************************************/
+int flash_read_sectors(UNS_32 sector, UNS_32 count, void *buff)
+{
+#if defined (S1L_SUPPORT_NAND) && !defined (S1L_NAND_BCH_T) && \
+	!defined (S1L_NAND_MLC)
+	/* The driver keeps the buffer coherent with the cache */
+	return nand_lb_slc_read_sectors(sector, (INT_32) count,
+		(UNS_8 *) buff);
+
+#else
+	UNS_8 *p8 = (UNS_8 *) buff;
+	int ret = 1;
+
+	while (count > 0)
+	{
+		if (flash_read_sector(sector, p8, NULL) <= 0)
+		{
+			ret = -1;
+		}
+
+		p8 += nandgeom.data_bytes_per_page;
+		sector++;
+		count--;
+	}
+
+	return ret;
+#endif
+}
+
 /***********************************************************************
  *
  * Function: flash_write_sector
@@ -184,26 +489,10 @@ int flash_write_sector(UNS_32 sector, void *buff, void *extra)
 {
 #ifdef S1L_SUPPORT_NAND
 	UNS_32 page, block;
-	static UNS_32 lastblock = 0xffffffff;
-	static int lastblockgood = 0;
 
 	nand_sector_to_bp(sector, &block, &page);
 
-	if (lastblock != block)
-	{
-		if (nand_lb_slc_is_block_bad(block))
-		{
-			lastblockgood = 0;
-		}
-		else
-		{
-			lastblockgood = 1;
-		}
-
-		lastblock = block;
-	}
-
-	if (lastblockgood == 0)
+	if (flash_is_bad_block(block) != FALSE)
 	{
 		return -2;
 	}
@@ -211,8 +500,16 @@ int flash_write_sector(UNS_32 sector, void *buff, void *extra)
 	/* Flush cache as NAND uses DMA */
 	dcache_flush();
 
+#ifdef S1L_NAND_MLC
+	return nand_lb_mlc_write_sector_dma(sector, (UNS_8 *) buff,
+		(UNS_8 *) extra);
+#elif defined (S1L_NAND_BCH_T)
+	return flash_bch_write_sector(sector, (UNS_8 *) buff,
+		(UNS_8 *) extra);
+#else
 	return nand_lb_slc_write_sector(sector, (UNS_8 *) buff,
 		(UNS_8 *) extra);
+#endif
 #else
 	return -1;
 #endif
@@ -240,11 +537,33 @@ int flash_write_sector(UNS_32 sector, void *buff, void *extra)
 BOOL_32 flash_erase_block(UNS_32 block)
 {
 #ifdef S1L_SUPPORT_NAND
+#ifdef S1L_NAND_MLC
+	BOOL_32 bad = (BOOL_32) (nand_lb_mlc_is_block_bad(block) != 0);
+#else
+	BOOL_32 bad = (BOOL_32) (nand_lb_slc_is_block_bad(block) != 0);
+#endif
+
+	/* The blocks holding the saved bad block table are never erased,
+	   not even with erasebadblocks set, or the table would be lost */
+	if ((nandbbt.save == TRUE) && (block >= nandbbt.first_rsvd))
+	{
+		return FALSE;
+	}
+
 	/* Don't allow erasure of bad blocks in S1L */
-	if (!(nand_lb_slc_is_block_bad(block)) || erasebadblocks)
+	if ((bad == FALSE) || erasebadblocks)
 	{
+#ifdef S1L_NAND_MLC
+		if (nand_lb_mlc_erase_block(block))
+#else
 		if (nand_lb_slc_erase_block(block))
+#endif
 		{
+			/* The erase also cleared the bad block marker */
+			if (bad == TRUE)
+			{
+				lpc_bbt_mark(&nandbbt, block, FALSE);
+			}
 			return TRUE;
 		}
 	}
@@ -275,7 +594,11 @@ BOOL_32 flash_erase_block(UNS_32 block)
 BOOL_32 flash_is_bad_block(UNS_32 block)
 {
 #ifdef S1L_SUPPORT_NAND
+#ifdef S1L_NAND_MLC
+	if (nand_lb_mlc_is_block_bad(block))
+#else
 	if (nand_lb_slc_is_block_bad(block))
+#endif
 	{
 		return TRUE;
 	}
@@ -21,6 +21,7 @@
 #include "lpc32xx_clkpwr_driver.h"
 #include "lpc32xx_dma_driver.h"
 #include "lpc32xx_slcnand.h"
+#include "lpc_arm922t_cp15_driver.h"
 #include "board_config.h"
 #include <string.h>
 #include "lpc_lbecc.h"
@@ -30,6 +31,15 @@ static UNS_32 ecc_data[8];
 #define NUM_OF_DMA_DESC 0x11
 static DMAC_LL_T dma_desc[NUM_OF_DMA_DESC];
 
+/* Bad block table used for the bad block checks, or NULL */
+static LPC_BBT_T *slcbbt = NULL;
+
+/* TRUE if the device supports the read cache commands */
+static BOOL_32 slc_cache_read = FALSE;
+
+/* Spare area of the sectors read by nand_lb_slc_read_sectors */
+static UNS_32 seq_spare[LARGE_BLOCK_PAGE_SPARE_AREA_SIZE / 4];
+
 /***********************************************************************
  *
  * Function: slc_start_dma
@@ -427,6 +437,16 @@ INT_32 nand_lb_slc_init(void)
 	id [2] = (UNS_8) SLCNAND->slc_data;
 	id [3] = (UNS_8) SLCNAND->slc_data;
 
+	/* The Micron parts support read cache */
+	if (id [0] == LPCNAND_VENDOR_MICRON)
+	{
+		slc_cache_read = TRUE;
+	}
+	else
+	{
+		slc_cache_read = FALSE;
+	}
+
     if ((id[3] == 0x15) || (id[3] == 0x95)) {
         /* Verify Micron ID */
         if (id [0] == LPCNAND_VENDOR_MICRON)
@@ -577,6 +597,12 @@ void nand_lb_slc_mark_bad_block(UNS_32 block)
 
     /* Unlock access and chip select */
     slc_sb_set_cs(FALSE);
+
+	/* Keep the bad block table up to date */
+	if (slcbbt != NULL)
+	{
+		lpc_bbt_mark(slcbbt, block, TRUE);
+	}
 }
 
 /***********************************************************************
@@ -604,6 +630,12 @@ INT_32 nand_lb_slc_is_block_bad(UNS_32 block)
 	INT_32 badblock;
 	UNS_8 i, spare[LARGE_BLOCK_PAGE_SPARE_AREA_SIZE];
 
+	/* The bad block table makes this a bit test */
+	if (slcbbt != NULL)
+	{
+		return lpc_bbt_is_bad(slcbbt, block);
+	}
+
 	/* Lock chip select */
     slc_sb_set_cs(TRUE);
 
@@ -635,9 +667,76 @@ INT_32 nand_lb_slc_is_block_bad(UNS_32 block)
 
 /***********************************************************************
  *
- * Function: nand_lb_slc_read_sector
+ * Function: nand_lb_slc_set_bbt
  *
- * Purpose: Read a NAND sector
+ * Purpose: Set the bad block table used for the bad block checks
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     bbt : Pointer to an initialized bad block table, or NULL to read
+ *           the bad block markers
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: The table is updated when a block is marked bad.
+ *
+ **********************************************************************/
+void nand_lb_slc_set_bbt(LPC_BBT_T *bbt)
+{
+	slcbbt = bbt;
+}
+
+/***********************************************************************
+ *
+ * Function: slc_lb_correct_page
+ *
+ * Purpose: Correct a page read with the hardware ECC
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     readbuff : Pointer to the page data
+ *     spare    : Pointer to the spare area of the page
+ *
+ * Outputs: None
+ *
+ * Returns: Returns 2048 or -1 if the data could not be corrected
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 slc_lb_correct_page(UNS_8 *readbuff, UNS_8 *spare)
+{
+	UNS_32 pspare[8];
+	INT_32 ret, i, bytes = LARGE_BLOCK_PAGE_MAIN_AREA_SIZE;
+
+	/* Assign ECC Data Pointer from Spare Area */
+	slc_ecc_copy_from_buffer(spare, pspare, 8);
+
+	/* Detect and Correct Errors if any */
+	for (i = 0; i < 8; i++)
+	{
+		ret = nand_slc_correct_ecc((UNS_32 *)&ecc_data[i],
+			&pspare[i], readbuff + (i * 256));
+		if(ret != LPC_ECC_CORRECTED && ret != LPC_ECC_NOERR)
+		{
+			bytes = -1;
+		}
+	}
+
+	return bytes;
+}
+
+/***********************************************************************
+ *
+ * Function: slc_lb_read_page
+ *
+ * Purpose: Read a NAND sector and its spare area
  *
  * Processing:
  *     See function.
@@ -646,6 +745,7 @@ INT_32 nand_lb_slc_is_block_bad(UNS_32 block)
  *     sector   : Sector to read
  *     readbuff : Pointer to read buffer
  *     spare : Pointer to spare area to fill
+ *     correct : TRUE to correct the data with the hardware ECC
  *
  * Outputs: None
  *
@@ -654,12 +754,12 @@ INT_32 nand_lb_slc_is_block_bad(UNS_32 block)
  * Notes: None
  *
  **********************************************************************/
-INT_32 nand_lb_slc_read_sector(UNS_32 sector, UNS_8 *readbuff,
-							   UNS_8 *spare)
+static INT_32 slc_lb_read_page(UNS_32 sector, UNS_8 *readbuff,
+							   UNS_8 *spare, BOOL_32 correct)
 {
-    UNS_32 block, page, offset, pspare[8];
+    UNS_32 block, page;
 	UNS_8 *tmpspare;
-	INT_32 ret, i, bytes = LARGE_BLOCK_PAGE_MAIN_AREA_SIZE;
+	INT_32 bytes = LARGE_BLOCK_PAGE_MAIN_AREA_SIZE;
 	UNS_8 tmp[LARGE_BLOCK_PAGE_SPARE_AREA_SIZE];
 
     /* Translate to page/block address */
@@ -722,19 +822,9 @@ INT_32 nand_lb_slc_read_sector(UNS_32 sector, UNS_8 *readbuff,
             SLCCFG_DMA_BURST | SLCCFG_ECC_EN |
             SLCCFG_DMA_ECC);
 
-	/* Assign ECC Data Pointer from Spare Area */
-	slc_ecc_copy_from_buffer(tmpspare, pspare, 8);
-
-	/* Detect and Correct Errors if any */
-	for (i = 0; i < 8; i++)
+	if (correct == TRUE)
 	{
-		offset = i * 256;
-		ret = nand_slc_correct_ecc((UNS_32 *)&ecc_data[i],
-			&pspare[i], readbuff + offset);
-		if(ret != LPC_ECC_CORRECTED && ret != LPC_ECC_NOERR)
-		{
-			bytes = -1;
-		}
+		bytes = slc_lb_correct_page(readbuff, tmpspare);
 	}
 
 	/* Unlock access and chip select */
@@ -745,9 +835,9 @@ INT_32 nand_lb_slc_read_sector(UNS_32 sector, UNS_8 *readbuff,
 
 /***********************************************************************
  *
- * Function: nand_lb_slc_write_sector
+ * Function: slc_lb_write_page
  *
- * Purpose: Write a NAND sector using hardware ECC 
+ * Purpose: Write a NAND sector and its spare area
  *
  * Processing:
  *     See function.
@@ -756,6 +846,7 @@ INT_32 nand_lb_slc_read_sector(UNS_32 sector, UNS_8 *readbuff,
  *     sector    : Sector to write
  *     writebuff : Pointer to write buffer
  *     spare     : Pointer to spare data to write
+ *     hwecc     : TRUE to place the hardware ECC in the spare area
  *
  * Outputs: None
  *
@@ -764,8 +855,8 @@ INT_32 nand_lb_slc_read_sector(UNS_32 sector, UNS_8 *readbuff,
  * Notes: None
  *
  **********************************************************************/
-INT_32 nand_lb_slc_write_sector(UNS_32 sector, UNS_8 *writebuff,
-								UNS_8 *spare)
+static INT_32 slc_lb_write_page(UNS_32 sector, UNS_8 *writebuff,
+								UNS_8 *spare, BOOL_32 hwecc)
 {
     UNS_32 block, page;
 	INT_32 bytes = LARGE_BLOCK_PAGE_MAIN_AREA_SIZE;
@@ -819,7 +910,10 @@ INT_32 nand_lb_slc_write_sector(UNS_32 sector, UNS_8 *writebuff,
 	/* Wait for DMA to Complete Transfer */
 	wait_dma();
 
-	slc_ecc_copy_to_buffer(tmpspare, ecc_data, 8);
+	if (hwecc == TRUE)
+	{
+		slc_ecc_copy_to_buffer(tmpspare, ecc_data, 8);
+	}
 	slc_start_dma(&dma_desc[16], DMAC_CHAN_FLOW_D_M2P |
 								DMAC_DEST_PERIP(DMA_PERID_NAND1) |
 								DMAC_SRC_PERIP(0) |
@@ -850,3 +944,249 @@ INT_32 nand_lb_slc_write_sector(UNS_32 sector, UNS_8 *writebuff,
 	slc_sb_set_cs(FALSE);
 	return bytes;
 }
+
+/***********************************************************************
+ *
+ * Function: nand_lb_slc_read_sector
+ *
+ * Purpose: Read a NAND sector
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector   : Sector to read
+ *     readbuff : Pointer to read buffer
+ *     spare : Pointer to spare area to fill
+ *
+ * Outputs: None
+ *
+ * Returns: Returns 2048 or -1 if Failure
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+INT_32 nand_lb_slc_read_sector(UNS_32 sector, UNS_8 *readbuff,
+							   UNS_8 *spare)
+{
+	return slc_lb_read_page(sector, readbuff, spare, TRUE);
+}
+
+/***********************************************************************
+ *
+ * Function: nand_lb_slc_read_sector_raw
+ *
+ * Purpose: Read a NAND sector without ECC correction
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector   : Sector to read
+ *     readbuff : Pointer to read buffer
+ *     spare : Pointer to spare area to fill
+ *
+ * Outputs: None
+ *
+ * Returns: Returns 2048 or -1 if Failure
+ *
+ * Notes: Used when the ECC is handled by software.
+ *
+ **********************************************************************/
+INT_32 nand_lb_slc_read_sector_raw(UNS_32 sector, UNS_8 *readbuff,
+								   UNS_8 *spare)
+{
+	return slc_lb_read_page(sector, readbuff, spare, FALSE);
+}
+
+/***********************************************************************
+ *
+ * Function: nand_lb_slc_read_sectors
+ *
+ * Purpose: Read a run of NAND sectors
+ *
+ * Processing:
+ *     The run is split at block boundaries. The first page of each
+ *     block is loaded with a page read. On parts with read cache, the
+ *     read cache command then moves each page to the cache register and
+ *     starts loading the next page from the array, so the array load
+ *     overlaps the DMA and ECC correction of the current page. The last
+ *     page of the block ends the read cache. Other parts load each page
+ *     with a page read. Each page is DMAed straight to the buffer and
+ *     corrected with the hardware ECC.
+ *
+ * Parameters:
+ *     sector   : First sector to read
+ *     count    : Number of sectors to read
+ *     readbuff : Pointer to read buffer, count * 2048 bytes
+ *
+ * Outputs: None
+ *
+ * Returns: Returns the number of bytes read or -1 if Failure
+ *
+ * Notes: All sectors are read even if one of them fails. Bad blocks
+ *        are not skipped.
+ *
+ **********************************************************************/
+INT_32 nand_lb_slc_read_sectors(UNS_32 sector, INT_32 count,
+								UNS_8 *readbuff)
+{
+	UNS_32 block, page;
+	INT_32 idx, run, bytes;
+	BOOL_32 cache;
+
+	if (count <= 0)
+	{
+		return 0;
+	}
+	bytes = count * LARGE_BLOCK_PAGE_MAIN_AREA_SIZE;
+
+	/* The buffer is filled by DMA, drop any cached copy of it */
+	cp15_force_cache_coherence((UNS_32 *) readbuff,
+		(UNS_32 *) (readbuff + bytes));
+
+	/* Lock access and chip select */
+    slc_sb_set_cs(TRUE);
+
+	/* Enable hardware ECC */
+	SLCNAND->slc_cfg |= (SLCCFG_DMA_DIR |
+						SLCCFG_DMA_BURST | SLCCFG_ECC_EN |
+						SLCCFG_DMA_ECC);
+
+	while (count > 0)
+	{
+	    /* Translate to page/block address */
+		nand_sector_to_bp(sector, &block, &page);
+
+		/* Read cache does not cross a block */
+		run = nandgeom.pages_per_block - page;
+		if (run > count)
+		{
+			run = count;
+		}
+		cache = (slc_cache_read == TRUE) && (run > 1);
+
+		for (idx = 0; idx < run; idx++)
+		{
+			if ((cache == FALSE) || (idx == 0))
+			{
+				/* Load the page into the page register */
+				slc_wait_ready();
+				slc_cmd(LPCNAND_CMD_PAGE_READ1);
+				slc_lb_write_address(block, page + idx, 0);
+				slc_cmd(LPCNAND_CMD_PAGE_READ2);
+				slc_wait_ready();
+			}
+
+			if (cache == TRUE)
+			{
+				/* Move the page to the cache register, the next page
+				   loads from the array while this one is read */
+				if (idx < (run - 1))
+				{
+					slc_cmd(LPCNAND_CMD_CACHE_READ);
+				}
+				else
+				{
+					slc_cmd(LPCNAND_CMD_CACHE_END);
+				}
+				slc_wait_ready();
+			}
+
+			/* The ECC and spare area are read back by the CPU */
+			cp15_force_cache_coherence(ecc_data, &ecc_data[8]);
+			cp15_force_cache_coherence(seq_spare,
+				&seq_spare[LARGE_BLOCK_PAGE_SPARE_AREA_SIZE / 4]);
+
+			/* Configure DMA Channel0 for NAND Read */
+			slc_lb_dma_read(readbuff, (UNS_8 *) seq_spare);
+
+			/* Set transfer count */
+			SLCNAND->slc_tc = LARGE_BLOCK_PAGE_SIZE;
+
+			/* Clear ECC */
+			SLCNAND->slc_ctrl |= SLCCTRL_ECC_CLEAR;
+
+			/* Start DMA and wait for it to complete */
+			SLCNAND->slc_ctrl |= SLCCTRL_DMA_START;
+			wait_dma();
+			SLCNAND->slc_ctrl &= ~SLCCTRL_DMA_START;
+
+			if (slc_lb_correct_page(readbuff,
+				(UNS_8 *) seq_spare) < 0)
+			{
+				bytes = -1;
+			}
+
+			readbuff += LARGE_BLOCK_PAGE_MAIN_AREA_SIZE;
+		}
+
+		sector += run;
+		count -= run;
+	}
+
+	/* Disable HW ECC */
+	SLCNAND->slc_cfg &= ~(SLCCFG_DMA_DIR |
+            SLCCFG_DMA_BURST | SLCCFG_ECC_EN |
+            SLCCFG_DMA_ECC);
+
+	/* Unlock access and chip select */
+	slc_sb_set_cs(FALSE);
+
+	return bytes;
+}
+
+/***********************************************************************
+ *
+ * Function: nand_lb_slc_write_sector
+ *
+ * Purpose: Write a NAND sector using hardware ECC 
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector    : Sector to write
+ *     writebuff : Pointer to write buffer
+ *     spare     : Pointer to spare data to write
+ *
+ * Outputs: None
+ *
+ * Returns: Returns 2048, or -1 if a write error occurs
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+INT_32 nand_lb_slc_write_sector(UNS_32 sector, UNS_8 *writebuff,
+								UNS_8 *spare)
+{
+	return slc_lb_write_page(sector, writebuff, spare, TRUE);
+}
+
+/***********************************************************************
+ *
+ * Function: nand_lb_slc_write_sector_raw
+ *
+ * Purpose: Write a NAND sector and spare area as passed
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector    : Sector to write
+ *     writebuff : Pointer to write buffer
+ *     spare     : Pointer to spare data to write
+ *
+ * Outputs: None
+ *
+ * Returns: Returns 2048, or -1 if a write error occurs
+ *
+ * Notes: The hardware ECC is not placed in the spare area, used when
+ *        the ECC is handled by software.
+ *
+ **********************************************************************/
+INT_32 nand_lb_slc_write_sector_raw(UNS_32 sector, UNS_8 *writebuff,
+									UNS_8 *spare)
+{
+	return slc_lb_write_page(sector, writebuff, spare, FALSE);
+}
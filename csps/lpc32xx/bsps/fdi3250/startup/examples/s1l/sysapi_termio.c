@@ -33,11 +33,13 @@
 #include "lpc32xx_intc_driver.h"
 #include "lpc32xx_hsuart_driver.h"
 #include "lpc_string.h"
+#include "lpc_ring.h"
 
 /* TX an RX ring buffers */
 static UNS_8 txbuff [512], rxbuff [512];
-volatile static int txsize, rxsize;
-static int txfill, rxget, txget, rxfill;
+static LPC_SPSC_RING_T rxring;
+volatile static int txsize;
+static int txfill, txget;
 static INT_32 uartdev;
 static volatile BOOL_32 uartbrk;
 static UNS_8 crlf[] = "\r\n";
@@ -87,7 +89,10 @@ void term_dat_send_cb(void) {
  * Purpose: UART receive data callback
  *
  * Processing:
- *     Read data from the driver into the RX ring buffer.
+ *     Read data from the driver straight into the free space of the
+ *     RX ring buffer, one contiguous span at a time until the UART
+ *     FIFO is empty. Data that does not fit in the ring buffer is
+ *     read and dropped.
  *
  * Parameters: None
  *
@@ -96,21 +101,29 @@ void term_dat_send_cb(void) {
  * Returns: Nothing
  *
  * Notes:
- *     Ring buffer overflow is not accounted for in this application.
  *     This function is called in interrupt context.
  *
  **********************************************************************/
 void term_dat_recv_cb(void) {
-  INT_32 bread, toreadmax = 512 - rxfill;
+  UNS_8 *span, discard;
+  INT_32 bread, toreadmax;
 
-  /* Read data */
-  bread = hsuart_read(uartdev, &rxbuff[rxfill], toreadmax);
-  rxsize = rxsize + bread;
-  rxfill = rxfill + bread;
-  if (rxfill >= 512)
+  do
   {
-    rxfill = 0;
-  }
+    toreadmax = (INT_32) lpc_ring_reserve(&rxring, (void **) &span);
+    if (toreadmax > 0)
+    {
+      /* Read data */
+      bread = hsuart_read(uartdev, span, toreadmax);
+      lpc_ring_commit(&rxring, (UNS_32) bread);
+    }
+    else
+    {
+      /* Ring buffer full, drop data */
+      toreadmax = 1;
+      bread = hsuart_read(uartdev, &discard, toreadmax);
+    }
+  } while (bread == toreadmax);
 }
 
 /***********************************************************************
@@ -261,23 +274,11 @@ void term_dat_out_crlf(UNS_8 *dat)
  **********************************************************************/
 int term_dat_in(UNS_8 *buff,
 				int bytes) {
-	int bread = 0;
-
-	while ((bytes > 0) && (rxsize > 0)) {
-		*buff = rxbuff[rxget];
-		buff++;
-		rxget++;
-		if (rxget >= 512) {
-			rxget = 0;
-		}
-		bytes--;
-		bread++;
-		int_disable(TERMIO_IRQ);
-		rxsize--;
-		int_enable(TERMIO_IRQ);
+	if (bytes <= 0) {
+		return 0;
 	}
 
-	return bread;
+	return (int) lpc_ring_get(&rxring, buff, (UNS_32) bytes);
 }
 
 /***********************************************************************
@@ -300,7 +301,7 @@ int term_dat_in(UNS_8 *buff,
  *
  **********************************************************************/
 int term_dat_in_ready(void) {
-	return rxsize;
+	return (int) lpc_ring_count(&rxring);
 }
 
 /***********************************************************************
@@ -367,7 +368,8 @@ void term_init(void) {
 	}
 
 	/* Initialize TX and RX ring buffers */
-	txfill = txget = rxfill = rxget = txsize = rxsize = 0;
+	txfill = txget = txsize = 0;
+	lpc_ring_init(&rxring, rxbuff, sizeof(rxbuff));
     uartbrk = FALSE;
 }
 
@@ -21,6 +21,7 @@
 
 #include "lpc_types.h"
 #include "nand_support_common.h"
+#include "lpc_bbt.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -43,6 +44,10 @@ void nand_sb_slc_mark_bad_block(UNS_32 block);
 /* Check is a passed block number is bad */
 INT_32 nand_sb_slc_is_block_bad(UNS_32 block);
 
+/* Use a bad block table for the bad block checks, or NULL to read
+   the bad block markers */
+void nand_sb_slc_set_bbt(LPC_BBT_T *bbt);
+
 /* Read a NAND sector using hardware ECC, returns -1 on failure or
    >0 on pass */
 INT_32 nand_sb_slc_read_sector(UNS_32 sector, UNS_8 *readbuff,
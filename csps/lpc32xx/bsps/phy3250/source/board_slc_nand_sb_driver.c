@@ -29,6 +29,9 @@ static UNS_32 ecc_data[2];
 #define NUM_OF_DMA_DESC 5
 static DMAC_LL_T dma_desc[NUM_OF_DMA_DESC];
 
+/* Bad block table used for the bad block checks, or NULL */
+static LPC_BBT_T *slcbbt = NULL;
+
 /***********************************************************************
  *
  * Function: slc_start_dma
@@ -579,6 +582,12 @@ void nand_sb_slc_mark_bad_block(UNS_32 block)
 
     /* Unlock access and chip select */
     slc_sb_set_cs(FALSE);
+
+	/* Keep the bad block table up to date */
+	if (slcbbt != NULL)
+	{
+		lpc_bbt_mark(slcbbt, block, TRUE);
+	}
 }
 
 /***********************************************************************
@@ -607,6 +616,12 @@ INT_32 nand_sb_slc_is_block_bad(UNS_32 block)
 	UNS_8 i, spare[16];
 	UNS_8 bbmark;
 
+	/* The bad block table makes this a bit test */
+	if (slcbbt != NULL)
+	{
+		return lpc_bbt_is_bad(slcbbt, block);
+	}
+
 	/* Lock chip select */
     slc_sb_set_cs(TRUE);
 
@@ -639,6 +654,31 @@ INT_32 nand_sb_slc_is_block_bad(UNS_32 block)
 	return badblock;
 }
 
+/***********************************************************************
+ *
+ * Function: nand_sb_slc_set_bbt
+ *
+ * Purpose: Set the bad block table used for the bad block checks
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     bbt : Pointer to an initialized bad block table, or NULL to read
+ *           the bad block markers
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: The table is updated when a block is marked bad.
+ *
+ **********************************************************************/
+void nand_sb_slc_set_bbt(LPC_BBT_T *bbt)
+{
+	slcbbt = bbt;
+}
+
 /***********************************************************************
  *
  * Function: nand_sb_slc_read_sector
@@ -37,6 +37,14 @@
 /* Uncomment this define to disable all NAND FLASH support */
 #define S1L_SUPPORT_NAND
 
+/* Uncomment this define to save the NAND bad block table in the last
+   4 blocks of the device, so S1L does not read the bad block marker
+   of every block at startup. The table blocks are reported as bad and
+   are never used for data. */
+/*
+#define S1L_NAND_BBT
+*/
+
 /* This define is used for picking either large or small block NAND
    FLASH support. Uncomment this define to use the large block SLC
    NAND driver */
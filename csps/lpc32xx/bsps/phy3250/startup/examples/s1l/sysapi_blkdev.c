@@ -17,10 +17,13 @@
  **********************************************************************/
 
 #include "sys.h"
+#include "s1l_sys_inf.h"
 #include "lpc_string.h"
 #include "lpc32xx_timer_driver.h"
 #include "lpc32xx_sdcard_driver.h"
 #include "lpc32xx_clkpwr_driver.h"
+#include "lpc32xx_dma_driver.h"
+#include "lpc_arm922t_cp15_driver.h"
 #include "lpc32xx_gpio_driver.h"
 #include "lpc_sdmmc.h"
 #include "phy3250_board.h"
@@ -43,6 +46,29 @@
    without using DMA at these clock speeds. */
 #define SDMMC_NORM_CLOCK  5000000
 
+/* Largest number of blocks moved by one read or write command, the
+   controller data length is limited to 65024 bytes per transfer */
+#define SDMMC_MAX_BLKS    127
+
+/* Clock used with SD cards switched into high-speed mode */
+#define SDMMC_HS_CLOCK    50000000
+
+/* Slowest clock the bus is stepped down to after transfer errors */
+#define SDMMC_MIN_CLOCK   SDMMC_NORM_CLOCK
+
+/* Card status polls (1mS apart) allowed for a write to complete */
+#define SDMMC_BUSY_TRIES  500
+
+/* Switch command class (10) in the CSD card command classes */
+#define CSD_CCC_SWITCH    (1 << 10)
+
+/* SD switch function (CMD6) arguments to check and to select high-speed
+   (function 1 of group 1), the other function groups are unchanged */
+#define SD_SWITCH_CHECK_HS   0x00FFFFF1
+#define SD_SWITCH_SET_HS     0x80FFFFF1
+#define SD_SWITCH_STS_SIZE   64
+#define SD_SWITCH_HS_SUPPORT (1 << 1) /* Status byte 13 */
+
 #define INIT_OP_RETRIES   10  /* initial OP_COND retries */
 #define SET_OP_RETRIES    200 /* set OP_COND retries */
 
@@ -53,6 +79,15 @@
 static volatile INT_32 cmdresp, datadone;
 static INT_32 sddev = 0;
 static UNS_32 rca, sdcardtype, cid[4], csd[4];
+static UNS_32 sdclock, swbuf[SD_SWITCH_STS_SIZE / sizeof(UNS_32)];
+static BOOL_32 sddma = FALSE, sdwide = FALSE, sdvalid = FALSE;
+static SDC_XFER_SETUP_T sdxfer;
+
+/* CSD TRAN_SPEED time values, multiplied by 10 */
+static const UNS_8 tran_speed_mult[16] =
+{
+	0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 70, 80
+};
 
 /***********************************************************************
  *
@@ -242,7 +277,10 @@ static INT_32 sdmmc_cmd_start_data(SD_CMDDATA_T *cmd,
 
 	/* Get the data transfer state */
 	sdcard_ioctl(sddev, SD_GET_CMD_RESP, (INT_32) resp);
-	if ((resp->data_status & SD_DATABLK_END) == 0)
+	if (((resp->data_status & SD_DATABLK_END) == 0) ||
+		((resp->data_status & (SD_DATA_TIMEOUT | SD_DATA_CRC_FAIL |
+		SD_STARTBIT_ERR | SD_FIFO_RXDATA_OFLOW |
+		SD_FIFO_TXDATA_UFLOW)) != 0))
 	{
 		status = -1;
 	}
@@ -250,6 +288,87 @@ static INT_32 sdmmc_cmd_start_data(SD_CMDDATA_T *cmd,
 	return status;
 }
 
+/***********************************************************************
+ *
+ * Function: sdmmc_dma_buffer
+ *
+ * Purpose: Prepare a data buffer for a block transfer
+ *
+ * Processing:
+ *     If DMA is not used, return the buffer unchanged. Otherwise clean
+ *     and invalidate the data cache lines covering the buffer and
+ *     return the physical address of the buffer.
+ *
+ * Parameters:
+ *     buff  : Pointer to word aligned data buffer
+ *     bytes : Size of the buffer in bytes
+ *
+ * Outputs: None
+ *
+ * Returns: The buffer address to pass to the SD card driver
+ *
+ * Notes:
+ *     The cache is cleaned so the DMA controller sees data written by
+ *     the CPU, and invalidated so the CPU does not read stale lines
+ *     over data received by DMA.
+ *
+ **********************************************************************/
+static UNS_32 *sdmmc_dma_buffer(UNS_32 *buff,
+                                UNS_32 bytes)
+{
+	if (sddma == FALSE)
+	{
+		return buff;
+	}
+
+	cp15_force_cache_coherence(buff, buff + (bytes / sizeof(UNS_32)));
+
+	return (UNS_32 *) cp15_map_virtual_to_physical(buff);
+}
+
+/***********************************************************************
+ *
+ * Function: sdmmc_wait_tran
+ *
+ * Purpose: Wait for the card to finish programming written data
+ *
+ * Processing:
+ *     Poll the card status until the card is back in the transfer
+ *     state and ready for data, or the poll count runs out.
+ *
+ * Parameters:
+ *     resp : Pointer to response buffers
+ *
+ * Outputs: None
+ *
+ * Returns: 0 if the card is ready, or -1 on a timeout
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 sdmmc_wait_tran(SD_CMDRESP_T *resp)
+{
+	INT_32 tries = SDMMC_BUSY_TRIES;
+	UNS_32 r;
+
+	do
+	{
+		sdmmc_cmd_send(CMD_SEND_STATUS, (rca << 16), resp);
+		r = resp->cmd_resp[1];
+		if (((resp->cmd_status & SD_CMD_RESP_RECEIVED) != 0) &&
+			(R1_CURRENT_STATE(r) == SDMMC_TRAN_ST) &&
+			((r & R1_READY_FOR_DATA) != 0))
+		{
+			return 0;
+		}
+
+		timer_wait_ms(TIMER_CNTR1, 1);
+	}
+	while (--tries > 0);
+
+	return -1;
+}
+
 /***********************************************************************
  *
  * Function: sdmmc_read_block
@@ -257,41 +376,136 @@ static INT_32 sdmmc_cmd_start_data(SD_CMDDATA_T *cmd,
  * Purpose: Read SD/MMC data blocks
  *
  * Processing:
- *     See function.
+ *     Issue a single block read for 1 block, or a multiple block read
+ *     followed by a stop command for more blocks.
  *
  * Parameters:
- *     buff    : Pointer to data buffer
- *     numblks : Number of blocks to read
+ *     buff    : Pointer to word aligned data buffer
+ *     numblks : Number of blocks to read (1 to SDMMC_MAX_BLKS)
  *     index   : Block read index
  *     resp    :  Pointer to response buffers
  *
  * Outputs: None
  *
- * Returns: Nothing
+ * Returns: 0 if the blocks were read, or -1 on an error
  *
  * Notes: None
  *
  **********************************************************************/
 static INT_32 sdmmc_read_block(UNS_32 *buff,
-                               INT_32 numblks, /* Must be 1 */
+                               INT_32 numblks,
                                UNS_32 index,
                                SD_CMDRESP_T *resp)
 {
     SD_CMDDATA_T sdcmd;
+	INT_32 status;
 
 	/* Setup read data */
 	sdcmd.data.dataop = SD_DATAOP_READ;
 	sdcmd.data.blocks = numblks;
-	sdcmd.data.buff = buff;
+	sdcmd.data.buff = sdmmc_dma_buffer(buff, numblks * SDMMC_BLK_SIZE);
 	sdcmd.data.usependcmd = FALSE;
 	sdcmd.data.stream = FALSE;
 
 	/* Perform command setup from standard MMC command table */
-	sdmmc_cmd_setup(&sdcmd.cmd, MMC_READ_SINGLE_BLOCK | CMD_RESP_R1,
-		index);
+	if (numblks == 1)
+	{
+		sdmmc_cmd_setup(&sdcmd.cmd, MMC_READ_SINGLE_BLOCK | CMD_RESP_R1,
+			index);
+	}
+	else
+	{
+		sdmmc_cmd_setup(&sdcmd.cmd,
+			MMC_READ_MULTIPLE_BLOCK | CMD_RESP_R1, index);
+	}
 
 	/* Read data from the SD card */
-	return sdmmc_cmd_start_data(&sdcmd, resp);
+	status = sdmmc_cmd_start_data(&sdcmd, resp);
+
+	/* A multiple block read runs until it is stopped */
+	if (numblks != 1)
+	{
+		sdmmc_cmd_send(CMD_STOP, 0, resp);
+		if ((resp->cmd_status & SD_CMD_RESP_RECEIVED) == 0)
+		{
+			status = -1;
+		}
+	}
+
+	return status;
+}
+
+/***********************************************************************
+ *
+ * Function: sdmmc_write_block
+ *
+ * Purpose: Write SD/MMC data blocks
+ *
+ * Processing:
+ *     Issue a single block write for 1 block, or a multiple block
+ *     write followed by a stop command for more blocks. Wait for the
+ *     card to finish programming the data.
+ *
+ * Parameters:
+ *     buff    : Pointer to word aligned data buffer
+ *     numblks : Number of blocks to write (1 to SDMMC_MAX_BLKS)
+ *     index   : Block write index
+ *     resp    :  Pointer to response buffers
+ *
+ * Outputs: None
+ *
+ * Returns: 0 if the blocks were written, or -1 on an error
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 sdmmc_write_block(UNS_32 *buff,
+                                INT_32 numblks,
+                                UNS_32 index,
+                                SD_CMDRESP_T *resp)
+{
+    SD_CMDDATA_T sdcmd;
+	INT_32 status;
+
+	/* Setup write data */
+	sdcmd.data.dataop = SD_DATAOP_WRITE;
+	sdcmd.data.blocks = numblks;
+	sdcmd.data.buff = sdmmc_dma_buffer(buff, numblks * SDMMC_BLK_SIZE);
+	sdcmd.data.usependcmd = FALSE;
+	sdcmd.data.stream = FALSE;
+
+	/* Perform command setup from standard MMC command table */
+	if (numblks == 1)
+	{
+		sdmmc_cmd_setup(&sdcmd.cmd, MMC_WRITE_BLOCK | CMD_RESP_R1,
+			index);
+	}
+	else
+	{
+		sdmmc_cmd_setup(&sdcmd.cmd,
+			MMC_WRITE_MULTIPLE_BLOCK | CMD_RESP_R1, index);
+	}
+
+	/* Write data to the SD card */
+	status = sdmmc_cmd_start_data(&sdcmd, resp);
+
+	/* A multiple block write runs until it is stopped */
+	if (numblks != 1)
+	{
+		sdmmc_cmd_send(CMD_STOP, 0, resp);
+		if ((resp->cmd_status & SD_CMD_RESP_RECEIVED) == 0)
+		{
+			status = -1;
+		}
+	}
+
+	/* The card stays busy while it programs the data */
+	if (sdmmc_wait_tran(resp) < 0)
+	{
+		status = -1;
+	}
+
+	return status;
 }
 
 /***********************************************************************
@@ -325,6 +539,265 @@ static void process_csd(void)
 	sdmmc_cmd_send(CMD_SET_BLOCKLEN, SDMMC_BLK_SIZE, &resp);
 }
 
+/***********************************************************************
+ *
+ * Function: sdmmc_set_bus
+ *
+ * Purpose: Setup the controller for data transfers
+ *
+ * Processing:
+ *     Setup the controller in push-pull mode with the selected clock
+ *     and the negotiated bus width.
+ *
+ * Parameters:
+ *     clock : Target bus clock in Hz
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the controller was setup ok
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 sdmmc_set_bus(UNS_32 clock)
+{
+    SDC_PRMS_T params;
+
+	params.opendrain = FALSE;
+	params.powermode = SD_POWER_ON_MODE;
+	params.pullup0 = 1;
+	params.pullup1 = 1;
+	params.pullup23 = 1;
+	params.pwrsave = FALSE;
+	params.sdclk_rate = clock;
+	params.use_wide = sdwide;
+
+	return (sdcard_ioctl(sddev, SD_SETUP_PARAMS,
+		(INT_32) &params) != _ERROR);
+}
+
+/***********************************************************************
+ *
+ * Function: sdmmc_csd_clock
+ *
+ * Purpose: Returns the maximum bus clock allowed by the card CSD
+ *
+ * Processing:
+ *     Decode the TRAN_SPEED field (CSD bits 103:96). The rate unit in
+ *     bits 2:0 is a power of 10 from 100Kbit/s and bits 6:3 select
+ *     the time value. Reserved values give the normal clock.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: The maximum bus clock in Hz
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 sdmmc_csd_clock(void)
+{
+	UNS_32 ts, unit, clock;
+
+	ts = csd[0] & 0xFF;
+	clock = tran_speed_mult[(ts >> 3) & 0xF] * 10000;
+	for (unit = (ts & 0x7); unit > 0; unit--)
+	{
+		clock = clock * 10;
+	}
+
+	if ((clock == 0) || ((ts & 0x7) > 3))
+	{
+		clock = SDMMC_NORM_CLOCK;
+	}
+
+	return clock;
+}
+
+/***********************************************************************
+ *
+ * Function: sdmmc_switch_func
+ *
+ * Purpose: Issue an SD switch function command
+ *
+ * Processing:
+ *     Issue CMD6 with the passed argument and read the 64 byte switch
+ *     status into swbuf. The controller block size must already be
+ *     set to the status size.
+ *
+ * Parameters:
+ *     arg  : Switch function argument
+ *     resp : Pointer to response buffers
+ *
+ * Outputs: None
+ *
+ * Returns: 0 if the status was read, or -1 on an error
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 sdmmc_switch_func(UNS_32 arg,
+                                SD_CMDRESP_T *resp)
+{
+    SD_CMDDATA_T sdcmd;
+
+	/* Setup read data */
+	sdcmd.data.dataop = SD_DATAOP_READ;
+	sdcmd.data.blocks = 1;
+	sdcmd.data.buff = sdmmc_dma_buffer(swbuf, sizeof(swbuf));
+	sdcmd.data.usependcmd = FALSE;
+	sdcmd.data.stream = FALSE;
+
+	sdmmc_cmd_setup(&sdcmd.cmd, SD_SWITCH | CMD_RESP_R1, arg);
+
+	return sdmmc_cmd_start_data(&sdcmd, resp);
+}
+
+/***********************************************************************
+ *
+ * Function: sdmmc_sd_high_speed
+ *
+ * Purpose: Switch an SD card into high-speed mode
+ *
+ * Processing:
+ *     Set the controller block size to the switch status size. Check
+ *     that the card supports high-speed mode, then select it and check
+ *     the card accepted the switch. Restore the block size.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the card is now in high-speed mode
+ *
+ * Notes: The card must be in the transfer state.
+ *
+ **********************************************************************/
+static BOOL_32 sdmmc_sd_high_speed(void)
+{
+    SD_CMDRESP_T resp;
+	UNS_8 *sts = (UNS_8 *) swbuf;
+	BOOL_32 hs = FALSE;
+
+	sdxfer.blocksize = SD_SWITCH_STS_SIZE;
+	sdcard_ioctl(sddev, SD_SETUP_DATA_XFER, (INT_32) &sdxfer);
+
+	if ((sdmmc_switch_func(SD_SWITCH_CHECK_HS, &resp) == 0) &&
+		((sts[13] & SD_SWITCH_HS_SUPPORT) != 0) &&
+		(sdmmc_switch_func(SD_SWITCH_SET_HS, &resp) == 0) &&
+		((sts[16] & 0xF) == 1))
+	{
+		hs = TRUE;
+	}
+
+	sdxfer.blocksize = SDMMC_BLK_SIZE;
+	sdcard_ioctl(sddev, SD_SETUP_DATA_XFER, (INT_32) &sdxfer);
+
+	return hs;
+}
+
+/***********************************************************************
+ *
+ * Function: sdmmc_card_resume
+ *
+ * Purpose: Bring a previously identified card back to transfer state
+ *
+ * Processing:
+ *     Ask the card for its status at the saved RCA. A card that does
+ *     not answer was removed or lost power. A card in standby is
+ *     selected again and a card left in a data state is stopped. Wait
+ *     for the card to reach the transfer state.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the card is ready for transfers
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 sdmmc_card_resume(void)
+{
+    SD_CMDRESP_T resp;
+	UNS_32 state;
+
+	sdmmc_cmd_send(CMD_SEND_STATUS, (rca << 16), &resp);
+	if ((resp.cmd_status & SD_CMD_RESP_RECEIVED) == 0)
+	{
+		return FALSE;
+	}
+
+	state = R1_CURRENT_STATE(resp.cmd_resp[1]);
+	if (state == SDMMC_STBY_ST)
+	{
+		process_csd();
+	}
+	else if ((state == SDMMC_DATA_ST) || (state == SDMMC_RCV_ST))
+	{
+		sdmmc_cmd_send(CMD_STOP, 0, &resp);
+	}
+	else if ((state != SDMMC_TRAN_ST) && (state != SDMMC_PRG_ST))
+	{
+		return FALSE;
+	}
+
+	return (sdmmc_wait_tran(&resp) == 0);
+}
+
+/***********************************************************************
+ *
+ * Function: sdmmc_step_down
+ *
+ * Purpose: Slow the bus down after a transfer error
+ *
+ * Processing:
+ *     Halve the bus clock, but not below SDMMC_MIN_CLOCK, and bring the
+ *     card back to the transfer state. Repeat until the card recovers
+ *     or the clock cannot go any lower. Once the clock is at
+ *     SDMMC_MIN_CLOCK, bring the card back to the transfer state at
+ *     that clock for one more retry of the transfer.
+ *
+ * Parameters:
+ *     retried : Pointer to a flag cleared before the first retry of a
+ *               transfer, set once the retry at SDMMC_MIN_CLOCK is used
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the transfer can be retried at the new clock
+ *
+ * Notes: The lower clock is kept for later transfers.
+ *
+ **********************************************************************/
+static BOOL_32 sdmmc_step_down(BOOL_32 *retried)
+{
+	while (sdclock > SDMMC_MIN_CLOCK)
+	{
+		sdclock = sdclock / 2;
+		if (sdclock < SDMMC_MIN_CLOCK)
+		{
+			sdclock = SDMMC_MIN_CLOCK;
+		}
+
+		if ((sdmmc_set_bus(sdclock) == TRUE) &&
+			(sdmmc_card_resume() == TRUE))
+		{
+			return TRUE;
+		}
+	}
+
+	/* A card can fail a transfer once at the lowest clock and still
+	   recover, so resume it and allow one more retry */
+	if (*retried == FALSE)
+	{
+		*retried = TRUE;
+		return sdmmc_card_resume();
+	}
+
+	return FALSE;
+}
+
 /***********************************************************************
  *
  * Function: blkdev_deinit
@@ -352,6 +825,9 @@ BOOL_32 blkdev_deinit(void)
 	}
 	phy3250_sdpower_enable(0);
 
+	/* The card loses its state with the slot power */
+	sdvalid = FALSE;
+
 	return TRUE;
 }
 
@@ -362,13 +838,17 @@ BOOL_32 blkdev_deinit(void)
  * Purpose: SDMMC init
  *
  * Processing:
- *     Initialize the SDMMC card
+ *     Open the controller and setup DMA transfers. If a card was
+ *     identified before and still answers at its address, resume it
+ *     with the saved card data and bus settings. Otherwise identify
+ *     the card, negotiate the 4-bit bus and high-speed mode for SD
+ *     cards, and run the bus at the fastest clock the card allows.
  *
  * Parameters: None
  *
  * Outputs: None
  *
- * Returns: Always returns TRUE
+ * Returns: TRUE if a card is ready for transfers, otherwise FALSE
  *
  * Notes: None
  *
@@ -377,7 +857,6 @@ BOOL_32 blkdev_init(void)
 {
     SD_CMDRESP_T resp;
     SDC_PRMS_T params;
-    SDC_XFER_SETUP_T dataset;
 	int state = 0, tries = 0;
 	UNS_32 command = 0, r, ocr = OCRVAL;
 
@@ -387,6 +866,13 @@ BOOL_32 blkdev_init(void)
 		return FALSE;
 	}
 
+	/* Restart the controller if it was left open after an error */
+	if (sddev != 0)
+	{
+		sdcard_close(sddev);
+		sddev = 0;
+	}
+
 	/* Open SD card controller driver */
 	sddev = sdcard_open(SDCARD, 0);
 	if (sddev == 0)
@@ -394,6 +880,43 @@ BOOL_32 blkdev_init(void)
 		return FALSE;
 	}
 
+	/* Setup data transfer paramaters, blocks are moved with DMA if a
+	   DMA channel can be allocated for the controller */
+	dma_init();
+
+	/* The board NAND drivers program DMA channel 0 directly. Keep it
+	   allocated for them so the SD driver gets a higher channel, and
+	   so closing the SD driver never turns off the DMA clock and
+	   controller under NAND. The channel is never freed, a repeated
+	   allocation just fails. */
+	dma_alloc_channel(0, NULL);
+
+	sdxfer.data_callback = (PFV) wait4datadone;
+	sdxfer.cmd_callback = (PFV) wait4cmddone;
+	sdxfer.blocksize = SDMMC_BLK_SIZE;
+	sdxfer.data_to = 0x001FFFFF; /* Long timeout for slow MMC cards */
+	sdxfer.use_dma = TRUE;
+	sddma = TRUE;
+	if (sdcard_ioctl(sddev, SD_SETUP_DATA_XFER,
+		(INT_32) &sdxfer) == _ERROR)
+	{
+		/* No DMA channel, the driver falls back to FIFO transfers */
+		sddma = FALSE;
+	}
+
+	/* A card that kept its state since the last init still answers at
+	   its address, so identification can be skipped */
+	if (sdvalid == TRUE)
+	{
+		if ((sdmmc_set_bus(sdclock) == TRUE) &&
+			(sdmmc_card_resume() == TRUE))
+		{
+			return TRUE;
+		}
+
+		sdvalid = FALSE;
+	}
+
 	/* Setup controller parameters */
 	params.opendrain = TRUE;
 	params.powermode = SD_POWER_ON_MODE;
@@ -410,14 +933,6 @@ BOOL_32 blkdev_init(void)
 		return FALSE;
 	}
 
-	/* Setup data transfer paramaters */
-	dataset.data_callback = (PFV) wait4datadone;
-	dataset.cmd_callback = (PFV) wait4cmddone;
-	dataset.blocksize = SDMMC_BLK_SIZE;
-	dataset.data_to = 0x001FFFFF; /* Long timeout for slow MMC cards */
-	dataset.use_dma = FALSE;
-	sdcard_ioctl(sddev, SD_SETUP_DATA_XFER, (INT_32) &dataset);
-
 	/* Issue IDLE command */
 	sdmmc_cmd_send(CMD_IDLE, 0, &resp);
 
@@ -553,20 +1068,47 @@ BOOL_32 blkdev_init(void)
 		}
 	}
 
+	/* Identification failed */
+	if (state != 100)
+	{
+		blkdev_deinit();
+		return FALSE;
+	}
+
     process_csd();
 
+	/* Start from the fastest clock the card CSD allows */
+	sdwide = FALSE;
+	sdclock = sdmmc_csd_clock();
+
 	if (sdcardtype & CARD_TYPE_SD)
 	{
 		/* Set bus width to 4 bits */
 		sdmmc_cmd_send(CMD_SD_SET_WIDTH, 2, &resp);
+		if ((resp.cmd_status & SD_CMD_RESP_RECEIVED) != 0)
+		{
+			sdwide = TRUE;
+		}
 
-		/* Switch controller to 4-bit data bus */
-		params.use_wide = TRUE;
-		params.opendrain = FALSE;
-		params.sdclk_rate = SDMMC_NORM_CLOCK;
-		sdcard_ioctl(sddev, SD_SETUP_PARAMS, (INT_32) &params);
+		/* Cards with the switch command class may support high-speed
+		   mode, the switch status is read at the normal clock */
+		sdmmc_set_bus(SDMMC_NORM_CLOCK);
+		if ((((csd[1] >> 20) & CSD_CCC_SWITCH) != 0) &&
+			(sdmmc_sd_high_speed() == TRUE))
+		{
+			sdclock = SDMMC_HS_CLOCK;
+		}
 	}
 
+	/* The FIFOs cannot keep up with fast clocks without DMA */
+	if ((sddma == FALSE) && (sdclock > SDMMC_NORM_CLOCK))
+	{
+		sdclock = SDMMC_NORM_CLOCK;
+	}
+
+	sdmmc_set_bus(sdclock);
+	sdvalid = TRUE;
+
 	return TRUE;
 }
 
@@ -589,20 +1131,141 @@ BOOL_32 blkdev_init(void)
  *
  **********************************************************************/
 BOOL_32 blkdev_read(void *buff, UNS_32 sector) 
+{
+	return blkdev_read_multi(buff, sector, 1);
+}
+
+/***********************************************************************
+ *
+ * Function: blkdev_read_multi
+ *
+ * Purpose: Reads a run of consecutive sectors
+ *
+ * Processing:
+ *     Split the run into transfers of up to SDMMC_MAX_BLKS blocks and
+ *     move each transfer with a single block command. A transfer that
+ *     fails is retried with the bus clock stepped down.
+ *
+ * Parameters:
+ *     buff   : Pointer to word aligned data buffer
+ *     sector : First sector of the run
+ *     count  : Number of sectors in the run
+ *
+ * Outputs: None
+ *
+ * Returns: Returns TRUE if all the blocks were read ok
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+BOOL_32 blkdev_read_multi(void *buff, UNS_32 sector, UNS_32 count)
 {
     SD_CMDRESP_T resp;
-	BOOL_32 good = TRUE;
+	UNS_8 *ptr8 = (UNS_8 *) buff;
+	UNS_32 blks, index;
+	BOOL_32 good = TRUE, retried;
+
+	if (sddev == 0)
+	{
+		return FALSE;
+	}
 
     gpio_set_gpo_state(P3_STATE_GPO(14), 0);
 
-	/* if high capacity card use block indexing */
-	if (!(sdcardtype & CARD_TYPE_HC))
-		sector = sector * SDMMC_BLK_SIZE;
+	while ((count > 0) && (good == TRUE))
+	{
+		blks = count;
+		if (blks > SDMMC_MAX_BLKS)
+			blks = SDMMC_MAX_BLKS;
+
+		/* if high capacity card use block indexing */
+		index = sector;
+		if (!(sdcardtype & CARD_TYPE_HC))
+			index = sector * SDMMC_BLK_SIZE;
+
+		/* Retry at a slower clock after an error */
+		retried = FALSE;
+		while (sdmmc_read_block((UNS_32 *) ptr8, blks, index, &resp) < 0)
+		{
+			if (sdmmc_step_down(&retried) == FALSE)
+			{
+				good = FALSE;
+				break;
+			}
+		}
+
+		ptr8 += blks * SDMMC_BLK_SIZE;
+		sector += blks;
+		count -= blks;
+	}
+
+    gpio_set_gpo_state(0, P3_STATE_GPO(14));
+
+	return good;
+}
+
+/***********************************************************************
+ *
+ * Function: blkdev_write_multi
+ *
+ * Purpose: Writes a run of consecutive sectors
+ *
+ * Processing:
+ *     Split the run into transfers of up to SDMMC_MAX_BLKS blocks and
+ *     move each transfer with a single block command. A transfer that
+ *     fails is retried with the bus clock stepped down.
+ *
+ * Parameters:
+ *     buff   : Pointer to word aligned data buffer
+ *     sector : First sector of the run
+ *     count  : Number of sectors in the run
+ *
+ * Outputs: None
+ *
+ * Returns: Returns TRUE if all the blocks were written ok
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+BOOL_32 blkdev_write_multi(void *buff, UNS_32 sector, UNS_32 count)
+{
+    SD_CMDRESP_T resp;
+	UNS_8 *ptr8 = (UNS_8 *) buff;
+	UNS_32 blks, index;
+	BOOL_32 good = TRUE, retried;
+
+	if (sddev == 0)
+	{
+		return FALSE;
+	}
+
+    gpio_set_gpo_state(P3_STATE_GPO(14), 0);
 
-	if (sdmmc_read_block(buff, 1, sector, &resp) < 0)
+	while ((count > 0) && (good == TRUE))
 	{
-		blkdev_deinit();
-		good = FALSE;
+		blks = count;
+		if (blks > SDMMC_MAX_BLKS)
+			blks = SDMMC_MAX_BLKS;
+
+		/* if high capacity card use block indexing */
+		index = sector;
+		if (!(sdcardtype & CARD_TYPE_HC))
+			index = sector * SDMMC_BLK_SIZE;
+
+		/* Retry at a slower clock after an error */
+		retried = FALSE;
+		while (sdmmc_write_block((UNS_32 *) ptr8, blks, index, &resp) < 0)
+		{
+			if (sdmmc_step_down(&retried) == FALSE)
+			{
+				good = FALSE;
+				break;
+			}
+		}
+
+		ptr8 += blks * SDMMC_BLK_SIZE;
+		sector += blks;
+		count -= blks;
 	}
 
     gpio_set_gpo_state(0, P3_STATE_GPO(14));
@@ -41,6 +41,117 @@
 
 int erasebadblocks = 0;
 
+#ifdef S1L_SUPPORT_NAND
+#ifdef S1L_NAND_BBT
+#define BBT_SAVE TRUE
+#else
+#define BBT_SAVE FALSE
+#endif
+
+/* RAM bad block table, bad block checks are a bit test */
+static LPC_BBT_T nandbbt;
+
+/* Page buffer used to load and save the bad block table */
+static UNS_32 bbtpage[SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 4];
+
+/***********************************************************************
+ *
+ * Function: flash_bbt_read_sector
+ *
+ * Purpose: Read a sector of the saved bad block table
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector : Sector to read
+ *     buff   : Where to place the sector data
+ *
+ * Outputs: None
+ *
+ * Returns: Returns >0 on success, -1 on fail
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 flash_bbt_read_sector(UNS_32 sector, UNS_8 *buff)
+{
+	/* Flush and invalidate cache as NAND uses DMA */
+	dcache_flush();
+	dcache_inval();
+
+	return nand_sb_slc_read_sector(sector, buff, NULL);
+}
+
+/***********************************************************************
+ *
+ * Function: flash_bbt_write_sector
+ *
+ * Purpose: Write a sector of the saved bad block table
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector : Sector to write
+ *     buff   : Sector data to write
+ *
+ * Outputs: None
+ *
+ * Returns: Returns >0 on success, -1 on fail
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 flash_bbt_write_sector(UNS_32 sector, UNS_8 *buff)
+{
+	/* Flush cache as NAND uses DMA */
+	dcache_flush();
+
+	return nand_sb_slc_write_sector(sector, buff, NULL);
+}
+
+/***********************************************************************
+ *
+ * Function: flash_bbt_init
+ *
+ * Purpose: Build the bad block table and hand it to the NAND driver
+ *
+ * Processing:
+ *     Load the saved table, or read the bad block marker of each
+ *     block, while the driver still reads the markers itself. Then
+ *     let the driver use the table for its bad block checks.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void flash_bbt_init(void)
+{
+	LPC_BBT_DEV_T dev;
+
+	nand_sb_slc_set_bbt(NULL);
+	dev.marker_bad = nand_sb_slc_is_block_bad;
+	dev.erase_block = nand_sb_slc_erase_block;
+	dev.num_blocks = nandgeom.num_blocks;
+	dev.pages_per_block = nandgeom.pages_per_block;
+	dev.page_size = nandgeom.data_bytes_per_page;
+	dev.read_sector = flash_bbt_read_sector;
+	dev.write_sector = flash_bbt_write_sector;
+	dev.pagebuff = (UNS_8 *) bbtpage;
+
+	if (lpc_bbt_init(&nandbbt, &dev, BBT_SAVE) == _NO_ERROR)
+	{
+		nand_sb_slc_set_bbt(&nandbbt);
+	}
+}
+#endif
+
 /***********************************************************************
  *
  * Function: flash_init
@@ -68,6 +179,7 @@ NAND_GEOM_T *flash_init(void)
 
 	if (nand_sb_slc_init())
 	{
+		flash_bbt_init();
 		return &nandgeom;
 	}
 #endif
@@ -122,33 +234,17 @@ int flash_read_sector(UNS_32 sector, void *buff, void *extra)
 {
 #ifdef S1L_SUPPORT_NAND
 	UNS_32 page, block;
-	static UNS_32 lastblock = 0xffffffff;
-	static int lastblockgood = 0;
 	int ret;
 
 	nand_sector_to_bp(sector, &block, &page);
 
-	if (lastblock != block)
-	{
-		if (nand_sb_slc_is_block_bad(block))
-		{
-			lastblockgood = 0;
-		}
-		else
-		{
-			lastblockgood = 1;
-		}
-
-		lastblock = block;
-	}
-
 	/* Flush and invalidate cache as NAND uses DMA */
 	dcache_flush();
 	dcache_inval();
 
 	ret = nand_sb_slc_read_sector(sector, (UNS_8 *) buff,
 		(UNS_8 *) extra);
-	if (lastblockgood == 0)
+	if (flash_is_bad_block(block) != FALSE)
 	{
 		return -2;
 	}
@@ -160,6 +256,48 @@ int flash_read_sector(UNS_32 sector, void *buff, void *extra)
 #endif
 }
 
+/***********************************************************************
+ *
+ * Function: flash_read_sectors
+ *
+ * Purpose: Read a run of NAND sectors
+ *
+ * Processing:
+ *     Read the sectors one at a time.
+ *
+ * Parameters:
+ *     sector : First sector to read
+ *     count  : Number of sectors to read
+ *     buff   : Where to place the sector data
+ *
+ * Outputs: None
+ *
+ * Returns: Returns >0 on success or -1 on fail
+ *
+ * Notes:
+ *     Bad blocks are not skipped, the caller checks the blocks.
+ *
+ **********************************************************************/
+int flash_read_sectors(UNS_32 sector, UNS_32 count, void *buff)
+{
+	UNS_8 *p8 = (UNS_8 *) buff;
+	int ret = 1;
+
+	while (count > 0)
+	{
+		if (flash_read_sector(sector, p8, NULL) <= 0)
+		{
+			ret = -1;
+		}
+
+		p8 += nandgeom.data_bytes_per_page;
+		sector++;
+		count--;
+	}
+
+	return ret;
+}
+
 /***********************************************************************
  *
  * Function: flash_write_sector
@@ -184,26 +322,10 @@ int flash_write_sector(UNS_32 sector, void *buff, void *extra)
 {
 #ifdef S1L_SUPPORT_NAND
 	UNS_32 page, block;
-	static UNS_32 lastblock = 0xffffffff;
-	static int lastblockgood = 0;
 
 	nand_sector_to_bp(sector, &block, &page);
 
-	if (lastblock != block)
-	{
-		if (nand_sb_slc_is_block_bad(block))
-		{
-			lastblockgood = 0;
-		}
-		else
-		{
-			lastblockgood = 1;
-		}
-
-		lastblock = block;
-	}
-
-	if (lastblockgood == 0)
+	if (flash_is_bad_block(block) != FALSE)
 	{
 		return -2;
 	}
@@ -240,11 +362,25 @@ int flash_write_sector(UNS_32 sector, void *buff, void *extra)
 BOOL_32 flash_erase_block(UNS_32 block)
 {
 #ifdef S1L_SUPPORT_NAND
+	BOOL_32 bad = (BOOL_32) (nand_sb_slc_is_block_bad(block) != 0);
+
+	/* The blocks holding the saved bad block table are never erased,
+	   not even with erasebadblocks set, or the table would be lost */
+	if ((nandbbt.save == TRUE) && (block >= nandbbt.first_rsvd))
+	{
+		return FALSE;
+	}
+
 	/* Don't allow erasure of bad blocks in S1L */
-	if (!(nand_sb_slc_is_block_bad(block)) || erasebadblocks)
+	if ((bad == FALSE) || erasebadblocks)
 	{
 		if (nand_sb_slc_erase_block(block))
 		{
+			/* The erase also cleared the bad block marker */
+			if (bad == TRUE)
+			{
+				lpc_bbt_mark(&nandbbt, block, FALSE);
+			}
 			return TRUE;
 		}
 	}
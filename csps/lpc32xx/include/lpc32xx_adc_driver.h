@@ -71,6 +71,11 @@ STATUS adc_ioctl(INT_32 devid,
 INT_32 adc_read_result(INT_32 devid,
                        void *buffer);
 
+/* ADC read function (interrupt, ring buffer) */
+INT_32 adc_read_ring(INT_32 devid,
+                     void *buffer,
+                     INT_32 max_bytes);
+
 /* ADC write function (stub only) */
 INT_32 adc_write(INT_32 devid,
                  void *buffer,
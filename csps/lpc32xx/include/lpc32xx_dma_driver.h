@@ -76,6 +76,13 @@ void dma_setup_link_phy(DMAC_LL_T *plink,
                         UNS_32 *dmadest_phy,
                         UNS_32 dma_ctrl);
 
+/* Get a linked list entry from the driver's entry pool, returns NULL
+   if all entries are in use. Safe to call from interrupt handlers. */
+DMAC_LL_T *dma_alloc_link(void);
+
+/* Return a linked list entry to the driver's entry pool */
+void dma_free_link(DMAC_LL_T *plink);
+
 /* Enable or disable SYNC logic for a specific peripheral, periph must
    be a value of type DMA_PER_xxx, see the DMA peripheral header file */
 void dma_enable_sync(UNS_32 periph,
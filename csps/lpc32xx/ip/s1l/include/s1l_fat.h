@@ -38,6 +38,10 @@ typedef BOOL_32 (*bvfunc) (void);
    pointer to a buffer, and a sector value */
 typedef BOOL_32 (*bviifunc) (void *, UNS_32);
 
+/* Prototype for device multi-sector read function, returns a boolean,
+   accepts a pointer to a buffer, a sector value, and a sector count */
+typedef BOOL_32 (*bviiifunc) (void *, UNS_32, UNS_32);
+
 /* Initialize device and file system */
 BOOL_32 fat_init(void);
 
@@ -51,6 +55,11 @@ BOOL_32 fat_file_open(UNS_8 *name);
 INT_32 fat_file_read(UNS_8 *buff,
                      INT_32 bytes);
 
+/* Read data from an open file straight into memory, using multi-sector
+   reads for whole sectors */
+INT_32 fat_file_read_direct(UNS_8 *buff,
+                            INT_32 bytes);
+
 /* Get a directory entry */
 BOOL_32 fat_get_dir(UNS_8 *dir,
                     BOOL_32 reset);
@@ -134,6 +134,12 @@ BOOL_32 blkdev_deinit(void);
 /* Read a block from the block device */
 BOOL_32 blkdev_read(void *buff, UNS_32 sector);
 
+/* Read a run of consecutive blocks from the block device */
+BOOL_32 blkdev_read_multi(void *buff, UNS_32 sector, UNS_32 count);
+
+/* Write a run of consecutive blocks to the block device */
+BOOL_32 blkdev_write_multi(void *buff, UNS_32 sector, UNS_32 count);
+
 /***********************************************************************
  * End of block driver functions
  **********************************************************************/
@@ -177,6 +183,10 @@ void flash_deinit(void);
    -1 on fail, or -2 if the block associated with the sector is bad. */
 int flash_read_sector(UNS_32 sector, void *buff, void *extra);
 
+/* Read a run of NAND sectors into a buffer, returns >0 on success or
+   -1 on fail. Bad blocks are not skipped. */
+int flash_read_sectors(UNS_32 sector, UNS_32 count, void *buff);
+
 /* Writes a NAND sector, will skip bad blocks, returns >0 on success,
    -1 on fail, or -2 if the block associated with the sector is bad. */
 int flash_write_sector(UNS_32 sector, void *buff, void *extra);
@@ -24,6 +24,9 @@
 #include "s1l_line_input.h"
 #include "s1l_sys_inf.h"
 #include "s1l_memtests.h"
+#ifdef LPC_HEAP_STATS
+#include "lpc_heap.h"
+#endif
 
 /* Peek saved data */
 static UNS_32 last_addr = 0;
@@ -273,6 +276,28 @@ static CMD_ROUTE_T core_script_cmd =
 	NULL
 };
 
+#ifdef LPC_HEAP_STATS
+/* heapstat command */
+static BOOL_32 cmd_heapstat(void);
+static UNS_32 cmd_heapstat_plist[] =
+{
+	(PARSE_TYPE_STR | PARSE_TYPE_OPT), /* The "heapstat" command */
+	(PARSE_TYPE_STR | PARSE_TYPE_END)
+};
+static CMD_ROUTE_T core_heapstat_cmd =
+{
+	(UNS_8 *) "heapstat",
+	cmd_heapstat,
+	(UNS_8 *) "Displays, dumps, or clears the heap statistics",
+	(UNS_8 *) "heapstat [dump, reset]",
+	cmd_heapstat_plist,
+	NULL
+};
+
+/* Binary heap statistics dump buffer */
+static UNS_8 heapstat_buff[LPC_HEAP_DUMP_MAX_SIZE];
+#endif
+
 /* Core group */
 GROUP_LIST_T core_group =
 {
@@ -1287,6 +1312,157 @@ static BOOL_32 cmd_script(void)
 	return parsed;
 }
 
+#ifdef LPC_HEAP_STATS
+/***********************************************************************
+ *
+ * Function: cmd_heapstat_val
+ *
+ * Purpose: Displays a labelled decimal value
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     label : Label to display before the value
+ *     val   : Value to display
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void cmd_heapstat_val(void *label, UNS_32 val)
+{
+	UNS_8 str[16];
+
+	term_dat_out((UNS_8 *) label);
+	str_makedec(str, val);
+	term_dat_out_crlf(str);
+}
+
+/***********************************************************************
+ *
+ * Function: cmd_heapstat
+ *
+ * Purpose: Displays, dumps, or clears the heap statistics
+ *
+ * Processing:
+ *     With no argument, the heap statistics are displayed as a table.
+ *     With "dump", the binary statistics dump is output as hex bytes
+ *     (16 per line) so it can be captured and compared on the host
+ *     between builds. With "reset", the heap counters are cleared.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the command was accepted, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 cmd_heapstat(void)
+{
+	LPC_HEAP_STATS_T stats;
+	UNS_8 str[16];
+	UNS_8 *arg;
+	UNS_32 idx, len;
+
+	if (parse_get_entry_count() == 2)
+	{
+		arg = get_parsed_entry(1);
+		if (str_cmp(arg, "reset") == 0)
+		{
+			lpc_heap_reset_stats();
+			return TRUE;
+		}
+		else if (str_cmp(arg, "dump") == 0)
+		{
+			len = lpc_heap_stats_dump(heapstat_buff,
+				sizeof(heapstat_buff));
+			for (idx = 0; idx < len; idx++)
+			{
+				/* Skip the 0x prefix */
+				str_makehex(str, heapstat_buff[idx], 2);
+				term_dat_out(&str[2]);
+				if (((idx & 0xF) == 0xF) || (idx == (len - 1)))
+				{
+					term_dat_out_crlf((UNS_8 *) "");
+				}
+			}
+			return TRUE;
+		}
+
+		term_dat_out_crlf((UNS_8 *)
+			"Invalid heapstat command, type help heapstat for more "
+			"info");
+		return FALSE;
+	}
+
+	lpc_heap_get_stats(&stats);
+
+	cmd_heapstat_val("Heap size (bytes)       : ", lpc_get_heapsize());
+	cmd_heapstat_val("Bytes in use            : ", stats.bytes_in_use);
+	cmd_heapstat_val("Peak bytes in use       : ", stats.peak_bytes);
+	cmd_heapstat_val("Allocations             : ", stats.alloc_calls);
+	cmd_heapstat_val("Frees                   : ", stats.free_calls);
+	cmd_heapstat_val("Failed allocations      : ", stats.failed_allocs);
+	cmd_heapstat_val("Allocation ticks        : ",
+		(UNS_32) stats.alloc_ticks);
+	cmd_heapstat_val("Free ticks              : ",
+		(UNS_32) stats.free_ticks);
+	cmd_heapstat_val("Free bytes              : ", stats.free_bytes);
+	cmd_heapstat_val("Largest free chunk      : ", stats.largest_free);
+	cmd_heapstat_val("Fragmentation (1/1000)  : ", stats.frag_permille);
+
+	term_dat_out_crlf((UNS_8 *) "Free chunks by size (>= bytes):");
+	for (idx = 0; idx < LPC_HEAP_HIST_BUCKETS; idx++)
+	{
+		if (stats.free_hist[idx] != 0)
+		{
+			term_dat_out((UNS_8 *) " ");
+			str_makedec(str, 1 << idx);
+			term_dat_out(str);
+			term_dat_out((UNS_8 *) " : ");
+			str_makedec(str, stats.free_hist[idx]);
+			term_dat_out_crlf(str);
+		}
+	}
+
+	term_dat_out_crlf((UNS_8 *) "Allocations by call site:");
+	for (idx = 0; idx < stats.num_tags; idx++)
+	{
+		term_dat_out((UNS_8 *) " ");
+		if (stats.tags[idx].file != NULL)
+		{
+			term_dat_out((UNS_8 *) stats.tags[idx].file);
+			term_dat_out((UNS_8 *) ":");
+			str_makedec(str, stats.tags[idx].line);
+			term_dat_out(str);
+		}
+		else
+		{
+			term_dat_out((UNS_8 *) "(untagged)");
+		}
+		term_dat_out((UNS_8 *) " : ");
+		str_makedec(str, stats.tags[idx].allocs);
+		term_dat_out(str);
+		term_dat_out((UNS_8 *) " allocs, ");
+		str_makedec(str, stats.tags[idx].bytes);
+		term_dat_out(str);
+		term_dat_out_crlf((UNS_8 *) " bytes");
+	}
+	if (stats.untracked_allocs != 0)
+	{
+		cmd_heapstat_val(" Other call sites : ", stats.untracked_allocs);
+	}
+
+	return TRUE;
+}
+#endif
+
 /***********************************************************************
  *
  * Function: cmd_core_add_commands
@@ -1324,4 +1500,10 @@ void cmd_core_add_commands(void)
 	cmd_add_new_command(&core_group, &core_prompt_cmd);
 	cmd_add_new_command(&core_group, &core_rstcfg_cmd);
 	cmd_add_new_command(&core_group, &core_script_cmd);
+#ifdef LPC_HEAP_STATS
+	cmd_add_new_command(&core_group, &core_heapstat_cmd);
+
+	/* Time heap operations with the system timer */
+	lpc_heap_set_timer(time_get);
+#endif
 }
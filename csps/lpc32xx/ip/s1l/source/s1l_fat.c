@@ -29,6 +29,14 @@
  * Local data and types
  **********************************************************************/
 
+/* Number of FAT windows, and number of FAT sectors in a window,
+   cached for cluster chain lookups */
+#define FAT_WIN_NUM  2
+#define FAT_WIN_SECS 4
+
+/* Sector value of an unused FAT window */
+#define FAT_WIN_NONE 0xFFFFFFFF
+
 /* FAT geometry structure - computed values from the partition boot
    record */
 typedef struct
@@ -80,6 +88,14 @@ typedef struct
     UNS_8  secdata [512];
 } FAT_BUFF_T;
 
+/* Cached window of consecutive FAT sectors */
+typedef struct
+{
+    UNS_32 sector;           /* First FAT sector in the window */
+    UNS_32 stamp;            /* Last use stamp for replacement */
+    UNS_32 dat[FAT_WIN_SECS * 128]; /* Cached FAT sectors */
+} FAT_WIN_T;
+
 /* FAT device structure, used to bind a device driver to the FAT
    driver */
 typedef struct
@@ -87,6 +103,7 @@ typedef struct
     bvfunc init_func;        /* Address of device init function */
     bvfunc dinit_func;       /* Address of device de-init function */
     bviifunc read_func;      /* Address of device read function */
+    bviiifunc readm_func;    /* Address of device multi-read function */
     FAT_GEOM_T fgeom;        /* FAT device geometry */
     UNS_32 dir_sector;       /* File directory search sector */
     UNS_32 dir_cluster;      /* Current directory cluster (FAT32) */
@@ -94,8 +111,9 @@ typedef struct
     UNS_32 dir_dat[128];     /* Cached directory sector */
     UNS_32 dir_sub_sector;   /* Sector index for a directory cluster */
     UNS_32 filesize;         /* Size of the file in bytes */
-    UNS_32 clusec_cached;    /* Cached cluster sector */
-    UNS_32 clus_dat[128];    /* Cached cluster sector */
+    UNS_32 dir_next_clus;    /* Next directory cluster (FAT32) */
+    FAT_WIN_T fat_win[FAT_WIN_NUM]; /* Cached FAT windows */
+    UNS_32 fat_stamp;        /* FAT window use counter */
     BOOL_32 cluster_last;    /* Cluster last flag */
     FAT_BUFF_T fbuff;
 } FAT_DATA_T;
@@ -406,7 +424,8 @@ BOOL_32 fat_check_boot(UNS_8 *buff_ptr)
  * Purpose: Initialize device and fetch boot record
  *
  * Processing:
- *     Call the device specific initialization function. Read sector
+ *     Call the device specific initialization function. Invalidate
+ *     the cached FAT windows. Read sector
  *     0 and check to see if it is the boot sector. If it isn't, check
  *     to see if it is a partition sector. If it is, read the sector
  *     offset by the partition table and check it as the boot sector.
@@ -425,6 +444,7 @@ BOOL_32 fat_check_boot(UNS_8 *buff_ptr)
 BOOL_32 fat_device_init(void)
 {
     UNS_8 boot_rec[512];
+    INT_32 idx;
 
     /* Try to initialize the device first */
     if (fat_data.init_func() == FALSE)
@@ -436,6 +456,14 @@ BOOL_32 fat_device_init(void)
     /* Set default sector offset for parition boot record to 0 */
     fat_data.fgeom.boot_part_off = 0;
 
+    /* The FAT of a new device is not cached yet */
+    for (idx = 0; idx < FAT_WIN_NUM; idx++)
+    {
+        fat_data.fat_win[idx].sector = FAT_WIN_NONE;
+        fat_data.fat_win[idx].stamp = 0;
+    }
+    fat_data.fat_stamp = 0;
+
     /* Read sector 0, this sector may be a partition boot record or
        a device master boot record */
     if (fat_data.read_func(&boot_rec[0], 0) == FALSE)
@@ -548,6 +576,98 @@ BOOL_32 name_check(CHAR *source,
     return same;
 }
 
+/***********************************************************************
+ *
+ * Function: fat_read_sectors
+ *
+ * Purpose: Read a run of consecutive sectors
+ *
+ * Processing:
+ *     Pass the whole run to the device multi-sector read function so
+ *     the device can transfer it with a single command.
+ *
+ * Parameters:
+ *     buff   : Buffer to read the sectors into
+ *     sector : First sector to read
+ *     count  : Number of sectors to read
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if all the sectors were read, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+BOOL_32 fat_read_sectors(void *buff,
+                         UNS_32 sector,
+                         UNS_32 count)
+{
+    if (count == 0)
+    {
+        return TRUE;
+    }
+
+    return fat_data.readm_func(buff, sector, count);
+}
+
+/***********************************************************************
+ *
+ * Function: fat_get_window
+ *
+ * Purpose: Return the cached FAT window starting at a sector
+ *
+ * Processing:
+ *     Look for a window holding the sector. If none does, read the
+ *     window sectors into the least recently used window. Update the
+ *     use stamp of the window.
+ *
+ * Parameters:
+ *     sector : First FAT sector of the window
+ *
+ * Outputs: None
+ *
+ * Returns: Pointer to the window, or NULL if it could not be read
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+FAT_WIN_T *fat_get_window(UNS_32 sector)
+{
+    FAT_WIN_T *win = NULL, *lru = &fat_data.fat_win[0];
+    INT_32 idx;
+
+    for (idx = 0; idx < FAT_WIN_NUM; idx++)
+    {
+        if (fat_data.fat_win[idx].sector == sector)
+        {
+            win = &fat_data.fat_win[idx];
+        }
+        else if (fat_data.fat_win[idx].stamp < lru->stamp)
+        {
+            lru = &fat_data.fat_win[idx];
+        }
+    }
+
+    if (win == NULL)
+    {
+        /* Window is not cached yet, so read it in */
+        win = lru;
+        win->sector = FAT_WIN_NONE;
+        if (fat_read_sectors(&win->dat[0], sector,
+            FAT_WIN_SECS) == FALSE)
+        {
+            return NULL;
+        }
+
+        win->sector = sector;
+    }
+
+    fat_data.fat_stamp++;
+    win->stamp = fat_data.fat_stamp;
+
+    return win;
+}
+
 /***********************************************************************
  *
  * Function: get_next_cluster
@@ -555,7 +675,8 @@ BOOL_32 name_check(CHAR *source,
  * Purpose: Return the next cluster number on a cluster chain
  *
  * Processing:
- *     Get the next cluster in the cluster chain. See function.
+ *     Get the FAT window holding the cluster entry and return the
+ *     entry. End of chain entries are returned as 0xFFFFFFFF.
  *
  * Parameters:
  *     cluster   : Current cluster to link against
@@ -569,10 +690,9 @@ BOOL_32 name_check(CHAR *source,
  **********************************************************************/
 UNS_32 get_next_cluster(UNS_32 cluster)
 {
-    UNS_16 *clu16;
-    UNS_32 secoff, csize, *clu32, next_cluster = 0xFFFFFFFE;
+    FAT_WIN_T *win;
+    UNS_32 csize, secoff, next_cluster;
 
-    /* Determine if the cluster sector has been cached already */
     /* Determine a FAT entry size in the cluster */
     if (fat_data.fgeom.fat32_fs == TRUE)
     {
@@ -585,40 +705,33 @@ UNS_32 get_next_cluster(UNS_32 cluster)
         csize = sizeof (UNS_16);
     }
 
-    /* Determine the sector offset to search for the cluster */
+    /* Determine the first sector of the window holding the cluster */
     secoff = (cluster * csize) / 512;
-    secoff = secoff + fat_data.fgeom.fat_st_sector +
-        fat_data.fgeom.boot_part_off;
-    if (fat_data.clusec_cached != secoff)
+    secoff = secoff - (secoff % FAT_WIN_SECS);
+    win = fat_get_window(secoff + fat_data.fgeom.fat_st_sector +
+        fat_data.fgeom.boot_part_off);
+    if (win == NULL)
     {
-        /* Sector to determine the next cluster is not cached yet,
-           so read it in */
-        if (fat_data.read_func(&fat_data.clus_dat[0], secoff) ==
-            FALSE)
-        {
-            return FALSE;
-        }
-
-        fat_data.clusec_cached = secoff;
+        return 0xFFFFFFFE;
     }
 
-    /* The cluster index contains an absolute index into the cluster
-       array that points to the next cluster to load. Convert this
-       cluster index into a sector specific index */
-    secoff = cluster / (512 / csize);
+    /* Convert the cluster number into an index in the window */
     cluster = cluster - (secoff * (512 / csize));
 
     /* Get next cluster */
     if (fat_data.fgeom.fat32_fs == TRUE)
     {
-        clu32 = (UNS_32 *) &fat_data.clus_dat[0];
-        next_cluster = clu32[cluster];
+        next_cluster = ((UNS_32 *) &win->dat[0])[cluster] & 0x0FFFFFFF;
+        if (next_cluster >= 0x0FFFFFF8)
+        {
+            /* Change a FAT32 end of chain tag to a usable tag */
+            next_cluster = 0xFFFFFFFF;
+        }
     }
     else
     {
-        clu16 = (UNS_16 *) &fat_data.clus_dat[0];
-        next_cluster = (UNS_32) clu16[cluster];
-        if (next_cluster == 0xFFFF)
+        next_cluster = (UNS_32) ((UNS_16 *) &win->dat[0])[cluster];
+        if (next_cluster >= 0xFFF8)
         {
             /* Change a smaller FAT16 tag to a usable tag */
             next_cluster = 0xFFFFFFFF;
@@ -655,12 +768,12 @@ BOOL_32 get_next_f32_dir(DIR_ENTRY_T **dir_entry)
     UNS_8 *dir_lin;
 
     /* Determine if the next cluster has to be started */
-    if (fat_data.dir_cluster != fat_data.clusec_cached)
+    if (fat_data.dir_cluster != fat_data.dir_next_clus)
     {
         /* A new cluster needs to be started, reset directory index
            to 0, sector subindex to 0, and directory sector index to
            start of directory cluster sector */
-        fat_data.dir_cluster = fat_data.clusec_cached;
+        fat_data.dir_cluster = fat_data.dir_next_clus;
         fat_data.dir_index = 0;
         fat_data.dir_sub_sector = 0;
         fat_data.dir_sector = fat_data.fgeom.data_st_sector +
@@ -679,7 +792,7 @@ BOOL_32 get_next_f32_dir(DIR_ENTRY_T **dir_entry)
         if (fat_data.dir_sub_sector >= fat_data.fgeom.secs_cluster)
         {
             /* The next cluster needs to be read in */
-            fat_data.clusec_cached = get_next_cluster(
+            fat_data.dir_next_clus = get_next_cluster(
                 fat_data.dir_cluster);
             return get_next_f32_dir(dir_entry);
         }
@@ -745,7 +858,7 @@ BOOL_32 get_next_dir(DIR_ENTRY_T **dir_entry)
 
         /* FAT32 systems start the search at the first DIR cluster */
         fat_data.dir_cluster = 0xFFFFFFFF;
-        fat_data.clusec_cached = fat_data.fgeom.rdir_clus_fat32;
+        fat_data.dir_next_clus = fat_data.fgeom.rdir_clus_fat32;
         fat_data.dir_sub_sector = 0;
 
         /* Set current directory index */
@@ -898,9 +1011,6 @@ BOOL_32 file_track(UNS_32 fcluster,
     UNS_32 sector, *saddr = (UNS_32 *) addr;
     UNS_8 dump [512];
 
-    /* Initial cluster data is not cached */
-    fat_data.clusec_cached = 0;
-
     /* Loop until all data is read or until an error occurs */
     while (fat_data.filesize > 0)
     {
@@ -1112,6 +1222,7 @@ BOOL_32 fat_init(void)
     /* Save pointers to functions */
     fat_data.init_func  = blkdev_init;
     fat_data.read_func  = blkdev_read;
+    fat_data.readm_func = blkdev_read_multi;
     fat_data.dinit_func = blkdev_deinit;
 
     /* Try to initialize interface first */
@@ -1219,9 +1330,6 @@ BOOL_32 fat_file_open(UNS_8 *name)
        the first cluster */
    	fat_data.cluster_last = FALSE;
 
-    /* Initial cluster data is not cached */
-   	fat_data.clusec_cached = 0;
-
 	/* Start file data read */
 	fat_data_cache_read(NULL, 0);
 
@@ -1254,6 +1362,123 @@ INT_32 fat_file_read(UNS_8 *buff,
 	return fat_data_cache_read(buff, bytes);
 }
 
+/***********************************************************************
+ *
+ * Function: fat_file_read_direct
+ *
+ * Purpose: Read data from an open file straight into memory
+ *
+ * Processing:
+ *     If the buffer is word aligned and the read position is on a
+ *     sector boundary, read the whole sectors of the request straight
+ *     into the buffer. Contiguous clusters of the file are merged into
+ *     a single run of sectors for each read. Read the rest of the
+ *     request (a partial sector or an unaligned buffer) through the
+ *     cached sector.
+ *
+ * Parameters:
+ *     buff  : Buffer pointer for read data
+ *     bytes : Number of bytes to read
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes read
+ *
+ * Notes: Used to load large files such as boot images.
+ *
+ **********************************************************************/
+INT_32 fat_file_read_direct(UNS_8 *buff,
+                            INT_32 bytes)
+{
+    INT_32 bread = 0;
+    UNS_32 sector, count, limit, left, cluster;
+    BOOL_32 contig, good = TRUE;
+
+    if ((((UNS_32) buff & 0x3) == 0) &&
+        (fat_data.fbuff.cachedbytes == 0))
+    {
+        /* Number of whole sectors that can be read directly */
+        limit = (UNS_32) bytes / 512;
+        left = (fat_data.filesize - fat_data.fbuff.tread) / 512;
+        if (limit > left)
+        {
+            limit = left;
+        }
+
+        while ((limit > 0) && (good == TRUE))
+        {
+            /* Get the next sector to read in the current cluster */
+            sector = fat_data.fgeom.data_st_sector +
+                fat_data.fgeom.boot_part_off +
+                ((fat_data.fbuff.next_cluster - CLUSTERU_MIN) *
+                fat_data.fgeom.secs_cluster) +
+                fat_data.fbuff.clus_index;
+
+            /* Extend the run through the following clusters while
+               they are contiguous on the device */
+            count = 0;
+            contig = TRUE;
+            while ((count < limit) && (contig == TRUE))
+            {
+                left = fat_data.fgeom.secs_cluster -
+                    fat_data.fbuff.clus_index;
+                if (left > (limit - count))
+                {
+                    left = limit - count;
+                }
+                count += left;
+                fat_data.fbuff.clus_index += left;
+
+                if (fat_data.fbuff.clus_index >=
+                    fat_data.fgeom.secs_cluster)
+                {
+                    fat_data.fbuff.clus_index = 0;
+
+                    /* Get next cluster in the chain */
+                    cluster = fat_data.fbuff.next_cluster;
+                    fat_data.fbuff.next_cluster =
+                        get_next_cluster(cluster);
+                    if (fat_data.fbuff.next_cluster == 0xFFFFFFFF)
+                    {
+                        /* This is the last cluster */
+                        fat_data.cluster_last = TRUE;
+                        contig = FALSE;
+                    }
+                    else if (fat_data.fbuff.next_cluster == 0xFFFFFFFE)
+                    {
+                        /* Error, read the run so far and stop */
+                        good = FALSE;
+                        contig = FALSE;
+                    }
+                    else if (fat_data.fbuff.next_cluster != (cluster + 1))
+                    {
+                        contig = FALSE;
+                    }
+                }
+            }
+
+            /* Read the run into memory */
+            if (fat_read_sectors(buff, sector, count) == FALSE)
+            {
+                return bread;
+            }
+
+            buff += (count * 512);
+            bread += (INT_32) (count * 512);
+            fat_data.fbuff.tread += (count * 512);
+            limit -= count;
+        }
+    }
+
+    /* Read the rest through the cached sector */
+    if (good == TRUE)
+    {
+        bread += fat_data_cache_read(buff, bytes - bread);
+    }
+
+    return bread;
+}
+
 /***********************************************************************
  *
  * Function: fat_get_dir
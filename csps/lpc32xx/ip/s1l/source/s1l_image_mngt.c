@@ -609,9 +609,9 @@ BOOL_32 raw_load(FILE_DATA_T *fdata,
                  UNS_8 *filename,
                  SRC_LOAD_T src) 
 {
-	UNS_32 rb, bytes = 0;
+	UNS_32 bytes = 0;
 	UNS_8 ch, *ptr8 = (UNS_8 *) addr;
-	BOOL_32 readloop, loaded = FALSE;
+	BOOL_32 loaded = FALSE;
 
 	if (src == SRC_TERM) 
 	{
@@ -652,18 +652,8 @@ BOOL_32 raw_load(FILE_DATA_T *fdata,
 		}
 		else 
 		{
-			fdata->num_bytes = 0;
-			readloop = TRUE;
-			while (readloop == TRUE) 
-			{
-				rb = fat_file_read(ptr8, 8);
-				fdata->num_bytes += rb;
-				ptr8 += 8;
-				if (rb != 8) 
-				{
-					readloop = FALSE;
-				}
-			}
+			/* Read the whole file straight into memory */
+			fdata->num_bytes = fat_file_read_direct(ptr8, 0x7FFFFFFF);
 			fdata->contiguous = TRUE;
 			loaded = TRUE;
 		}
@@ -898,7 +888,7 @@ BOOL_32 nand_to_mem(UNS_32 starting_sector,
 					UNS_32 bytes)
 {
 	BOOL_32 blkchk;
-	UNS_32 block, page, sector, toread;
+	UNS_32 block, page, sector, toread, count;
 	UNS_8 str[16], *p8 = (UNS_8 *) buff;
 
 	if (sysinfo.nandgeom == NULL)
@@ -938,26 +928,50 @@ BOOL_32 nand_to_mem(UNS_32 starting_sector,
 			/* Convert to sector */
 			sector = conv_to_sector(block, page);
 
-			toread = bytes;
-			if (toread > sysinfo.nandgeom->data_bytes_per_page)
+			/* Whole pages left in this block go straight to memory */
+			count = bytes / sysinfo.nandgeom->data_bytes_per_page;
+			if (count > (sysinfo.nandgeom->pages_per_block - page))
 			{
-				toread = sysinfo.nandgeom->data_bytes_per_page;
+				count = sysinfo.nandgeom->pages_per_block - page;
 			}
 
-			/* Read sector data */
-			if (flash_read_sector(sector, secdat, NULL) <= 0)
+			if ((count > 0) && (((UNS_32) p8 & 0x3) == 0))
 			{
-				term_dat_out(readerr_msg);
-				str_makedec(str, sector);
-				term_dat_out_crlf(str);
+				toread = count * sysinfo.nandgeom->data_bytes_per_page;
+
+				/* Read sector data */
+				if (flash_read_sectors(sector, count, p8) <= 0)
+				{
+					term_dat_out(readerr_msg);
+					str_makedec(str, sector);
+					term_dat_out_crlf(str);
+				}
+			}
+			else
+			{
+				count = 1;
+				toread = bytes;
+				if (toread > sysinfo.nandgeom->data_bytes_per_page)
+				{
+					toread = sysinfo.nandgeom->data_bytes_per_page;
+				}
+
+				/* Read sector data */
+				if (flash_read_sector(sector, secdat, NULL) <= 0)
+				{
+					term_dat_out(readerr_msg);
+					str_makedec(str, sector);
+					term_dat_out_crlf(str);
+				}
+
+				memcpy(p8, secdat, toread);
 			}
 
-			memcpy(p8, secdat, toread);
 			p8 += toread;
 			bytes -= toread;
 
 			/* Next page and block */
-			page++;
+			page += count;
 			if (page >= sysinfo.nandgeom->pages_per_block)
 			{
 				page = 0;
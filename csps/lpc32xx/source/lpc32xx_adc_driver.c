@@ -28,12 +28,13 @@
  **********************************************************************/
 
 #include "lpc32xx_adc_driver.h"
+#include "lpc_ring.h"
 
 /***********************************************************************
  * ADC driver private data and types
  **********************************************************************/
 
-/* Size of the ADC receive ring buffer */
+/* Size of the ADC receive ring buffer in samples (power of 2) */
 #define ADC_RING_BUFSIZE 4
 
 /* Function prototype used for polled and interrupt driven reads */
@@ -44,9 +45,8 @@ typedef struct
 {
   BOOL_32 init;       			    /* Device initialized flag */
   LPC3250_ADCTSC_REGS_T *regptr; 	/* Pointer to ADC registers */
-  UNS_16 rx[ADC_RING_BUFSIZE];  	/* ADC data ring buffer */
-  INT_32 rx_head;     			    /* ADC ring buffer head index */
-  INT_32 rx_tail;     			    /* ADC ring buffer tail index */
+  UNS_16 rx[ADC_RING_BUFSIZE];  	/* ADC data ring buffer storage */
+  LPC_SPSC_RING_T rx_ring;  		/* ADC ring buffer */
 } ADC_CFG_T;
 
 /* ADC device configuration structure */
@@ -134,7 +134,7 @@ INT_32 adc_open(void *ipbase,
     adc_default(adccfg.regptr);
 
     /* Empty ring buffer and set conversion counter to 0 */
-    adccfg.rx_head = adccfg.rx_tail = 0;
+    lpc_ring_init(&adccfg.rx_ring, adccfg.rx, sizeof(adccfg.rx));
 
     /* set the channel for conversion */
     adccfg.regptr->adc_sel =  ADC_SEL_MASK;
@@ -286,7 +286,45 @@ INT_32 adc_read_result(INT_32 devid,
   return bytes;
 }
 
+/***********************************************************************
+ *
+ * Function: adc_read_ring
+ *
+ * Purpose: Reads data from the ADC ring buffer
+ *
+ * Processing:
+ *     If the init flag for the ADC structure is FALSE, return 0 to
+ *     the caller. Otherwise, get as many whole samples as fit in
+ *     max_bytes from the ring buffer into the user buffer and return
+ *     the number of bytes read to the caller.
+ *
+ * Parameters:
+ *     devid:     Pointer to an ADC configuration structure
+ *     buffer:    Pointer to data buffer to copy to
+ *     max_bytes: Number of bytes to read
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes actually read from the ring buffer
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+INT_32 adc_read_ring(INT_32 devid,
+                     void *buffer,
+                     INT_32 max_bytes)
+{
+  ADC_CFG_T *adccfgptr = (ADC_CFG_T *) devid;
+  INT_32 bytes = 0;
 
+  if ((adccfgptr->init == TRUE) && (max_bytes > 0))
+  {
+    bytes = (INT_32) lpc_ring_get(&adccfgptr->rx_ring, buffer,
+                                  (UNS_32) max_bytes & ~0x1);
+  }
+
+  return bytes;
+}
 
 /***********************************************************************
  *
@@ -324,10 +362,8 @@ INT_32 adc_write(INT_32 devid,
  * Purpose: Move data from the ADC DAT to the driver ring buffer
  *
  * Processing:
- *     While there is ADC Data, copy an entry from the ADC DAT into
- *     the ADC driver ring buffer. Increment the ring buffer
- *     head pointer. If it exceeds the ring buffer size, reset the
- *     head pointer to 0.
+ *     Copy the entry from the ADC DAT into the ADC driver ring buffer.
+ *     The entry is dropped if the ring buffer is full.
  *
  * Parameters:
  *     adccfgptr: Pointer to ADC config structure
@@ -343,18 +379,13 @@ STATIC void adc_ring_fill(ADC_CFG_T *adccfgptr)
 {
   LPC3250_ADCTSC_REGS_T *adcregsptr = 
       (LPC3250_ADCTSC_REGS_T *) adccfgptr->regptr;
+  UNS_16 sample;
 
   /* read in the 10 bit value */
-  adccfgptr->rx[adccfgptr->rx_head] =
-    (UNS_16) adcregsptr->adc_dat & TSC_ADCDAT_VALUE_MASK;
-
-  /* Increment receive ring buffer head pointer */
-  adccfgptr->rx_head++;
-  if (adccfgptr->rx_head >= ADC_RING_BUFSIZE)
-  {
-    adccfgptr->rx_head = 0;
-  }
+  sample = (UNS_16) adcregsptr->adc_dat & TSC_ADCDAT_VALUE_MASK;
 
+  /* Add it to the receive ring buffer */
+  lpc_ring_put(&adccfgptr->rx_ring, &sample, sizeof(sample));
 }
 /***********************************************************************
  *
@@ -23,6 +23,7 @@
 #include "lpc32xx_intc_driver.h"
 #include "lpc32xx_clkpwr_driver.h"
 #include "lpc_arm922t_cp15_driver.h"
+#include "lpc_pool.h"
 
 /***********************************************************************
  * DMA driver private data
@@ -31,6 +32,9 @@
 /* Number of DMA channels */
 #define DMA_MAX_CHANNELS 8
 
+/* Number of linked list entries in the driver entry pool */
+#define DMA_MAX_LINKS 32
+
 /* DMA driver control structure */
 typedef struct
 {
@@ -44,6 +48,12 @@ typedef struct
 /* DMAS driver data */
 static DMA_DRV_DATA_T dmadrv_dat;
 
+/* Linked list entry pool and its storage */
+static LPC_POOL_T dma_link_pool;
+static UNS_32 dma_link_storage [LPC_POOL_STORAGE_SIZE(DMA_MAX_LINKS,
+                                sizeof(DMAC_LL_T), sizeof(UNS_32)) /
+                                sizeof(UNS_32)];
+
 /***********************************************************************
  * DMA driver private functions
 ***********************************************************************/
@@ -120,7 +130,8 @@ void dma_interrupt(void)
  *
  * Processing:
  *     This function sets up the DMA controller as initially disabled.
- *     All DMA channels used by the driver are unallocated.
+ *     All DMA channels used by the driver are unallocated and all
+ *     linked list entries are returned to the entry pool.
  *
  * Parameters: None
  *
@@ -174,6 +185,11 @@ STATUS dma_init(void)
        enabled when one or moer channels are active. */
     clkpwr_clk_en_dis(CLKPWR_DMA_CLK, 0);
 
+    /* Setup the linked list entry pool */
+    lpc_pool_init(&dma_link_pool, dma_link_storage,
+                  sizeof(dma_link_storage), sizeof(DMAC_LL_T),
+                  sizeof(UNS_32));
+
     init = _NO_ERROR;
   }
 
@@ -470,6 +486,58 @@ void dma_setup_virt_link(DMAC_LL_T *plink,
   dma_setup_link_phy(plink, src_phy, dest_phy, dma_ctrl);
 }
 
+/***********************************************************************
+ *
+ * Function: dma_alloc_link
+ *
+ * Purpose: Get a linked list entry from the driver's entry pool
+ *
+ * Processing:
+ *     Pop an entry from the linked list entry pool.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Pointer to a free linked list entry, or NULL if all entries
+ *          are in use.
+ *
+ * Notes:
+ *     The allocation time is constant and the function can be used
+ *     from an interrupt handler. dma_init() must have been called.
+ *
+ **********************************************************************/
+DMAC_LL_T *dma_alloc_link(void)
+{
+  return (DMAC_LL_T *) lpc_pool_alloc(&dma_link_pool);
+}
+
+/***********************************************************************
+ *
+ * Function: dma_free_link
+ *
+ * Purpose: Return a linked list entry to the driver's entry pool
+ *
+ * Processing:
+ *     Push the entry back on the linked list entry pool.
+ *
+ * Parameters:
+ *     plink : Pointer to entry returned from dma_alloc_link()
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes:
+ *     An entry that is not in use, such as one already returned, is
+ *     ignored.
+ *
+ **********************************************************************/
+void dma_free_link(DMAC_LL_T *plink)
+{
+  lpc_pool_free(&dma_link_pool, plink);
+}
+
 /***********************************************************************
  *
  * Function: dma_get_base
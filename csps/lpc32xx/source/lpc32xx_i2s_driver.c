@@ -32,13 +32,14 @@
 #include "lpc32xx_gpio_driver.h"
 #include "lpc32xx_dma_driver.h"
 #include "lpc_irq_fiq.h"
+#include "lpc_ring.h"
 #include "lpc32xx_intc_driver.h"
 
 /***********************************************************************
  * I2S driver private data and types
  **********************************************************************/
 
-/* Size of the I2S receive ring buffer */
+/* Size of the I2S receive ring buffer in words (power of 2) */
 #define I2S_RING_BUFSIZE 64
 
 /* I2S device configuration structure type */
@@ -48,9 +49,8 @@ typedef struct
   INT_32 i2snum;                /* Used for array indicing, 0 = I2S0 */
   INT_32 i2s_w_sz;              /* i2s word size, 8,16 or 32 */
   I2S_REGS_T *regptr;           /* Pointer to I2S registers */
-  UNS_32 rx[I2S_RING_BUFSIZE];  /* I2S data ring buffer */
-  INT_32 rx_head;     	        /* I2S ring buffer head index */
-  INT_32 rx_tail;               /* I2S ring buffer tail index */
+  UNS_32 rx[I2S_RING_BUFSIZE];  /* I2S data ring buffer storage */
+  LPC_SPSC_RING_T rx_ring;      /* I2S ring buffer */
 } I2S_CFG_T;
 
 /* I2S driver data */
@@ -555,7 +555,8 @@ INT_32 i2s_open(void *ipbase,
       i2s_pin_mux(i2snum, 1);
 
       /* Empty ring buffer and set conversion counter to 0 */
-      i2sdat[i2snum].rx_head = i2sdat[i2snum].rx_tail = 0;
+      lpc_ring_init(&i2sdat[i2snum].rx_ring, i2sdat[i2snum].rx,
+                    sizeof(i2sdat[i2snum].rx));
 
       /* Return pointer to I2S configuration structure */
       status = (INT_32) & i2sdat[i2snum];
@@ -928,19 +929,11 @@ INT_32 i2s_write(INT_32 devid,
  *
  * Processing:
  *     If the init flag for the I2S structure is FALSE, return 0 to
- *     the caller. Otherwise, save the state of the I2S interrupts and
- *     disable the I2S interrupts. Loop until max_bytes equals 0 or
- *     until the receive ring buffer is empty, whichever comes
- *     first. Read the data from the ring buffer  indexed by the tail
- *     pointer and place it into the user buffer. Increment the tail
- *     pointer and user buffer pointer. If the tail pointer exceeds the
- *     buffer size, set the tail pointer to 0. Increment bytes, and
- *     decrement max_bytes. Exit the loop based on the loop conditions,
- *     re-enable the receive interrupts, and return the number of bytes
- *     read to the caller.
- *     Depending on the I2S Word Width, the function will read 8/16 or
- *     32bits of data at a time into the ring buffer and increment
- *     as appropriate
+ *     the caller. Otherwise, get as many whole 32-bit FIFO words as
+ *     fit in max_bytes from the ring buffer into the user buffer and
+ *     return the number of bytes read to the caller. The ring buffer
+ *     is only read here and only written by the interrupt, so the I2S
+ *     interrupt is not disabled.
  *
  * Parameters:
  *     devid:     Pointer to an I2S configuration structure
@@ -962,55 +955,11 @@ INT_32 i2s_read_ring(INT_32 devid,
   I2S_CFG_T *i2scfgptr = (I2S_CFG_T *) devid;
   INT_32 bytes = 0;
 
-  UNS_32 *data = (UNS_32 *) buffer;
-
-  if (i2scfgptr->init == TRUE)
+  if ((i2scfgptr->init == TRUE) && (max_bytes > 0))
   {
-    /* Temporarily lock out I2S interrupts during this
-       read so the I2S receive interrupt won't cause problems
-       with the ring buffer index values */
-    if (i2scfgptr->i2snum == I2S_CH0)
-    {
-      int_disable(IRQ_I2S0);
-    }
-    else if (i2scfgptr->i2snum == I2S_CH1)
-    {
-      int_disable(IRQ_I2S1);
-    }
-
-    /* Loop until receive ring buffer is empty or until max_bytes
-       expires */
-    while ((max_bytes > 0) &&
-           (i2scfgptr->rx_tail != i2scfgptr->rx_head))
-    {
-      /* Read data from ring buffer into user buffer */
-      *data = i2scfgptr->rx[i2scfgptr->rx_tail];
-      data++;
-
-      /* Update tail pointer */
-      i2scfgptr->rx_tail++;
-
-      /* Make sure tail didn't overflow */
-      if (i2scfgptr->rx_tail >= I2S_RING_BUFSIZE)
-      {
-        i2scfgptr->rx_tail = 0;
-      }
-
-      /* Increment data count and decrement buffer size count */
-      bytes = bytes + 4;
-      max_bytes = max_bytes - 4;
-    }
-
-    /* Re-enable I2S receive interrupt(s) */
-    if (i2scfgptr->i2snum == 0)
-    {
-      int_enable(IRQ_I2S0);
-    }
-    else if (i2scfgptr->i2snum == 1)
-    {
-      int_enable(IRQ_I2S1);
-    }
-
+    /* Copy whole words from the ring buffer into the user buffer */
+    bytes = (INT_32) lpc_ring_get(&i2scfgptr->rx_ring, buffer,
+                                  (UNS_32) max_bytes & ~0x3);
   }
 
   return bytes;
@@ -1023,10 +972,10 @@ INT_32 i2s_read_ring(INT_32 devid,
  * Purpose: Move data from the I2S DAT to the driver ring buffer
  *
  * Processing:
- *     While there is I2S FIFO data, copy an entry from the I2S FIFO into
- *     the IS2 driver ring buffer. Increment the ring buffer
- *     head pointer. If it exceeds the ring buffer size, reset the
- *     head pointer to 0.
+ *     While there is I2S FIFO data, reserve the free span of the I2S
+ *     driver ring buffer, read the entries from the I2S FIFO straight
+ *     into it and commit them to the ring buffer. Entries that do not
+ *     fit in the ring buffer are dropped.
  *
  * Parameters:
  *     i2scfgptr: Pointer to I2S config structure
@@ -1041,17 +990,30 @@ INT_32 i2s_read_ring(INT_32 devid,
 STATIC void i2s_ring_fill(I2S_CFG_T *i2scfgptr)
 {
   I2S_REGS_T *i2sregsptr = i2scfgptr->regptr;
+  UNS_32 *words;
+  UNS_32 count, space;
 
   /* Read from Rx FIFO until empty */
   while ((i2sregsptr->i2s_stat & I2S_RX_STATE_MASK) != 0)
   {
-    i2scfgptr->rx[i2scfgptr->rx_head] = i2sregsptr->i2s_rx_fifo;
-
-    /* Increment receive ring buffer head pointer */
-    i2scfgptr->rx_head++;
-    if (i2scfgptr->rx_head >= I2S_RING_BUFSIZE)
+    space = lpc_ring_reserve(&i2scfgptr->rx_ring, (void **) &words)
+            / sizeof(words[0]);
+    if (space == 0)
     {
-      i2scfgptr->rx_head = 0;
+      /* Ring buffer full, drop the entry */
+      (void) i2sregsptr->i2s_rx_fifo;
+    }
+    else
+    {
+      count = 0;
+      while ((count < space) &&
+             ((i2sregsptr->i2s_stat & I2S_RX_STATE_MASK) != 0))
+      {
+        words[count] = i2sregsptr->i2s_rx_fifo;
+        count++;
+      }
+
+      lpc_ring_commit(&i2scfgptr->rx_ring, count * sizeof(words[0]));
     }
   }
 }
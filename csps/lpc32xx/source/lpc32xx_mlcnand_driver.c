@@ -44,8 +44,12 @@ static MLCNAND_CFG_T mlcdat;
 /* device handle */
 static INT_32 dmach;
 
-/* DMA list */
-static DMAC_LL_T *dmalist;
+/* Maximum number of linked list entries used by one transfer */
+#define MLCNAND_DMA_MAX_LINKS 3
+
+/* DMA list, entries are taken from the DMA driver link pool */
+static DMAC_LL_T *dmalist[MLCNAND_DMA_MAX_LINKS];
+static INT_32 dmalinks;
 
 /* Pointer to DMA registers */
 static DMAC_REGS_T *pdmaregs;
@@ -142,6 +146,71 @@ void mlcnand_interrupt(void)
                                        MLC_INT_SWWP_FAULT)));
 }
 
+/***********************************************************************
+ *
+ * Function: mlcnand_dma_put_links
+ *
+ * Purpose: Return the linked list entries of a DMA transfer
+ *
+ * Processing:
+ *     Give each entry taken by mlcnand_dma_get_links() back to the DMA
+ *     driver link pool.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void mlcnand_dma_put_links(void)
+{
+  while (dmalinks > 0)
+  {
+    dmalinks--;
+    dma_free_link(dmalist[dmalinks]);
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: mlcnand_dma_get_links
+ *
+ * Purpose: Get the linked list entries for a DMA transfer
+ *
+ * Processing:
+ *     Take the requested number of entries from the DMA driver link
+ *     pool. If the pool runs out, return the entries already taken.
+ *
+ * Parameters:
+ *     count: Number of linked list entries needed
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if all entries were allocated, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS mlcnand_dma_get_links(INT_32 count)
+{
+  dmalinks = 0;
+  while (dmalinks < count)
+  {
+    dmalist[dmalinks] = dma_alloc_link();
+    if (dmalist[dmalinks] == NULL)
+    {
+      mlcnand_dma_put_links();
+      return _ERROR;
+    }
+    dmalinks++;
+  }
+
+  return _NO_ERROR;
+}
+
 /***********************************************************************
  *
  * Function: mlcnand_dma_read
@@ -155,6 +224,8 @@ void mlcnand_interrupt(void)
  *     devid: Pointer to MLC NAND controller config structure
  *     dmasrc: DMA src address
  *     dmadest: DMA dest address
+ *     dma: Not used, linked list entries are taken from the DMA
+ *          driver link pool
  *
  * Outputs: None
  *
@@ -170,12 +241,15 @@ STATUS mlcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
 
   dma_completion = FALSE;
 
-  dmalist = dma;
+  if (mlcnand_dma_get_links(1) != _NO_ERROR)
+  {
+    return _ERROR;
+  }
 
-  dmalist[0].dma_src = dmasrc;
-  dmalist[0].dma_dest = (UNS_32)dmadest;
-  dmalist[0].next_lli = 0;
-  dmalist[0].next_ctrl = ((SMALL_BLOCK_PAGE_SIZE / 4) |
+  dmalist[0]->dma_src = dmasrc;
+  dmalist[0]->dma_dest = (UNS_32)dmadest;
+  dmalist[0]->next_lli = 0;
+  dmalist[0]->next_ctrl = ((SMALL_BLOCK_PAGE_SIZE / 4) |
                     DMAC_CHAN_SRC_BURST_1 |
                     DMAC_CHAN_DEST_BURST_1 |
                     DMAC_CHAN_SRC_WIDTH_32 |
@@ -188,6 +262,7 @@ STATUS mlcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
   dmach = dma_alloc_channel(-1, (PFV) mlcnand_dma_interrupt);
   if (dmach < 0)
   {
+    mlcnand_dma_put_links();
     return _ERROR;
   }
 
@@ -195,10 +270,10 @@ STATUS mlcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
   pdmaregs = dma_get_base();
   pdmaregs->int_tc_clear = _BIT(dmach);
   pdmaregs->int_err_clear = _BIT(dmach);
-  pdmaregs->dma_chan[dmach].src_addr = dmalist[0].dma_src;
-  pdmaregs->dma_chan[dmach].dest_addr = dmalist[0].dma_dest;
-  pdmaregs->dma_chan[dmach].lli = (UNS_32)dmalist[0].next_lli;
-  pdmaregs->dma_chan[dmach].control = dmalist[0].next_ctrl;
+  pdmaregs->dma_chan[dmach].src_addr = dmalist[0]->dma_src;
+  pdmaregs->dma_chan[dmach].dest_addr = dmalist[0]->dma_dest;
+  pdmaregs->dma_chan[dmach].lli = dmalist[0]->next_lli;
+  pdmaregs->dma_chan[dmach].control = dmalist[0]->next_ctrl;
   pdmaregs->dma_chan[dmach].config_ch = DMAC_CHAN_ITC |
                     DMAC_CHAN_IE |
                     DMAC_CHAN_FLOW_D_P2M |
@@ -222,6 +297,8 @@ STATUS mlcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
  *     devid: Pointer to MLC NAND controller config structure
  *     dmasrc: DMA src address
  *     dmadest: DMA dest address
+ *     dma: Not used, linked list entries are taken from the DMA
+ *          driver link pool
  *
  * Outputs: None
  *
@@ -237,12 +314,15 @@ STATUS mlcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
 
   dma_completion = FALSE;
 
-  dmalist = dma;
+  if (mlcnand_dma_get_links(3) != _NO_ERROR)
+  {
+    return _ERROR;
+  }
 
-  dmalist[0].dma_src = (UNS_32)dmasrc;
-  dmalist[0].dma_dest = dmadest;
-  dmalist[0].next_lli = (UNS_32) & dmalist[1];
-  dmalist[0].next_ctrl = ((SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 4) |
+  dmalist[0]->dma_src = (UNS_32)dmasrc;
+  dmalist[0]->dma_dest = dmadest;
+  dmalist[0]->next_lli = (UNS_32) dmalist[1];
+  dmalist[0]->next_ctrl = ((SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 4) |
                     DMAC_CHAN_SRC_BURST_1 |
                     DMAC_CHAN_DEST_BURST_1 |
                     DMAC_CHAN_SRC_WIDTH_32 |
@@ -251,11 +331,11 @@ STATUS mlcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_SRC_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-  dmalist[1].dma_src = (UNS_32)(dmasrc +
+  dmalist[1]->dma_src = (UNS_32)(dmasrc +
                     SMALL_BLOCK_PAGE_MAIN_AREA_SIZE);
-  dmalist[1].dma_dest = dmadest;
-  dmalist[1].next_lli = (UNS_32) & dmalist[2];
-  dmalist[1].next_ctrl = (1 |
+  dmalist[1]->dma_dest = dmadest;
+  dmalist[1]->next_lli = (UNS_32) dmalist[2];
+  dmalist[1]->next_ctrl = (1 |
                     DMAC_CHAN_SRC_BURST_1 |
                     DMAC_CHAN_DEST_BURST_1 |
                     DMAC_CHAN_SRC_WIDTH_32 |
@@ -264,11 +344,11 @@ STATUS mlcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_SRC_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-  dmalist[2].dma_src = (UNS_32)(dmasrc +
+  dmalist[2]->dma_src = (UNS_32)(dmasrc +
                     SMALL_BLOCK_PAGE_MAIN_AREA_SIZE + 4);
-  dmalist[2].dma_dest = dmadest;
-  dmalist[2].next_lli = 0;
-  dmalist[2].next_ctrl = (1 |
+  dmalist[2]->dma_dest = dmadest;
+  dmalist[2]->next_lli = 0;
+  dmalist[2]->next_ctrl = (1 |
                     DMAC_CHAN_SRC_BURST_1 |
                     DMAC_CHAN_DEST_BURST_1 |
                     DMAC_CHAN_SRC_WIDTH_16 |
@@ -281,6 +361,7 @@ STATUS mlcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
   dmach = dma_alloc_channel(-1, (PFV) mlcnand_dma_interrupt);
   if (dmach < 0)
   {
+    mlcnand_dma_put_links();
     return _ERROR;
   }
 
@@ -288,10 +369,10 @@ STATUS mlcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
   pdmaregs = dma_get_base();
   pdmaregs->int_tc_clear = _BIT(dmach);
   pdmaregs->int_err_clear = _BIT(dmach);
-  pdmaregs->dma_chan[dmach].src_addr = dmalist[0].dma_src;
-  pdmaregs->dma_chan[dmach].dest_addr = dmalist[0].dma_dest;
-  pdmaregs->dma_chan[dmach].lli = (UNS_32)dmalist[0].next_lli;
-  pdmaregs->dma_chan[dmach].control = dmalist[0].next_ctrl;
+  pdmaregs->dma_chan[dmach].src_addr = dmalist[0]->dma_src;
+  pdmaregs->dma_chan[dmach].dest_addr = dmalist[0]->dma_dest;
+  pdmaregs->dma_chan[dmach].lli = dmalist[0]->next_lli;
+  pdmaregs->dma_chan[dmach].control = dmalist[0]->next_ctrl;
   pdmaregs->dma_chan[dmach].config_ch = DMAC_CHAN_ITC |
                     DMAC_CHAN_IE |
                     DMAC_CHAN_FLOW_D_M2M |
@@ -719,9 +800,12 @@ STATUS mlcnand_read_page(INT_32 devid, MLC_BLOCKPAGE_T *blockpage)
         clkpwr_setup_nand_ctrlr(0, 0, 1);
 
         dwptr = (UNS_32 *)blockpage->buffer;
-        mlcnand_dma_read(devid,
+        if (mlcnand_dma_read(devid,
                     (UNS_32)&mlcdat.regptr->mlc_buff[0],
-                    (UNS_32)dwptr, blockpage->dma);
+                    (UNS_32)dwptr, blockpage->dma) != _NO_ERROR)
+        {
+          return _ERROR;
+        }
 
         /* ECC Auto Decode */
         mlcdat.regptr->mlc_autodec_dec = 0;
@@ -739,8 +823,9 @@ STATUS mlcnand_read_page(INT_32 devid, MLC_BLOCKPAGE_T *blockpage)
           status = _ERROR;
         }
 
-        /* release the DMA Channel */
+        /* release the DMA Channel and its linked list entries */
         dma_free_channel(dmach);
+        mlcnand_dma_put_links();
 
         /* Wait for MLC NAND ready */
         while (!(mlcdat.regptr->mlc_isr & MLC_DEV_RDY_STS));
@@ -854,9 +939,12 @@ STATUS mlcnand_read_page(INT_32 devid, MLC_BLOCKPAGE_T *blockpage)
 
           dwptr = (UNS_32 *)(blockpage->buffer +
                     (LARGE_BLOCK_PAGE_SIZE / 4) * idy);
-          mlcnand_dma_read(devid,
+          if (mlcnand_dma_read(devid,
                     (UNS_32)&mlcdat.regptr->mlc_buff[0],
-                    (UNS_32)dwptr, blockpage->dma);
+                    (UNS_32)dwptr, blockpage->dma) != _NO_ERROR)
+          {
+            return _ERROR;
+          }
 
           /* ECC Auto Decode */
           mlcdat.regptr->mlc_autodec_dec = 0;
@@ -874,8 +962,9 @@ STATUS mlcnand_read_page(INT_32 devid, MLC_BLOCKPAGE_T *blockpage)
             status = _ERROR;
           }
 
-          /* release the DMA Channel */
+          /* release the DMA Channel and its linked list entries */
           dma_free_channel(dmach);
+          mlcnand_dma_put_links();
         }
 
         /* Wait for MLC NAND ready */
@@ -1036,9 +1125,12 @@ STATUS mlcnand_write_page(INT_32 devid, MLC_BLOCKPAGE_T *blockpage)
         mlcdat.regptr->mlc_enc_ecc = 0;
 
         dwptr = (UNS_32 *)blockpage->buffer;
-        mlcnand_dma_write(devid, (UNS_32)dwptr,
+        if (mlcnand_dma_write(devid, (UNS_32)dwptr,
                     (UNS_32)&mlcdat.regptr->mlc_buff[0],
-                    blockpage->dma);
+                    blockpage->dma) != _NO_ERROR)
+        {
+          return _ERROR;
+        }
 
         /* Wait for completion of DMA */
         while (dma_completion == FALSE);
@@ -1049,8 +1141,9 @@ STATUS mlcnand_write_page(INT_32 devid, MLC_BLOCKPAGE_T *blockpage)
         /* Wait for MLC NAND controller ready */
         while (!(mlcdat.regptr->mlc_isr & MLC_CNTRLLR_RDY_STS));
 
-        /* release the DMA Channel */
+        /* release the DMA Channel and its linked list entries */
         dma_free_channel(dmach);
+        mlcnand_dma_put_links();
 
         /* Auto program command */
         mlcdat.regptr->mlc_cmd = NAND_CMD_PAGEPROG;
@@ -1157,9 +1250,12 @@ STATUS mlcnand_write_page(INT_32 devid, MLC_BLOCKPAGE_T *blockpage)
 
           dwptr = (UNS_32 *)(blockpage->buffer +
                     (LARGE_BLOCK_PAGE_SIZE / 4) * idy);
-          mlcnand_dma_write(devid, (UNS_32)dwptr,
+          if (mlcnand_dma_write(devid, (UNS_32)dwptr,
                     (UNS_32)&mlcdat.regptr->mlc_buff[0],
-                    blockpage->dma);
+                    blockpage->dma) != _NO_ERROR)
+          {
+            return _ERROR;
+          }
 
           /* Wait for completion of DMA */
           while (dma_completion == FALSE);
@@ -1170,8 +1266,9 @@ STATUS mlcnand_write_page(INT_32 devid, MLC_BLOCKPAGE_T *blockpage)
           /* Wait for MLC NAND controller ready */
           while (!(mlcdat.regptr->mlc_isr & MLC_CNTRLLR_RDY_STS));
 
-          /* release the DMA Channel */
+          /* release the DMA Channel and its linked list entries */
           dma_free_channel(dmach);
+          mlcnand_dma_put_links();
         }
 
         /* Auto program command */
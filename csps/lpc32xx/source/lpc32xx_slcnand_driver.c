@@ -47,8 +47,12 @@ static UNS_32 *ECC;
 /* device handle */
 static INT_32 dmach;
 
-/* DMA list */
-static DMAC_LL_T *dmalist;
+/* Maximum number of linked list entries used by one transfer */
+#define SLCNAND_DMA_MAX_LINKS 17
+
+/* DMA list, entries are taken from the DMA driver link pool */
+static DMAC_LL_T *dmalist[SLCNAND_DMA_MAX_LINKS];
+static INT_32 dmalinks;
 
 /* Pointer to DMA registers */
 static DMAC_REGS_T *pdmaregs;
@@ -143,6 +147,113 @@ void slcnand_interrupt(void)
   }
 }
 
+/***********************************************************************
+ *
+ * Function: slcnand_dma_put_links
+ *
+ * Purpose: Return the linked list entries of a DMA transfer
+ *
+ * Processing:
+ *     Give each entry taken by slcnand_dma_get_links() back to the DMA
+ *     driver link pool.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void slcnand_dma_put_links(void)
+{
+  while (dmalinks > 0)
+  {
+    dmalinks--;
+    dma_free_link(dmalist[dmalinks]);
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: slcnand_dma_get_links
+ *
+ * Purpose: Get the linked list entries for a DMA transfer
+ *
+ * Processing:
+ *     Take the requested number of entries from the DMA driver link
+ *     pool. If the pool runs out, return the entries already taken.
+ *
+ * Parameters:
+ *     count: Number of linked list entries needed
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if all entries were allocated, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS slcnand_dma_get_links(INT_32 count)
+{
+  dmalinks = 0;
+  while (dmalinks < count)
+  {
+    dmalist[dmalinks] = dma_alloc_link();
+    if (dmalist[dmalinks] == NULL)
+    {
+      slcnand_dma_put_links();
+      return _ERROR;
+    }
+    dmalinks++;
+  }
+
+  return _NO_ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: slcnand_dma_count
+ *
+ * Purpose: Return the number of linked list entries for a page transfer
+ *
+ * Processing:
+ *     A small page transfer uses two main area entries and a spare area
+ *     entry, a large page transfer eight and one. Each main area entry
+ *     pair is followed by an ECC entry when hardware ECC is used.
+ *
+ * Parameters:
+ *     ecc: ECC buffer, or 0 if hardware ECC is not used
+ *
+ * Outputs: None
+ *
+ * Returns: The number of linked list entries needed
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 slcnand_dma_count(UNS_32 *ecc)
+{
+  INT_32 count;
+
+  if (slcdat.paramptr->block_page == BLOCK_PAGE_SMALL)
+  {
+    count = 3;
+  }
+  else
+  {
+    count = 9;
+  }
+
+  if (ecc != 0)
+  {
+    count += (count - 1);
+  }
+
+  return count;
+}
+
 /***********************************************************************
  *
  * Function: slcnand_dma_read
@@ -157,6 +268,8 @@ void slcnand_interrupt(void)
  *     devid: Pointer to SLC NAND controller config structure
  *     dmasrc: DMA src address
  *     dmadest: DMA dest address
+ *     dma: Not used, linked list entries are taken from the DMA
+ *          driver link pool
  *     ecc: ECC ECC enable(TRUE)/disable(FALSE)
  *
  * Outputs: None
@@ -174,7 +287,10 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
 
   dma_completion = FALSE;
 
-  dmalist = dma;
+  if (slcnand_dma_get_links(slcnand_dma_count(ecc)) != _NO_ERROR)
+  {
+    return _ERROR;
+  }
 
   ECC = ecc;
 
@@ -182,10 +298,10 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
   {
     if (ecc != 0)
     {
-      dmalist[0].dma_src = dmasrc;
-      dmalist[0].dma_dest = (UNS_32)dmadest;
-      dmalist[0].next_lli = (UNS_32) & dmalist[1];
-      dmalist[0].next_ctrl = (
+      dmalist[0]->dma_src = dmasrc;
+      dmalist[0]->dma_dest = (UNS_32)dmadest;
+      dmalist[0]->next_lli = (UNS_32) dmalist[1];
+      dmalist[0]->next_ctrl = (
                     ((SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 2) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -195,10 +311,10 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-      dmalist[1].dma_src = (UNS_32) & slcdat.regptr->slc_ecc;
-      dmalist[1].dma_dest = (UNS_32) & ECC[0];
-      dmalist[1].next_lli = (UNS_32) & dmalist[2];
-      dmalist[1].next_ctrl = (0x1 |
+      dmalist[1]->dma_src = (UNS_32) & slcdat.regptr->slc_ecc;
+      dmalist[1]->dma_dest = (UNS_32) & ECC[0];
+      dmalist[1]->next_lli = (UNS_32) dmalist[2];
+      dmalist[1]->next_ctrl = (0x1 |
                     DMAC_CHAN_SRC_BURST_1 |
                     DMAC_CHAN_DEST_BURST_1 |
                     DMAC_CHAN_SRC_WIDTH_32 |
@@ -206,11 +322,11 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AHB1 |
                     DMAC_CHAN_INT_TC_EN);
 
-      dmalist[2].dma_src = dmasrc;
-      dmalist[2].dma_dest = (UNS_32)(dmadest +
+      dmalist[2]->dma_src = dmasrc;
+      dmalist[2]->dma_dest = (UNS_32)(dmadest +
                     (SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 2));
-      dmalist[2].next_lli = (UNS_32) & dmalist[3];
-      dmalist[2].next_ctrl = (
+      dmalist[2]->next_lli = (UNS_32) dmalist[3];
+      dmalist[2]->next_ctrl = (
                     ((SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 2) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -220,10 +336,10 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-      dmalist[3].dma_src = (UNS_32) & slcdat.regptr->slc_ecc;
-      dmalist[3].dma_dest = (UNS_32) & ECC[1];
-      dmalist[3].next_lli = (UNS_32) & dmalist[4];
-      dmalist[3].next_ctrl = (0x1 |
+      dmalist[3]->dma_src = (UNS_32) & slcdat.regptr->slc_ecc;
+      dmalist[3]->dma_dest = (UNS_32) & ECC[1];
+      dmalist[3]->next_lli = (UNS_32) dmalist[4];
+      dmalist[3]->next_ctrl = (0x1 |
                     DMAC_CHAN_SRC_BURST_1 |
                     DMAC_CHAN_DEST_BURST_1 |
                     DMAC_CHAN_SRC_WIDTH_32 |
@@ -231,11 +347,11 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AHB1 |
                     DMAC_CHAN_INT_TC_EN);
 
-      dmalist[4].dma_src = dmasrc;
-      dmalist[4].dma_dest = (UNS_32)(dmadest +
+      dmalist[4]->dma_src = dmasrc;
+      dmalist[4]->dma_dest = (UNS_32)(dmadest +
                     SMALL_BLOCK_PAGE_MAIN_AREA_SIZE);
-      dmalist[4].next_lli = 0;
-      dmalist[4].next_ctrl = (
+      dmalist[4]->next_lli = 0;
+      dmalist[4]->next_ctrl = (
                     (SMALL_BLOCK_PAGE_SPARE_AREA_SIZE / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -247,10 +363,10 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
     }
     else
     {
-      dmalist[0].dma_src = dmasrc;
-      dmalist[0].dma_dest = (UNS_32)dmadest;
-      dmalist[0].next_lli = (UNS_32) & dmalist[1];
-      dmalist[0].next_ctrl = (
+      dmalist[0]->dma_src = dmasrc;
+      dmalist[0]->dma_dest = (UNS_32)dmadest;
+      dmalist[0]->next_lli = (UNS_32) dmalist[1];
+      dmalist[0]->next_ctrl = (
                     ((SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 2) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -260,11 +376,11 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-      dmalist[1].dma_src = dmasrc;
-      dmalist[1].dma_dest = (UNS_32)(dmadest +
+      dmalist[1]->dma_src = dmasrc;
+      dmalist[1]->dma_dest = (UNS_32)(dmadest +
                     (SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 2));
-      dmalist[1].next_lli = (UNS_32) & dmalist[2];
-      dmalist[1].next_ctrl = (
+      dmalist[1]->next_lli = (UNS_32) dmalist[2];
+      dmalist[1]->next_ctrl = (
                     ((SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 2) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -274,11 +390,11 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-      dmalist[2].dma_src = dmasrc;
-      dmalist[2].dma_dest = (UNS_32)(dmadest +
+      dmalist[2]->dma_src = dmasrc;
+      dmalist[2]->dma_dest = (UNS_32)(dmadest +
                     SMALL_BLOCK_PAGE_MAIN_AREA_SIZE);
-      dmalist[2].next_lli = 0;
-      dmalist[2].next_ctrl = (
+      dmalist[2]->next_lli = 0;
+      dmalist[2]->next_ctrl = (
                     (SMALL_BLOCK_PAGE_SPARE_AREA_SIZE / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -295,11 +411,11 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
     {
       for (idx = 0; idx < 4; idx++)
       {
-        dmalist[idx*4].dma_src = dmasrc;
-        dmalist[idx*4].dma_dest = (UNS_32)(dmadest +
+        dmalist[idx*4]->dma_src = dmasrc;
+        dmalist[idx*4]->dma_dest = (UNS_32)(dmadest +
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) * (idx * 2)));
-        dmalist[idx*4].next_lli = (UNS_32) & dmalist[(idx*4)+1];
-        dmalist[idx*4].next_ctrl = (
+        dmalist[idx*4]->next_lli = (UNS_32) dmalist[(idx*4)+1];
+        dmalist[idx*4]->next_ctrl = (
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -309,12 +425,12 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-        dmalist[(idx*4)+1].dma_src = (UNS_32)
+        dmalist[(idx*4)+1]->dma_src = (UNS_32)
                     & slcdat.regptr->slc_ecc;
-        dmalist[(idx*4)+1].dma_dest = (UNS_32) & ECC[idx*2];
-        dmalist[(idx*4)+1].next_lli =
-                    (UNS_32) & dmalist[(idx*4)+2];
-        dmalist[(idx*4)+1].next_ctrl = (0x1 |
+        dmalist[(idx*4)+1]->dma_dest = (UNS_32) & ECC[idx*2];
+        dmalist[(idx*4)+1]->next_lli =
+                    (UNS_32) dmalist[(idx*4)+2];
+        dmalist[(idx*4)+1]->next_ctrl = (0x1 |
                     DMAC_CHAN_SRC_BURST_1 |
                     DMAC_CHAN_DEST_BURST_1 |
                     DMAC_CHAN_SRC_WIDTH_32 |
@@ -322,13 +438,13 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AHB1 |
                     DMAC_CHAN_INT_TC_EN);
 
-        dmalist[(idx*4)+2].dma_src = dmasrc;
-        dmalist[(idx*4)+2].dma_dest = (UNS_32)(dmadest +
+        dmalist[(idx*4)+2]->dma_src = dmasrc;
+        dmalist[(idx*4)+2]->dma_dest = (UNS_32)(dmadest +
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) *
                     ((idx * 2) + 1)));
-        dmalist[(idx*4)+2].next_lli =
-                    (UNS_32) & dmalist[(idx*4)+3];
-        dmalist[(idx*4)+2].next_ctrl = (
+        dmalist[(idx*4)+2]->next_lli =
+                    (UNS_32) dmalist[(idx*4)+3];
+        dmalist[(idx*4)+2]->next_ctrl = (
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -338,12 +454,12 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-        dmalist[(idx*4)+3].dma_src = (UNS_32)
+        dmalist[(idx*4)+3]->dma_src = (UNS_32)
                     & slcdat.regptr->slc_ecc;
-        dmalist[(idx*4)+3].dma_dest = (UNS_32) & ECC[(idx*2)+1];
-        dmalist[(idx*4)+3].next_lli =
-                    (UNS_32) & dmalist[(idx*4)+4];
-        dmalist[(idx*4)+3].next_ctrl = (0x1 |
+        dmalist[(idx*4)+3]->dma_dest = (UNS_32) & ECC[(idx*2)+1];
+        dmalist[(idx*4)+3]->next_lli =
+                    (UNS_32) dmalist[(idx*4)+4];
+        dmalist[(idx*4)+3]->next_ctrl = (0x1 |
                     DMAC_CHAN_SRC_BURST_1 |
                     DMAC_CHAN_DEST_BURST_1 |
                     DMAC_CHAN_SRC_WIDTH_32 |
@@ -351,11 +467,11 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AHB1 |
                     DMAC_CHAN_INT_TC_EN);
       }
-      dmalist[idx*4].dma_src = dmasrc;
-      dmalist[idx*4].dma_dest = (UNS_32)(dmadest +
+      dmalist[idx*4]->dma_src = dmasrc;
+      dmalist[idx*4]->dma_dest = (UNS_32)(dmadest +
                     LARGE_BLOCK_PAGE_MAIN_AREA_SIZE);
-      dmalist[idx*4].next_lli = 0;
-      dmalist[idx*4].next_ctrl = (
+      dmalist[idx*4]->next_lli = 0;
+      dmalist[idx*4]->next_ctrl = (
                     (LARGE_BLOCK_PAGE_SPARE_AREA_SIZE / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -369,11 +485,11 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
     {
       for (idx = 0; idx < 4; idx++)
       {
-        dmalist[idx*2].dma_src = dmasrc;
-        dmalist[idx*2].dma_dest = (UNS_32)(dmadest +
+        dmalist[idx*2]->dma_src = dmasrc;
+        dmalist[idx*2]->dma_dest = (UNS_32)(dmadest +
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) * (idx * 2)));
-        dmalist[idx*2].next_lli = (UNS_32) & dmalist[(idx*2)+1];
-        dmalist[idx*2].next_ctrl = (
+        dmalist[idx*2]->next_lli = (UNS_32) dmalist[(idx*2)+1];
+        dmalist[idx*2]->next_ctrl = (
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -383,13 +499,13 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-        dmalist[(idx*2)+1].dma_src = dmasrc;
-        dmalist[(idx*2)+1].dma_dest = (UNS_32)(dmadest +
+        dmalist[(idx*2)+1]->dma_src = dmasrc;
+        dmalist[(idx*2)+1]->dma_dest = (UNS_32)(dmadest +
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) *
                     ((idx * 2) + 1)));
-        dmalist[(idx*2)+1].next_lli =
-                    (UNS_32) & dmalist[(idx*2)+2];
-        dmalist[(idx*2)+1].next_ctrl = (
+        dmalist[(idx*2)+1]->next_lli =
+                    (UNS_32) dmalist[(idx*2)+2];
+        dmalist[(idx*2)+1]->next_ctrl = (
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -399,11 +515,11 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
       }
-      dmalist[idx*2].dma_src = dmasrc;
-      dmalist[idx*2].dma_dest = (UNS_32)(dmadest +
+      dmalist[idx*2]->dma_src = dmasrc;
+      dmalist[idx*2]->dma_dest = (UNS_32)(dmadest +
                     LARGE_BLOCK_PAGE_MAIN_AREA_SIZE);
-      dmalist[idx*2].next_lli = 0;
-      dmalist[idx*2].next_ctrl = (
+      dmalist[idx*2]->next_lli = 0;
+      dmalist[idx*2]->next_ctrl = (
                     (LARGE_BLOCK_PAGE_SPARE_AREA_SIZE / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -419,6 +535,7 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
   dmach = dma_alloc_channel(-1, (PFV) slcnand_dma_interrupt);
   if (dmach < 0)
   {
+    slcnand_dma_put_links();
     return _ERROR;
   }
 
@@ -426,10 +543,10 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
   pdmaregs = dma_get_base();
   pdmaregs->int_tc_clear = _BIT(dmach);
   pdmaregs->int_err_clear = _BIT(dmach);
-  pdmaregs->dma_chan[dmach].src_addr = dmalist[0].dma_src;
-  pdmaregs->dma_chan[dmach].dest_addr = dmalist[0].dma_dest;
-  pdmaregs->dma_chan[dmach].lli = (UNS_32)dmalist[0].next_lli;
-  pdmaregs->dma_chan[dmach].control = dmalist[0].next_ctrl;
+  pdmaregs->dma_chan[dmach].src_addr = dmalist[0]->dma_src;
+  pdmaregs->dma_chan[dmach].dest_addr = dmalist[0]->dma_dest;
+  pdmaregs->dma_chan[dmach].lli = dmalist[0]->next_lli;
+  pdmaregs->dma_chan[dmach].control = dmalist[0]->next_ctrl;
   pdmaregs->dma_chan[dmach].config_ch = DMAC_CHAN_ITC |
                     DMAC_CHAN_IE |
                     DMAC_CHAN_FLOW_D_P2M |
@@ -454,6 +571,8 @@ STATUS slcnand_dma_read(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
  *     devid: Pointer to SLC NAND controller config structure
  *     dmasrc: DMA src address
  *     dmadest: DMA dest address
+ *     dma: Not used, linked list entries are taken from the DMA
+ *          driver link pool
  *     ecc: ECC ECC enable(TRUE)/disable(FALSE)
  *
  * Outputs: None
@@ -471,16 +590,19 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
 
   dma_completion = FALSE;
 
-  dmalist = dma;
+  if (slcnand_dma_get_links(slcnand_dma_count(ecc)) != _NO_ERROR)
+  {
+    return _ERROR;
+  }
 
   if (slcdat.paramptr->block_page == BLOCK_PAGE_SMALL)
   {
     if (ecc != 0)
     {
-      dmalist[0].dma_src = (UNS_32)dmasrc;
-      dmalist[0].dma_dest = dmadest;
-      dmalist[0].next_lli = (UNS_32) & dmalist[1];
-      dmalist[0].next_ctrl = (
+      dmalist[0]->dma_src = (UNS_32)dmasrc;
+      dmalist[0]->dma_dest = dmadest;
+      dmalist[0]->next_lli = (UNS_32) dmalist[1];
+      dmalist[0]->next_ctrl = (
                     ((SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 2) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -490,11 +612,11 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_SRC_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-      dmalist[1].dma_src = (UNS_32)(dmasrc +
+      dmalist[1]->dma_src = (UNS_32)(dmasrc +
                     (SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 2));
-      dmalist[1].dma_dest = dmadest;
-      dmalist[1].next_lli = (UNS_32) & dmalist[2];
-      dmalist[1].next_ctrl = (
+      dmalist[1]->dma_dest = dmadest;
+      dmalist[1]->next_lli = (UNS_32) dmalist[2];
+      dmalist[1]->next_ctrl = (
                     ((SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 2) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -504,11 +626,11 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_SRC_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-      dmalist[2].dma_src = (UNS_32) & slcdat.regptr->slc_ecc;
-      dmalist[2].dma_dest = (UNS_32)(dmasrc +
+      dmalist[2]->dma_src = (UNS_32) & slcdat.regptr->slc_ecc;
+      dmalist[2]->dma_dest = (UNS_32)(dmasrc +
                     SMALL_BLOCK_PAGE_1ST_ECC);
-      dmalist[2].next_lli = (UNS_32) & dmalist[3];
-      dmalist[2].next_ctrl = (0x1 |
+      dmalist[2]->next_lli = (UNS_32) dmalist[3];
+      dmalist[2]->next_ctrl = (0x1 |
                     DMAC_CHAN_SRC_BURST_1 |
                     DMAC_CHAN_DEST_BURST_1 |
                     DMAC_CHAN_SRC_WIDTH_32 |
@@ -516,11 +638,11 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AHB1 |
                     DMAC_CHAN_INT_TC_EN);
 
-      dmalist[3].dma_src = (UNS_32) & slcdat.regptr->slc_ecc;
-      dmalist[3].dma_dest = (UNS_32)(dmasrc +
+      dmalist[3]->dma_src = (UNS_32) & slcdat.regptr->slc_ecc;
+      dmalist[3]->dma_dest = (UNS_32)(dmasrc +
                     SMALL_BLOCK_PAGE_2ND_ECC);
-      dmalist[3].next_lli = (UNS_32) & dmalist[4];
-      dmalist[3].next_ctrl = (0x1 |
+      dmalist[3]->next_lli = (UNS_32) dmalist[4];
+      dmalist[3]->next_ctrl = (0x1 |
                     DMAC_CHAN_SRC_BURST_1 |
                     DMAC_CHAN_DEST_BURST_1 |
                     DMAC_CHAN_SRC_WIDTH_32 |
@@ -528,11 +650,11 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AHB1 |
                     DMAC_CHAN_INT_TC_EN);
 
-      dmalist[4].dma_src = (UNS_32)(dmasrc +
+      dmalist[4]->dma_src = (UNS_32)(dmasrc +
                     SMALL_BLOCK_PAGE_MAIN_AREA_SIZE);
-      dmalist[4].dma_dest = dmadest;
-      dmalist[4].next_lli = 0;
-      dmalist[4].next_ctrl = (
+      dmalist[4]->dma_dest = dmadest;
+      dmalist[4]->next_lli = 0;
+      dmalist[4]->next_ctrl = (
                     (SMALL_BLOCK_PAGE_SPARE_AREA_SIZE / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -544,10 +666,10 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
     }
     else
     {
-      dmalist[0].dma_src = (UNS_32)dmasrc;
-      dmalist[0].dma_dest = dmadest;
-      dmalist[0].next_lli = (UNS_32) & dmalist[1];
-      dmalist[0].next_ctrl = (
+      dmalist[0]->dma_src = (UNS_32)dmasrc;
+      dmalist[0]->dma_dest = dmadest;
+      dmalist[0]->next_lli = (UNS_32) dmalist[1];
+      dmalist[0]->next_ctrl = (
                     ((SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 2) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -557,11 +679,11 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_SRC_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-      dmalist[1].dma_src = (UNS_32)(dmasrc +
+      dmalist[1]->dma_src = (UNS_32)(dmasrc +
                     (SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 2));
-      dmalist[1].dma_dest = dmadest;
-      dmalist[1].next_lli = (UNS_32) & dmalist[2];
-      dmalist[1].next_ctrl = (
+      dmalist[1]->dma_dest = dmadest;
+      dmalist[1]->next_lli = (UNS_32) dmalist[2];
+      dmalist[1]->next_ctrl = (
                     ((SMALL_BLOCK_PAGE_MAIN_AREA_SIZE / 2) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -571,11 +693,11 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_SRC_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-      dmalist[2].dma_src = (UNS_32)(dmasrc +
+      dmalist[2]->dma_src = (UNS_32)(dmasrc +
                     SMALL_BLOCK_PAGE_MAIN_AREA_SIZE);
-      dmalist[2].dma_dest = dmadest;
-      dmalist[2].next_lli = 0;
-      dmalist[2].next_ctrl = (
+      dmalist[2]->dma_dest = dmadest;
+      dmalist[2]->next_lli = 0;
+      dmalist[2]->next_ctrl = (
                     (SMALL_BLOCK_PAGE_SPARE_AREA_SIZE / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -592,11 +714,11 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
     {
       for (idx = 0; idx < 4; idx++)
       {
-        dmalist[idx*4].dma_src = (UNS_32)(dmasrc +
+        dmalist[idx*4]->dma_src = (UNS_32)(dmasrc +
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) * (idx * 2)));
-        dmalist[idx*4].dma_dest = dmadest;
-        dmalist[idx*4].next_lli = (UNS_32) & dmalist[(idx*4)+1];
-        dmalist[idx*4].next_ctrl = (
+        dmalist[idx*4]->dma_dest = dmadest;
+        dmalist[idx*4]->next_lli = (UNS_32) dmalist[(idx*4)+1];
+        dmalist[idx*4]->next_ctrl = (
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -606,13 +728,13 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_SRC_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-        dmalist[(idx*4)+1].dma_src = (UNS_32)(dmasrc +
+        dmalist[(idx*4)+1]->dma_src = (UNS_32)(dmasrc +
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) *
                     ((idx * 2) + 1)));
-        dmalist[(idx*4)+1].dma_dest = dmadest;
-        dmalist[(idx*4)+1].next_lli =
-                    (UNS_32) & dmalist[(idx*4)+2];
-        dmalist[(idx*4)+1].next_ctrl = (
+        dmalist[(idx*4)+1]->dma_dest = dmadest;
+        dmalist[(idx*4)+1]->next_lli =
+                    (UNS_32) dmalist[(idx*4)+2];
+        dmalist[(idx*4)+1]->next_ctrl = (
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -622,13 +744,13 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_SRC_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-        dmalist[(idx*4)+2].dma_src = (UNS_32)
+        dmalist[(idx*4)+2]->dma_src = (UNS_32)
                     & slcdat.regptr->slc_ecc;
-        dmalist[(idx*4)+2].dma_dest = (UNS_32)(dmasrc +
+        dmalist[(idx*4)+2]->dma_dest = (UNS_32)(dmasrc +
                     LARGE_BLOCK_PAGE_1ST_ECC(idx));
-        dmalist[(idx*4)+2].next_lli =
-                    (UNS_32) & dmalist[(idx*4)+3];
-        dmalist[(idx*4)+2].next_ctrl = (0x1 |
+        dmalist[(idx*4)+2]->next_lli =
+                    (UNS_32) dmalist[(idx*4)+3];
+        dmalist[(idx*4)+2]->next_ctrl = (0x1 |
                     DMAC_CHAN_SRC_BURST_1 |
                     DMAC_CHAN_DEST_BURST_1 |
                     DMAC_CHAN_SRC_WIDTH_32 |
@@ -636,13 +758,13 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AHB1 |
                     DMAC_CHAN_INT_TC_EN);
 
-        dmalist[(idx*4)+3].dma_src = (UNS_32)
+        dmalist[(idx*4)+3]->dma_src = (UNS_32)
                     & slcdat.regptr->slc_ecc;
-        dmalist[(idx*4)+3].dma_dest = (UNS_32)(dmasrc +
+        dmalist[(idx*4)+3]->dma_dest = (UNS_32)(dmasrc +
                     LARGE_BLOCK_PAGE_2ND_ECC(idx));
-        dmalist[(idx*4)+3].next_lli =
-                    (UNS_32) & dmalist[(idx*4)+4];
-        dmalist[(idx*4)+3].next_ctrl = (0x1 |
+        dmalist[(idx*4)+3]->next_lli =
+                    (UNS_32) dmalist[(idx*4)+4];
+        dmalist[(idx*4)+3]->next_ctrl = (0x1 |
                     DMAC_CHAN_SRC_BURST_1 |
                     DMAC_CHAN_DEST_BURST_1 |
                     DMAC_CHAN_SRC_WIDTH_32 |
@@ -650,11 +772,11 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_DEST_AHB1 |
                     DMAC_CHAN_INT_TC_EN);
       }
-      dmalist[idx*4].dma_src = (UNS_32)(dmasrc +
+      dmalist[idx*4]->dma_src = (UNS_32)(dmasrc +
                     LARGE_BLOCK_PAGE_MAIN_AREA_SIZE);
-      dmalist[idx*4].dma_dest = dmadest;
-      dmalist[idx*4].next_lli = 0;
-      dmalist[idx*4].next_ctrl = (
+      dmalist[idx*4]->dma_dest = dmadest;
+      dmalist[idx*4]->next_lli = 0;
+      dmalist[idx*4]->next_ctrl = (
                     (LARGE_BLOCK_PAGE_SPARE_AREA_SIZE / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -668,11 +790,11 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
     {
       for (idx = 0; idx < 4; idx++)
       {
-        dmalist[idx*2].dma_src = (UNS_32)(dmasrc +
+        dmalist[idx*2]->dma_src = (UNS_32)(dmasrc +
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) * (idx * 2)));
-        dmalist[idx*2].dma_dest = dmadest;
-        dmalist[idx*2].next_lli = (UNS_32) & dmalist[(idx*2)+1];
-        dmalist[idx*2].next_ctrl = (
+        dmalist[idx*2]->dma_dest = dmadest;
+        dmalist[idx*2]->next_lli = (UNS_32) dmalist[(idx*2)+1];
+        dmalist[idx*2]->next_ctrl = (
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -682,13 +804,13 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_SRC_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
 
-        dmalist[(idx*2)+1].dma_src = (UNS_32)(dmasrc +
+        dmalist[(idx*2)+1]->dma_src = (UNS_32)(dmasrc +
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) *
                     ((idx * 2) + 1)));
-        dmalist[(idx*2)+1].dma_dest = dmadest;
-        dmalist[(idx*2)+1].next_lli =
-                    (UNS_32) & dmalist[(idx*2)+2];
-        dmalist[(idx*2)+1].next_ctrl = (
+        dmalist[(idx*2)+1]->dma_dest = dmadest;
+        dmalist[(idx*2)+1]->next_lli =
+                    (UNS_32) dmalist[(idx*2)+2];
+        dmalist[(idx*2)+1]->next_ctrl = (
                     ((LARGE_BLOCK_PAGE_MAIN_AREA_SIZE / 8) / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -698,11 +820,11 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
                     DMAC_CHAN_SRC_AUTOINC |
                     DMAC_CHAN_INT_TC_EN);
       }
-      dmalist[idx*2].dma_src = (UNS_32)(dmasrc +
+      dmalist[idx*2]->dma_src = (UNS_32)(dmasrc +
                     LARGE_BLOCK_PAGE_MAIN_AREA_SIZE);
-      dmalist[idx*2].dma_dest = dmadest;
-      dmalist[idx*2].next_lli = 0;
-      dmalist[idx*2].next_ctrl = (
+      dmalist[idx*2]->dma_dest = dmadest;
+      dmalist[idx*2]->next_lli = 0;
+      dmalist[idx*2]->next_ctrl = (
                     (LARGE_BLOCK_PAGE_SPARE_AREA_SIZE / 4) |
                     DMAC_CHAN_SRC_BURST_4 |
                     DMAC_CHAN_DEST_BURST_4 |
@@ -718,6 +840,7 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
   dmach = dma_alloc_channel(-1, (PFV) slcnand_dma_interrupt);
   if (dmach < 0)
   {
+    slcnand_dma_put_links();
     return _ERROR;
   }
 
@@ -725,10 +848,10 @@ STATUS slcnand_dma_write(INT_32 devid, UNS_32 dmasrc, UNS_32 dmadest,
   pdmaregs = dma_get_base();
   pdmaregs->int_tc_clear = _BIT(dmach);
   pdmaregs->int_err_clear = _BIT(dmach);
-  pdmaregs->dma_chan[dmach].src_addr = dmalist[0].dma_src;
-  pdmaregs->dma_chan[dmach].dest_addr = dmalist[0].dma_dest;
-  pdmaregs->dma_chan[dmach].lli = (UNS_32)dmalist[0].next_lli;
-  pdmaregs->dma_chan[dmach].control = dmalist[0].next_ctrl;
+  pdmaregs->dma_chan[dmach].src_addr = dmalist[0]->dma_src;
+  pdmaregs->dma_chan[dmach].dest_addr = dmalist[0]->dma_dest;
+  pdmaregs->dma_chan[dmach].lli = dmalist[0]->next_lli;
+  pdmaregs->dma_chan[dmach].control = dmalist[0]->next_ctrl;
   pdmaregs->dma_chan[dmach].config_ch = DMAC_CHAN_ITC |
                     DMAC_CHAN_IE |
                     DMAC_CHAN_FLOW_D_M2P |
@@ -1086,10 +1209,13 @@ STATUS slcnand_read_page(INT_32 devid, SLC_BLOCKPAGE_T *blockpage)
                     SLCCFG_DMA_BURST);
         }
 
-        slcnand_dma_read(devid,
+        if (slcnand_dma_read(devid,
                     (UNS_32)&slcdat.regptr->slc_dma_data,
                     (UNS_32)dwptr, blockpage->dma,
-                    blockpage->ecc);
+                    blockpage->ecc) != _NO_ERROR)
+        {
+          return _ERROR;
+        }
 
         /* Wait for SLC NAND ready */
         while (!(slcdat.regptr->slc_stat & SLCSTAT_NAND_READY));
@@ -1148,8 +1274,9 @@ STATUS slcnand_read_page(INT_32 devid, SLC_BLOCKPAGE_T *blockpage)
                     SLCCFG_DMA_BURST);
         }
 
-        /* release the DMA Channel */
+        /* release the DMA Channel and its linked list entries */
         dma_free_channel(dmach);
+        slcnand_dma_put_links();
 
         if (blockpage->ecc != 0)
         {
@@ -1230,10 +1357,13 @@ STATUS slcnand_read_page(INT_32 devid, SLC_BLOCKPAGE_T *blockpage)
                     SLCCFG_DMA_BURST);
         }
 
-        slcnand_dma_read(devid,
+        if (slcnand_dma_read(devid,
                     (UNS_32)&slcdat.regptr->slc_dma_data,
                     (UNS_32)dwptr, blockpage->dma,
-                    blockpage->ecc);
+                    blockpage->ecc) != _NO_ERROR)
+        {
+          return _ERROR;
+        }
 
         /* Wait for SLC NAND ready */
         while (!(slcdat.regptr->slc_stat & SLCSTAT_NAND_READY));
@@ -1295,8 +1425,9 @@ STATUS slcnand_read_page(INT_32 devid, SLC_BLOCKPAGE_T *blockpage)
                     SLCCFG_DMA_BURST);
         }
 
-        /* release the DMA Channel */
+        /* release the DMA Channel and its linked list entries */
         dma_free_channel(dmach);
+        slcnand_dma_put_links();
 
         if (blockpage->ecc != 0)
         {
@@ -1482,9 +1613,12 @@ STATUS slcnand_write_page(INT_32 devid, SLC_BLOCKPAGE_T *blockpage)
           slcdat.regptr->slc_cfg &= ~SLCCFG_DMA_DIR;
         }
 
-        slcnand_dma_write(devid, (UNS_32)dwptr,
+        if (slcnand_dma_write(devid, (UNS_32)dwptr,
                     (UNS_32)&slcdat.regptr->slc_dma_data,
-                    blockpage->dma, blockpage->ecc);
+                    blockpage->dma, blockpage->ecc) != _NO_ERROR)
+        {
+          return _ERROR;
+        }
 
         /* Wait for SLC NAND ready */
         while (!(slcdat.regptr->slc_stat & SLCSTAT_NAND_READY));
@@ -1552,8 +1686,9 @@ STATUS slcnand_write_page(INT_32 devid, SLC_BLOCKPAGE_T *blockpage)
           slcdat.regptr->slc_cfg &= ~SLCCFG_DMA_BURST;
         }
 
-        /* release the DMA Channel */
+        /* release the DMA Channel and its linked list entries */
         dma_free_channel(dmach);
+        slcnand_dma_put_links();
       }
       else
       {
@@ -1630,9 +1765,12 @@ STATUS slcnand_write_page(INT_32 devid, SLC_BLOCKPAGE_T *blockpage)
           slcdat.regptr->slc_cfg &= ~SLCCFG_DMA_DIR;
         }
 
-        slcnand_dma_write(devid, (UNS_32)dwptr,
+        if (slcnand_dma_write(devid, (UNS_32)dwptr,
                     (UNS_32)&slcdat.regptr->slc_dma_data,
-                    blockpage->dma, blockpage->ecc);
+                    blockpage->dma, blockpage->ecc) != _NO_ERROR)
+        {
+          return _ERROR;
+        }
 
         /* Wait for SLC NAND ready */
         while (!(slcdat.regptr->slc_stat & SLCSTAT_NAND_READY));
@@ -1700,8 +1838,9 @@ STATUS slcnand_write_page(INT_32 devid, SLC_BLOCKPAGE_T *blockpage)
           slcdat.regptr->slc_cfg &= ~SLCCFG_DMA_BURST;
         }
 
-        /* release the DMA Channel */
+        /* release the DMA Channel and its linked list entries */
         dma_free_channel(dmach);
+        slcnand_dma_put_links();
       }
       else
       {
@@ -29,13 +29,14 @@
 
 #include "lpc32xx_tsc_driver.h"
 #include "lpc_irq_fiq.h"
+#include "lpc_ring.h"
 #include "lpc32xx_intc_driver.h"
 
 /***********************************************************************
  * TSC driver private data and types
  **********************************************************************/
 
-/* Size of the TSC receive ring buffer */
+/* Size of the TSC receive ring buffer in samples (power of 2) */
 #define TSC_RING_BUFSIZE 16
 
 /* Function prototype used for polled and interrupt driven reads */
@@ -46,9 +47,8 @@ typedef struct
 {
   BOOL_32 init;                         /* Device initialized flag */
   LPC3250_ADCTSC_REGS_T *regptr; 	/* Pointer to ADC/TSC registers */
-  UNS_32 rx[TSC_RING_BUFSIZE];  	/* TSC data ring buffer */
-  INT_32 rx_head;                       /* TSC ring buffer head index */
-  INT_32 rx_tail;                       /* TSC ring buffer tail index */
+  UNS_32 rx[TSC_RING_BUFSIZE];  	/* TSC data ring buffer storage */
+  LPC_SPSC_RING_T rx_ring;              /* TSC ring buffer */
 } TSC_CFG_T;
 
 /* TSC device configuration structure */
@@ -171,7 +171,7 @@ INT_32 tsc_open(void *ipbase,
     tsc_default(tsccfg.regptr);
 
     /* Empty ring buffer and set conversion counter to 0 */
-    tsccfg.rx_head = tsccfg.rx_tail = 0;
+    lpc_ring_init(&tsccfg.rx_ring, tsccfg.rx, sizeof(tsccfg.rx));
 
     /* Return pointer to ADC configuration structure */
     status = (INT_32) & tsccfg;
@@ -529,16 +529,13 @@ INT_32 tsc_write(INT_32 devid,
  *
  * Processing:
  *     If the init flag for the TSC structure is FALSE, return 0 to
- *     the caller. Otherwise, save the state of the TSC interrupts and
- *     disable the TSC interrupts. Loop until max_bytes equals 0 or
- *     until the receive ring buffer is empty, whichever comes
- *     first. Read the data from the ring buffer  indexed by the tail
- *     pointer and place it into the user buffer. Increment the tail
- *     pointer and user buffer pointer. If the tail pointer exceeds the
- *     buffer size, set the tail pointer to 0. Increment bytes, and
- *     decrement max_bytes. Exit the loop based on the loop conditions,
- *     re-enable the receive interrupts, and return the number of bytes
- *     read to the caller.
+ *     the caller. Otherwise, loop until max_bytes equals 0 or until
+ *     the receive ring buffer is empty, whichever comes first. Each
+ *     contiguous span of samples in the ring buffer is converted in
+ *     place into the user buffer and then released. Return the number
+ *     of bytes read to the caller. The ring buffer is only read here
+ *     and only written by the interrupt, so the TSC interrupt is not
+ *     disabled.
  *
  * Parameters:
  *     devid:     Pointer to an TSC configuration structure
@@ -559,41 +556,37 @@ INT_32 tsc_read_ring(INT_32 devid,
 
   TSC_CFG_T *tsccfgptr = (TSC_CFG_T *) devid;
   INT_32 bytes = 0;
+  UNS_32 *samples;
+  UNS_32 count, avail;
 
   UNS_16 *data = (UNS_16 *) buffer;
 
     if (tsccfgptr->init == TRUE)
     {
-        /* Temporarily lock out TSC interrupts during this
-           read so the TSC receive interrupt won't cause problems
-           with the ring buffer index values */
-        int_disable(IRQ_TS_IRQ);
-
         /* Loop until receive ring buffer is empty or until max_bytes
            expires */
-        while ((max_bytes > 0) &&
-            (tsccfgptr->rx_tail != tsccfgptr->rx_head))
+        avail = lpc_ring_peek_span(&tsccfgptr->rx_ring,
+                                   (void **) &samples) / sizeof(UNS_32);
+        while ((max_bytes > 0) && (avail > 0))
         {
-            /* Read data from ring buffer into user buffer */
-            *data = tsccfgptr->rx[tsccfgptr->rx_tail];
-            data++;
-
-            /* Update tail pointer */
-            tsccfgptr->rx_tail++;
-
-            /* Make sure tail didn't overflow */
-            if (tsccfgptr->rx_tail >= TSC_RING_BUFSIZE)
+            count = 0;
+            while ((max_bytes > 0) && (count < avail))
             {
-                tsccfgptr->rx_tail = 0;
+                /* Read data from ring buffer into user buffer */
+                *data = (UNS_16) samples[count];
+                data++;
+                count++;
+
+                /* Increment data count and decrement buffer size
+                   count */
+                bytes = bytes + 2;
+                max_bytes = max_bytes - 2;
             }
 
-            /* Increment data count and decrement buffer size count */
-            bytes = bytes + 2;
-            max_bytes = max_bytes - 2;
+            lpc_ring_release(&tsccfgptr->rx_ring, count * sizeof(UNS_32));
+            avail = lpc_ring_peek_span(&tsccfgptr->rx_ring,
+                                       (void **) &samples) / sizeof(UNS_32);
         }
-
-        /* Re-enable TSC receive interrupt(s) */
-        int_enable(IRQ_TS_IRQ);
     }
 
     return bytes;
@@ -607,10 +600,11 @@ INT_32 tsc_read_ring(INT_32 devid,
  * Purpose: Move data from the TSC DAT to the driver ring buffer
  *
  * Processing:
- *     While there is TSC FIFO data, copy an entry from the TSC FIFO into
- *     the TSC driver ring buffer. Increment the ring buffer
- *     head pointer. If it exceeds the ring buffer size, reset the
- *     head pointer to 0.
+ *     While there is TSC FIFO data, reserve the free span of the TSC
+ *     driver ring buffer and read the entries from the TSC FIFO
+ *     straight into it, keeping the valid (pressed) samples. The
+ *     kept samples are then committed to the ring buffer. Samples
+ *     that do not fit in the ring buffer are dropped.
  *
  * Parameters:
  *     adccfgptr: Pointer to TSC config structure
@@ -626,24 +620,32 @@ STATIC void tsc_ring_fill(TSC_CFG_T *tsccfgptr)
 {
 
   LPC3250_ADCTSC_REGS_T *tscregsptr = tsccfgptr->regptr;
+  UNS_32 *samples, sample;
+  UNS_32 count, space;
 
   /* Read the full FIFO until the FIFO Empty status bit is set */
   while ((tscregsptr->tsc_stat & TSC_STAT_FIFO_EMPTY) 
         != TSC_STAT_FIFO_EMPTY)
   {
-    /* read in the 32 bit value */
-    tsccfgptr->rx[tsccfgptr->rx_head] = (UNS_32) tscregsptr->tsc_fifo;
-    /* Check that the TSC is pressed, sample valid */
-    if ((tsccfgptr->rx[tsccfgptr->rx_head] & TSC_FIFO_TS_P_LEVEL) 
-       != TSC_FIFO_TS_P_LEVEL)
+    space = lpc_ring_reserve(&tsccfgptr->rx_ring, (void **) &samples)
+            / sizeof(samples[0]);
+    count = 0;
+    do
     {
-      /* Increment receive ring buffer head pointer */
-      tsccfgptr->rx_head++;
-      if (tsccfgptr->rx_head >= TSC_RING_BUFSIZE)
+      /* read in the 32 bit value */
+      sample = (UNS_32) tscregsptr->tsc_fifo;
+      /* Check that the TSC is pressed, sample valid */
+      if (((sample & TSC_FIFO_TS_P_LEVEL) != TSC_FIFO_TS_P_LEVEL) &&
+          (count < space))
       {
-        tsccfgptr->rx_head = 0;
+        samples[count] = sample;
+        count++;
       }
-    }
+    } while ((count < space) &&
+             ((tscregsptr->tsc_stat & TSC_STAT_FIFO_EMPTY)
+              != TSC_STAT_FIFO_EMPTY));
+
+    lpc_ring_commit(&tsccfgptr->rx_ring, count * sizeof(samples[0]));
   }
 }
 /***********************************************************************
@@ -0,0 +1,455 @@
+/***********************************************************************
+ * $Id:: bch_test.c                                                    $
+ *
+ * Project: Host NAND BCH ECC test
+ *
+ * Description:
+ *     Checks lpc_bch for t = 4 and t = 8. Random and erased (0xFF)
+ *     blocks get 0 to t bit errors spread over the data and ECC bytes
+ *     and must be corrected with the right error count. Blocks with
+ *     t + 1 errors must be reported as not correctable and must be
+ *     left as they were, unless the errors moved the block to within t
+ *     bits of another code word (see test_nearer).
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lpc_bch.h"
+
+/***********************************************************************
+ * Package defines
+ **********************************************************************/
+
+/* Defaults */
+#define TEST_DEF_BLOCKS        500
+#define TEST_DEF_SEED          1
+
+/* Block data patterns */
+#define TEST_PAT_RANDOM        0  /* Random bytes */
+#define TEST_PAT_ERASED        1  /* All 0xFF */
+#define TEST_PATTERNS          2
+
+/* Number of failures printed */
+#define TEST_MAX_REPORTS       5
+
+/***********************************************************************
+ * Package data
+ **********************************************************************/
+
+static UNS_32 randstate = TEST_DEF_SEED;
+static LPC_BCH_T bch;
+static UNS_32 reports;
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: test_rand
+ *
+ * Purpose: Return a pseudo random number
+ *
+ * Processing:
+ *     Step a linear congruential generator, so a seed gives the same
+ *     blocks on every host.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: A 15-bit random number
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_rand(void)
+{
+  randstate = (randstate * 1103515245) + 12345;
+
+  return (randstate >> 16) & 0x7FFF;
+}
+
+/***********************************************************************
+ *
+ * Function: test_flip
+ *
+ * Purpose: Flip distinct random bits of a block and its ECC
+ *
+ * Processing:
+ *     Pick bit numbers over the 4096 data bits followed by the deg
+ *     used ECC bits until count different bits are found, then flip
+ *     them. The pad bits of the last ECC byte are not used, they are
+ *     not part of the code word.
+ *
+ * Parameters:
+ *     datbuf : Block data
+ *     ecc    : Block ECC
+ *     count  : Number of bits to flip
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void test_flip(UNS_8 *datbuf, UNS_8 *ecc, INT_32 count)
+{
+  UNS_32 bits[LPC_BCH_MAX_T + 1], total, bit;
+  INT_32 idx, used = 0;
+
+  total = (LPC_BCH_DATA_BYTES * 8) + (UNS_32) bch.deg;
+  while (used < count)
+  {
+    bit = ((test_rand() << 15) | test_rand()) % total;
+    for (idx = 0; idx < used; idx++)
+    {
+      if (bits[idx] == bit)
+      {
+        break;
+      }
+    }
+    if (idx == used)
+    {
+      bits[used] = bit;
+      used++;
+    }
+  }
+
+  for (idx = 0; idx < count; idx++)
+  {
+    bit = bits[idx];
+    if (bit < (LPC_BCH_DATA_BYTES * 8))
+    {
+      datbuf[bit / 8] ^= (UNS_8) (0x80 >> (bit % 8));
+    }
+    else
+    {
+      bit -= LPC_BCH_DATA_BYTES * 8;
+      ecc[bit / 8] ^= (UNS_8) (0x80 >> (bit % 8));
+    }
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: test_bits
+ *
+ * Purpose: Count the bits that differ between two byte arrays
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     a     : First array
+ *     b     : Second array
+ *     bytes : Number of bytes
+ *     mask  : Mask of the bits compared in the last byte
+ *
+ * Outputs: None
+ *
+ * Returns: The number of different bits
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 test_bits(const UNS_8 *a, const UNS_8 *b, INT_32 bytes,
+                        UNS_8 mask)
+{
+  INT_32 idx, count = 0;
+  UNS_8 diff;
+
+  for (idx = 0; idx < bytes; idx++)
+  {
+    diff = a[idx] ^ b[idx];
+    if (idx == (bytes - 1))
+    {
+      diff &= mask;
+    }
+    while (diff != 0)
+    {
+      count += diff & 1;
+      diff >>= 1;
+    }
+  }
+
+  return count;
+}
+
+/***********************************************************************
+ *
+ * Function: test_nearer
+ *
+ * Purpose: Check that a decode of a block with more than t errors
+ *          moved it to a code word within t bits
+ *
+ * Processing:
+ *     A code with a minimum distance of 2t + 1 cannot tell t + 1
+ *     errors from a different code word with up to t errors, so a
+ *     decoder that corrects every t bit error must accept those
+ *     blocks. For t = 4 this happens to about 3 in 1000 blocks with 5
+ *     random errors. The decode is right if the corrected data and the
+ *     read ECC are a code word that is exactly as many bits from the
+ *     read block as the decode reported, and that is at most t.
+ *
+ * Parameters:
+ *     datbuf   : Block data after the decode
+ *     bad_data : Block data before the decode
+ *     ecc      : Read ECC
+ *     ret      : Decode return value
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the decode found a nearer code word, otherwise
+ *          FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 test_nearer(UNS_8 *datbuf, UNS_8 *bad_data, UNS_8 *ecc,
+                           INT_32 ret)
+{
+  UNS_8 newecc[LPC_BCH_MAX_ECC_BYTES], mask;
+  INT_32 dist;
+
+  if ((ret < 1) || (ret > bch.t))
+  {
+    return FALSE;
+  }
+
+  mask = (UNS_8) (0xFF << ((8 - (bch.deg % 8)) % 8));
+  lpc_bch_encode(&bch, datbuf, newecc);
+  dist = test_bits(datbuf, bad_data, LPC_BCH_DATA_BYTES, 0xFF) +
+         test_bits(newecc, ecc, bch.eccbytes, mask);
+
+  return (BOOL_32) (dist == ret);
+}
+
+/***********************************************************************
+ *
+ * Function: test_errors
+ *
+ * Purpose: Check the decode of blocks with a number of bit errors
+ *
+ * Processing:
+ *     Fill a random or erased block and encode it, then flip the bits.
+ *     Up to t errors, the decode must return the error count and the
+ *     data must match the original. For more than t errors, the decode
+ *     must return -1 and the data must be unchanged, or have moved the
+ *     block to a nearer code word.
+ *
+ * Parameters:
+ *     pattern : TEST_PAT_xxx
+ *     errors  : Number of bit errors per block
+ *     blocks  : Number of blocks
+ *     nearer  : Incremented for each block decoded to a nearer code
+ *               word
+ *
+ * Outputs: None
+ *
+ * Returns: The number of failed blocks
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_errors(UNS_32 pattern, INT_32 errors, UNS_32 blocks,
+                          UNS_32 *nearer)
+{
+  UNS_8 datbuf[LPC_BCH_DATA_BYTES], good[LPC_BCH_DATA_BYTES];
+  UNS_8 bad_data[LPC_BCH_DATA_BYTES], ecc[LPC_BCH_MAX_ECC_BYTES];
+  UNS_32 idx, byte, bad = 0;
+  INT_32 ret, expect;
+
+  for (idx = 0; idx < blocks; idx++)
+  {
+    for (byte = 0; byte < LPC_BCH_DATA_BYTES; byte++)
+    {
+      good[byte] = (pattern == TEST_PAT_ERASED) ? 0xFF :
+                   (UNS_8) test_rand();
+    }
+    lpc_bch_encode(&bch, good, ecc);
+
+    memcpy(datbuf, good, sizeof(datbuf));
+    test_flip(datbuf, ecc, errors);
+    memcpy(bad_data, datbuf, sizeof(bad_data));
+
+    ret = lpc_bch_decode(&bch, datbuf, ecc);
+    if (errors <= bch.t)
+    {
+      expect = errors;
+      if ((ret == expect) &&
+          (memcmp(datbuf, good, sizeof(datbuf)) == 0))
+      {
+        continue;
+      }
+    }
+    else
+    {
+      expect = -1;
+      if ((ret == expect) &&
+          (memcmp(datbuf, bad_data, sizeof(datbuf)) == 0))
+      {
+        continue;
+      }
+      if (test_nearer(datbuf, bad_data, ecc, ret) == TRUE)
+      {
+        *nearer += 1;
+        continue;
+      }
+    }
+
+    if (reports < TEST_MAX_REPORTS)
+    {
+      printf("t=%d %s block %u, %d errors: decode returned %d, "
+             "expected %d%s\n", bch.t,
+             (pattern == TEST_PAT_ERASED) ? "erased" : "random", idx,
+             errors, ret, expect,
+             (ret == expect) ? ", data changed" : "");
+      reports++;
+    }
+    bad++;
+  }
+
+  return bad;
+}
+
+/***********************************************************************
+ *
+ * Function: test_codec
+ *
+ * Purpose: Run all error counts for one t
+ *
+ * Processing:
+ *     Setup the codec, check that an erased block has an all 0xFF ECC,
+ *     then run 0 to t + 1 errors on random and erased blocks. Blocks
+ *     with t + 1 errors that decode to a nearer code word are counted
+ *     and printed, they are not failures.
+ *
+ * Parameters:
+ *     t      : Correctable bits per block
+ *     blocks : Number of blocks per pattern and error count
+ *
+ * Outputs: None
+ *
+ * Returns: The number of failed checks
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_codec(INT_32 t, UNS_32 blocks)
+{
+  UNS_8 datbuf[LPC_BCH_DATA_BYTES], ecc[LPC_BCH_MAX_ECC_BYTES];
+  UNS_32 pattern, fails, nearer, bad = 0;
+  INT_32 errors, idx;
+
+  if (lpc_bch_init(&bch, t) != _NO_ERROR)
+  {
+    printf("t=%d: lpc_bch_init failed\n", t);
+    return 1;
+  }
+
+  memset(datbuf, 0xFF, sizeof(datbuf));
+  lpc_bch_encode(&bch, datbuf, ecc);
+  for (idx = 0; idx < bch.eccbytes; idx++)
+  {
+    if (ecc[idx] != 0xFF)
+    {
+      printf("t=%d: ECC of an erased block is not 0xFF\n", t);
+      bad++;
+      break;
+    }
+  }
+
+  for (errors = 0; errors <= (t + 1); errors++)
+  {
+    nearer = 0;
+    for (pattern = 0; pattern < TEST_PATTERNS; pattern++)
+    {
+      fails = test_errors(pattern, errors, blocks, &nearer);
+      printf("t=%d %d errors %s: %u/%u failed\n", t, errors,
+             (pattern == TEST_PAT_ERASED) ? "erased" : "random", fails,
+             blocks);
+      bad += fails;
+    }
+    if (nearer != 0)
+    {
+      printf("t=%d %d errors: %u/%u blocks decoded to a code word "
+             "within %d bits\n", t, errors, nearer, 2 * blocks, t);
+    }
+  }
+
+  return bad;
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: main
+ *
+ * Purpose: Test entry point
+ *
+ * Processing:
+ *     Parse the options and run the checks for t = 4 and t = 8.
+ *
+ * Parameters:
+ *     argc : Number of arguments
+ *     argv : Arguments
+ *
+ * Outputs: None
+ *
+ * Returns: 0 if all checks passed, otherwise 1
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+int main(int argc, char *argv[])
+{
+  UNS_32 blocks = TEST_DEF_BLOCKS, bad;
+  int idx;
+
+  for (idx = 1; idx < argc; idx++)
+  {
+    if ((strcmp(argv[idx], "-n") == 0) && (idx + 1 < argc))
+    {
+      blocks = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-s") == 0) && (idx + 1 < argc))
+    {
+      randstate = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else
+    {
+      printf("usage: bch_test [-n blocks] [-s seed]\n");
+      return 1;
+    }
+  }
+
+  bad = test_codec(4, blocks);
+  bad += test_codec(8, blocks);
+
+  if (bad != 0)
+  {
+    printf("FAIL\n");
+    return 1;
+  }
+  printf("ok\n");
+
+  return 0;
+}
@@ -0,0 +1,900 @@
+/***********************************************************************
+ * $Id:: fat_bench.c                                                   $
+ *
+ * Project: Host FAT driver benchmark
+ *
+ * Description:
+ *     Runs lpc_fat16 and the S1L FAT loader (s1l_fat) against a FAT16
+ *     image file on a PC and reports, for each phase, the rate and the
+ *     device commands and sectors it needed:
+ *      - lpc_fat16 sequential write, sequential read, and random read
+ *        of a test file
+ *      - lpc_fat16 file creation, root directory listing, and file
+ *        deletion
+ *      - lpc_fat16 sequential write into clusters reserved with
+ *        fat16_preallocate
+ *      - the lpc_fat16 read and file phases again through a sector
+ *        cache set up with fat16_cache_init
+ *      - s1l_fat direct and streamed reads of the test file and root
+ *        directory listing
+ *     All data read back is checked. The test file is left on the
+ *     image, so the image can be checked with fat_image afterwards.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lpc_fat16.h"
+#include "s1l_fat.h"
+#include "fat_host.h"
+
+/***********************************************************************
+ * Package defines
+ **********************************************************************/
+
+/* Defaults */
+#define BENCH_DEF_FILE_KB      4096
+#define BENCH_DEF_CHUNK        32768
+#define BENCH_DEF_READS        1000
+#define BENCH_DEF_FILES        64
+#define BENCH_DEF_PASSES       20
+#define BENCH_DEF_SEED         1
+#define BENCH_DEF_CACHE_KB     64
+
+/* Size of a random read */
+#define BENCH_RAND_BYTES       4096
+
+/* Size of a file made by the create phase */
+#define BENCH_SMALL_BYTES      1000
+
+/* Ways of the sector cache */
+#define BENCH_CACHE_WAYS       4
+
+/* Bytes reserved past the end of the preallocated test file */
+#define BENCH_PREALLOC_SLACK   65536
+
+/* Largest chunk */
+#define BENCH_MAX_CHUNK        (1024 * 1024)
+
+/* Name of the test file */
+#define BENCH_FILE_NAME        "BENCH.BIN"
+
+/***********************************************************************
+ * Package data
+ **********************************************************************/
+
+static UNS_32 randstate = BENCH_DEF_SEED;
+static UNS_8 seedbyte;
+
+/* Phase start time */
+static struct timespec phasestart;
+
+/* Number of data mismatches */
+static UNS_32 mismatches;
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: bench_rand
+ *
+ * Purpose: Return a pseudo random number
+ *
+ * Processing:
+ *     Step a linear congruential generator, so a seed gives the same
+ *     run on every host.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: A 15-bit random number
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 bench_rand(void)
+{
+  randstate = (randstate * 1103515245) + 12345;
+
+  return (randstate >> 16) & 0x7FFF;
+}
+
+/***********************************************************************
+ *
+ * Function: bench_byte
+ *
+ * Purpose: Return the byte at a position of the test file
+ *
+ * Processing:
+ *     The high bits of the position are folded in, so a sector read
+ *     from the wrong place in the file does not match.
+ *
+ * Parameters:
+ *     pos : Byte position in the file
+ *
+ * Outputs: None
+ *
+ * Returns: The file byte
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_8 bench_byte(UNS_32 pos)
+{
+  return (UNS_8) (pos ^ (pos >> 8) ^ (pos >> 16) ^ (pos >> 24) ^
+                  seedbyte);
+}
+
+/***********************************************************************
+ *
+ * Function: bench_fill
+ *
+ * Purpose: Fill a buffer with a piece of the test file
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     buff  : Buffer
+ *     pos   : File position of the first byte
+ *     bytes : Number of bytes
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void bench_fill(UNS_8 *buff, UNS_32 pos, UNS_32 bytes)
+{
+  UNS_32 idx;
+
+  for (idx = 0; idx < bytes; idx++)
+  {
+    buff[idx] = bench_byte(pos + idx);
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: bench_check
+ *
+ * Purpose: Check a piece of the test file read back
+ *
+ * Processing:
+ *     Compare the bytes with the test file and count a mismatch.
+ *
+ * Parameters:
+ *     buff  : Data read
+ *     pos   : File position of the first byte
+ *     bytes : Number of bytes
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void bench_check(const UNS_8 *buff, UNS_32 pos, UNS_32 bytes)
+{
+  UNS_32 idx;
+
+  for (idx = 0; idx < bytes; idx++)
+  {
+    if (buff[idx] != bench_byte(pos + idx))
+    {
+      if (mismatches < 5)
+      {
+        printf("mismatch at file offset %u\n", pos + idx);
+      }
+      mismatches++;
+      return;
+    }
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: bench_start
+ *
+ * Purpose: Start a benchmark phase
+ *
+ * Processing:
+ *     Clear the device counters and save the start time.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void bench_start(void)
+{
+  fat_host_reset_stats();
+  clock_gettime(CLOCK_MONOTONIC, &phasestart);
+}
+
+/***********************************************************************
+ *
+ * Function: bench_report
+ *
+ * Purpose: Print the result of a benchmark phase
+ *
+ * Processing:
+ *     Print the rate in MB/s for a phase that moves bytes, or in
+ *     operations per second otherwise, followed by the device
+ *     commands and sectors moved.
+ *
+ * Parameters:
+ *     name  : Phase name
+ *     bytes : Bytes moved, or 0
+ *     ops   : Operations made if no bytes were moved
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void bench_report(const char *name, UNS_32 bytes, UNS_32 ops)
+{
+  FAT_HOST_STATS_T stats;
+  struct timespec end;
+  double secs;
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  fat_host_get_stats(&stats);
+  secs = (double) (end.tv_sec - phasestart.tv_sec) +
+         ((double) (end.tv_nsec - phasestart.tv_nsec) / 1e9);
+  if (secs <= 0.0)
+  {
+    secs = 1e-9;
+  }
+
+  if (bytes > 0)
+  {
+    printf("%-20s %9.2f MB/s  ", name, (double) bytes / secs / 1e6);
+  }
+  else
+  {
+    printf("%-20s %9.0f op/s  ", name, (double) ops / secs);
+  }
+  printf("%8u cmds %7u multi %8u rd %8u wr\n", stats.commands,
+         stats.multi_commands, stats.sectors_read,
+         stats.sectors_written);
+}
+
+/***********************************************************************
+ *
+ * Function: bench_fat16_write
+ *
+ * Purpose: Write the test file with lpc_fat16
+ *
+ * Processing:
+ *     Create the test file, reserve clusters for it if asked to, and
+ *     write it in chunks.
+ *
+ * Parameters:
+ *     file_data : File descriptor
+ *     buff      : Chunk buffer
+ *     size      : Test file size in bytes
+ *     chunk     : Bytes per write call
+ *     reserve   : Bytes to reserve with fat16_preallocate, or 0
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if the file was written, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS bench_fat16_write(FILE_TYPE *file_data, UNS_8 *buff,
+                                UNS_32 size, UNS_32 chunk,
+                                UNS_32 reserve)
+{
+  CHAR name[16];
+  UNS_32 pos, bytes;
+
+  strcpy((char *) name, BENCH_FILE_NAME);
+  if (fat16_open_file(name, file_data, FWRITE) == 0)
+  {
+    printf("lpc_fat16: can't create %s\n", name);
+    return _ERROR;
+  }
+  if ((reserve != 0) && (fat16_preallocate(file_data, reserve) == 0))
+  {
+    printf("lpc_fat16: can't reserve %u bytes\n", reserve);
+    fat16_close_file(file_data);
+    return _ERROR;
+  }
+  for (pos = 0; pos < size; pos += bytes)
+  {
+    bytes = ((size - pos) < chunk) ? (size - pos) : chunk;
+    bench_fill(buff, pos, bytes);
+    if (fat16_write(file_data, buff, (INT_32) bytes) == 0)
+    {
+      printf("lpc_fat16: write at %u failed\n", pos);
+      fat16_close_file(file_data);
+      return _ERROR;
+    }
+  }
+  fat16_close_file(file_data);
+
+  return _NO_ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: bench_fat16_read
+ *
+ * Purpose: Read the test file with lpc_fat16
+ *
+ * Processing:
+ *     Read the test file in chunks and check the data and size.
+ *
+ * Parameters:
+ *     file_data : File descriptor
+ *     buff      : Chunk buffer
+ *     size      : Test file size in bytes
+ *     chunk     : Bytes per read call
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes read
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 bench_fat16_read(FILE_TYPE *file_data, UNS_8 *buff,
+                               UNS_32 size, UNS_32 chunk)
+{
+  CHAR name[16];
+  UNS_32 pos = 0;
+  INT_32 got, eof = 0;
+
+  strcpy((char *) name, BENCH_FILE_NAME);
+  if (fat16_open_file(name, file_data, FREAD) == 0)
+  {
+    printf("lpc_fat16: can't open %s\n", name);
+    mismatches++;
+    return 0;
+  }
+  while (eof == 0)
+  {
+    fat16_read(file_data, (INT_32) chunk, buff, &got, &eof);
+    bench_check(buff, pos, (UNS_32) got);
+    pos += (UNS_32) got;
+    if ((got == 0) && (eof == 0))
+    {
+      break;
+    }
+  }
+  fat16_close_file(file_data);
+  if (pos != size)
+  {
+    printf("lpc_fat16: read %u of %u bytes\n", pos, size);
+    mismatches++;
+  }
+
+  return pos;
+}
+
+/***********************************************************************
+ *
+ * Function: bench_fat16_rand
+ *
+ * Purpose: Read random pieces of the test file with lpc_fat16
+ *
+ * Processing:
+ *     Read BENCH_RAND_BYTES at random sector offsets of the test file
+ *     with fat16_read_at and check the data.
+ *
+ * Parameters:
+ *     file_data : File descriptor
+ *     buff      : Buffer of at least BENCH_RAND_BYTES
+ *     size      : Test file size in bytes
+ *     reads     : Number of reads
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes read
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 bench_fat16_rand(FILE_TYPE *file_data, UNS_8 *buff,
+                               UNS_32 size, UNS_32 reads)
+{
+  CHAR name[16];
+  UNS_32 pos, bytes, idx, total = 0;
+  INT_32 got, eof;
+
+  strcpy((char *) name, BENCH_FILE_NAME);
+  fat16_open_file(name, file_data, FREAD);
+  for (idx = 0; idx < reads; idx++)
+  {
+    pos = (((bench_rand() << 15) | bench_rand()) %
+           (size / FAT_HOST_SECTOR_SIZE)) * FAT_HOST_SECTOR_SIZE;
+    bytes = ((size - pos) < BENCH_RAND_BYTES) ? (size - pos) :
+            BENCH_RAND_BYTES;
+    if ((fat16_read_at(file_data, pos, (INT_32) bytes, buff, &got,
+                       &eof) == 0) || ((UNS_32) got != bytes))
+    {
+      printf("lpc_fat16: read of %u bytes at %u failed\n", bytes, pos);
+      mismatches++;
+      break;
+    }
+    bench_check(buff, pos, bytes);
+    total += bytes;
+  }
+  fat16_close_file(file_data);
+
+  return total;
+}
+
+/***********************************************************************
+ *
+ * Function: bench_fat16_files
+ *
+ * Purpose: Run the lpc_fat16 small file phases
+ *
+ * Processing:
+ *     Create small files, list the root directory, and delete the
+ *     small files, reporting each as a phase.
+ *
+ * Parameters:
+ *     file_data : File descriptor
+ *     buff      : Buffer of at least BENCH_SMALL_BYTES
+ *     files     : Number of small files
+ *     passes    : Number of directory listings
+ *     prefix    : Phase name prefix
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if all operations passed, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS bench_fat16_files(FILE_TYPE *file_data, UNS_8 *buff,
+                                UNS_32 files, UNS_32 passes,
+                                const char *prefix)
+{
+  CHAR name[16];
+  char phase[32];
+  UNS_8 etype;
+  UNS_32 idx, entries = 0;
+  INT_32 empty, last;
+
+  /* File creation */
+  bench_start();
+  bench_fill(buff, 0, BENCH_SMALL_BYTES);
+  for (idx = 0; idx < files; idx++)
+  {
+    sprintf((char *) name, "F%04u.TXT", idx);
+    if ((fat16_open_file(name, file_data, FWRITE) == 0) ||
+        (fat16_write(file_data, buff, BENCH_SMALL_BYTES) == 0))
+    {
+      printf("lpc_fat16: can't create %s\n", name);
+      return _ERROR;
+    }
+    fat16_close_file(file_data);
+  }
+  sprintf(phase, "%s create", prefix);
+  bench_report(phase, 0, files);
+
+  /* Root directory listing */
+  bench_start();
+  for (idx = 0; idx < passes; idx++)
+  {
+    fat16_set_dir_index(file_data, 0);
+    last = 0;
+    while (last == 0)
+    {
+      fat16_get_dirname(file_data, name, &etype, &empty, &last);
+      if (empty == 0)
+      {
+        entries++;
+      }
+    }
+  }
+  sprintf(phase, "%s dir list", prefix);
+  bench_report(phase, 0, entries);
+
+  /* File deletion */
+  bench_start();
+  for (idx = 0; idx < files; idx++)
+  {
+    sprintf((char *) name, "F%04u.TXT", idx);
+    if (fat16_delete(file_data, name) == 0)
+    {
+      printf("lpc_fat16: can't delete %s\n", name);
+      return _ERROR;
+    }
+  }
+  sprintf(phase, "%s delete", prefix);
+  bench_report(phase, 0, files);
+
+  return _NO_ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: bench_fat16
+ *
+ * Purpose: Run the lpc_fat16 phases
+ *
+ * Processing:
+ *     Mount the image, write and read the test file in chunks, read
+ *     random pieces of it, create small files, list the root
+ *     directory, and delete the small files. Write the test file again
+ *     with fat16_preallocate. Then set up the sector cache and run the
+ *     read and small file phases through it. Shut the driver down.
+ *
+ * Parameters:
+ *     multi    : TRUE to bind the multi-sector functions
+ *     size     : Test file size in bytes
+ *     chunk    : Bytes per write or read call
+ *     reads    : Number of random reads
+ *     files    : Number of small files
+ *     passes   : Number of directory listings
+ *     cache_kb : Sector cache size in K bytes, 0 for no cache phases
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if all operations passed, otherwise _ERROR
+ *
+ * Notes: The preallocated write reserves BENCH_PREALLOC_SLACK more
+ *        bytes than it writes, so the image check also covers the
+ *        unused reserved clusters being freed on close.
+ *
+ **********************************************************************/
+static STATUS bench_fat16(BOOL_32 multi, UNS_32 size, UNS_32 chunk,
+                          UNS_32 reads, UNS_32 files, UNS_32 passes,
+                          UNS_32 cache_kb)
+{
+  FAT_DEVICE_TYPE *fat_data;
+  FILE_TYPE *file_data;
+  CHAR name[16];
+  UNS_8 *buff, *cache = NULL;
+  UNS_32 bytes, hits, misses, writebacks;
+  INT_32 lines;
+  STATUS status = _ERROR;
+
+  /* Also holds a random read */
+  buff = (UNS_8 *) malloc((chunk > BENCH_RAND_BYTES) ? chunk :
+                          BENCH_RAND_BYTES);
+  fat_data = fat_host_fat16_mount(multi);
+  if ((buff == NULL) || (fat_data == NULL))
+  {
+    printf("lpc_fat16: can't mount the image\n");
+    free(buff);
+    return _ERROR;
+  }
+  file_data = fat16_create_new_file_descriptor(fat_data);
+  if (file_data == NULL)
+  {
+    printf("lpc_fat16: no file descriptor\n");
+    fat16_shutdown(fat_data);
+    free(buff);
+    return _ERROR;
+  }
+  strcpy((char *) name, BENCH_FILE_NAME);
+  fat16_delete(file_data, name);
+
+  /* Sequential write and read */
+  bench_start();
+  if (bench_fat16_write(file_data, buff, size, chunk, 0) != _NO_ERROR)
+  {
+    goto done;
+  }
+  bench_report("fat16 seq write", size, 0);
+
+  bench_start();
+  bytes = bench_fat16_read(file_data, buff, size, chunk);
+  bench_report("fat16 seq read", bytes, 0);
+
+  /* Random reads */
+  bench_start();
+  bytes = bench_fat16_rand(file_data, buff, size, reads);
+  bench_report("fat16 rand read", bytes, 0);
+
+  /* Small files */
+  if (bench_fat16_files(file_data, buff, files, passes,
+                        "fat16") != _NO_ERROR)
+  {
+    goto done;
+  }
+
+  /* Sequential write into reserved clusters, the test file is read
+     back by the cached and s1l_fat phases */
+  fat16_delete(file_data, name);
+  bench_start();
+  if (bench_fat16_write(file_data, buff, size, chunk,
+                        size + BENCH_PREALLOC_SLACK) != _NO_ERROR)
+  {
+    goto done;
+  }
+  bench_report("fat16 prealloc write", size, 0);
+
+  /* The same reads and small files through the sector cache */
+  if (cache_kb != 0)
+  {
+    cache = (UNS_8 *) malloc(cache_kb * 1024);
+    lines = (cache == NULL) ? 0 :
+            fat16_cache_init(fat_data, cache, cache_kb * 1024,
+                             BENCH_CACHE_WAYS);
+    if (lines <= 0)
+    {
+      printf("lpc_fat16: can't set up a %u K byte cache\n", cache_kb);
+      goto done;
+    }
+
+    bench_start();
+    bytes = bench_fat16_read(file_data, buff, size, chunk);
+    bench_report("fat16 cached read", bytes, 0);
+
+    bench_start();
+    bytes = bench_fat16_rand(file_data, buff, size, reads);
+    bench_report("fat16 cached rand", bytes, 0);
+
+    if (bench_fat16_files(file_data, buff, files, passes,
+                          "fat16 cached") != _NO_ERROR)
+    {
+      goto done;
+    }
+
+    fat16_cache_get_stats(fat_data, &hits, &misses, &writebacks);
+    printf("fat16 cache: %d lines, %u hits, %u misses, "
+           "%u write backs\n", lines, hits, misses, writebacks);
+  }
+
+  status = _NO_ERROR;
+
+done:
+  /* Write back the directory, FAT, and cached sectors */
+  bench_start();
+  fat16_destroy_file_descriptor(file_data);
+  fat16_shutdown(fat_data);
+  bench_report("fat16 shutdown", 0, 1);
+  free(cache);
+  free(buff);
+
+  return status;
+}
+
+/***********************************************************************
+ *
+ * Function: bench_s1l
+ *
+ * Purpose: Run the s1l_fat phases
+ *
+ * Processing:
+ *     Bind s1l_fat to the image with fat_init(), read the test file
+ *     with fat_file_read_direct and with fat_file_read in chunks, and
+ *     list the root directory.
+ *
+ * Parameters:
+ *     size   : Test file size in bytes
+ *     chunk  : Bytes per streamed read call
+ *     passes : Number of directory listings
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if all operations passed, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS bench_s1l(UNS_32 size, UNS_32 chunk, UNS_32 passes)
+{
+  UNS_8 name[16], dir[16];
+  UNS_8 *buff;
+  UNS_32 pos, idx, entries = 0;
+  INT_32 got;
+  BOOL_32 last;
+
+  /* Word aligned, as an S1L load address */
+  buff = (UNS_8 *) malloc(size + 4);
+  if ((buff == NULL) || (fat_init() == FALSE))
+  {
+    printf("s1l_fat: can't mount the image\n");
+    free(buff);
+    return _ERROR;
+  }
+  strcpy((char *) name, BENCH_FILE_NAME);
+
+  /* Whole file read to memory */
+  bench_start();
+  got = 0;
+  if (fat_file_open(name) == TRUE)
+  {
+    got = fat_file_read_direct(buff, (INT_32) size);
+  }
+  bench_report("s1l direct read", (UNS_32) got, 0);
+  if ((UNS_32) got != size)
+  {
+    printf("s1l_fat: read %d of %u bytes\n", got, size);
+    mismatches++;
+  }
+  bench_check(buff, 0, (UNS_32) got);
+
+  /* Streamed read */
+  bench_start();
+  pos = 0;
+  if (fat_file_open(name) == TRUE)
+  {
+    do
+    {
+      got = fat_file_read(buff, (INT_32) chunk);
+      bench_check(buff, pos, (UNS_32) got);
+      pos += (UNS_32) got;
+    } while ((got > 0) && (pos < size));
+  }
+  bench_report("s1l stream read", pos, 0);
+  if (pos != size)
+  {
+    printf("s1l_fat: streamed %u of %u bytes\n", pos, size);
+    mismatches++;
+  }
+
+  /* Root directory listing */
+  bench_start();
+  for (idx = 0; idx < passes; idx++)
+  {
+    last = fat_get_dir(dir, TRUE);
+    while (dir[0] != '\0')
+    {
+      entries++;
+      if (last == TRUE)
+      {
+        break;
+      }
+      last = fat_get_dir(dir, FALSE);
+    }
+  }
+  bench_report("s1l dir list", 0, entries);
+
+  fat_deinit();
+  free(buff);
+
+  return _NO_ERROR;
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: main
+ *
+ * Purpose: Benchmark entry point
+ *
+ * Processing:
+ *     Parse the options, open the image, and run the lpc_fat16 and
+ *     s1l_fat phases.
+ *
+ * Parameters:
+ *     argc : Number of arguments
+ *     argv : Arguments
+ *
+ * Outputs: None
+ *
+ * Returns: 0 if all operations passed and all data matched, otherwise
+ *          1
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+int main(int argc, char *argv[])
+{
+  UNS_32 size = BENCH_DEF_FILE_KB * 1024, chunk = BENCH_DEF_CHUNK;
+  UNS_32 reads = BENCH_DEF_READS, files = BENCH_DEF_FILES;
+  UNS_32 passes = BENCH_DEF_PASSES, cache_kb = BENCH_DEF_CACHE_KB;
+  BOOL_32 multi = TRUE;
+  const char *image = NULL;
+  STATUS status;
+  int idx;
+
+  for (idx = 1; idx < argc; idx++)
+  {
+    if ((strcmp(argv[idx], "-i") == 0) && (idx + 1 < argc))
+    {
+      image = argv[++idx];
+    }
+    else if ((strcmp(argv[idx], "-k") == 0) && (idx + 1 < argc))
+    {
+      size = (UNS_32) strtoul(argv[++idx], NULL, 0) * 1024;
+    }
+    else if ((strcmp(argv[idx], "-c") == 0) && (idx + 1 < argc))
+    {
+      chunk = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-r") == 0) && (idx + 1 < argc))
+    {
+      reads = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-n") == 0) && (idx + 1 < argc))
+    {
+      files = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-l") == 0) && (idx + 1 < argc))
+    {
+      passes = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-w") == 0) && (idx + 1 < argc))
+    {
+      cache_kb = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-s") == 0) && (idx + 1 < argc))
+    {
+      randstate = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if (strcmp(argv[idx], "-1") == 0)
+    {
+      multi = FALSE;
+    }
+    else
+    {
+      image = NULL;
+      break;
+    }
+  }
+
+  if ((image == NULL) || (size < FAT_HOST_SECTOR_SIZE) ||
+      (chunk == 0) || (chunk > BENCH_MAX_CHUNK) || (files > 500) ||
+      (cache_kb > 65536))
+  {
+    printf("usage: fat_bench -i image [-k file_kb] [-c chunk] "
+           "[-r reads] [-n files]\n"
+           "                 [-l passes] [-w cache_kb] [-s seed] [-1]\n");
+    return 1;
+  }
+  seedbyte = (UNS_8) randstate;
+
+  if (fat_host_open(image) == FALSE)
+  {
+    printf("Can't open %s\n", image);
+    return 1;
+  }
+
+  status = bench_fat16(multi, size, chunk, reads, files, passes,
+                       cache_kb);
+  if (status == _NO_ERROR)
+  {
+    status = bench_s1l(size, chunk, passes);
+  }
+  fat_host_close();
+
+  if ((status != _NO_ERROR) || (mismatches != 0))
+  {
+    printf("FAIL\n");
+    return 1;
+  }
+  printf("ok\n");
+
+  return 0;
+}
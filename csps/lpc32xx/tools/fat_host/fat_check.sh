@@ -0,0 +1,53 @@
+#!/bin/sh
+# $Id:: fat_check.sh                                                   $
+#
+# Makes new FAT16 images with fat_image, one without and one with an
+# MBR, runs fat_bench on each twice (the second run replaces the test
+# file), and checks the image with fat_image after each run. If mkfs.fat
+# is installed, an image made by it is also run, and if fsck.fat is
+# installed, it also checks each image. Options are passed to fat_bench.
+#
+# usage: fat_check.sh [fat_bench options]
+#
+# FAT_IMAGE sets the image file (fat_check.img), FAT_SIZE_KB its size
+# (32768).
+
+IMAGE=${FAT_IMAGE:-fat_check.img}
+SIZE_KB=${FAT_SIZE_KB:-32768}
+
+LAYOUTS="plain mbr"
+if command -v mkfs.fat > /dev/null 2>&1; then
+  LAYOUTS="$LAYOUTS mkfs"
+fi
+
+for layout in $LAYOUTS; do
+  echo "== $layout image"
+  rm -f "$IMAGE"
+  case $layout in
+    plain) ./fat_image -i "$IMAGE" -m "$SIZE_KB" > /dev/null ;;
+    mbr)   ./fat_image -i "$IMAGE" -m "$SIZE_KB" -p > /dev/null ;;
+    mkfs)  mkfs.fat -F 16 -C "$IMAGE" "$SIZE_KB" > /dev/null ;;
+  esac
+  if [ $? -ne 0 ]; then
+    echo "can't make the $layout image"
+    exit 1
+  fi
+
+  for run in 1 2; do
+    if ! ./fat_bench -i "$IMAGE" "$@"; then
+      exit 1
+    fi
+    if ! ./fat_image -i "$IMAGE"; then
+      echo "fat_image found errors after run $run"
+      exit 1
+    fi
+    if command -v fsck.fat > /dev/null 2>&1 &&
+       ! fsck.fat -n "$IMAGE"; then
+      echo "fsck.fat found errors after run $run"
+      exit 1
+    fi
+  done
+done
+
+echo "images ok"
+exit 0
@@ -0,0 +1,782 @@
+/***********************************************************************
+ * $Id:: fat_host.c                                                    $
+ *
+ * Project: Host FAT image device
+ *
+ * Description:
+ *     Provides the lpc_fat16 device functions and the S1L block
+ *     device functions (blkdev_xxx) on a FAT image file, so both FAT
+ *     drivers can be run, checked, and measured on a PC. Every read
+ *     and write command and sector moved is counted.
+ *
+ *     lpc_new, lpc_new_placed, and lpc_free are provided with the C
+ *     library heap, as lpc_heap keeps addresses in 32 bits and does
+ *     not run on a 64-bit host.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lpc_heap.h"
+#include "s1l_sys_inf.h"
+#include "fat_host.h"
+
+/***********************************************************************
+ * Package data
+ **********************************************************************/
+
+/* Image file and its size in sectors */
+static FILE *imgfile;
+static UNS_32 imgsectors;
+
+/* Sector selected by the lpc_fat16 set sector function, and the data
+   of the last sector read for it */
+static UNS_32 cursector;
+static UNS_8 secbuff[FAT_HOST_SECTOR_SIZE];
+
+/* Device name passed to lpc_fat16 */
+static CHAR devname[DSIZE] = "image";
+
+static FAT_HOST_STATS_T hoststats;
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: host_io
+ *
+ * Purpose: Move sectors between the image file and a buffer
+ *
+ * Processing:
+ *     Check that the sectors are in the image, seek to the first one,
+ *     and read or write them.
+ *
+ * Parameters:
+ *     sector : First sector
+ *     buff   : Buffer
+ *     count  : Number of sectors
+ *     write  : TRUE to write the image, FALSE to read it
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the sectors were moved, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 host_io(UNS_32 sector, void *buff, UNS_32 count,
+                       BOOL_32 write)
+{
+  size_t len = (size_t) count * FAT_HOST_SECTOR_SIZE;
+
+  if ((imgfile == NULL) || (sector >= imgsectors) ||
+      (count > (imgsectors - sector)))
+  {
+    return FALSE;
+  }
+
+  if (fseek(imgfile, (long) sector * FAT_HOST_SECTOR_SIZE,
+            SEEK_SET) != 0)
+  {
+    return FALSE;
+  }
+  if (write == TRUE)
+  {
+    return (BOOL_32) (fwrite(buff, 1, len, imgfile) == len);
+  }
+
+  return (BOOL_32) (fread(buff, 1, len, imgfile) == len);
+}
+
+/***********************************************************************
+ *
+ * Function: host_init
+ *
+ * Purpose: lpc_fat16 device init, insert check, and ready check
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: 1 if the image is open, otherwise 0
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 host_init(void)
+{
+  return (imgfile != NULL) ? 1 : 0;
+}
+
+/***********************************************************************
+ *
+ * Function: host_shutdown
+ *
+ * Purpose: lpc_fat16 device shutdown
+ *
+ * Processing:
+ *     Flush the image file.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void host_shutdown(void)
+{
+  if (imgfile != NULL)
+  {
+    fflush(imgfile);
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: host_busy
+ *
+ * Purpose: lpc_fat16 device busy check
+ *
+ * Processing:
+ *     File operations complete at once, the device is never busy.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: 0
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 host_busy(void)
+{
+  return 0;
+}
+
+/***********************************************************************
+ *
+ * Function: host_set_sector
+ *
+ * Purpose: lpc_fat16 set sector function
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector : Absolute sector of the next command
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void host_set_sector(UNS_32 sector)
+{
+  cursector = sector;
+}
+
+/***********************************************************************
+ *
+ * Function: host_start_read
+ *
+ * Purpose: lpc_fat16 read start function
+ *
+ * Processing:
+ *     Read the selected sector into the sector buffer, as a card
+ *     reads it into its data buffer. A sector outside the image reads
+ *     as zeros.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void host_start_read(void)
+{
+  hoststats.commands++;
+  hoststats.sectors_read++;
+  if (host_io(cursector, secbuff, 1, FALSE) == FALSE)
+  {
+    memset(secbuff, 0, sizeof(secbuff));
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: host_start_write
+ *
+ * Purpose: lpc_fat16 write start function
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void host_start_write(void)
+{
+  hoststats.commands++;
+}
+
+/***********************************************************************
+ *
+ * Function: host_read
+ *
+ * Purpose: lpc_fat16 read function
+ *
+ * Processing:
+ *     Copy the start of the sector read by host_start_read.
+ *
+ * Parameters:
+ *     buff  : Where to place the data
+ *     bytes : Number of bytes, at most a sector
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes copied
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 host_read(void *buff, INT_32 bytes)
+{
+  if (bytes > FAT_HOST_SECTOR_SIZE)
+  {
+    bytes = FAT_HOST_SECTOR_SIZE;
+  }
+  memcpy(buff, secbuff, (size_t) bytes);
+
+  return bytes;
+}
+
+/***********************************************************************
+ *
+ * Function: host_write
+ *
+ * Purpose: lpc_fat16 write function
+ *
+ * Processing:
+ *     Write a sector to the sector selected for the write command.
+ *
+ * Parameters:
+ *     buff  : Sector data
+ *     bytes : Number of bytes, a sector
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes written, or 0 on a fail
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 host_write(void *buff, INT_32 bytes)
+{
+  if ((bytes != FAT_HOST_SECTOR_SIZE) ||
+      (host_io(cursector, buff, 1, TRUE) == FALSE))
+  {
+    return 0;
+  }
+  hoststats.sectors_written++;
+
+  return bytes;
+}
+
+/***********************************************************************
+ *
+ * Function: host_read_multi
+ *
+ * Purpose: lpc_fat16 multi-sector read function
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector : First absolute sector
+ *     buff   : Where to place the data
+ *     count  : Number of sectors
+ *
+ * Outputs: None
+ *
+ * Returns: The number of sectors read
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 host_read_multi(UNS_32 sector, void *buff, UNS_32 count)
+{
+  hoststats.commands++;
+  hoststats.multi_commands++;
+  if (host_io(sector, buff, count, FALSE) == FALSE)
+  {
+    return 0;
+  }
+  hoststats.sectors_read += count;
+
+  return (INT_32) count;
+}
+
+/***********************************************************************
+ *
+ * Function: host_write_multi
+ *
+ * Purpose: lpc_fat16 multi-sector write function
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector : First absolute sector
+ *     buff   : Sector data
+ *     count  : Number of sectors
+ *
+ * Outputs: None
+ *
+ * Returns: The number of sectors written
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 host_write_multi(UNS_32 sector, void *buff, UNS_32 count)
+{
+  hoststats.commands++;
+  hoststats.multi_commands++;
+  if (host_io(sector, buff, count, TRUE) == FALSE)
+  {
+    return 0;
+  }
+  hoststats.sectors_written += count;
+
+  return (INT_32) count;
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: fat_host_open
+ *
+ * Purpose: Open a FAT image file as the device
+ *
+ * Processing:
+ *     Open the file for update and find its size in sectors. Clear
+ *     the counters.
+ *
+ * Parameters:
+ *     path : Image file name
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the image was opened, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+BOOL_32 fat_host_open(const char *path)
+{
+  long size;
+
+  fat_host_close();
+
+  imgfile = fopen(path, "r+b");
+  if (imgfile == NULL)
+  {
+    return FALSE;
+  }
+
+  if ((fseek(imgfile, 0, SEEK_END) != 0) ||
+      ((size = ftell(imgfile)) < FAT_HOST_SECTOR_SIZE))
+  {
+    fat_host_close();
+    return FALSE;
+  }
+  imgsectors = (UNS_32) (size / FAT_HOST_SECTOR_SIZE);
+  fat_host_reset_stats();
+
+  return TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: fat_host_close
+ *
+ * Purpose: Close the FAT image file
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void fat_host_close(void)
+{
+  if (imgfile != NULL)
+  {
+    fclose(imgfile);
+    imgfile = NULL;
+  }
+  imgsectors = 0;
+}
+
+/***********************************************************************
+ *
+ * Function: fat_host_get_stats
+ *
+ * Purpose: Return the device operation counters
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     stats : Where to place the counters
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void fat_host_get_stats(FAT_HOST_STATS_T *stats)
+{
+  *stats = hoststats;
+}
+
+/***********************************************************************
+ *
+ * Function: fat_host_reset_stats
+ *
+ * Purpose: Clear the device operation counters
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void fat_host_reset_stats(void)
+{
+  memset(&hoststats, 0, sizeof(hoststats));
+}
+
+/***********************************************************************
+ *
+ * Function: fat_host_fat16_mount
+ *
+ * Purpose: Bind lpc_fat16 to the image and mount it
+ *
+ * Processing:
+ *     Bind the device functions with fat16_init_device and, if
+ *     requested, the multi-sector functions. Select the first FAT
+ *     partition of the MBR, or the image itself if sector 0 is a
+ *     partition boot record, as on an image made by mkfs.fat.
+ *
+ * Parameters:
+ *     multi : TRUE to bind the multi-sector functions
+ *
+ * Outputs: None
+ *
+ * Returns: The FAT device structure, or NULL if there is no FAT16
+ *          partition
+ *
+ * Notes: Release the device with fat16_shutdown().
+ *
+ **********************************************************************/
+FAT_DEVICE_TYPE *fat_host_fat16_mount(BOOL_32 multi)
+{
+  FAT_DEVICE_TYPE *fat_data;
+  INT_32 partnum;
+
+  fat_data = fat16_init_device(devname, host_init, host_shutdown,
+                               host_init, host_init, host_busy,
+                               host_set_sector, host_start_read,
+                               host_start_write, host_read, host_write);
+  if (fat_data == NULL)
+  {
+    return NULL;
+  }
+
+  if (multi == TRUE)
+  {
+    fat16_set_multi_funcs(fat_data, host_read_multi, host_write_multi);
+  }
+
+  partnum = fat16_get_active_mbr(fat_data, 0, 1);
+  if ((partnum < 0) || (fat16_set_partition(partnum, fat_data) == 0))
+  {
+    fat16_shutdown(fat_data);
+    return NULL;
+  }
+
+  return fat_data;
+}
+
+/***********************************************************************
+ *
+ * Function: blkdev_init
+ *
+ * Purpose: S1L block device init
+ *
+ * Processing:
+ *     s1l_fat binds its FAT_DATA_T read functions to the blkdev_xxx
+ *     functions in fat_init(), these give it the image file.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the image is open, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+BOOL_32 blkdev_init(void)
+{
+  return (BOOL_32) (imgfile != NULL);
+}
+
+/***********************************************************************
+ *
+ * Function: blkdev_deinit
+ *
+ * Purpose: S1L block device close
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE
+ *
+ * Notes: The image stays open for fat_host_close().
+ *
+ **********************************************************************/
+BOOL_32 blkdev_deinit(void)
+{
+  return TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: blkdev_read
+ *
+ * Purpose: S1L block device sector read
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     buff   : Where to place the data
+ *     sector : Sector number
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the sector was read, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+BOOL_32 blkdev_read(void *buff, UNS_32 sector)
+{
+  hoststats.commands++;
+  if (host_io(sector, buff, 1, FALSE) == FALSE)
+  {
+    return FALSE;
+  }
+  hoststats.sectors_read++;
+
+  return TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: blkdev_read_multi
+ *
+ * Purpose: S1L block device multi-sector read
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     buff   : Where to place the data
+ *     sector : First sector
+ *     count  : Number of sectors
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the sectors were read, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+BOOL_32 blkdev_read_multi(void *buff, UNS_32 sector, UNS_32 count)
+{
+  hoststats.commands++;
+  hoststats.multi_commands++;
+  if (host_io(sector, buff, count, FALSE) == FALSE)
+  {
+    return FALSE;
+  }
+  hoststats.sectors_read += count;
+
+  return TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: blkdev_write_multi
+ *
+ * Purpose: S1L block device multi-sector write
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     buff   : Sector data
+ *     sector : First sector
+ *     count  : Number of sectors
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the sectors were written, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+BOOL_32 blkdev_write_multi(void *buff, UNS_32 sector, UNS_32 count)
+{
+  hoststats.commands++;
+  hoststats.multi_commands++;
+  if (host_io(sector, buff, count, TRUE) == FALSE)
+  {
+    return FALSE;
+  }
+  hoststats.sectors_written += count;
+
+  return TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_new
+ *
+ * Purpose: Allocate memory from the C library heap
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     size_in_bytes : Number of bytes
+ *
+ * Outputs: None
+ *
+ * Returns: The memory, or NULL
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void *lpc_new(UNS_32 size_in_bytes)
+{
+  return malloc(size_in_bytes);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_new_placed
+ *
+ * Purpose: Allocate memory from the C library heap
+ *
+ * Processing:
+ *     The host has one memory type, the placement hint is ignored.
+ *
+ * Parameters:
+ *     size_in_bytes : Number of bytes
+ *     mem_type      : Placement hint
+ *
+ * Outputs: None
+ *
+ * Returns: The memory, or NULL
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void *lpc_new_placed(UNS_32 size_in_bytes, LPC_MEM_TYPE_T mem_type)
+{
+  (void) mem_type;
+
+  return malloc(size_in_bytes);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_free
+ *
+ * Purpose: Return memory to the C library heap
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     free_addr : Memory from lpc_new or lpc_new_placed
+ *
+ * Outputs: None
+ *
+ * Returns: 1
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+INT_32 lpc_free(void *free_addr)
+{
+  free(free_addr);
+
+  return 1;
+}
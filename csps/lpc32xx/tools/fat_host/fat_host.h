@@ -0,0 +1,79 @@
+/***********************************************************************
+ * $Id:: fat_host.h                                                    $
+ *
+ * Project: Host FAT image device
+ *
+ * Description:
+ *     Binds lpc_fat16 and the S1L FAT loader (s1l_fat) to a FAT image
+ *     file on a PC, and counts the device operations they make.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#ifndef FAT_HOST_H
+#define FAT_HOST_H
+
+#include "lpc_types.h"
+#include "lpc_fat16.h"
+
+#if defined (__cplusplus)
+extern "C"
+{
+#endif
+
+/***********************************************************************
+ * FAT image device defines
+ **********************************************************************/
+
+/* Size of a device sector */
+#define FAT_HOST_SECTOR_SIZE   512
+
+/***********************************************************************
+ * FAT image device types
+ **********************************************************************/
+
+/* Device operation counters */
+typedef struct
+{
+  UNS_32 commands;              /* Read or write commands issued */
+  UNS_32 multi_commands;        /* Commands for more than one sector */
+  UNS_32 sectors_read;          /* Sectors read */
+  UNS_32 sectors_written;       /* Sectors written */
+} FAT_HOST_STATS_T;
+
+/***********************************************************************
+ * FAT image device functions
+ **********************************************************************/
+
+/* Open a FAT image file as the device */
+BOOL_32 fat_host_open(const char *path);
+
+/* Close the FAT image file */
+void fat_host_close(void);
+
+/* Return the device operation counters */
+void fat_host_get_stats(FAT_HOST_STATS_T *stats);
+
+/* Clear the device operation counters */
+void fat_host_reset_stats(void);
+
+/* Bind lpc_fat16 to the image and mount its first FAT partition, or
+   the image itself if it has no MBR. With multi set, the
+   multi-sector functions are also bound. */
+FAT_DEVICE_TYPE *fat_host_fat16_mount(BOOL_32 multi);
+
+#if defined (__cplusplus)
+}
+#endif /*__cplusplus */
+
+#endif /* FAT_HOST_H */
@@ -0,0 +1,923 @@
+/***********************************************************************
+ * $Id:: fat_image.c                                                   $
+ *
+ * Project: Host FAT16 image maker and checker
+ *
+ * Description:
+ *     Makes an empty FAT16 image file, with or without an MBR, and
+ *     checks the file system of a FAT16 image:
+ *      - the boot sector and the partition it is found from
+ *      - all FAT copies are the same
+ *      - every file and directory chain stays in the data area, does
+ *        not run into a free or bad cluster, and is not shared with
+ *        another chain
+ *      - every file chain has the number of clusters its size needs
+ *      - no cluster is in use without being in a chain (lost)
+ *     fat_check.sh uses it in place of mkfs.fat and fsck.fat, so the
+ *     drivers can be checked on a PC without dosfstools.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "lpc_types.h"
+
+/***********************************************************************
+ * Package defines
+ **********************************************************************/
+
+#define IMG_SECTOR_SIZE        512
+#define IMG_DIR_ENTRY_SIZE     32
+
+/* Layout of a new image */
+#define IMG_RESERVED           1
+#define IMG_FATS               2
+#define IMG_ROOT_ENTRIES       512
+#define IMG_MEDIA              0xF8
+#define IMG_PART_START         63
+
+/* FAT16 cluster count limits */
+#define IMG_MIN_CLUSTERS       4085
+#define IMG_MAX_CLUSTERS       65524
+
+/* Partition types of a FAT16 partition */
+#define IMG_PART_LT32M         0x04
+#define IMG_PART_GT32M         0x06
+#define IMG_PART_LBA           0x0E
+
+/* FAT entry values */
+#define IMG_FAT_FREE           0x0000
+#define IMG_FAT_BAD            0xFFF7
+#define IMG_FAT_LAST           0xFFF8
+
+/* Directory entry attributes */
+#define IMG_ATTR_VOLUME        0x08
+#define IMG_ATTR_DIR           0x10
+#define IMG_ATTR_LFN           0x0F
+
+/* Deepest sub directory checked */
+#define IMG_MAX_DEPTH          16
+
+/* Number of errors printed */
+#define IMG_MAX_PRINT          20
+
+/***********************************************************************
+ * Package types
+ **********************************************************************/
+
+/* File system layout read from a boot sector */
+typedef struct
+{
+  UNS_32 start;                 /* First sector of the partition */
+  UNS_32 sectors;               /* Sectors in the partition */
+  UNS_32 spc;                   /* Sectors per cluster */
+  UNS_32 fats;                  /* Number of FAT copies */
+  UNS_32 fat_sectors;           /* Sectors per FAT copy */
+  UNS_32 fat_start;             /* First sector of the first FAT */
+  UNS_32 root_entries;          /* Root directory entries */
+  UNS_32 root_start;            /* First sector of the root directory */
+  UNS_32 data_start;            /* First sector of cluster 2 */
+  UNS_32 clusters;              /* Number of data clusters */
+  UNS_8 media;                  /* Media descriptor */
+} IMG_LAYOUT_T;
+
+/***********************************************************************
+ * Package data
+ **********************************************************************/
+
+static FILE *imgfile;
+static IMG_LAYOUT_T layout;
+
+/* First FAT copy, and a flag for each cluster found in a chain */
+static UNS_16 *fat;
+static UNS_8 *refs;
+
+/* Check counters */
+static UNS_32 errors, files, dirs;
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: img_put16
+ *
+ * Purpose: Store a little endian 16-bit value
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     buff  : Where to store the value
+ *     value : Value
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void img_put16(UNS_8 *buff, UNS_32 value)
+{
+  buff[0] = (UNS_8) value;
+  buff[1] = (UNS_8) (value >> 8);
+}
+
+/***********************************************************************
+ *
+ * Function: img_put32
+ *
+ * Purpose: Store a little endian 32-bit value
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     buff  : Where to store the value
+ *     value : Value
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void img_put32(UNS_8 *buff, UNS_32 value)
+{
+  img_put16(buff, value);
+  img_put16(buff + 2, value >> 16);
+}
+
+/***********************************************************************
+ *
+ * Function: img_get16
+ *
+ * Purpose: Return a little endian 16-bit value
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     buff : Where the value is stored
+ *
+ * Outputs: None
+ *
+ * Returns: The value
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 img_get16(const UNS_8 *buff)
+{
+  return (UNS_32) buff[0] | ((UNS_32) buff[1] << 8);
+}
+
+/***********************************************************************
+ *
+ * Function: img_get32
+ *
+ * Purpose: Return a little endian 32-bit value
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     buff : Where the value is stored
+ *
+ * Outputs: None
+ *
+ * Returns: The value
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 img_get32(const UNS_8 *buff)
+{
+  return img_get16(buff) | (img_get16(buff + 2) << 16);
+}
+
+/***********************************************************************
+ *
+ * Function: img_io
+ *
+ * Purpose: Move sectors between the image file and a buffer
+ *
+ * Processing:
+ *     Seek to the first sector and read or write the sectors.
+ *
+ * Parameters:
+ *     sector : First sector
+ *     buff   : Buffer
+ *     count  : Number of sectors
+ *     write  : TRUE to write the image, FALSE to read it
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the sectors were moved, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 img_io(UNS_32 sector, void *buff, UNS_32 count,
+                      BOOL_32 write)
+{
+  size_t len = (size_t) count * IMG_SECTOR_SIZE;
+
+  if (fseek(imgfile, (long) sector * IMG_SECTOR_SIZE, SEEK_SET) != 0)
+  {
+    return FALSE;
+  }
+  if (write == TRUE)
+  {
+    return (BOOL_32) (fwrite(buff, 1, len, imgfile) == len);
+  }
+
+  return (BOOL_32) (fread(buff, 1, len, imgfile) == len);
+}
+
+/***********************************************************************
+ *
+ * Function: img_error
+ *
+ * Purpose: Count a file system error
+ *
+ * Processing:
+ *     Print the first errors and count all of them.
+ *
+ * Parameters:
+ *     name : Name of the file or directory, or NULL
+ *     text : printf format of the error text, followed by its values
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void img_error(const char *name, const char *text, ...)
+{
+  va_list args;
+
+  if (errors < IMG_MAX_PRINT)
+  {
+    if (name != NULL)
+    {
+      printf("%s: ", name);
+    }
+    va_start(args, text);
+    vprintf(text, args);
+    va_end(args);
+    printf("\n");
+  }
+  errors++;
+}
+
+/***********************************************************************
+ *
+ * Function: img_make
+ *
+ * Purpose: Make an empty FAT16 image
+ *
+ * Processing:
+ *     Find the smallest power of 2 sectors per cluster that keeps the
+ *     cluster count in the FAT16 range, and the FAT size for it. Write
+ *     a zeroed image, the MBR with one FAT16 partition if asked for,
+ *     the boot sector, and the first sector of each FAT copy.
+ *
+ * Parameters:
+ *     size_kb : Image size in K bytes
+ *     mbr     : TRUE to put an MBR before the partition
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if the image was made, otherwise _ERROR
+ *
+ * Notes:
+ *     The partition starts at sector 63 when there is an MBR, as on a
+ *     card partitioned by a PC.
+ *
+ **********************************************************************/
+static STATUS img_make(UNS_32 size_kb, BOOL_32 mbr)
+{
+  UNS_8 sec[IMG_SECTOR_SIZE];
+  UNS_32 total, start, psecs, rootsecs, spc, fatsecs, clusters, idx;
+
+  total = size_kb * 2;
+  start = (mbr == TRUE) ? IMG_PART_START : 0;
+  if (total <= (start + 64))
+  {
+    printf("image too small for FAT16\n");
+    return _ERROR;
+  }
+  psecs = total - start;
+  rootsecs = (IMG_ROOT_ENTRIES * IMG_DIR_ENTRY_SIZE) / IMG_SECTOR_SIZE;
+
+  /* The FAT size is worked out from the clusters it leaves room for,
+     which only overestimates it */
+  clusters = 0;
+  fatsecs = 0;
+  for (spc = 1; spc <= 64; spc = spc * 2)
+  {
+    clusters = (psecs - IMG_RESERVED - rootsecs) / spc;
+    fatsecs = (((clusters + 2) * 2) + IMG_SECTOR_SIZE - 1) /
+              IMG_SECTOR_SIZE;
+    clusters = (psecs - IMG_RESERVED - rootsecs -
+                (IMG_FATS * fatsecs)) / spc;
+    if (clusters <= IMG_MAX_CLUSTERS)
+    {
+      break;
+    }
+  }
+  if ((clusters < IMG_MIN_CLUSTERS) || (clusters > IMG_MAX_CLUSTERS))
+  {
+    printf("%u K bytes is outside the FAT16 size range\n", size_kb);
+    return _ERROR;
+  }
+
+  memset(sec, 0, sizeof(sec));
+  for (idx = 0; idx < total; idx++)
+  {
+    if (img_io(idx, sec, 1, TRUE) == FALSE)
+    {
+      printf("can't write the image\n");
+      return _ERROR;
+    }
+  }
+
+  /* MBR with a single active FAT16 partition */
+  if (mbr == TRUE)
+  {
+    sec[0x1BE] = 0x80;
+    sec[0x1BE + 4] = (psecs < 65536) ? IMG_PART_LT32M : IMG_PART_GT32M;
+    img_put32(&sec[0x1BE + 8], start);
+    img_put32(&sec[0x1BE + 12], psecs);
+    sec[510] = 0x55;
+    sec[511] = 0xAA;
+    img_io(0, sec, 1, TRUE);
+    memset(sec, 0, sizeof(sec));
+  }
+
+  /* Boot sector */
+  sec[0] = 0xEB;
+  sec[1] = 0x3C;
+  sec[2] = 0x90;
+  memcpy(&sec[3], "LPCFAT16", 8);
+  img_put16(&sec[11], IMG_SECTOR_SIZE);
+  sec[13] = (UNS_8) spc;
+  img_put16(&sec[14], IMG_RESERVED);
+  sec[16] = IMG_FATS;
+  img_put16(&sec[17], IMG_ROOT_ENTRIES);
+  img_put16(&sec[19], (psecs < 65536) ? psecs : 0);
+  sec[21] = IMG_MEDIA;
+  img_put16(&sec[22], fatsecs);
+  img_put16(&sec[24], 63);
+  img_put16(&sec[26], 255);
+  img_put32(&sec[28], start);
+  img_put32(&sec[32], (psecs < 65536) ? 0 : psecs);
+  sec[36] = 0x80;
+  sec[38] = 0x29;
+  img_put32(&sec[39], 0x32500000 | size_kb);
+  memcpy(&sec[43], "NO NAME    FAT16   ", 19);
+  sec[510] = 0x55;
+  sec[511] = 0xAA;
+  img_io(start, sec, 1, TRUE);
+
+  /* Media and end of chain markers in clusters 0 and 1 of each FAT */
+  memset(sec, 0, sizeof(sec));
+  img_put16(&sec[0], 0xFF00 | IMG_MEDIA);
+  img_put16(&sec[2], 0xFFFF);
+  for (idx = 0; idx < IMG_FATS; idx++)
+  {
+    if (img_io(start + IMG_RESERVED + (idx * fatsecs), sec, 1,
+               TRUE) == FALSE)
+    {
+      printf("can't write the image\n");
+      return _ERROR;
+    }
+  }
+
+  printf("%u sectors, %u per cluster, %u clusters, %u FAT sectors%s\n",
+         psecs, spc, clusters, fatsecs,
+         (mbr == TRUE) ? ", MBR" : "");
+
+  return _NO_ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: img_layout
+ *
+ * Purpose: Find the FAT16 file system of an image
+ *
+ * Processing:
+ *     Use sector 0 as the boot sector if it is one, otherwise use the
+ *     first FAT16 partition of the MBR. Check the boot sector fields
+ *     and work out the file system layout from them.
+ *
+ * Parameters: None
+ *
+ * Outputs: The layout is saved in layout.
+ *
+ * Returns: _NO_ERROR if a FAT16 file system was found, otherwise
+ *          _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS img_layout(void)
+{
+  UNS_8 sec[IMG_SECTOR_SIZE];
+  UNS_32 idx, type, bps, rootsecs;
+
+  if (img_io(0, sec, 1, FALSE) == FALSE)
+  {
+    printf("can't read sector 0\n");
+    return _ERROR;
+  }
+  if ((sec[510] != 0x55) || (sec[511] != 0xAA))
+  {
+    printf("no boot signature in sector 0\n");
+    return _ERROR;
+  }
+
+  layout.start = 0;
+  if (((sec[0] != 0xEB) && (sec[0] != 0xE9)) ||
+      (memcmp(&sec[54], "FAT16", 5) != 0))
+  {
+    for (idx = 0; idx < 4; idx++)
+    {
+      type = sec[0x1BE + (idx * 16) + 4];
+      if ((type == IMG_PART_LT32M) || (type == IMG_PART_GT32M) ||
+          (type == IMG_PART_LBA))
+      {
+        layout.start = img_get32(&sec[0x1BE + (idx * 16) + 8]);
+        break;
+      }
+    }
+    if ((idx == 4) || (img_io(layout.start, sec, 1, FALSE) == FALSE))
+    {
+      printf("no FAT16 partition found\n");
+      return _ERROR;
+    }
+  }
+
+  bps = img_get16(&sec[11]);
+  layout.spc = sec[13];
+  layout.fats = sec[16];
+  layout.root_entries = img_get16(&sec[17]);
+  layout.sectors = img_get16(&sec[19]);
+  if (layout.sectors == 0)
+  {
+    layout.sectors = img_get32(&sec[32]);
+  }
+  layout.media = sec[21];
+  layout.fat_sectors = img_get16(&sec[22]);
+  if ((bps != IMG_SECTOR_SIZE) || (layout.spc == 0) ||
+      ((layout.spc & (layout.spc - 1)) != 0) || (layout.fats == 0) ||
+      (layout.fat_sectors == 0) || (layout.root_entries == 0) ||
+      (sec[510] != 0x55) || (sec[511] != 0xAA))
+  {
+    printf("bad boot sector at sector %u\n", layout.start);
+    return _ERROR;
+  }
+
+  rootsecs = ((layout.root_entries * IMG_DIR_ENTRY_SIZE) +
+              IMG_SECTOR_SIZE - 1) / IMG_SECTOR_SIZE;
+  layout.fat_start = layout.start + img_get16(&sec[14]);
+  layout.root_start = layout.fat_start +
+                      (layout.fats * layout.fat_sectors);
+  layout.data_start = layout.root_start + rootsecs;
+  if ((layout.data_start - layout.start) >= layout.sectors)
+  {
+    printf("boot sector leaves no data area\n");
+    return _ERROR;
+  }
+  layout.clusters = (layout.sectors -
+                     (layout.data_start - layout.start)) / layout.spc;
+  if ((layout.clusters < IMG_MIN_CLUSTERS) ||
+      (layout.clusters > IMG_MAX_CLUSTERS) ||
+      ((layout.clusters + 2) > (layout.fat_sectors *
+                                (IMG_SECTOR_SIZE / 2))))
+  {
+    printf("%u clusters do not fit a FAT16 file system\n",
+           layout.clusters);
+    return _ERROR;
+  }
+
+  return _NO_ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: img_load_fats
+ *
+ * Purpose: Read the FAT and compare its copies
+ *
+ * Processing:
+ *     Read the first FAT copy into fat, read the other copies and
+ *     count each one that differs from it. Check the media byte in
+ *     the entry of cluster 0.
+ *
+ * Parameters: None
+ *
+ * Outputs: fat and refs are allocated.
+ *
+ * Returns: _NO_ERROR if the FAT was read, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS img_load_fats(void)
+{
+  UNS_8 *copy, *first;
+  UNS_32 bytes, idx;
+
+  bytes = layout.fat_sectors * IMG_SECTOR_SIZE;
+  first = (UNS_8 *) malloc(bytes);
+  copy = (UNS_8 *) malloc(bytes);
+  fat = (UNS_16 *) malloc((layout.clusters + 2) * sizeof(UNS_16));
+  refs = (UNS_8 *) calloc(layout.clusters + 2, 1);
+  if ((first == NULL) || (copy == NULL) || (fat == NULL) ||
+      (refs == NULL) ||
+      (img_io(layout.fat_start, first, layout.fat_sectors,
+              FALSE) == FALSE))
+  {
+    printf("can't read the FAT\n");
+    free(first);
+    free(copy);
+    return _ERROR;
+  }
+
+  for (idx = 1; idx < layout.fats; idx++)
+  {
+    if ((img_io(layout.fat_start + (idx * layout.fat_sectors), copy,
+                layout.fat_sectors, FALSE) == FALSE) ||
+        (memcmp(first, copy, bytes) != 0))
+    {
+      img_error(NULL, "FAT copy %u differs from the first", idx + 1);
+    }
+  }
+
+  for (idx = 0; idx < (layout.clusters + 2); idx++)
+  {
+    fat[idx] = (UNS_16) img_get16(&first[idx * 2]);
+  }
+  if ((fat[0] & 0xFF) != layout.media)
+  {
+    img_error(NULL, "FAT media byte 0x%02x does not match the boot "
+              "sector", fat[0] & 0xFF);
+  }
+
+  free(first);
+  free(copy);
+
+  return _NO_ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: img_chain
+ *
+ * Purpose: Follow a cluster chain
+ *
+ * Processing:
+ *     Walk the chain from its first cluster to an end of chain entry.
+ *     Stop with an error at a cluster outside the data area, a free or
+ *     bad cluster, or a cluster that is already in a chain. Count a
+ *     use of each cluster of the chain.
+ *
+ * Parameters:
+ *     name  : Name of the file or directory
+ *     first : First cluster
+ *
+ * Outputs: None
+ *
+ * Returns: The number of clusters in the chain
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 img_chain(const char *name, UNS_32 first)
+{
+  UNS_32 clus = first, count = 0;
+
+  while (1)
+  {
+    if ((clus < 2) || (clus >= (layout.clusters + 2)))
+    {
+      img_error(name, "chain runs to cluster %u outside the data area",
+                clus);
+      break;
+    }
+    if ((fat[clus] == IMG_FAT_FREE) || (fat[clus] == IMG_FAT_BAD))
+    {
+      img_error(name, "chain runs into free or bad cluster %u", clus);
+      break;
+    }
+    if (refs[clus] != 0)
+    {
+      img_error(name, "cluster %u is in more than one chain", clus);
+      break;
+    }
+    refs[clus] = 1;
+    count++;
+
+    if (fat[clus] >= IMG_FAT_LAST)
+    {
+      break;
+    }
+    clus = fat[clus];
+  }
+
+  return count;
+}
+
+/***********************************************************************
+ *
+ * Function: img_check_dir
+ *
+ * Purpose: Check the entries of a directory
+ *
+ * Processing:
+ *     For each entry in use that is not a long name or volume label,
+ *     follow its cluster chain. A file chain must have the clusters
+ *     its size needs, and a file of size 0 no chain. The chain of a
+ *     sub directory is read and its entries are checked in turn.
+ *
+ * Parameters:
+ *     entries : Directory entries
+ *     count   : Number of entries
+ *     depth   : Directory depth, 0 for the root directory
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void img_check_dir(const UNS_8 *entries, UNS_32 count,
+                          UNS_32 depth)
+{
+  const UNS_8 *ent;
+  char name[13];
+  UNS_8 *sub;
+  UNS_32 *list;
+  UNS_32 idx, first, size, need, got, clus, cbytes, len;
+
+  cbytes = layout.spc * IMG_SECTOR_SIZE;
+  for (idx = 0; idx < count; idx++)
+  {
+    ent = &entries[idx * IMG_DIR_ENTRY_SIZE];
+    if (ent[0] == 0x00)
+    {
+      break;
+    }
+    if ((ent[0] == 0xE5) || (ent[11] == IMG_ATTR_LFN) ||
+        ((ent[11] & IMG_ATTR_VOLUME) != 0) || (ent[0] == '.'))
+    {
+      continue;
+    }
+
+    /* 8.3 name for messages */
+    for (len = 0; (len < 8) && (ent[len] != ' '); len++)
+    {
+      name[len] = (char) ent[len];
+    }
+    if (ent[8] != ' ')
+    {
+      name[len++] = '.';
+      for (got = 8; (got < 11) && (ent[got] != ' '); got++)
+      {
+        name[len++] = (char) ent[got];
+      }
+    }
+    name[len] = '\0';
+
+    first = img_get16(&ent[26]);
+    size = img_get32(&ent[28]);
+    if ((ent[11] & IMG_ATTR_DIR) == 0)
+    {
+      files++;
+      need = (size + cbytes - 1) / cbytes;
+      got = (first == 0) ? 0 : img_chain(name, first);
+      if (got != need)
+      {
+        img_error(name, "size %u needs %u clusters, chain has %u", size,
+                  need, got);
+      }
+      continue;
+    }
+
+    dirs++;
+    if ((first == 0) || (depth >= IMG_MAX_DEPTH))
+    {
+      img_error(name, "directory at depth %u has no chain or is too "
+                "deep", depth + 1);
+      continue;
+    }
+    got = img_chain(name, first);
+    list = (UNS_32 *) malloc(got * sizeof(UNS_32));
+    sub = (UNS_8 *) malloc(got * cbytes);
+    if ((list == NULL) || (sub == NULL))
+    {
+      img_error(name, "no memory for a %u cluster directory", got);
+      free(list);
+      free(sub);
+      continue;
+    }
+
+    /* Walk the chain again for its clusters, the first walk counted
+       its uses */
+    for (need = 0, clus = first; need < got; need++)
+    {
+      list[need] = clus;
+      clus = fat[clus];
+    }
+    for (need = 0; need < got; need++)
+    {
+      img_io(layout.data_start + ((list[need] - 2) * layout.spc),
+             &sub[need * cbytes], layout.spc, FALSE);
+    }
+    img_check_dir(sub, (got * cbytes) / IMG_DIR_ENTRY_SIZE,
+                  depth + 1);
+    free(list);
+    free(sub);
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: img_check
+ *
+ * Purpose: Check the FAT16 file system of an image
+ *
+ * Processing:
+ *     Find the file system, read and compare the FAT copies, check the
+ *     root directory and all sub directories, and count the clusters
+ *     that are in use without being in a chain.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if no error was found, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS img_check(void)
+{
+  UNS_8 *root;
+  UNS_32 rootsecs, clus, used = 0, lost = 0, bad = 0;
+
+  if ((img_layout() != _NO_ERROR) || (img_load_fats() != _NO_ERROR))
+  {
+    return _ERROR;
+  }
+
+  rootsecs = layout.data_start - layout.root_start;
+  root = (UNS_8 *) malloc(rootsecs * IMG_SECTOR_SIZE);
+  if ((root == NULL) ||
+      (img_io(layout.root_start, root, rootsecs, FALSE) == FALSE))
+  {
+    printf("can't read the root directory\n");
+    free(root);
+    return _ERROR;
+  }
+  img_check_dir(root, layout.root_entries, 0);
+  free(root);
+
+  for (clus = 2; clus < (layout.clusters + 2); clus++)
+  {
+    if (fat[clus] == IMG_FAT_BAD)
+    {
+      bad++;
+    }
+    else if (fat[clus] != IMG_FAT_FREE)
+    {
+      used++;
+      if (refs[clus] == 0)
+      {
+        if (lost == 0)
+        {
+          img_error(NULL, "cluster %u is used but in no chain", clus);
+        }
+        lost++;
+      }
+    }
+  }
+  if (lost > 1)
+  {
+    img_error(NULL, "%u lost clusters in all", lost);
+  }
+
+  printf("%u files, %u directories, %u of %u clusters used, %u bad\n",
+         files, dirs, used, layout.clusters, bad);
+
+  return (errors == 0) ? _NO_ERROR : _ERROR;
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: main
+ *
+ * Purpose: Image maker and checker entry point
+ *
+ * Processing:
+ *     Parse the options, then make a new image or check an image.
+ *
+ * Parameters:
+ *     argc : Number of arguments
+ *     argv : Arguments
+ *
+ * Outputs: None
+ *
+ * Returns: 0 if the image was made or has no errors, otherwise 1
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+int main(int argc, char *argv[])
+{
+  const char *image = NULL;
+  UNS_32 size_kb = 0;
+  BOOL_32 mbr = FALSE;
+  STATUS status;
+  int idx;
+
+  for (idx = 1; idx < argc; idx++)
+  {
+    if ((strcmp(argv[idx], "-i") == 0) && (idx + 1 < argc))
+    {
+      image = argv[++idx];
+    }
+    else if ((strcmp(argv[idx], "-m") == 0) && (idx + 1 < argc))
+    {
+      size_kb = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if (strcmp(argv[idx], "-p") == 0)
+    {
+      mbr = TRUE;
+    }
+    else
+    {
+      image = NULL;
+      break;
+    }
+  }
+
+  if ((image == NULL) || ((mbr == TRUE) && (size_kb == 0)))
+  {
+    printf("usage: fat_image -i image [-m size_kb [-p]]\n");
+    return 1;
+  }
+
+  imgfile = fopen(image, (size_kb != 0) ? "w+b" : "rb");
+  if (imgfile == NULL)
+  {
+    printf("Can't open %s\n", image);
+    return 1;
+  }
+  if (size_kb != 0)
+  {
+    status = img_make(size_kb, mbr);
+  }
+  else
+  {
+    status = img_check();
+  }
+  fclose(imgfile);
+  free(fat);
+  free(refs);
+
+  if (status != _NO_ERROR)
+  {
+    printf("FAIL\n");
+    return 1;
+  }
+  printf("ok\n");
+
+  return 0;
+}
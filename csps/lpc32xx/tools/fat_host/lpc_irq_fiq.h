@@ -0,0 +1,75 @@
+/***********************************************************************
+ * $Id:: lpc_irq_fiq.h                                                 $
+ *
+ * Project: Host FAT image device
+ *
+ * Description:
+ *     Takes the place of lpc/include/lpc_irq_fiq.h in a host build.
+ *     A PC program has no IRQ or FIQ exceptions to mask, so these
+ *     functions do nothing and return 0.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#ifndef LPC_IRQ_FIQ_H
+#define LPC_IRQ_FIQ_H
+
+static __inline UNS_32 disable_irq(void)
+{
+  return 0;
+}
+
+static __inline UNS_32 disable_fiq(void)
+{
+  return 0;
+}
+
+static __inline UNS_32 disable_irq_fiq(void)
+{
+  return 0;
+}
+
+static __inline UNS_32 enable_irq(void)
+{
+  return 0;
+}
+
+static __inline UNS_32 enable_fiq(void)
+{
+  return 0;
+}
+
+static __inline UNS_32 enable_irq_fiq(void)
+{
+  return 0;
+}
+
+static __inline UNS_32 disable_irq_fiq_mask(UNS_32 mask)
+{
+  (void) mask;
+  return 0;
+}
+
+static __inline UNS_32 enable_irq_fiq_mask(UNS_32 mask)
+{
+  (void) mask;
+  return 0;
+}
+
+static __inline UNS_32 restore_exceptions(UNS_32 old)
+{
+  (void) old;
+  return 0;
+}
+
+#endif /* LPC_IRQ_FIQ_H */
@@ -0,0 +1,701 @@
+/***********************************************************************
+ * $Id:: heap_bench.c                                                  $
+ *
+ * Project: Host heap benchmark
+ *
+ * Description:
+ *     Replays an allocation trace against the first-fit and the
+ *     size-class modes of lpc_heap and reports the time per
+ *     allocation and free, failed allocations, and the largest free
+ *     chunk, so the two modes can be compared on a PC.
+ *
+ *     A trace is a text file with one operation per line:
+ *         a <slot> <size>   allocate size bytes into a slot
+ *         f <slot>          free the area in a slot
+ *     Slots are numbered from 0. A trace can also be generated with
+ *     a mix of small descriptors and larger buffers, and saved for
+ *     later runs.
+ *
+ *     The data of each live allocation is filled with a pattern and
+ *     checked before it is freed, so overlapping areas are found.
+ *
+ *     The first-fit mode keeps heap addresses in 32-bit words, so on a
+ *     64-bit host the heap is mapped in the low 4 GB of the address
+ *     space.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "lpc_heap.h"
+
+/***********************************************************************
+ * Package defines
+ **********************************************************************/
+
+/* Defaults of the generated trace */
+#define BENCH_DEF_OPS          1000000
+#define BENCH_DEF_SLOTS        500
+#define BENCH_DEF_HEAP_KB      4096
+
+/* Trace operations */
+#define BENCH_OP_ALLOC         0
+#define BENCH_OP_FREE          1
+
+/***********************************************************************
+ * Package types
+ **********************************************************************/
+
+/* Trace entry */
+typedef struct
+{
+  UNS_32 op;                    /* BENCH_OP_xxx */
+  UNS_32 slot;                  /* Slot number */
+  UNS_32 size;                  /* Allocation size */
+} BENCH_OP_T;
+
+/* Results of a replay */
+typedef struct
+{
+  UNS_32 allocs;                /* Allocations done */
+  UNS_32 frees;                 /* Frees done */
+  UNS_32 failed;                /* Allocations that returned 0 */
+  UNS_32 peak_count;            /* Largest number of live allocations */
+  UNS_32 corrupt;               /* Areas with a damaged pattern */
+  UNS_64 alloc_ns;              /* Time spent in lpc_new */
+  UNS_64 free_ns;               /* Time spent in lpc_free */
+  UNS_32 largest_start;         /* Largest chunk of the empty heap */
+  UNS_32 largest_end;           /* Largest chunk after all frees */
+} BENCH_RESULT_T;
+
+/***********************************************************************
+ * Package data
+ **********************************************************************/
+
+static BENCH_OP_T *trace;
+static UNS_32 trace_ops;
+static UNS_32 trace_slots;
+static UNS_32 randstate = 1;
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: bench_rand
+ *
+ * Purpose: Return a pseudo random number
+ *
+ * Processing:
+ *     Step a linear congruential generator, so a seed gives the same
+ *     trace on every host.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: A 15-bit random number
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 bench_rand(void)
+{
+  randstate = (randstate * 1103515245) + 12345;
+
+  return (randstate >> 16) & 0x7FFF;
+}
+
+/***********************************************************************
+ *
+ * Function: bench_now_ns
+ *
+ * Purpose: Return a monotonic time in nanoseconds
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: The time in nanoseconds
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_64 bench_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ((UNS_64) ts.tv_sec * 1000000000) + (UNS_64) ts.tv_nsec;
+}
+
+/***********************************************************************
+ *
+ * Function: bench_add_op
+ *
+ * Purpose: Add an operation to the trace
+ *
+ * Processing:
+ *     Grow the trace array when it is full and append the operation.
+ *
+ * Parameters:
+ *     op   : BENCH_OP_xxx
+ *     slot : Slot number
+ *     size : Allocation size
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void bench_add_op(UNS_32 op, UNS_32 slot, UNS_32 size)
+{
+  static UNS_32 trace_max = 0;
+
+  if (trace_ops == trace_max)
+  {
+    trace_max = (trace_max == 0) ? 4096 : (trace_max * 2);
+    trace = (BENCH_OP_T *) realloc(trace, trace_max * sizeof(BENCH_OP_T));
+    if (trace == NULL)
+    {
+      printf("Out of memory for the trace\n");
+      exit(1);
+    }
+  }
+
+  trace[trace_ops].op = op;
+  trace[trace_ops].slot = slot;
+  trace[trace_ops].size = size;
+  trace_ops++;
+
+  if (slot >= trace_slots)
+  {
+    trace_slots = slot + 1;
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: bench_generate
+ *
+ * Purpose: Generate a trace
+ *
+ * Processing:
+ *     Pick a random slot for each operation. A free slot is allocated
+ *     and a used slot is freed, so the number of live allocations
+ *     settles around half the slots. Most sizes are small descriptors
+ *     of up to 256 bytes, 1 in 10 is a buffer of up to 8K. The slots
+ *     still used at the end are freed.
+ *
+ * Parameters:
+ *     ops   : Number of operations
+ *     slots : Number of slots
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void bench_generate(UNS_32 ops, UNS_32 slots)
+{
+  UNS_8 *used = (UNS_8 *) calloc(slots, 1);
+  UNS_32 idx, slot, size;
+
+  for (idx = 0; idx < ops; idx++)
+  {
+    slot = bench_rand() % slots;
+    if (used[slot] != 0)
+    {
+      bench_add_op(BENCH_OP_FREE, slot, 0);
+      used[slot] = 0;
+    }
+    else
+    {
+      if ((bench_rand() % 10) == 0)
+      {
+        size = 256 + (((bench_rand() << 15) | bench_rand()) % 7936);
+      }
+      else
+      {
+        size = 4 + (bench_rand() % 253);
+      }
+      bench_add_op(BENCH_OP_ALLOC, slot, size);
+      used[slot] = 1;
+    }
+  }
+
+  for (slot = 0; slot < slots; slot++)
+  {
+    if (used[slot] != 0)
+    {
+      bench_add_op(BENCH_OP_FREE, slot, 0);
+    }
+  }
+
+  free(used);
+}
+
+/***********************************************************************
+ *
+ * Function: bench_load
+ *
+ * Purpose: Load a trace file
+ *
+ * Processing:
+ *     Read one operation per line, skipping blank lines and lines
+ *     starting with '#'.
+ *
+ * Parameters:
+ *     path : Trace file
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the trace was loaded, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 bench_load(const char *path)
+{
+  FILE *fp = fopen(path, "r");
+  char line[128];
+  unsigned long slot, size;
+  UNS_32 lineno = 0;
+
+  if (fp == NULL)
+  {
+    printf("Can't open %s\n", path);
+    return FALSE;
+  }
+
+  while (fgets(line, sizeof(line), fp) != NULL)
+  {
+    lineno++;
+    if (sscanf(line, " a %lu %lu", &slot, &size) == 2)
+    {
+      bench_add_op(BENCH_OP_ALLOC, (UNS_32) slot, (UNS_32) size);
+    }
+    else if (sscanf(line, " f %lu", &slot) == 1)
+    {
+      bench_add_op(BENCH_OP_FREE, (UNS_32) slot, 0);
+    }
+    else if ((line[strspn(line, " \t\r\n")] != '\0') &&
+             (line[strspn(line, " \t")] != '#'))
+    {
+      printf("%s:%u: bad trace line\n", path, lineno);
+      fclose(fp);
+      return FALSE;
+    }
+  }
+
+  fclose(fp);
+
+  return TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: bench_save
+ *
+ * Purpose: Save the trace to a file
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     path : Trace file
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the trace was saved, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 bench_save(const char *path)
+{
+  FILE *fp = fopen(path, "w");
+  UNS_32 idx;
+
+  if (fp == NULL)
+  {
+    printf("Can't create %s\n", path);
+    return FALSE;
+  }
+
+  for (idx = 0; idx < trace_ops; idx++)
+  {
+    if (trace[idx].op == BENCH_OP_ALLOC)
+    {
+      fprintf(fp, "a %u %u\n", trace[idx].slot, trace[idx].size);
+    }
+    else
+    {
+      fprintf(fp, "f %u\n", trace[idx].slot);
+    }
+  }
+
+  fclose(fp);
+
+  return TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: bench_replay
+ *
+ * Purpose: Replay the trace against one heap mode
+ *
+ * Processing:
+ *     Setup the default heap in the mode, then run each operation and
+ *     time the lpc_new and lpc_free calls. A free of an empty slot is
+ *     skipped, an allocation into a used slot frees the old area
+ *     first. New areas are filled with a pattern of their slot, which
+ *     is checked when they are freed.
+ *
+ * Parameters:
+ *     heap      : Heap area
+ *     heap_size : Size of the heap area
+ *     mode      : Heap mode
+ *     result    : Where to place the results
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void bench_replay(void *heap, UNS_32 heap_size,
+                         LPC_HEAP_MODE_T mode, BENCH_RESULT_T *result)
+{
+  void **area = (void **) calloc(trace_slots, sizeof(void *));
+  UNS_32 *size = (UNS_32 *) calloc(trace_slots, sizeof(UNS_32));
+  UNS_32 idx, slot, live = 0;
+  UNS_64 start;
+  UNS_8 *p8;
+
+  memset(result, 0, sizeof(BENCH_RESULT_T));
+  lpc_heap_init_mode(heap, heap_size, mode);
+  result->largest_start = lpc_get_largest_chunk();
+
+  for (idx = 0; idx < (trace_ops + trace_slots); idx++)
+  {
+    /* Free the slots still used after the last operation */
+    if (idx >= trace_ops)
+    {
+      slot = idx - trace_ops;
+    }
+    else
+    {
+      slot = trace[idx].slot;
+    }
+
+    if (area[slot] != NULL)
+    {
+      p8 = (UNS_8 *) area[slot];
+      if ((size[slot] > 0) &&
+          ((p8[0] != (UNS_8) slot) ||
+           (p8[size[slot] - 1] != (UNS_8) slot)))
+      {
+        result->corrupt++;
+      }
+
+      start = bench_now_ns();
+      lpc_free(area[slot]);
+      result->free_ns += bench_now_ns() - start;
+      result->frees++;
+      area[slot] = NULL;
+      live--;
+    }
+
+    if ((idx >= trace_ops) || (trace[idx].op == BENCH_OP_FREE))
+    {
+      continue;
+    }
+
+    start = bench_now_ns();
+    area[slot] = lpc_new(trace[idx].size);
+    result->alloc_ns += bench_now_ns() - start;
+    result->allocs++;
+
+    if (area[slot] == NULL)
+    {
+      result->failed++;
+    }
+    else
+    {
+      size[slot] = trace[idx].size;
+      memset(area[slot], (int) (slot & 0xFF), size[slot]);
+      live++;
+      if (live > result->peak_count)
+      {
+        result->peak_count = live;
+      }
+    }
+  }
+
+  result->largest_end = lpc_get_largest_chunk();
+
+  free(area);
+  free(size);
+}
+
+/***********************************************************************
+ *
+ * Function: bench_last_entry
+ *
+ * Purpose: Check that a freed last entry of the first-fit heap is
+ *          usable again
+ *
+ * Processing:
+ *     Setup the default heap in first-fit mode and allocate a small
+ *     area. Allocate the rest of the heap with the largest size that
+ *     fits, so the second area is the last entry and is not split.
+ *     Free the second area while the first is still used, then
+ *     allocate 200 bytes, which must succeed.
+ *
+ * Parameters:
+ *     heap      : Heap area
+ *     heap_size : Size of the heap area
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the check passed, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 bench_last_entry(void *heap, UNS_32 heap_size)
+{
+  void *a, *b = NULL, *c;
+  UNS_32 size;
+  BOOL_32 ok;
+
+  lpc_heap_init_mode(heap, heap_size, LPC_HEAP_FIRST_FIT);
+  a = lpc_new(100);
+
+  size = lpc_get_largest_chunk() & ~0x3;
+  while ((b == NULL) && (size > 0))
+  {
+    b = lpc_new(size);
+    size = size - 4;
+  }
+
+  ok = (BOOL_32) ((a != NULL) && (b != NULL) &&
+                  (lpc_get_largest_chunk() == 0));
+  if (ok == TRUE)
+  {
+    lpc_free(b);
+    c = lpc_new(200);
+    ok = (BOOL_32) (c != NULL);
+    if (c != NULL)
+    {
+      lpc_free(c);
+    }
+  }
+
+  if (a != NULL)
+  {
+    lpc_free(a);
+  }
+
+  printf("first-fit last entry free: %s\n", (ok == TRUE) ? "ok" : "FAIL");
+
+  return ok;
+}
+
+/***********************************************************************
+ *
+ * Function: bench_print
+ *
+ * Purpose: Print the results of a replay
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     name   : Mode name
+ *     result : Results
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void bench_print(const char *name, BENCH_RESULT_T *result)
+{
+  printf("%-10s %8.1f %8.1f %8u %8u %10u %10u %s\n", name,
+         (result->allocs == 0) ? 0.0 :
+         ((double) result->alloc_ns / result->allocs),
+         (result->frees == 0) ? 0.0 :
+         ((double) result->free_ns / result->frees),
+         result->failed, result->peak_count, result->largest_start,
+         result->largest_end,
+         (result->corrupt != 0) ? "CORRUPT" :
+         ((result->largest_end != result->largest_start) ?
+          "LEAK" : "ok"));
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: main
+ *
+ * Purpose: Benchmark entry point
+ *
+ * Processing:
+ *     Parse the options, load or generate the trace, check the free
+ *     of the last first-fit entry, and replay the trace against both
+ *     heap modes.
+ *
+ * Parameters:
+ *     argc : Number of arguments
+ *     argv : Arguments
+ *
+ * Outputs: None
+ *
+ * Returns: 0 if both modes and the last entry check passed,
+ *          otherwise 1
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+int main(int argc, char *argv[])
+{
+  const char *load = NULL, *save = NULL;
+  UNS_32 ops = BENCH_DEF_OPS, slots = BENCH_DEF_SLOTS;
+  UNS_32 heap_kb = BENCH_DEF_HEAP_KB;
+  BENCH_RESULT_T ff, sc;
+  BOOL_32 last_ok;
+  void *heap;
+  int idx;
+
+  for (idx = 1; idx < argc; idx++)
+  {
+    if ((strcmp(argv[idx], "-t") == 0) && (idx + 1 < argc))
+    {
+      load = argv[++idx];
+    }
+    else if ((strcmp(argv[idx], "-w") == 0) && (idx + 1 < argc))
+    {
+      save = argv[++idx];
+    }
+    else if ((strcmp(argv[idx], "-n") == 0) && (idx + 1 < argc))
+    {
+      ops = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-l") == 0) && (idx + 1 < argc))
+    {
+      slots = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-k") == 0) && (idx + 1 < argc))
+    {
+      heap_kb = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-s") == 0) && (idx + 1 < argc))
+    {
+      randstate = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else
+    {
+      printf("usage: heap_bench [-t trace] [-w trace] [-n ops] "
+             "[-l slots] [-k heap_kb] [-s seed]\n");
+      return 1;
+    }
+  }
+
+  if (load != NULL)
+  {
+    if (bench_load(load) == FALSE)
+    {
+      return 1;
+    }
+  }
+  else if ((ops == 0) || (slots == 0))
+  {
+    printf("ops and slots must not be 0\n");
+    return 1;
+  }
+  else
+  {
+    bench_generate(ops, slots);
+  }
+
+  if ((save != NULL) && (bench_save(save) == FALSE))
+  {
+    return 1;
+  }
+
+#ifdef MAP_32BIT
+  heap = mmap(NULL, heap_kb * 1024, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+  if (heap == MAP_FAILED)
+  {
+    heap = NULL;
+  }
+#else
+  heap = malloc(heap_kb * 1024);
+#endif
+  if (heap == NULL)
+  {
+    printf("Out of memory for the heap\n");
+    return 1;
+  }
+
+  last_ok = bench_last_entry(heap, heap_kb * 1024);
+
+  printf("%u operations, %u slots, %u KB heap\n", trace_ops,
+         trace_slots, heap_kb);
+  printf("%-10s %8s %8s %8s %8s %10s %10s\n", "mode", "ns/new",
+         "ns/free", "failed", "peak", "largest0", "largest1");
+
+  bench_replay(heap, heap_kb * 1024, LPC_HEAP_FIRST_FIT, &ff);
+  bench_print("first-fit", &ff);
+  bench_replay(heap, heap_kb * 1024, LPC_HEAP_SIZE_CLASS, &sc);
+  bench_print("size-class", &sc);
+
+#ifdef MAP_32BIT
+  munmap(heap, heap_kb * 1024);
+#else
+  free(heap);
+#endif
+  free(trace);
+
+  if ((last_ok == FALSE) || (ff.corrupt != 0) || (sc.corrupt != 0) ||
+      (ff.largest_end != ff.largest_start) ||
+      (sc.largest_end != sc.largest_start))
+  {
+    return 1;
+  }
+
+  return 0;
+}
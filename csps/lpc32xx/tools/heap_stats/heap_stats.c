@@ -0,0 +1,626 @@
+/***********************************************************************
+ * $Id:: heap_stats.c                                                  $
+ *
+ * Project: Host heap statistics dump reader
+ *
+ * Description:
+ *     Decodes the binary heap statistics dump written by
+ *     lpc_heap_stats_dump (magic 'HPST', version 1) and prints it, or
+ *     compares two dumps and prints the old value, the new value and
+ *     the change of each counter, histogram bucket and call site.
+ *
+ *     A dump file is either the raw binary dump or the hex text output
+ *     of the S1L "heapstat dump" command. In a text capture, lines that
+ *     hold anything but hex digits and white space (such as the
+ *     command prompt) are skipped.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/* The dump layout defines are only present with the statistics */
+#ifndef LPC_HEAP_STATS
+#define LPC_HEAP_STATS
+#endif
+#include "lpc_heap.h"
+
+/***********************************************************************
+ * Package defines
+ **********************************************************************/
+
+/* Largest dump file read */
+#define HS_MAX_FILE            65536
+
+/* Largest histogram and call site counts accepted in a dump, a build
+   may use other table sizes than this header */
+#define HS_MAX_BUCKETS         32
+#define HS_MAX_TAGS            256
+
+/* Number of header words before the histogram bucket count */
+#define HS_HEAD_WORDS          17
+
+/***********************************************************************
+ * Package types
+ **********************************************************************/
+
+/* Call site entry of a dump */
+typedef struct
+{
+  char name[LPC_HEAP_TAG_NAME_LEN + 1]; /* File name, zero ended */
+  UNS_32 line;                  /* Call site line */
+  UNS_32 allocs;                /* Number of allocations */
+  UNS_32 bytes;                 /* Number of bytes allocated */
+} HS_TAG_T;
+
+/* Decoded dump */
+typedef struct
+{
+  UNS_32 heap_size;             /* Heap size in bytes */
+  UNS_32 mode;                  /* LPC_HEAP_MODE_T */
+  UNS_32 bytes_in_use;          /* Allocated bytes, including headers */
+  UNS_32 peak_bytes;            /* Peak of bytes_in_use */
+  UNS_32 alloc_calls;           /* Number of allocation requests */
+  UNS_32 free_calls;            /* Number of successful frees */
+  UNS_32 failed_allocs;         /* Number of failed allocations */
+  UNS_32 untracked_allocs;      /* Allocations beyond the site table */
+  UNS_64 alloc_ticks;           /* Time spent in allocation */
+  UNS_64 free_ticks;            /* Time spent in free */
+  UNS_32 free_bytes;            /* Total free bytes */
+  UNS_32 largest_free;          /* Largest free chunk */
+  UNS_32 frag_permille;         /* Fragmentation (per mille) */
+  UNS_32 num_buckets;           /* Used entries in hist */
+  UNS_32 hist[HS_MAX_BUCKETS];  /* Free chunk histogram */
+  UNS_32 num_tags;              /* Used entries in tags */
+  HS_TAG_T tags[HS_MAX_TAGS];   /* Call sites */
+} HS_DUMP_T;
+
+/***********************************************************************
+ * Package data
+ **********************************************************************/
+
+static HS_DUMP_T dump_old, dump_new;
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: hs_get32
+ *
+ * Purpose: Read a little-endian 32-bit word of a dump
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     buff : Address of the word
+ *
+ * Outputs: None
+ *
+ * Returns: The word
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 hs_get32(const UNS_8 *buff)
+{
+  return (UNS_32) buff[0] | ((UNS_32) buff[1] << 8) |
+         ((UNS_32) buff[2] << 16) | ((UNS_32) buff[3] << 24);
+}
+
+/***********************************************************************
+ *
+ * Function: hs_hex_line
+ *
+ * Purpose: Decode a line of a hex text capture
+ *
+ * Processing:
+ *     Check that the line only holds hex digits and white space, then
+ *     convert each pair of digits to a byte.
+ *
+ * Parameters:
+ *     line : Text line
+ *     buff : Where to place the bytes
+ *     size : Free bytes in buff
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes decoded, 0 for a skipped line, or -1
+ *          if buff is full or a line has an odd digit count
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 hs_hex_line(const char *line, UNS_8 *buff, UNS_32 size)
+{
+  const char *p;
+  char digits[3];
+  INT_32 count = 0, num_digits = 0;
+
+  for (p = line; *p != 0; p++)
+  {
+    if (isxdigit((unsigned char) *p))
+    {
+      num_digits++;
+    }
+    else if (!isspace((unsigned char) *p))
+    {
+      return 0;
+    }
+  }
+
+  if ((num_digits & 1) != 0)
+  {
+    return -1;
+  }
+  if ((UNS_32) (num_digits / 2) > size)
+  {
+    return -1;
+  }
+
+  digits[2] = 0;
+  for (p = line; *p != 0; p++)
+  {
+    if (isxdigit((unsigned char) *p))
+    {
+      digits[0] = *p;
+      p++;
+      while (!isxdigit((unsigned char) *p))
+      {
+        p++;
+      }
+      digits[1] = *p;
+      buff[count] = (UNS_8) strtoul(digits, NULL, 16);
+      count++;
+    }
+  }
+
+  return count;
+}
+
+/***********************************************************************
+ *
+ * Function: hs_read_file
+ *
+ * Purpose: Read the bytes of a binary or hex text dump file
+ *
+ * Processing:
+ *     A file that starts with the 'HPST' magic bytes is a binary dump
+ *     and is read as is. Otherwise each line is decoded as hex text.
+ *
+ * Parameters:
+ *     path : Dump file
+ *     buff : Where to place the dump bytes, HS_MAX_FILE bytes
+ *
+ * Outputs: None
+ *
+ * Returns: The number of dump bytes, or -1 on an error
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 hs_read_file(const char *path, UNS_8 *buff)
+{
+  FILE *fp;
+  char line[512];
+  INT_32 len = 0, count;
+
+  fp = fopen(path, "rb");
+  if (fp == NULL)
+  {
+    printf("Cannot open %s\n", path);
+    return -1;
+  }
+
+  len = (INT_32) fread(buff, 1, 4, fp);
+  if ((len == 4) && (hs_get32(buff) == LPC_HEAP_DUMP_MAGIC))
+  {
+    len += (INT_32) fread(&buff[4], 1, HS_MAX_FILE - 4, fp);
+  }
+  else
+  {
+    rewind(fp);
+    len = 0;
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+      count = hs_hex_line(line, &buff[len], (UNS_32) (HS_MAX_FILE - len));
+      if (count < 0)
+      {
+        printf("%s: bad hex line: %s", path, line);
+        fclose(fp);
+        return -1;
+      }
+      len += count;
+    }
+  }
+
+  fclose(fp);
+
+  return len;
+}
+
+/***********************************************************************
+ *
+ * Function: hs_load
+ *
+ * Purpose: Read and decode a dump file
+ *
+ * Processing:
+ *     Read the dump bytes, check the magic, version and sizes, and
+ *     decode the header, histogram and call site entries.
+ *
+ * Parameters:
+ *     path : Dump file
+ *     dump : Where to place the decoded dump
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the dump was decoded, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 hs_load(const char *path, HS_DUMP_T *dump)
+{
+  static UNS_8 buff[HS_MAX_FILE];
+  const UNS_8 *in;
+  UNS_32 idx, need;
+  INT_32 len;
+
+  len = hs_read_file(path, buff);
+  if (len < 0)
+  {
+    return FALSE;
+  }
+  if (len < ((HS_HEAD_WORDS + 1) * 4))
+  {
+    printf("%s: dump is too short\n", path);
+    return FALSE;
+  }
+  if (hs_get32(&buff[0]) != LPC_HEAP_DUMP_MAGIC)
+  {
+    printf("%s: not a heap statistics dump\n", path);
+    return FALSE;
+  }
+  if (hs_get32(&buff[4]) != LPC_HEAP_DUMP_VERSION)
+  {
+    printf("%s: unsupported dump version %u\n", path,
+           hs_get32(&buff[4]));
+    return FALSE;
+  }
+
+  memset(dump, 0, sizeof(HS_DUMP_T));
+  in = &buff[8];
+  dump->heap_size = hs_get32(&in[0]);
+  dump->mode = hs_get32(&in[4]);
+  dump->bytes_in_use = hs_get32(&in[8]);
+  dump->peak_bytes = hs_get32(&in[12]);
+  dump->alloc_calls = hs_get32(&in[16]);
+  dump->free_calls = hs_get32(&in[20]);
+  dump->failed_allocs = hs_get32(&in[24]);
+  dump->untracked_allocs = hs_get32(&in[28]);
+  dump->alloc_ticks = (UNS_64) hs_get32(&in[32]) |
+                      ((UNS_64) hs_get32(&in[36]) << 32);
+  dump->free_ticks = (UNS_64) hs_get32(&in[40]) |
+                     ((UNS_64) hs_get32(&in[44]) << 32);
+  dump->free_bytes = hs_get32(&in[48]);
+  dump->largest_free = hs_get32(&in[52]);
+  dump->frag_permille = hs_get32(&in[56]);
+  dump->num_buckets = hs_get32(&in[60]);
+  in = &in[64];
+
+  if (dump->num_buckets > HS_MAX_BUCKETS)
+  {
+    printf("%s: too many histogram buckets (%u)\n", path,
+           dump->num_buckets);
+    return FALSE;
+  }
+  need = ((HS_HEAD_WORDS + 2 + dump->num_buckets) * 4);
+  if ((UNS_32) len < need)
+  {
+    printf("%s: dump is too short\n", path);
+    return FALSE;
+  }
+  for (idx = 0; idx < dump->num_buckets; idx++)
+  {
+    dump->hist[idx] = hs_get32(in);
+    in += 4;
+  }
+
+  dump->num_tags = hs_get32(in);
+  in += 4;
+  if (dump->num_tags > HS_MAX_TAGS)
+  {
+    printf("%s: too many call sites (%u)\n", path, dump->num_tags);
+    return FALSE;
+  }
+  need += dump->num_tags * (LPC_HEAP_TAG_NAME_LEN + 12);
+  if ((UNS_32) len < need)
+  {
+    printf("%s: dump is too short\n", path);
+    return FALSE;
+  }
+  for (idx = 0; idx < dump->num_tags; idx++)
+  {
+    memcpy(dump->tags[idx].name, in, LPC_HEAP_TAG_NAME_LEN);
+    dump->tags[idx].name[LPC_HEAP_TAG_NAME_LEN] = 0;
+    in += LPC_HEAP_TAG_NAME_LEN;
+    dump->tags[idx].line = hs_get32(&in[0]);
+    dump->tags[idx].allocs = hs_get32(&in[4]);
+    dump->tags[idx].bytes = hs_get32(&in[8]);
+    in += 12;
+  }
+
+  return TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: hs_print_val
+ *
+ * Purpose: Print a value, or its old and new values and the change
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     name : Value name
+ *     oval : Old value
+ *     nval : New value
+ *     diff : TRUE to print both values and the change, FALSE to only
+ *            print the new value
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void hs_print_val(const char *name, UNS_64 oval, UNS_64 nval,
+                         BOOL_32 diff)
+{
+  if (diff == FALSE)
+  {
+    printf("%-28s %14llu\n", name, (unsigned long long) nval);
+  }
+  else
+  {
+    printf("%-28s %14llu %14llu %+14lld\n", name,
+           (unsigned long long) oval, (unsigned long long) nval,
+           (long long) (nval - oval));
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: hs_find_tag
+ *
+ * Purpose: Find a call site in a dump
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     dump : Dump to search
+ *     tag  : Call site to find by file name and line
+ *
+ * Outputs: None
+ *
+ * Returns: The call site entry, or NULL if it is not in the dump
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static HS_TAG_T *hs_find_tag(HS_DUMP_T *dump, HS_TAG_T *tag)
+{
+  UNS_32 idx;
+
+  for (idx = 0; idx < dump->num_tags; idx++)
+  {
+    if ((dump->tags[idx].line == tag->line) &&
+        (strcmp(dump->tags[idx].name, tag->name) == 0))
+    {
+      return &dump->tags[idx];
+    }
+  }
+
+  return NULL;
+}
+
+/***********************************************************************
+ *
+ * Function: hs_print_tag
+ *
+ * Purpose: Print the counts of a call site
+ *
+ * Processing:
+ *     An untagged call site has no file name and is shown as
+ *     "(untagged)".
+ *
+ * Parameters:
+ *     otag : Call site in the old dump, or NULL
+ *     ntag : Call site in the new dump, or NULL
+ *     diff : TRUE to print both counts and the changes
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void hs_print_tag(HS_TAG_T *otag, HS_TAG_T *ntag, BOOL_32 diff)
+{
+  HS_TAG_T *tag = (ntag != NULL) ? ntag : otag;
+  char name[LPC_HEAP_TAG_NAME_LEN + 32];
+  char label[sizeof(name) + 16];
+
+  if (tag->name[0] == 0)
+  {
+    strcpy(name, "(untagged)");
+  }
+  else
+  {
+    sprintf(name, "%s:%u", tag->name, tag->line);
+  }
+
+  sprintf(label, "%s allocs", name);
+  hs_print_val(label, (otag != NULL) ? otag->allocs : 0,
+               (ntag != NULL) ? ntag->allocs : 0, diff);
+  sprintf(label, "%s bytes", name);
+  hs_print_val(label, (otag != NULL) ? otag->bytes : 0,
+               (ntag != NULL) ? ntag->bytes : 0, diff);
+}
+
+/***********************************************************************
+ *
+ * Function: hs_print
+ *
+ * Purpose: Print a dump, or the changes between two dumps
+ *
+ * Processing:
+ *     Print the header values and each histogram bucket with its
+ *     lower chunk size. Then print the call sites of the new dump, and
+ *     in a comparison also the call sites only found in the old dump.
+ *
+ * Parameters:
+ *     odump : Old dump, or NULL to only print ndump
+ *     ndump : New dump
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void hs_print(HS_DUMP_T *odump, HS_DUMP_T *ndump)
+{
+  static HS_DUMP_T empty;
+  BOOL_32 diff = (BOOL_32) (odump != NULL);
+  HS_DUMP_T *od = (odump != NULL) ? odump : &empty;
+  UNS_32 idx, buckets;
+  char label[40];
+
+  if (diff == TRUE)
+  {
+    printf("%-28s %14s %14s %14s\n", "", "old", "new", "change");
+  }
+
+  hs_print_val("Heap size (bytes)", od->heap_size, ndump->heap_size, diff);
+  hs_print_val("Mode (1 = size-class)", od->mode, ndump->mode, diff);
+  hs_print_val("Bytes in use", od->bytes_in_use, ndump->bytes_in_use,
+               diff);
+  hs_print_val("Peak bytes in use", od->peak_bytes, ndump->peak_bytes,
+               diff);
+  hs_print_val("Allocations", od->alloc_calls, ndump->alloc_calls, diff);
+  hs_print_val("Frees", od->free_calls, ndump->free_calls, diff);
+  hs_print_val("Failed allocations", od->failed_allocs,
+               ndump->failed_allocs, diff);
+  hs_print_val("Untracked allocations", od->untracked_allocs,
+               ndump->untracked_allocs, diff);
+  hs_print_val("Allocation ticks", od->alloc_ticks, ndump->alloc_ticks,
+               diff);
+  hs_print_val("Free ticks", od->free_ticks, ndump->free_ticks, diff);
+  hs_print_val("Free bytes", od->free_bytes, ndump->free_bytes, diff);
+  hs_print_val("Largest free chunk", od->largest_free,
+               ndump->largest_free, diff);
+  hs_print_val("Fragmentation (1/1000)", od->frag_permille,
+               ndump->frag_permille, diff);
+
+  printf("Free chunks by size (>= bytes):\n");
+  buckets = ndump->num_buckets;
+  if (od->num_buckets > buckets)
+  {
+    buckets = od->num_buckets;
+  }
+  for (idx = 0; idx < buckets; idx++)
+  {
+    sprintf(label, "  %u", 1U << idx);
+    hs_print_val(label, od->hist[idx], ndump->hist[idx], diff);
+  }
+
+  printf("Call sites:\n");
+  for (idx = 0; idx < ndump->num_tags; idx++)
+  {
+    hs_print_tag(hs_find_tag(od, &ndump->tags[idx]), &ndump->tags[idx],
+                 diff);
+  }
+  for (idx = 0; idx < od->num_tags; idx++)
+  {
+    if (hs_find_tag(ndump, &od->tags[idx]) == NULL)
+    {
+      hs_print_tag(&od->tags[idx], NULL, diff);
+    }
+  }
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: main
+ *
+ * Purpose: Dump reader entry point
+ *
+ * Processing:
+ *     With one file, print the dump. With two files, print the
+ *     changes from the first dump to the second.
+ *
+ * Parameters:
+ *     argc : Number of arguments
+ *     argv : Arguments
+ *
+ * Outputs: None
+ *
+ * Returns: 0 if the dumps were decoded, otherwise 1
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+int main(int argc, char *argv[])
+{
+  if ((argc < 2) || (argc > 3))
+  {
+    printf("usage: heap_stats dump | heap_stats old_dump new_dump\n");
+    return 1;
+  }
+
+  if (argc == 2)
+  {
+    if (hs_load(argv[1], &dump_new) == FALSE)
+    {
+      return 1;
+    }
+    hs_print(NULL, &dump_new);
+  }
+  else
+  {
+    if ((hs_load(argv[1], &dump_old) == FALSE) ||
+        (hs_load(argv[2], &dump_new) == FALSE))
+    {
+      return 1;
+    }
+    hs_print(&dump_old, &dump_new);
+  }
+
+  return 0;
+}
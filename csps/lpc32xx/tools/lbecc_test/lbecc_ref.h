@@ -0,0 +1,35 @@
+/***********************************************************************
+ * $Id:: lbecc_ref.h                                                   $
+ *
+ * Project: Reference NAND software ECC generator
+ *
+ * Description:
+ *     Table-driven 512 byte ECC generator used as the reference for
+ *     lpc_eccgenerate512.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#ifndef LBECC_REF_H
+#define LBECC_REF_H
+
+#include "lpc_lbecc.h"
+
+/* Generate the reference parity lookup tables */
+void ref_eccinittables(void);
+
+/* Generate a reference ECC for a 512 byte block of data */
+UNS_32 ref_eccgenerate512(LPC_ECC512 eccbuf,
+                          UNS_8 *datbuf);
+
+#endif /* LBECC_REF_H */
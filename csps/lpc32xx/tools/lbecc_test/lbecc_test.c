@@ -0,0 +1,496 @@
+/***********************************************************************
+ * $Id:: lbecc_test.c                                                  $
+ *
+ * Project: Host NAND software ECC test and benchmark
+ *
+ * Description:
+ *     Checks that lpc_eccgenerate512 gives the same ECC as the
+ *     previous table-driven generator (lbecc_ref.c) for random and
+ *     patterned blocks at every byte alignment, that a single bit
+ *     error is found and corrected by lpc_eccCheckAndCorrect, that
+ *     lpc_eccgenerate256 gives the parities of the SLC hardware ECC
+ *     layout computed a bit at a time, and times both generators.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lpc_lbecc.h"
+#include "lbecc_ref.h"
+
+/***********************************************************************
+ * Package defines
+ **********************************************************************/
+
+/* Defaults */
+#define TEST_DEF_BLOCKS        200000
+#define TEST_DEF_BENCH_BLOCKS  200000
+#define TEST_DEF_SEED          1
+
+/* Block data patterns */
+#define TEST_PAT_RANDOM        0  /* Random bytes */
+#define TEST_PAT_SPARSE        1  /* Mostly 0x00 with a few random bytes */
+#define TEST_PAT_ERASED        2  /* Mostly 0xFF with a few cleared bits */
+#define TEST_PAT_BYTES         3  /* Random mix of 0x00 and 0xFF bytes */
+#define TEST_PATTERNS          4
+
+/* Number of mismatches printed */
+#define TEST_MAX_REPORTS       5
+
+/***********************************************************************
+ * Package data
+ **********************************************************************/
+
+static UNS_32 randstate = TEST_DEF_SEED;
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: test_rand
+ *
+ * Purpose: Return a pseudo random number
+ *
+ * Processing:
+ *     Step a linear congruential generator, so a seed gives the same
+ *     blocks on every host.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: A 15-bit random number
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_rand(void)
+{
+  randstate = (randstate * 1103515245) + 12345;
+
+  return (randstate >> 16) & 0x7FFF;
+}
+
+/***********************************************************************
+ *
+ * Function: test_now_ns
+ *
+ * Purpose: Return a monotonic time in nanoseconds
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: The time in nanoseconds
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_64 test_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ((UNS_64) ts.tv_sec * 1000000000) + (UNS_64) ts.tv_nsec;
+}
+
+/***********************************************************************
+ *
+ * Function: test_fill
+ *
+ * Purpose: Fill a 512 byte block with a data pattern
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     datbuf  : Block to fill
+ *     pattern : TEST_PAT_xxx
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void test_fill(UNS_8 *datbuf, UNS_32 pattern)
+{
+  UNS_32 idx;
+
+  for (idx = 0; idx < 512; idx++)
+  {
+    switch (pattern)
+    {
+      case TEST_PAT_RANDOM:
+        datbuf[idx] = (UNS_8) test_rand();
+        break;
+
+      case TEST_PAT_SPARSE:
+        datbuf[idx] = ((test_rand() % 50) == 0) ? (UNS_8) test_rand() : 0;
+        break;
+
+      case TEST_PAT_ERASED:
+        datbuf[idx] = ((test_rand() % 50) == 0) ?
+                      (UNS_8) ~(1 << (test_rand() & 7)) : 0xFF;
+        break;
+
+      default:
+        datbuf[idx] = ((test_rand() & 1) != 0) ? 0xFF : 0x00;
+        break;
+    }
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: test_equivalence
+ *
+ * Purpose: Compare the ECC of lpc_eccgenerate512 with the reference
+ *
+ * Processing:
+ *     Generate blocks of each pattern at byte offsets 0 to 3 of a
+ *     word aligned buffer and compare both ECC words of the two
+ *     generators.
+ *
+ * Parameters:
+ *     blocks : Number of blocks
+ *
+ * Outputs: None
+ *
+ * Returns: The number of blocks with a different ECC
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_equivalence(UNS_32 blocks)
+{
+  static UNS_32 raw[(512 / 4) + 1];
+  UNS_8 *datbuf;
+  LPC_ECC512 eccnew, eccref;
+  UNS_32 idx, bad = 0;
+
+  for (idx = 0; idx < blocks; idx++)
+  {
+    datbuf = (UNS_8 *) raw + (idx & 3);
+    test_fill(datbuf, (idx >> 2) % TEST_PATTERNS);
+
+    lpc_eccgenerate512(eccnew, datbuf);
+    ref_eccgenerate512(eccref, datbuf);
+    if ((eccnew[0] != eccref[0]) || (eccnew[1] != eccref[1]))
+    {
+      if (bad < TEST_MAX_REPORTS)
+      {
+        printf("block %u offset %u: ECC %04x %04x, reference %04x "
+               "%04x\n", idx, idx & 3, eccnew[0], eccnew[1], eccref[0],
+               eccref[1]);
+      }
+      bad++;
+    }
+  }
+
+  return bad;
+}
+
+/***********************************************************************
+ *
+ * Function: test_ref256
+ *
+ * Purpose: Compute the SLC layout ECC of 256 bytes a bit at a time
+ *
+ * Processing:
+ *     Each set data bit toggles one column parity for each of the 3
+ *     bits of its bit number and one line parity for each of the 8
+ *     bits of its byte number. CP(2k) covers the bits with bit k of
+ *     the bit number 0 and CP(2k + 1) those with bit k set, LP(2k) and
+ *     LP(2k + 1) do the same for bit k of the byte number.
+ *
+ * Parameters:
+ *     datbuf : 256 byte block of data
+ *
+ * Outputs: None
+ *
+ * Returns: The ECC, CP0 to CP5 in bits 0 to 5 and LP0 to LP15 in
+ *          bits 6 to 21
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_ref256(const UNS_8 *datbuf)
+{
+  UNS_32 byte, bit, k, ecc = 0;
+
+  for (byte = 0; byte < 256; byte++)
+  {
+    for (bit = 0; bit < 8; bit++)
+    {
+      if ((datbuf[byte] & (1 << bit)) == 0)
+      {
+        continue;
+      }
+      for (k = 0; k < 3; k++)
+      {
+        ecc ^= 1 << ((2 * k) + ((bit >> k) & 1));
+      }
+      for (k = 0; k < 8; k++)
+      {
+        ecc ^= 1 << (6 + (2 * k) + ((byte >> k) & 1));
+      }
+    }
+  }
+
+  return ecc;
+}
+
+/***********************************************************************
+ *
+ * Function: test_generate256
+ *
+ * Purpose: Compare lpc_eccgenerate256 with the bitwise parities
+ *
+ * Processing:
+ *     Generate 256 byte blocks of each pattern at byte offsets 0 to 3
+ *     of a word aligned buffer and compare the ECC with test_ref256.
+ *
+ * Parameters:
+ *     blocks : Number of blocks
+ *
+ * Outputs: None
+ *
+ * Returns: The number of blocks with a different ECC
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_generate256(UNS_32 blocks)
+{
+  static UNS_32 raw[(512 / 4) + 1];
+  UNS_8 *datbuf;
+  UNS_32 idx, eccnew, eccref, bad = 0;
+
+  for (idx = 0; idx < blocks; idx++)
+  {
+    datbuf = (UNS_8 *) raw + (idx & 3);
+    test_fill(datbuf, (idx >> 2) % TEST_PATTERNS);
+
+    eccnew = lpc_eccgenerate256(datbuf);
+    eccref = test_ref256(datbuf);
+    if (eccnew != eccref)
+    {
+      if (bad < TEST_MAX_REPORTS)
+      {
+        printf("block %u offset %u: 256 byte ECC %06x, bitwise %06x\n",
+               idx, idx & 3, eccnew, eccref);
+      }
+      bad++;
+    }
+  }
+
+  return bad;
+}
+
+/***********************************************************************
+ *
+ * Function: test_correction
+ *
+ * Purpose: Check single bit error correction
+ *
+ * Processing:
+ *     Flip a random bit of a random block, regenerate the ECC and let
+ *     lpc_eccCheckAndCorrect repair the block, which must then match
+ *     the original. An unchanged block must check as LPC_ECC_NOERR.
+ *
+ * Parameters:
+ *     blocks : Number of blocks
+ *
+ * Outputs: None
+ *
+ * Returns: The number of failed checks
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_correction(UNS_32 blocks)
+{
+  UNS_8 datbuf[512], good[512];
+  LPC_ECC512 eccgood, eccerr;
+  UNS_32 idx, bit, bad = 0;
+
+  for (idx = 0; idx < blocks; idx++)
+  {
+    test_fill(good, idx % TEST_PATTERNS);
+    memcpy(datbuf, good, sizeof(datbuf));
+    lpc_eccgenerate512(eccgood, datbuf);
+
+    if (lpc_eccCheckAndCorrect(eccgood, eccgood, datbuf) !=
+        LPC_ECC_NOERR)
+    {
+      bad++;
+    }
+
+    bit = ((test_rand() << 15) | test_rand()) % 4096;
+    datbuf[bit >> 3] ^= (UNS_8) (1 << (bit & 7));
+    lpc_eccgenerate512(eccerr, datbuf);
+
+    if ((lpc_eccCheckAndCorrect(eccgood, eccerr, datbuf) !=
+         LPC_ECC_CORRECTED) ||
+        (memcmp(datbuf, good, sizeof(datbuf)) != 0))
+    {
+      if (bad < TEST_MAX_REPORTS)
+      {
+        printf("block %u: bit %u not corrected\n", idx, bit);
+      }
+      bad++;
+    }
+  }
+
+  return bad;
+}
+
+/***********************************************************************
+ *
+ * Function: test_bench
+ *
+ * Purpose: Time a 512 byte ECC generator
+ *
+ * Processing:
+ *     Generate the ECC of a word aligned random block a number of
+ *     times, changing one byte between calls.
+ *
+ * Parameters:
+ *     generate : ECC generator
+ *     blocks   : Number of blocks
+ *
+ * Outputs: None
+ *
+ * Returns: The time per block in nanoseconds
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static double test_bench(UNS_32 (*generate)(LPC_ECC512, UNS_8 *),
+                         UNS_32 blocks)
+{
+  static UNS_32 raw[512 / 4];
+  UNS_8 *datbuf = (UNS_8 *) raw;
+  LPC_ECC512 ecc;
+  UNS_64 start;
+  UNS_32 idx;
+
+  test_fill(datbuf, TEST_PAT_RANDOM);
+
+  start = test_now_ns();
+  for (idx = 0; idx < blocks; idx++)
+  {
+    datbuf[idx & 511]++;
+    generate(ecc, datbuf);
+  }
+
+  return (double) (test_now_ns() - start) / blocks;
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: main
+ *
+ * Purpose: Test entry point
+ *
+ * Processing:
+ *     Parse the options, run the equivalence, correction and 256 byte
+ *     ECC checks, then time both generators.
+ *
+ * Parameters:
+ *     argc : Number of arguments
+ *     argv : Arguments
+ *
+ * Outputs: None
+ *
+ * Returns: 0 if all checks passed, otherwise 1
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+int main(int argc, char *argv[])
+{
+  UNS_32 blocks = TEST_DEF_BLOCKS, bench = TEST_DEF_BENCH_BLOCKS;
+  UNS_32 bad_equal, bad_corr, bad_256;
+  double ns_ref, ns_new;
+  int idx;
+
+  for (idx = 1; idx < argc; idx++)
+  {
+    if ((strcmp(argv[idx], "-n") == 0) && (idx + 1 < argc))
+    {
+      blocks = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-b") == 0) && (idx + 1 < argc))
+    {
+      bench = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-s") == 0) && (idx + 1 < argc))
+    {
+      randstate = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else
+    {
+      printf("usage: lbecc_test [-n blocks] [-b bench_blocks] "
+             "[-s seed]\n");
+      return 1;
+    }
+  }
+
+  lpc_eccinittables();
+  ref_eccinittables();
+
+  bad_equal = test_equivalence(blocks);
+  printf("equivalence: %u blocks, %u mismatches\n", blocks, bad_equal);
+
+  bad_corr = test_correction(blocks / 10);
+  printf("correction:  %u blocks, %u failures\n", blocks / 10, bad_corr);
+
+  bad_256 = test_generate256(blocks / 10);
+  printf("256 bytes:   %u blocks, %u mismatches\n", blocks / 10, bad_256);
+
+  if (bench > 0)
+  {
+    ns_ref = test_bench(ref_eccgenerate512, bench);
+    ns_new = test_bench(lpc_eccgenerate512, bench);
+    printf("reference    %8.1f ns/block %8.1f MB/s\n", ns_ref,
+           512.0 * 1000.0 / ns_ref);
+    printf("lpc_lbecc    %8.1f ns/block %8.1f MB/s\n", ns_new,
+           512.0 * 1000.0 / ns_new);
+    printf("speedup      %8.1fx\n", ns_ref / ns_new);
+  }
+
+  if ((bad_equal != 0) || (bad_corr != 0) || (bad_256 != 0))
+  {
+    printf("FAIL\n");
+    return 1;
+  }
+  printf("ok\n");
+
+  return 0;
+}
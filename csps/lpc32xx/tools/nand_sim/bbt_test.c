@@ -0,0 +1,744 @@
+/***********************************************************************
+ * $Id:: bbt_test.c                                                    $
+ *
+ * Project: Host bad block table test on the NAND simulator
+ *
+ * Description:
+ *     Runs lpc_bbt on the nand_sim simulated NAND device on a PC and
+ *     checks the saved copies of the table on the device after each
+ *     step.
+ *
+ *     The load step leaves a corrupt copy with the highest version and
+ *     a stale older copy next to the good copies, and checks that the
+ *     newest good copy is used. The repair step erases or damages one
+ *     copy and checks that the other one is loaded and the lost copy
+ *     is written again. The relocation step fails a program and an
+ *     erase of a table block and checks that the table moves to
+ *     another reserved block and retires the failed one.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lpc_bbt.h"
+#include "s1l_sys_inf.h"
+#include "nand_sim.h"
+
+/***********************************************************************
+ * Package defines
+ **********************************************************************/
+
+/* Defaults */
+#define TEST_DEF_BLOCKS        256
+
+/* Blocks marked bad by the test, below the reserved blocks */
+#define TEST_MARK_BLOCK        100
+
+/* Words in the header of a saved copy (magic, version, number of
+   blocks, check), as written by lpc_bbt */
+#define TEST_HDR_WORDS         4
+
+/***********************************************************************
+ * Package data
+ **********************************************************************/
+
+/* Simulated device and table */
+static NAND_SIM_CFG_T simcfg;
+static NAND_GEOM_T *geom;
+static LPC_BBT_DEV_T bbtdev;
+static LPC_BBT_T bbt;
+
+/* Factory bad blocks of the simulated device */
+static const UNS_32 badblocks[] = {5, 40};
+
+/* Expected bitmap of the table */
+static UNS_32 expmap[LPC_BBT_MAX_BLOCKS / 32];
+
+/* Page buffers, word aligned */
+static UNS_32 bbtbuff[4096 / 4];
+static UNS_32 pagebuff[4096 / 4];
+
+/* Block whose programs or erases fail, or -1 for none */
+static INT_32 failwrite = -1;
+static INT_32 failerase = -1;
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: test_marker_bad
+ *
+ * Purpose: Read the bad block marker of a block for the table
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     block : Block number
+ *
+ * Outputs: None
+ *
+ * Returns: !0 if the block is marked bad
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 test_marker_bad(UNS_32 block)
+{
+  return (INT_32) flash_is_bad_block(block);
+}
+
+/***********************************************************************
+ *
+ * Function: test_read_sector
+ *
+ * Purpose: Read a sector for the table
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector : Sector to read
+ *     buff   : Where to place the sector data
+ *
+ * Outputs: None
+ *
+ * Returns: >0 on pass
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 test_read_sector(UNS_32 sector, UNS_8 *buff)
+{
+  return flash_read_sector(sector, buff, NULL);
+}
+
+/***********************************************************************
+ *
+ * Function: test_write_sector
+ *
+ * Purpose: Write a sector for the table, failing in the failwrite
+ *          block
+ *
+ * Processing:
+ *     A program in the failing block is not made and fails, as a
+ *     program status failure of a worn block.
+ *
+ * Parameters:
+ *     sector : Sector to write
+ *     buff   : Sector data
+ *
+ * Outputs: None
+ *
+ * Returns: >0 on pass
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 test_write_sector(UNS_32 sector, UNS_8 *buff)
+{
+  if ((INT_32) (sector / geom->pages_per_block) == failwrite)
+  {
+    return -1;
+  }
+
+  return flash_write_sector(sector, buff, NULL);
+}
+
+/***********************************************************************
+ *
+ * Function: test_erase_block
+ *
+ * Purpose: Erase a block for the table, failing the failerase block
+ *
+ * Processing:
+ *     An erase of the failing block is not made and fails, so the
+ *     block keeps its old contents.
+ *
+ * Parameters:
+ *     block : Block to erase
+ *
+ * Outputs: None
+ *
+ * Returns: !0 on pass
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 test_erase_block(UNS_32 block)
+{
+  if ((INT_32) block == failerase)
+  {
+    return 0;
+  }
+
+  return (INT_32) flash_erase_block(block);
+}
+
+/***********************************************************************
+ *
+ * Function: test_set
+ *
+ * Purpose: Set the bit of a block in the expected bitmap
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     block : Block number
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void test_set(UNS_32 block)
+{
+  expmap[block >> 5] |= (UNS_32) 1 << (block & 0x1F);
+}
+
+/***********************************************************************
+ *
+ * Function: test_read_copy
+ *
+ * Purpose: Read a saved copy of the table from the device
+ *
+ * Processing:
+ *     Read the pages of the copy and check the header and the check
+ *     value, the complement of the sum of the version and the bitmap
+ *     words.
+ *
+ * Parameters:
+ *     block   : Block holding the copy
+ *     magic   : Where to place the signature of the copy
+ *     version : Where to place the version of the copy
+ *     map     : Where to place the bitmap of the copy
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the block holds a good copy, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 test_read_copy(UNS_32 block, UNS_32 *magic,
+                              UNS_32 *version, UNS_32 *map)
+{
+  static UNS_32 copy[(4096 / 4) * 2];
+  UNS_32 page, idx, sum, words = (geom->num_blocks + 31) / 32;
+
+  for (page = 0; page < bbt.tblpages; page++)
+  {
+    if (flash_read_sector((block * geom->pages_per_block) + page,
+                          (UNS_8 *) copy +
+                          (page * geom->data_bytes_per_page),
+                          NULL) <= 0)
+    {
+      return FALSE;
+    }
+  }
+
+  *magic = copy[0];
+  *version = copy[1];
+  if (((copy[0] != LPC_BBT_MAGIC_PRI) && (copy[0] != LPC_BBT_MAGIC_MIR)) ||
+      (copy[2] != geom->num_blocks))
+  {
+    return FALSE;
+  }
+
+  sum = copy[1];
+  for (idx = 0; idx < words; idx++)
+  {
+    map[idx] = copy[TEST_HDR_WORDS + idx];
+    sum += map[idx];
+  }
+
+  return (BOOL_32) (copy[3] == ~sum);
+}
+
+/***********************************************************************
+ *
+ * Function: test_put_copy
+ *
+ * Purpose: Write a saved copy of the table to the device
+ *
+ * Processing:
+ *     Erase the block and write the header and bitmap in the layout of
+ *     lpc_bbt, with a good or a wrong check value.
+ *
+ * Parameters:
+ *     block   : Block for the copy
+ *     magic   : Signature of the copy
+ *     version : Version of the copy
+ *     map     : Bitmap of the copy
+ *     good    : FALSE to write a wrong check value
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: The copy must fit in one page, which holds for the default
+ *        device sizes.
+ *
+ **********************************************************************/
+static void test_put_copy(UNS_32 block, UNS_32 magic, UNS_32 version,
+                          const UNS_32 *map, BOOL_32 good)
+{
+  UNS_32 idx, sum = version, words = (geom->num_blocks + 31) / 32;
+
+  memset(pagebuff, 0xFF, sizeof(pagebuff));
+  pagebuff[0] = magic;
+  pagebuff[1] = version;
+  pagebuff[2] = geom->num_blocks;
+  for (idx = 0; idx < words; idx++)
+  {
+    pagebuff[TEST_HDR_WORDS + idx] = map[idx];
+    sum += map[idx];
+  }
+  pagebuff[3] = (good == TRUE) ? ~sum : sum;
+
+  flash_erase_block(block);
+  flash_write_sector(block * geom->pages_per_block, pagebuff, NULL);
+}
+
+/***********************************************************************
+ *
+ * Function: test_check
+ *
+ * Purpose: Check the table and its saved copies
+ *
+ * Processing:
+ *     The bitmap in memory must match the expected bitmap. The primary
+ *     and mirror blocks of the table must hold good copies of the
+ *     current version with the same bitmap and the right signatures,
+ *     and no other reserved block may hold a good copy of a newer
+ *     version.
+ *
+ * Parameters:
+ *     step : Name of the step, for messages
+ *
+ * Outputs: None
+ *
+ * Returns: The number of failed checks
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_check(const char *step)
+{
+  static UNS_32 map[LPC_BBT_MAX_BLOCKS / 32];
+  UNS_32 words = (geom->num_blocks + 31) / 32;
+  UNS_32 blk, magic, version, bad = 0;
+  INT_32 copy;
+
+  if (memcmp(bbt.map, expmap, words * 4) != 0)
+  {
+    printf("%s: bitmap differs from the expected bitmap\n", step);
+    bad++;
+  }
+
+  for (copy = 0; copy < 2; copy++)
+  {
+    if (bbt.copyblk[copy] < 0)
+    {
+      printf("%s: no %s copy\n", step,
+             (copy == 0) ? "primary" : "mirror");
+      bad++;
+      continue;
+    }
+
+    if ((test_read_copy((UNS_32) bbt.copyblk[copy], &magic, &version,
+                        map) == FALSE) ||
+        (magic != ((copy == 0) ? LPC_BBT_MAGIC_PRI : LPC_BBT_MAGIC_MIR)) ||
+        (version != bbt.version) ||
+        (memcmp(map, expmap, words * 4) != 0))
+    {
+      printf("%s: %s copy in block %d is not the current table\n", step,
+             (copy == 0) ? "primary" : "mirror", bbt.copyblk[copy]);
+      bad++;
+    }
+  }
+
+  for (blk = bbt.first_rsvd; blk < geom->num_blocks; blk++)
+  {
+    if ((test_read_copy(blk, &magic, &version, map) == TRUE) &&
+        (version > bbt.version))
+    {
+      printf("%s: block %u holds a newer copy (%u)\n", step, blk,
+             version);
+      bad++;
+    }
+  }
+
+  return bad;
+}
+
+/***********************************************************************
+ *
+ * Function: test_init
+ *
+ * Purpose: Setup the table from the device
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     step : Name of the step, for messages
+ *
+ * Outputs: None
+ *
+ * Returns: The number of failed checks
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_init(const char *step)
+{
+  memset(&bbt, 0xA5, sizeof(bbt));
+  if (lpc_bbt_init(&bbt, &bbtdev, TRUE) != _NO_ERROR)
+  {
+    printf("%s: lpc_bbt_init failed\n", step);
+    return 1;
+  }
+
+  return test_check(step);
+}
+
+/***********************************************************************
+ *
+ * Function: test_device
+ *
+ * Purpose: Create a new simulated device and a table for it
+ *
+ * Processing:
+ *     Set up an erased simulated device with the factory bad blocks,
+ *     scan it into a new table and check the factory bad blocks and
+ *     the two saved copies.
+ *
+ * Parameters:
+ *     device : NAND_SIM_xxx_PAGE
+ *     blocks : Number of blocks
+ *
+ * Outputs: None
+ *
+ * Returns: The number of failed checks
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_device(UNS_32 device, UNS_32 blocks)
+{
+  UNS_32 idx;
+
+  memset(&simcfg, 0, sizeof(simcfg));
+  simcfg.device = device;
+  simcfg.num_blocks = blocks;
+  simcfg.bad_blocks = badblocks;
+  simcfg.num_bad = 2;
+  simcfg.strict = TRUE;
+  nand_sim_setup(&simcfg);
+  geom = flash_init();
+  if (geom == NULL)
+  {
+    printf("Can't create the simulated device\n");
+    return 1;
+  }
+
+  bbtdev.num_blocks = geom->num_blocks;
+  bbtdev.pages_per_block = geom->pages_per_block;
+  bbtdev.page_size = geom->data_bytes_per_page;
+  bbtdev.marker_bad = test_marker_bad;
+  bbtdev.read_sector = test_read_sector;
+  bbtdev.write_sector = test_write_sector;
+  bbtdev.erase_block = test_erase_block;
+  bbtdev.pagebuff = (UNS_8 *) bbtbuff;
+
+  memset(expmap, 0, sizeof(expmap));
+  for (idx = 0; idx < simcfg.num_bad; idx++)
+  {
+    test_set(badblocks[idx]);
+  }
+
+  return test_init("scan");
+}
+
+/***********************************************************************
+ *
+ * Function: test_load
+ *
+ * Purpose: Check that the newest good copy is loaded
+ *
+ * Processing:
+ *     Mark a block bad, so the copies hold a new version. Then put a
+ *     copy of a higher version with a wrong check value in the primary
+ *     block and a good copy of an older version without the new bad
+ *     block in a free reserved block. The table must load the good
+ *     mirror copy, and replace the corrupt primary copy with a version
+ *     above the corrupt one.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: The number of failed checks
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_load(void)
+{
+  UNS_32 oldmap[LPC_BBT_MAX_BLOCKS / 32], blk, corrupt, bad;
+
+  memcpy(oldmap, expmap, sizeof(oldmap));
+  lpc_bbt_mark(&bbt, TEST_MARK_BLOCK, TRUE);
+  test_set(TEST_MARK_BLOCK);
+  bad = test_check("load: mark");
+
+  /* Older good copy in a reserved block not used by the table */
+  for (blk = bbt.first_rsvd; blk < geom->num_blocks; blk++)
+  {
+    if (((INT_32) blk != bbt.copyblk[0]) &&
+        ((INT_32) blk != bbt.copyblk[1]))
+    {
+      test_put_copy(blk, LPC_BBT_MAGIC_PRI, bbt.version - 1, oldmap,
+                    TRUE);
+      break;
+    }
+  }
+
+  /* Newer corrupt primary copy */
+  corrupt = bbt.version + 10;
+  test_put_copy((UNS_32) bbt.copyblk[0], LPC_BBT_MAGIC_PRI, corrupt,
+                expmap, FALSE);
+
+  bad += test_init("load: newest good copy");
+  if (bbt.version <= corrupt)
+  {
+    printf("load: version %u is not above the corrupt copy\n",
+           bbt.version);
+    bad++;
+  }
+
+  return bad;
+}
+
+/***********************************************************************
+ *
+ * Function: test_repair
+ *
+ * Purpose: Check that a lost copy is written again from the other one
+ *
+ * Processing:
+ *     Erase the mirror block and setup the table again, then damage
+ *     the primary copy with bit flips the ECC cannot correct and setup
+ *     the table again. Each time the table must load the remaining
+ *     copy and save both copies.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: The number of failed checks
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_repair(void)
+{
+  UNS_32 version, sector, bad;
+
+  version = bbt.version;
+  flash_erase_block((UNS_32) bbt.copyblk[1]);
+  bad = test_init("repair: erased mirror");
+  if (bbt.version <= version)
+  {
+    printf("repair: erased mirror was not written again\n");
+    bad++;
+  }
+
+  version = bbt.version;
+  sector = (UNS_32) bbt.copyblk[0] * geom->pages_per_block;
+  nand_sim_flip_bit(sector, 64);
+  nand_sim_flip_bit(sector, 65);
+  if (flash_read_sector(sector, pagebuff, NULL) > 0)
+  {
+    printf("repair: damaged primary copy still reads\n");
+    bad++;
+  }
+  bad += test_init("repair: damaged primary");
+  if (bbt.version <= version)
+  {
+    printf("repair: damaged primary was not written again\n");
+    bad++;
+  }
+
+  return bad;
+}
+
+/***********************************************************************
+ *
+ * Function: test_relocate
+ *
+ * Purpose: Check that a copy moves when its block fails
+ *
+ * Processing:
+ *     Fail the programs of the primary block and mark a block bad, so
+ *     the table is saved. The primary copy must move to a free
+ *     reserved block and the failed block must be retired in the
+ *     table. Do the same with a failed erase of the mirror block. Then
+ *     setup the table again from the device. With no reserved block
+ *     left, a failed program must make the save fail.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: The number of failed checks
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_relocate(void)
+{
+  INT_32 oldblk;
+  UNS_32 bad;
+
+  oldblk = bbt.copyblk[0];
+  failwrite = oldblk;
+  lpc_bbt_mark(&bbt, TEST_MARK_BLOCK + 1, TRUE);
+  test_set(TEST_MARK_BLOCK + 1);
+  test_set((UNS_32) oldblk);
+  bad = test_check("relocate: failed program");
+  if (bbt.copyblk[0] == oldblk)
+  {
+    printf("relocate: primary copy did not move\n");
+    bad++;
+  }
+
+  oldblk = bbt.copyblk[1];
+  failerase = oldblk;
+  lpc_bbt_mark(&bbt, TEST_MARK_BLOCK + 2, TRUE);
+  test_set(TEST_MARK_BLOCK + 2);
+  test_set((UNS_32) oldblk);
+  bad += test_check("relocate: failed erase");
+  if (bbt.copyblk[1] == oldblk)
+  {
+    printf("relocate: mirror copy did not move\n");
+    bad++;
+  }
+
+  bad += test_init("relocate: load");
+
+  failwrite = bbt.copyblk[0];
+  if (lpc_bbt_save(&bbt) != _ERROR)
+  {
+    printf("relocate: save with no free reserved block passed\n");
+    bad++;
+  }
+  failwrite = -1;
+  failerase = -1;
+
+  return bad;
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: main
+ *
+ * Purpose: Test entry point
+ *
+ * Processing:
+ *     Parse the options, create the device and run the load, repair
+ *     and relocation steps in turn on it.
+ *
+ * Parameters:
+ *     argc : Number of arguments
+ *     argv : Arguments
+ *
+ * Outputs: None
+ *
+ * Returns: 0 if all checks passed, otherwise 1
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+int main(int argc, char *argv[])
+{
+  UNS_32 device = NAND_SIM_SMALL_PAGE, blocks = TEST_DEF_BLOCKS, bad;
+  int idx;
+
+  for (idx = 1; idx < argc; idx++)
+  {
+    if ((strcmp(argv[idx], "-d") == 0) && (idx + 1 < argc))
+    {
+      idx++;
+      device = (strcmp(argv[idx], "large") == 0) ?
+               NAND_SIM_LARGE_PAGE : NAND_SIM_SMALL_PAGE;
+    }
+    else if ((strcmp(argv[idx], "-b") == 0) && (idx + 1 < argc))
+    {
+      blocks = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else
+    {
+      printf("usage: bbt_test [-d small|large] [-b blocks]\n");
+      return 1;
+    }
+  }
+
+  if ((blocks <= (TEST_MARK_BLOCK + 2 + LPC_BBT_RSVD_BLOCKS)) ||
+      (blocks > LPC_BBT_MAX_BLOCKS))
+  {
+    printf("blocks must be %u to %u\n",
+           TEST_MARK_BLOCK + 3 + LPC_BBT_RSVD_BLOCKS, LPC_BBT_MAX_BLOCKS);
+    return 1;
+  }
+
+  bad = test_device(device, blocks);
+  printf("scan:     %u failures\n", bad);
+  if (bad == 0)
+  {
+    bad = test_load();
+    printf("load:     %u failures\n", bad);
+  }
+  if (bad == 0)
+  {
+    bad = test_repair();
+    printf("repair:   %u failures\n", bad);
+  }
+  if (bad == 0)
+  {
+    bad = test_relocate();
+    printf("relocate: %u failures\n", bad);
+  }
+  flash_deinit();
+
+  if (bad != 0)
+  {
+    printf("FAIL\n");
+    return 1;
+  }
+  printf("ok\n");
+
+  return 0;
+}
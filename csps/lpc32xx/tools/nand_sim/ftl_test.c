@@ -0,0 +1,1023 @@
+/***********************************************************************
+ * $Id:: ftl_test.c                                                    $
+ *
+ * Project: Host FTL test on the NAND simulator
+ *
+ * Description:
+ *     Runs lpc_ftl on the nand_sim simulated NAND device on a PC and
+ *     checks every sector read back against a RAM copy of the volume.
+ *
+ *     The endurance run writes a hot and cold workload until the most
+ *     erased block reaches a given erase count, and reports the wear
+ *     spread and write amplification.
+ *
+ *     The power loss run cuts the power at a random device operation,
+ *     leaving a torn page or an unfinished erase, then mounts the FTL
+ *     again on new work memory and checks that all data synced before
+ *     the cut is still there.
+ *
+ *     The throughput run reports the rate of sequential and random
+ *     writes and reads for each garbage collection policy from the
+ *     simulated device clock, together with the device operation
+ *     counts.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lpc_ftl.h"
+#include "s1l_sys_inf.h"
+#include "nand_sim.h"
+
+/***********************************************************************
+ * Package defines
+ **********************************************************************/
+
+/* Defaults */
+#define TEST_DEF_BLOCKS        256
+#define TEST_DEF_MAX_ERASES    300
+#define TEST_DEF_CUTS          50
+#define TEST_DEF_SEED          1
+
+/* Test runs */
+#define TEST_RUN_ENDURANCE     0x1
+#define TEST_RUN_POWERLOSS     0x2
+#define TEST_RUN_THROUGHPUT    0x4
+#define TEST_RUN_ALL           0x7
+
+/* Largest number of sectors moved by one FTL call */
+#define TEST_MAX_SECTORS       128
+
+/* Sectors in a random throughput transfer (4K bytes) */
+#define TEST_RAND_SECTORS      8
+
+/* Device operations before a power cut, at most */
+#define TEST_CUT_WINDOW        2000
+
+/* Writes between power cuts */
+#define TEST_CUT_WRITES        3000
+
+/* Number of mismatches printed */
+#define TEST_MAX_REPORTS       5
+
+/***********************************************************************
+ * Package data
+ **********************************************************************/
+
+static UNS_32 randstate = TEST_DEF_SEED;
+
+/* Simulated device and FTL */
+static NAND_SIM_CFG_T simcfg;
+static LPC_FTL_DEV_T ftldev;
+static LPC_FTL_T ftl;
+static UNS_32 *ftlmem;
+static UNS_32 ftlmemsize;
+static UNS_32 numsecs;
+
+/* Factory bad blocks of the simulated device */
+static const UNS_32 badblocks[] = {5, 40};
+
+/* Volume contents as written, as of the last sync, and sectors
+   written since the last sync */
+static UNS_8 *model;
+static UNS_8 *safe;
+static UNS_8 *touched;
+
+/* Transfer buffers, word aligned */
+static UNS_32 wrbuff[(TEST_MAX_SECTORS * LPC_FTL_SECTOR_SIZE) / 4];
+static UNS_32 rdbuff[(TEST_MAX_SECTORS * LPC_FTL_SECTOR_SIZE) / 4];
+static UNS_32 tornbuff[4096 / 4];
+
+/* Device operations left before the power cut, or -1 for none, and
+   FALSE once the power is off */
+static INT_32 cutops = -1;
+static BOOL_32 powered = TRUE;
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: test_rand
+ *
+ * Purpose: Return a pseudo random number
+ *
+ * Processing:
+ *     Step a linear congruential generator, so a seed gives the same
+ *     run on every host.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: A 30-bit random number
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_rand(void)
+{
+  UNS_32 val;
+
+  randstate = (randstate * 1103515245) + 12345;
+  val = (randstate >> 16) & 0x7FFF;
+  randstate = (randstate * 1103515245) + 12345;
+
+  return (val << 15) | ((randstate >> 16) & 0x7FFF);
+}
+
+/***********************************************************************
+ *
+ * Function: test_power_cut
+ *
+ * Purpose: Count a device operation against the power cut
+ *
+ * Processing:
+ *     If a cut is armed and no operations are left, turn the power
+ *     off, otherwise count the operation.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the power is cut during this operation
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 test_power_cut(void)
+{
+  if (cutops == 0)
+  {
+    cutops = -1;
+    powered = FALSE;
+    return TRUE;
+  }
+  if (cutops > 0)
+  {
+    cutops--;
+  }
+
+  return FALSE;
+}
+
+/***********************************************************************
+ *
+ * Function: test_write_sector
+ *
+ * Purpose: FTL page program function
+ *
+ * Processing:
+ *     Program the page with flash_write_sector. If the power is cut
+ *     during the program, either leave the page erased or program it
+ *     with the start of the data and random bits cleared in the rest,
+ *     as an interrupted program does, and fail.
+ *
+ * Parameters:
+ *     sector : Page number
+ *     buff   : Page data
+ *     extra  : Spare area data, or NULL
+ *
+ * Outputs: None
+ *
+ * Returns: The data bytes written, or <0 on a fail
+ *
+ * Notes: Nothing is programmed while the power is off.
+ *
+ **********************************************************************/
+static int test_write_sector(UNS_32 sector, void *buff, void *extra)
+{
+  UNS_8 *torn = (UNS_8 *) tornbuff;
+  UNS_32 size, idx;
+
+  if (powered == FALSE)
+  {
+    return -1;
+  }
+
+  if (test_power_cut() == TRUE)
+  {
+    if ((test_rand() & 1) != 0)
+    {
+      size = ftldev.geom->data_bytes_per_page;
+      memcpy(torn, buff, size);
+      for (idx = test_rand() % size; idx < size; idx++)
+      {
+        torn[idx] &= (UNS_8) test_rand();
+      }
+      flash_write_sector(sector, torn, extra);
+    }
+    return -1;
+  }
+
+  return flash_write_sector(sector, buff, extra);
+}
+
+/***********************************************************************
+ *
+ * Function: test_erase_block
+ *
+ * Purpose: FTL block erase function
+ *
+ * Processing:
+ *     Erase the block with flash_erase_block. If the power is cut
+ *     during the erase, the block is left as it was or erased, and
+ *     the erase fails.
+ *
+ * Parameters:
+ *     block : Block number
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE on a good erase, otherwise FALSE
+ *
+ * Notes: Nothing is erased while the power is off.
+ *
+ **********************************************************************/
+static BOOL_32 test_erase_block(UNS_32 block)
+{
+  if (powered == FALSE)
+  {
+    return FALSE;
+  }
+
+  if (test_power_cut() == TRUE)
+  {
+    if ((test_rand() & 1) != 0)
+    {
+      flash_erase_block(block);
+    }
+    return FALSE;
+  }
+
+  return flash_erase_block(block);
+}
+
+/***********************************************************************
+ *
+ * Function: test_fill
+ *
+ * Purpose: Fill the write buffer with random data
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     count : Number of sectors
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void test_fill(UNS_32 count)
+{
+  UNS_32 idx;
+
+  for (idx = 0; idx < ((count * LPC_FTL_SECTOR_SIZE) / 4); idx++)
+  {
+    wrbuff[idx] = test_rand() ^ (test_rand() << 2);
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: test_write
+ *
+ * Purpose: Write random data to sectors and update the model
+ *
+ * Processing:
+ *     Fill the write buffer, write it with lpc_ftl_write, and copy it
+ *     to the model and mark the sectors as touched for the part that
+ *     was written.
+ *
+ * Parameters:
+ *     sector : First sector
+ *     count  : Number of sectors, at most TEST_MAX_SECTORS
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if all sectors were written
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 test_write(UNS_32 sector, UNS_32 count)
+{
+  INT_32 done;
+
+  test_fill(count);
+  done = lpc_ftl_write(&ftl, sector, wrbuff, count);
+  if (done > 0)
+  {
+    memcpy(model + (sector * LPC_FTL_SECTOR_SIZE), wrbuff,
+           (UNS_32) done * LPC_FTL_SECTOR_SIZE);
+  }
+  memset(touched + sector, 1, count);
+
+  return (BOOL_32) (done == (INT_32) count);
+}
+
+/***********************************************************************
+ *
+ * Function: test_verify
+ *
+ * Purpose: Compare the volume with a copy
+ *
+ * Processing:
+ *     Read the volume in TEST_MAX_SECTORS pieces and compare each
+ *     sector with the copy, skipping touched sectors if requested.
+ *
+ * Parameters:
+ *     copy      : Expected volume contents
+ *     skiptouch : TRUE to skip sectors written since the last sync
+ *
+ * Outputs: None
+ *
+ * Returns: The number of sectors that do not match
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 test_verify(const UNS_8 *copy, BOOL_32 skiptouch)
+{
+  UNS_32 sector, count, idx, bad = 0;
+  const UNS_8 *expect;
+
+  for (sector = 0; sector < numsecs; sector += count)
+  {
+    count = numsecs - sector;
+    if (count > TEST_MAX_SECTORS)
+    {
+      count = TEST_MAX_SECTORS;
+    }
+    if (lpc_ftl_read(&ftl, sector, rdbuff, count) != (INT_32) count)
+    {
+      printf("read of sectors %u to %u failed\n", sector,
+             sector + count - 1);
+      return bad + count;
+    }
+
+    for (idx = 0; idx < count; idx++)
+    {
+      if ((skiptouch == TRUE) && (touched[sector + idx] != 0))
+      {
+        continue;
+      }
+      expect = copy + ((sector + idx) * LPC_FTL_SECTOR_SIZE);
+      if (memcmp((UNS_8 *) rdbuff + (idx * LPC_FTL_SECTOR_SIZE), expect,
+                 LPC_FTL_SECTOR_SIZE) != 0)
+      {
+        if (bad < TEST_MAX_REPORTS)
+        {
+          printf("sector %u does not match\n", sector + idx);
+        }
+        bad++;
+      }
+    }
+  }
+
+  return bad;
+}
+
+/***********************************************************************
+ *
+ * Function: test_mount
+ *
+ * Purpose: Mount the FTL on new work memory
+ *
+ * Processing:
+ *     Fill the work memory and control structure with a pattern, so
+ *     nothing is carried over from the previous mount, and mount the
+ *     FTL from the device.
+ *
+ * Parameters:
+ *     format : TRUE to format the device if it has no checkpoint
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if the FTL mounted, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS test_mount(BOOL_32 format)
+{
+  memset(ftlmem, 0xA5, ftlmemsize);
+  memset(&ftl, 0xA5, sizeof(ftl));
+
+  return lpc_ftl_init(&ftl, &ftldev, ftlmem, ftlmemsize, format);
+}
+
+/***********************************************************************
+ *
+ * Function: test_device
+ *
+ * Purpose: Create a new simulated device and format the FTL on it
+ *
+ * Processing:
+ *     Set up an erased simulated device with the factory bad blocks,
+ *     bind the FTL to it through the test program and erase
+ *     functions, check that a blank device does not mount, and format
+ *     it. Allocate and clear the volume copies.
+ *
+ * Parameters:
+ *     device : NAND_SIM_xxx_PAGE
+ *     blocks : Number of blocks
+ *     policy : LPC_FTL_GC_xxx
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if the FTL was formatted, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS test_device(UNS_32 device, UNS_32 blocks, UNS_32 policy)
+{
+  NAND_GEOM_T *geom;
+  UNS_32 bytes;
+
+  memset(&simcfg, 0, sizeof(simcfg));
+  simcfg.device = device;
+  simcfg.num_blocks = blocks;
+  simcfg.bad_blocks = badblocks;
+  simcfg.num_bad = (blocks > 40) ? 2 : 0;
+  simcfg.seed = randstate;
+  simcfg.strict = TRUE;
+  nand_sim_setup(&simcfg);
+  geom = flash_init();
+  if (geom == NULL)
+  {
+    printf("Can't create the simulated device\n");
+    return _ERROR;
+  }
+
+  ftldev.geom = geom;
+  ftldev.first_block = 0;
+  ftldev.num_blocks = geom->num_blocks;
+  ftldev.gc_policy = policy;
+  ftldev.read_sector = flash_read_sector;
+  ftldev.write_sector = test_write_sector;
+  ftldev.erase_block = test_erase_block;
+  ftldev.is_bad_block = flash_is_bad_block;
+
+  free(ftlmem);
+  ftlmemsize = lpc_ftl_mem_size(&ftldev);
+  ftlmem = (UNS_32 *) malloc(ftlmemsize);
+  if (ftlmem == NULL)
+  {
+    printf("Out of memory for the FTL\n");
+    return _ERROR;
+  }
+
+  cutops = -1;
+  powered = TRUE;
+  if (test_mount(FALSE) == _NO_ERROR)
+  {
+    printf("FTL mounted a blank device\n");
+    return _ERROR;
+  }
+  if (test_mount(TRUE) != _NO_ERROR)
+  {
+    printf("FTL format failed\n");
+    return _ERROR;
+  }
+
+  numsecs = lpc_ftl_sectors(&ftl);
+  bytes = numsecs * LPC_FTL_SECTOR_SIZE;
+  free(model);
+  free(safe);
+  free(touched);
+  model = (UNS_8 *) malloc(bytes);
+  safe = (UNS_8 *) malloc(bytes);
+  touched = (UNS_8 *) malloc(numsecs);
+  if ((model == NULL) || (safe == NULL) || (touched == NULL))
+  {
+    printf("Out of memory for the volume copy\n");
+    return _ERROR;
+  }
+  memset(model, 0xFF, bytes);
+  memset(touched, 0, numsecs);
+
+  return _NO_ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: test_fill_volume
+ *
+ * Purpose: Write the whole volume once
+ *
+ * Processing:
+ *     Write all sectors in TEST_MAX_SECTORS pieces, then sync.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the volume was written
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 test_fill_volume(void)
+{
+  UNS_32 sector, count;
+
+  for (sector = 0; sector < numsecs; sector += count)
+  {
+    count = numsecs - sector;
+    if (count > TEST_MAX_SECTORS)
+    {
+      count = TEST_MAX_SECTORS;
+    }
+    if (test_write(sector, count) == FALSE)
+    {
+      return FALSE;
+    }
+  }
+
+  return (BOOL_32) (lpc_ftl_sync(&ftl) == _NO_ERROR);
+}
+
+/***********************************************************************
+ *
+ * Function: test_random_write
+ *
+ * Purpose: Write a random run of sectors
+ *
+ * Processing:
+ *     Three of four writes go to the first eighth of the volume. Most
+ *     writes are 1 to 3 sectors, some up to 40.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the sectors were written
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 test_random_write(void)
+{
+  UNS_32 sector, count;
+
+  if ((test_rand() % 4) == 0)
+  {
+    sector = test_rand() % numsecs;
+  }
+  else
+  {
+    sector = test_rand() % (numsecs / 8);
+  }
+  count = 1 + (test_rand() % (((test_rand() % 3) != 0) ? 3 : 40));
+  if (count > (numsecs - sector))
+  {
+    count = numsecs - sector;
+  }
+
+  return test_write(sector, count);
+}
+
+/***********************************************************************
+ *
+ * Function: test_endurance
+ *
+ * Purpose: Wear the device with a hot and cold workload
+ *
+ * Processing:
+ *     Fill the volume, then write random runs of sectors, mostly to a
+ *     hot region, syncing now and then, until the most erased block
+ *     reaches the erase count. Mount again and compare the volume,
+ *     then report the erase counts of the good blocks from the
+ *     simulator and the FTL counters.
+ *
+ * Parameters:
+ *     device     : NAND_SIM_xxx_PAGE
+ *     blocks     : Number of blocks
+ *     policy     : LPC_FTL_GC_xxx
+ *     max_erases : Erase count at which to stop
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if all data matched, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS test_endurance(UNS_32 device, UNS_32 blocks,
+                             UNS_32 policy, UNS_32 max_erases)
+{
+  LPC_FTL_STATS_T stats;
+  UNS_32 block, count, emin = 0xFFFFFFFF, emax = 0, good = 0, bad;
+  UNS_64 total = 0;
+
+  if ((test_device(device, blocks, policy) != _NO_ERROR) ||
+      (test_fill_volume() == FALSE))
+  {
+    return _ERROR;
+  }
+
+  lpc_ftl_get_stats(&ftl, &stats);
+  while (stats.max_erases < max_erases)
+  {
+    for (count = 0; count < 1000; count++)
+    {
+      if (test_random_write() == FALSE)
+      {
+        printf("endurance: write failed\n");
+        return _ERROR;
+      }
+    }
+    if ((test_rand() % 8) == 0)
+    {
+      lpc_ftl_sync(&ftl);
+    }
+    lpc_ftl_get_stats(&ftl, &stats);
+  }
+
+  if ((lpc_ftl_sync(&ftl) != _NO_ERROR) || (test_mount(FALSE) !=
+      _NO_ERROR))
+  {
+    printf("endurance: remount failed\n");
+    return _ERROR;
+  }
+  bad = test_verify(model, FALSE);
+
+  for (block = 0; block < ftldev.num_blocks; block++)
+  {
+    if (flash_is_bad_block(block) == FALSE)
+    {
+      count = nand_sim_erase_count(block);
+      emin = (count < emin) ? count : emin;
+      emax = (count > emax) ? count : emax;
+      total += count;
+      good++;
+    }
+  }
+
+  printf("endurance: %u host sectors, %u pages written, %u moved by "
+         "GC, write amplification %.2f\n", stats.host_writes,
+         stats.page_writes, stats.gc_writes,
+         (double) stats.page_writes * ftl.spp / stats.host_writes);
+  printf("endurance: device erases min %u max %u mean %.1f over %u "
+         "blocks, FTL min %u max %u\n", emin, emax,
+         (double) total / good, good, stats.min_erases,
+         stats.max_erases);
+  printf("endurance: %u sectors do not match after remount\n", bad);
+
+  return (bad == 0) ? _NO_ERROR : _ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: test_powerloss
+ *
+ * Purpose: Check that synced data survives power cuts
+ *
+ * Processing:
+ *     For each round, arm a power cut at a random device operation
+ *     and write random runs of sectors, syncing now and then. A sync
+ *     that finishes with the power on makes the volume safe. Then
+ *     turn the power on, mount the FTL on new work memory, and compare
+ *     every sector not written since the last safe sync. The volume as
+ *     read back is the starting point of the next round.
+ *
+ * Parameters:
+ *     device : NAND_SIM_xxx_PAGE
+ *     blocks : Number of blocks
+ *     policy : LPC_FTL_GC_xxx
+ *     cuts   : Number of power cuts
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if no synced data was lost, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS test_powerloss(UNS_32 device, UNS_32 blocks,
+                             UNS_32 policy, UNS_32 cuts)
+{
+  UNS_32 round, count, sector, bad, lost = 0, synced = 0;
+
+  if ((test_device(device, blocks, policy) != _NO_ERROR) ||
+      (test_fill_volume() == FALSE))
+  {
+    return _ERROR;
+  }
+
+  for (round = 0; round < cuts; round++)
+  {
+    memcpy(safe, model, numsecs * LPC_FTL_SECTOR_SIZE);
+    memset(touched, 0, numsecs);
+
+    cutops = (INT_32) (test_rand() % TEST_CUT_WINDOW);
+    for (count = 0; count < TEST_CUT_WRITES; count++)
+    {
+      test_random_write();
+      if (((test_rand() % 500) == 0) &&
+          (lpc_ftl_sync(&ftl) == _NO_ERROR) && (powered == TRUE))
+      {
+        memcpy(safe, model, numsecs * LPC_FTL_SECTOR_SIZE);
+        memset(touched, 0, numsecs);
+        synced++;
+      }
+    }
+
+    cutops = -1;
+    powered = TRUE;
+    if (test_mount(FALSE) != _NO_ERROR)
+    {
+      printf("powerloss: mount after cut %u failed\n", round);
+      return _ERROR;
+    }
+    bad = test_verify(safe, TRUE);
+    if (bad != 0)
+    {
+      printf("powerloss: cut %u lost %u synced sectors\n", round, bad);
+      lost += bad;
+    }
+
+    /* Continue from the volume as it is now */
+    for (sector = 0; sector < numsecs; sector += count)
+    {
+      count = numsecs - sector;
+      if (count > TEST_MAX_SECTORS)
+      {
+        count = TEST_MAX_SECTORS;
+      }
+      lpc_ftl_read(&ftl, sector, model + (sector * LPC_FTL_SECTOR_SIZE),
+                   count);
+    }
+  }
+
+  memset(touched, 0, numsecs);
+  if ((lpc_ftl_sync(&ftl) != _NO_ERROR) || (test_mount(FALSE) !=
+      _NO_ERROR))
+  {
+    printf("powerloss: final remount failed\n");
+    return _ERROR;
+  }
+  lost += test_verify(model, FALSE);
+
+  printf("powerloss: %u power cuts, %u syncs before a cut, %u synced "
+         "sectors lost\n", cuts, synced, lost);
+
+  return (lost == 0) ? _NO_ERROR : _ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: test_report
+ *
+ * Purpose: Print the simulated rate of a throughput phase
+ *
+ * Processing:
+ *     Read the simulator counters and print the rate from the
+ *     simulated device time and the device operation counts. Clear
+ *     the counters for the next phase.
+ *
+ * Parameters:
+ *     name    : Phase name
+ *     sectors : Sectors moved by the phase
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void test_report(const char *name, UNS_32 sectors)
+{
+  NAND_SIM_STATS_T stats;
+  double bytes = (double) sectors * LPC_FTL_SECTOR_SIZE;
+
+  nand_sim_get_stats(&stats);
+  printf("  %-12s %8.2f MB/s %9u reads %9u programs %7u erases\n", name,
+         (stats.elapsed_ns > 0) ? (bytes * 1000.0 / stats.elapsed_ns) :
+         0.0, stats.reads, stats.programs, stats.erases);
+  nand_sim_reset_stats();
+}
+
+/***********************************************************************
+ *
+ * Function: test_throughput
+ *
+ * Purpose: Measure the FTL rates on the simulated clock
+ *
+ * Processing:
+ *     On a new device, write the whole volume in sequence and read it
+ *     back, then write and read the same amount in random 4K byte
+ *     pieces, and report each phase. Writes include the sync at the
+ *     end. The volume is compared after the phases.
+ *
+ * Parameters:
+ *     device : NAND_SIM_xxx_PAGE
+ *     blocks : Number of blocks
+ *     policy : LPC_FTL_GC_xxx
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if all data matched, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS test_throughput(UNS_32 device, UNS_32 blocks,
+                              UNS_32 policy)
+{
+  UNS_32 sector, count, pieces, idx;
+
+  if (test_device(device, blocks, policy) != _NO_ERROR)
+  {
+    return _ERROR;
+  }
+  printf("throughput: %s GC, %u sectors\n",
+         (policy == LPC_FTL_GC_GREEDY) ? "greedy" : "cost-benefit",
+         numsecs);
+
+  nand_sim_reset_stats();
+  if (test_fill_volume() == FALSE)
+  {
+    printf("throughput: sequential write failed\n");
+    return _ERROR;
+  }
+  test_report("seq write", numsecs);
+
+  for (sector = 0; sector < numsecs; sector += count)
+  {
+    count = numsecs - sector;
+    if (count > TEST_MAX_SECTORS)
+    {
+      count = TEST_MAX_SECTORS;
+    }
+    lpc_ftl_read(&ftl, sector, rdbuff, count);
+  }
+  test_report("seq read", numsecs);
+
+  pieces = numsecs / TEST_RAND_SECTORS;
+  for (idx = 0; idx < pieces; idx++)
+  {
+    sector = (test_rand() % pieces) * TEST_RAND_SECTORS;
+    if (test_write(sector, TEST_RAND_SECTORS) == FALSE)
+    {
+      printf("throughput: random write failed\n");
+      return _ERROR;
+    }
+  }
+  lpc_ftl_sync(&ftl);
+  test_report("rand write", pieces * TEST_RAND_SECTORS);
+
+  for (idx = 0; idx < pieces; idx++)
+  {
+    sector = (test_rand() % pieces) * TEST_RAND_SECTORS;
+    lpc_ftl_read(&ftl, sector, rdbuff, TEST_RAND_SECTORS);
+  }
+  test_report("rand read", pieces * TEST_RAND_SECTORS);
+
+  return (test_verify(model, FALSE) == 0) ? _NO_ERROR : _ERROR;
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: main
+ *
+ * Purpose: Test entry point
+ *
+ * Processing:
+ *     Parse the options and run the selected tests, each on a new
+ *     simulated device.
+ *
+ * Parameters:
+ *     argc : Number of arguments
+ *     argv : Arguments
+ *
+ * Outputs: None
+ *
+ * Returns: 0 if all tests passed, otherwise 1
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+int main(int argc, char *argv[])
+{
+  UNS_32 device = NAND_SIM_SMALL_PAGE, blocks = TEST_DEF_BLOCKS;
+  UNS_32 policy = LPC_FTL_GC_GREEDY, max_erases = TEST_DEF_MAX_ERASES;
+  UNS_32 cuts = TEST_DEF_CUTS, runs = TEST_RUN_ALL;
+  STATUS status = _NO_ERROR;
+  int idx;
+
+  for (idx = 1; idx < argc; idx++)
+  {
+    if ((strcmp(argv[idx], "-d") == 0) && (idx + 1 < argc))
+    {
+      idx++;
+      device = (strcmp(argv[idx], "large") == 0) ?
+               NAND_SIM_LARGE_PAGE : NAND_SIM_SMALL_PAGE;
+    }
+    else if ((strcmp(argv[idx], "-b") == 0) && (idx + 1 < argc))
+    {
+      blocks = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-g") == 0) && (idx + 1 < argc))
+    {
+      idx++;
+      policy = (strcmp(argv[idx], "cb") == 0) ?
+               LPC_FTL_GC_COST_BENEFIT : LPC_FTL_GC_GREEDY;
+    }
+    else if ((strcmp(argv[idx], "-e") == 0) && (idx + 1 < argc))
+    {
+      max_erases = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-c") == 0) && (idx + 1 < argc))
+    {
+      cuts = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-s") == 0) && (idx + 1 < argc))
+    {
+      randstate = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-r") == 0) && (idx + 1 < argc))
+    {
+      idx++;
+      if (strcmp(argv[idx], "endurance") == 0)
+      {
+        runs = TEST_RUN_ENDURANCE;
+      }
+      else if (strcmp(argv[idx], "powerloss") == 0)
+      {
+        runs = TEST_RUN_POWERLOSS;
+      }
+      else if (strcmp(argv[idx], "throughput") == 0)
+      {
+        runs = TEST_RUN_THROUGHPUT;
+      }
+    }
+    else
+    {
+      printf("usage: ftl_test [-d small|large] [-b blocks] "
+             "[-g greedy|cb] [-e max_erases] [-c cuts] [-s seed]\n"
+             "                [-r endurance|powerloss|throughput]\n");
+      return 1;
+    }
+  }
+
+  if ((runs & TEST_RUN_THROUGHPUT) != 0)
+  {
+    if ((test_throughput(device, blocks, LPC_FTL_GC_GREEDY) !=
+         _NO_ERROR) ||
+        (test_throughput(device, blocks, LPC_FTL_GC_COST_BENEFIT) !=
+         _NO_ERROR))
+    {
+      status = _ERROR;
+    }
+  }
+  if ((runs & TEST_RUN_ENDURANCE) != 0)
+  {
+    if (test_endurance(device, blocks, policy, max_erases) != _NO_ERROR)
+    {
+      status = _ERROR;
+    }
+  }
+  if ((runs & TEST_RUN_POWERLOSS) != 0)
+  {
+    if (test_powerloss(device, blocks, policy, cuts) != _NO_ERROR)
+    {
+      status = _ERROR;
+    }
+  }
+
+  flash_deinit();
+
+  if (status != _NO_ERROR)
+  {
+    printf("FAIL\n");
+    return 1;
+  }
+  printf("ok\n");
+
+  return 0;
+}
@@ -0,0 +1,981 @@
+/***********************************************************************
+ * $Id:: nand_sim.c                                                    $
+ *
+ * Project: Host NAND simulator
+ *
+ * Description:
+ *     Implements the following functions required for the S1L API
+ *         flash_init
+ *         flash_deinit
+ *         flash_read_sector
+ *         flash_read_sectors
+ *         flash_write_sector
+ *         flash_erase_block
+ *         flash_is_bad_block
+ *     on a simulated NAND device. See the header file for a
+ *     description of the model.
+ *
+ *     The backing file holds the data and spare area of each page,
+ *     followed by the erase count of each block and a programmed flag
+ *     for each page, so wear and page state are kept between runs.
+ *     Injected bit flips are only kept in memory.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nand_sim.h"
+#include "s1l_sys_inf.h"
+
+/***********************************************************************
+ * Package defines
+ **********************************************************************/
+
+/* Spare area byte holding the factory bad block marker */
+#define SIM_SB_BADBLOCK_OFFS   5
+#define SIM_LB_BADBLOCK_OFFS   0
+
+/* Marker value of a good block */
+#define SIM_GOOD_BLOCK_MARKER  0xFF
+
+/* Same meaning as in the board sysapi_flash.c files, allows bad
+   blocks to be erased */
+int erasebadblocks = 0;
+
+/* Simulator setup, in use once flash_init() is called */
+static NAND_SIM_CFG_T simcfg =
+{
+  NULL, NAND_SIM_SMALL_PAGE, 0, NULL, 0, 0, 0, 0, 1, FALSE,
+  {0, 0, 0, 0}
+};
+
+/* Simulated device state */
+static NAND_GEOM_T simgeom;
+static FILE *simfile;
+static UNS_8 *simmem;           /* Pages when there is no file */
+static UNS_32 *erasecnt;        /* Erase count per block */
+static UNS_8 *programmed;       /* Programmed flag per page */
+static UNS_8 *numflips;         /* Bit flips per page */
+static UNS_32 *flipbits;        /* Flipped bits of each page */
+static UNS_8 *pagebuff;         /* Page and spare area work buffer */
+static UNS_32 pagebytes;        /* Bytes per page with spare area */
+static UNS_32 numpages;         /* Pages on the device */
+static UNS_32 randstate;
+static NAND_SIM_STATS_T simstats;
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: sim_rand
+ *
+ * Purpose: Return a pseudo random number
+ *
+ * Processing:
+ *     Step a linear congruential generator, so a seed gives the same
+ *     bit flips on every host.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: A 15-bit random number
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 sim_rand(void)
+{
+  randstate = (randstate * 1103515245) + 12345;
+
+  return (randstate >> 16) & 0x7FFF;
+}
+
+/***********************************************************************
+ *
+ * Function: sim_io
+ *
+ * Purpose: Move bytes between the backing store and a buffer
+ *
+ * Processing:
+ *     Use the backing file if there is one, otherwise memory.
+ *
+ * Parameters:
+ *     offset : Offset in the backing store
+ *     buff   : Buffer
+ *     len    : Number of bytes
+ *     write  : TRUE to write the store, FALSE to read it
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the bytes were moved, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 sim_io(UNS_32 offset, void *buff, UNS_32 len,
+                     BOOL_32 write)
+{
+  if (simfile == NULL)
+  {
+    if (write == TRUE)
+    {
+      memcpy(simmem + offset, buff, len);
+    }
+    else
+    {
+      memcpy(buff, simmem + offset, len);
+    }
+    return TRUE;
+  }
+
+  if (fseek(simfile, (long) offset, SEEK_SET) != 0)
+  {
+    return FALSE;
+  }
+  if (write == TRUE)
+  {
+    return (BOOL_32) (fwrite(buff, 1, len, simfile) == len);
+  }
+
+  return (BOOL_32) (fread(buff, 1, len, simfile) == len);
+}
+
+/***********************************************************************
+ *
+ * Function: sim_save_state
+ *
+ * Purpose: Save the erase count of a block and the programmed flags of
+ *          its pages to the backing file
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     block : Block number
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void sim_save_state(UNS_32 block)
+{
+  UNS_32 base = numpages * pagebytes;
+
+  if (simfile != NULL)
+  {
+    sim_io(base + (block * 4), &erasecnt[block], 4, TRUE);
+    sim_io(base + (simgeom.num_blocks * 4) +
+           (block * simgeom.pages_per_block),
+           &programmed[block * simgeom.pages_per_block],
+           simgeom.pages_per_block, TRUE);
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: sim_create
+ *
+ * Purpose: Create an erased device with the factory bad blocks marked
+ *
+ * Processing:
+ *     Fill every page with 0xFF and clear the erase counts and
+ *     programmed flags. Write the bad block marker in the first two
+ *     pages of each factory bad block.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the device was created, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 sim_create(void)
+{
+  UNS_32 idx, page, offs;
+
+  memset(pagebuff, 0xFF, pagebytes);
+  for (idx = 0; idx < numpages; idx++)
+  {
+    if (sim_io(idx * pagebytes, pagebuff, pagebytes, TRUE) == FALSE)
+    {
+      return FALSE;
+    }
+  }
+
+  memset(erasecnt, 0, simgeom.num_blocks * 4);
+  memset(programmed, 0, numpages);
+  for (idx = 0; idx < simgeom.num_blocks; idx++)
+  {
+    sim_save_state(idx);
+  }
+
+  offs = simgeom.data_bytes_per_page;
+  if (simcfg.device == NAND_SIM_SMALL_PAGE)
+  {
+    offs += SIM_SB_BADBLOCK_OFFS;
+  }
+  else
+  {
+    offs += SIM_LB_BADBLOCK_OFFS;
+  }
+
+  for (idx = 0; idx < simcfg.num_bad; idx++)
+  {
+    if (simcfg.bad_blocks[idx] >= simgeom.num_blocks)
+    {
+      continue;
+    }
+
+    page = simcfg.bad_blocks[idx] * simgeom.pages_per_block;
+    pagebuff[offs] = 0x00;
+    sim_io((page * pagebytes) + offs, &pagebuff[offs], 1, TRUE);
+    sim_io(((page + 1) * pagebytes) + offs, &pagebuff[offs], 1, TRUE);
+  }
+
+  return TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: sim_open
+ *
+ * Purpose: Open the backing file, creating the device if needed
+ *
+ * Processing:
+ *     Use an existing file of the right size and load its erase
+ *     counts and programmed flags. Otherwise create a new device.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the device is ready, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 sim_open(void)
+{
+  UNS_32 base = numpages * pagebytes;
+  UNS_32 size = base + (simgeom.num_blocks * 4) + numpages;
+
+  if (simcfg.path == NULL)
+  {
+    simmem = malloc(base);
+    if (simmem == NULL)
+    {
+      return FALSE;
+    }
+    return sim_create();
+  }
+
+  simfile = fopen(simcfg.path, "r+b");
+  if (simfile != NULL)
+  {
+    if ((fseek(simfile, 0, SEEK_END) == 0) &&
+        (ftell(simfile) == (long) size))
+    {
+      return (BOOL_32) (
+        (sim_io(base, erasecnt, simgeom.num_blocks * 4, FALSE) ==
+         TRUE) &&
+        (sim_io(base + (simgeom.num_blocks * 4), programmed, numpages,
+                FALSE) == TRUE));
+    }
+    fclose(simfile);
+  }
+
+  simfile = fopen(simcfg.path, "w+b");
+  if (simfile == NULL)
+  {
+    return FALSE;
+  }
+
+  return sim_create();
+}
+
+/***********************************************************************
+ *
+ * Function: sim_sector_ok
+ *
+ * Purpose: Check a sector number
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector : Sector number
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the sector is on the device, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 sim_sector_ok(UNS_32 sector)
+{
+  return (BOOL_32) ((pagebuff != NULL) && (sector < numpages));
+}
+
+/***********************************************************************
+ *
+ * Function: sim_read_page
+ *
+ * Purpose: Read a page and apply the ECC model
+ *
+ * Processing:
+ *     Read the page and spare area and add the read time. Randomly
+ *     add a bit flip to the page. For each ECC step with more bit
+ *     flips than can be corrected, return the flipped bits and fail
+ *     the read, otherwise return the page as programmed.
+ *
+ * Parameters:
+ *     sector : Sector number
+ *
+ * Outputs: The page and spare area are in pagebuff
+ *
+ * Returns: Data bytes read, or -1 on an uncorrectable read
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static int sim_read_page(UNS_32 sector)
+{
+  UNS_32 *pflip = &flipbits[sector * NAND_SIM_MAX_FLIPS];
+  UNS_32 step, idx, cnt, flips = 0;
+  int bytes = (int) simgeom.data_bytes_per_page;
+
+  if (sim_io(sector * pagebytes, pagebuff, pagebytes, FALSE) == FALSE)
+  {
+    return -1;
+  }
+
+  simstats.reads++;
+  simstats.elapsed_ns += simcfg.timing.tr_ns +
+                         ((UNS_64) pagebytes * simcfg.timing.tcyc_ns);
+
+  if ((simcfg.flip_rate != 0) &&
+      ((((sim_rand() << 15) | sim_rand()) % simcfg.flip_rate) == 0))
+  {
+    nand_sim_flip_bit(sector,
+                      (((sim_rand() << 15) | sim_rand()) %
+                       (simgeom.data_bytes_per_page * 8)));
+  }
+
+  for (step = 0; step < simgeom.data_bytes_per_page;
+       step += simcfg.ecc_step)
+  {
+    cnt = 0;
+    for (idx = 0; idx < numflips[sector]; idx++)
+    {
+      if (((pflip[idx] / 8) >= step) &&
+          ((pflip[idx] / 8) < (step + simcfg.ecc_step)))
+      {
+        cnt++;
+      }
+    }
+    flips += cnt;
+
+    if (cnt > simcfg.ecc_bits)
+    {
+      for (idx = 0; idx < numflips[sector]; idx++)
+      {
+        if (((pflip[idx] / 8) >= step) &&
+            ((pflip[idx] / 8) < (step + simcfg.ecc_step)))
+        {
+          pagebuff[pflip[idx] / 8] ^= (UNS_8) (1 << (pflip[idx] % 8));
+        }
+      }
+      bytes = -1;
+    }
+  }
+
+  if (bytes < 0)
+  {
+    simstats.uncorrectable++;
+  }
+  else if (flips > 0)
+  {
+    simstats.corrected++;
+  }
+
+  return bytes;
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: nand_sim_setup
+ *
+ * Purpose: Select the simulated device
+ *
+ * Processing:
+ *     Save the setup. flash_init() fills in the device defaults.
+ *
+ * Parameters:
+ *     cfg : Simulator setup
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: Call before flash_init().
+ *
+ **********************************************************************/
+void nand_sim_setup(const NAND_SIM_CFG_T *cfg)
+{
+  simcfg = *cfg;
+}
+
+/***********************************************************************
+ *
+ * Function: nand_sim_get_stats
+ *
+ * Purpose: Return the simulator counters
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     stats : Where to place the counters
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void nand_sim_get_stats(NAND_SIM_STATS_T *stats)
+{
+  *stats = simstats;
+}
+
+/***********************************************************************
+ *
+ * Function: nand_sim_reset_stats
+ *
+ * Purpose: Clear the simulator counters and clock
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: The erase count of each block is not cleared.
+ *
+ **********************************************************************/
+void nand_sim_reset_stats(void)
+{
+  memset(&simstats, 0, sizeof(simstats));
+}
+
+/***********************************************************************
+ *
+ * Function: nand_sim_erase_count
+ *
+ * Purpose: Return the number of times a block has been erased
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     block : Block number
+ *
+ * Outputs: None
+ *
+ * Returns: Erase count, 0 for a block not on the device
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+UNS_32 nand_sim_erase_count(UNS_32 block)
+{
+  if ((erasecnt == NULL) || (block >= simgeom.num_blocks))
+  {
+    return 0;
+  }
+
+  return erasecnt[block];
+}
+
+/***********************************************************************
+ *
+ * Function: nand_sim_flip_bit
+ *
+ * Purpose: Flip a bit of a page
+ *
+ * Processing:
+ *     Add the bit to the flipped bits of the page. The flip is seen on
+ *     reads until the page is erased or programmed.
+ *
+ * Parameters:
+ *     sector : Sector number
+ *     bit    : Bit in the page data
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the bit was flipped, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+BOOL_32 nand_sim_flip_bit(UNS_32 sector,
+                          UNS_32 bit)
+{
+  if ((sim_sector_ok(sector) == FALSE) ||
+      (bit >= (simgeom.data_bytes_per_page * 8)) ||
+      (numflips[sector] >= NAND_SIM_MAX_FLIPS))
+  {
+    return FALSE;
+  }
+
+  flipbits[(sector * NAND_SIM_MAX_FLIPS) + numflips[sector]] = bit;
+  numflips[sector]++;
+  simstats.flips++;
+
+  return TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: flash_init
+ *
+ * Purpose: Initialize the simulated NAND device
+ *
+ * Processing:
+ *     Fill in the geometry, timing, and ECC defaults of the device,
+ *     allocate the device state, and open or create the backing store.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns:
+ *     Returns pointer to an initialized NAND structure if good, NULL
+ *     if bad
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+NAND_GEOM_T *flash_init(void)
+{
+  flash_deinit();
+
+  if (simcfg.device == NAND_SIM_SMALL_PAGE)
+  {
+    /* ST NAND256R3A */
+    simgeom.num_blocks = 2048;
+    simgeom.pages_per_block = 32;
+    simgeom.data_bytes_per_page = 512;
+    simgeom.spare_bytes_per_page = 16;
+    simgeom.address_cycles = 3;
+    if (simcfg.timing.tr_ns == 0)
+    {
+      simcfg.timing.tr_ns = 12000;
+    }
+    if (simcfg.timing.tcyc_ns == 0)
+    {
+      simcfg.timing.tcyc_ns = 50;
+    }
+  }
+  else
+  {
+    /* Micron MT29F2G08 */
+    simgeom.num_blocks = 2048;
+    simgeom.pages_per_block = 64;
+    simgeom.data_bytes_per_page = 2048;
+    simgeom.spare_bytes_per_page = 64;
+    simgeom.address_cycles = 5;
+    if (simcfg.timing.tr_ns == 0)
+    {
+      simcfg.timing.tr_ns = 25000;
+    }
+    if (simcfg.timing.tcyc_ns == 0)
+    {
+      simcfg.timing.tcyc_ns = 25;
+    }
+  }
+
+  if (simcfg.num_blocks != 0)
+  {
+    simgeom.num_blocks = simcfg.num_blocks;
+  }
+  if (simcfg.timing.tprog_ns == 0)
+  {
+    simcfg.timing.tprog_ns = 200000;
+  }
+  if (simcfg.timing.tbers_ns == 0)
+  {
+    simcfg.timing.tbers_ns = 2000000;
+  }
+
+  /* The SLC controller ECC corrects 1 bit in each 256 bytes */
+  if (simcfg.ecc_bits == 0)
+  {
+    simcfg.ecc_bits = 1;
+  }
+  if ((simcfg.ecc_step == 0) ||
+      (simcfg.ecc_step > simgeom.data_bytes_per_page))
+  {
+    simcfg.ecc_step = 256;
+  }
+
+  pagebytes = simgeom.data_bytes_per_page + simgeom.spare_bytes_per_page;
+  numpages = simgeom.num_blocks * simgeom.pages_per_block;
+  randstate = simcfg.seed;
+  nand_sim_reset_stats();
+
+  erasecnt = calloc(simgeom.num_blocks, 4);
+  programmed = calloc(numpages, 1);
+  numflips = calloc(numpages, 1);
+  flipbits = calloc(numpages, NAND_SIM_MAX_FLIPS * 4);
+  pagebuff = malloc(pagebytes);
+  if ((erasecnt == NULL) || (programmed == NULL) || (numflips == NULL) ||
+      (flipbits == NULL) || (pagebuff == NULL) || (sim_open() == FALSE))
+  {
+    flash_deinit();
+    return NULL;
+  }
+
+  return &simgeom;
+}
+
+/***********************************************************************
+ *
+ * Function: flash_deinit
+ *
+ * Purpose: Close the simulated NAND device
+ *
+ * Processing:
+ *     Close the backing file and free the device state.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void flash_deinit(void)
+{
+  if (simfile != NULL)
+  {
+    fclose(simfile);
+    simfile = NULL;
+  }
+
+  free(simmem);
+  free(erasecnt);
+  free(programmed);
+  free(numflips);
+  free(flipbits);
+  free(pagebuff);
+  simmem = NULL;
+  erasecnt = NULL;
+  programmed = NULL;
+  numflips = NULL;
+  flipbits = NULL;
+  pagebuff = NULL;
+}
+
+/***********************************************************************
+ *
+ * Function: flash_read_sector
+ *
+ * Purpose: Read a NAND sector, will skip bad blocks
+ *
+ * Processing:
+ *     Read the page through the ECC model and copy out the data and
+ *     spare area.
+ *
+ * Parameters:
+ *     sector : Sector to read
+ *     buff   : Where to place the sector data
+ *     extra  : Where to place the spare area, or NULL
+ *
+ * Outputs: None
+ *
+ * Returns:
+ *     Returns >0 on success, -1 on fail, or -2 if the block
+ *     associated with the sector is bad
+ *
+ * Notes:
+ *     The block is read regardless of whether the block is bad or not.
+ *
+ **********************************************************************/
+int flash_read_sector(UNS_32 sector, void *buff, void *extra)
+{
+  int ret;
+
+  if (sim_sector_ok(sector) == FALSE)
+  {
+    return -1;
+  }
+
+  ret = sim_read_page(sector);
+  memcpy(buff, pagebuff, simgeom.data_bytes_per_page);
+  if (extra != NULL)
+  {
+    memcpy(extra, pagebuff + simgeom.data_bytes_per_page,
+           simgeom.spare_bytes_per_page);
+  }
+
+  if (flash_is_bad_block(sector / simgeom.pages_per_block) != FALSE)
+  {
+    return -2;
+  }
+
+  return ret;
+}
+
+/***********************************************************************
+ *
+ * Function: flash_read_sectors
+ *
+ * Purpose: Read a run of NAND sectors
+ *
+ * Processing:
+ *     Read each sector in turn.
+ *
+ * Parameters:
+ *     sector : First sector to read
+ *     count  : Number of sectors to read
+ *     buff   : Where to place the sector data
+ *
+ * Outputs: None
+ *
+ * Returns: Returns >0 on success or -1 on fail
+ *
+ * Notes: Bad blocks are not skipped.
+ *
+ **********************************************************************/
+int flash_read_sectors(UNS_32 sector, UNS_32 count, void *buff)
+{
+  UNS_8 *p8 = (UNS_8 *) buff;
+  int ret = 1;
+
+  while (count > 0)
+  {
+    if (flash_read_sector(sector, p8, NULL) <= 0)
+    {
+      ret = -1;
+    }
+
+    p8 += simgeom.data_bytes_per_page;
+    sector++;
+    count--;
+  }
+
+  return ret;
+}
+
+/***********************************************************************
+ *
+ * Function: flash_write_sector
+ *
+ * Purpose: Writes a NAND sector, will skip bad blocks
+ *
+ * Processing:
+ *     Fail a program of a page that has not been erased since it was
+ *     last programmed, stopping the program if strict checking is
+ *     enabled. Otherwise program the data and spare area and add the
+ *     program time.
+ *
+ * Parameters:
+ *     sector : Sector to write
+ *     buff   : Sector data
+ *     extra  : Spare area data, or NULL to leave it erased
+ *
+ * Outputs: None
+ *
+ * Returns:
+ *     Returns >0 on success, -1 on fail, or -2 if the block
+ *     associated with the sector is bad
+ *
+ * Notes: The block will not be written if it is bad.
+ *
+ **********************************************************************/
+int flash_write_sector(UNS_32 sector, void *buff, void *extra)
+{
+  UNS_32 block = sector / simgeom.pages_per_block;
+
+  if (sim_sector_ok(sector) == FALSE)
+  {
+    return -1;
+  }
+
+  if (flash_is_bad_block(block) != FALSE)
+  {
+    return -2;
+  }
+
+  if (programmed[sector] != 0)
+  {
+    simstats.violations++;
+    if (simcfg.strict == TRUE)
+    {
+      fprintf(stderr, "nand_sim: sector %u (block %u page %u) "
+              "programmed again without an erase\n", sector, block,
+              sector % simgeom.pages_per_block);
+      abort();
+    }
+    return -1;
+  }
+
+  memset(pagebuff, 0xFF, pagebytes);
+  memcpy(pagebuff, buff, simgeom.data_bytes_per_page);
+  if (extra != NULL)
+  {
+    memcpy(pagebuff + simgeom.data_bytes_per_page, extra,
+           simgeom.spare_bytes_per_page);
+  }
+
+  if (sim_io(sector * pagebytes, pagebuff, pagebytes, TRUE) == FALSE)
+  {
+    return -1;
+  }
+
+  programmed[sector] = 1;
+  numflips[sector] = 0;
+  sim_save_state(block);
+
+  simstats.programs++;
+  simstats.elapsed_ns += simcfg.timing.tprog_ns +
+                         ((UNS_64) pagebytes * simcfg.timing.tcyc_ns);
+
+  return (int) simgeom.data_bytes_per_page;
+}
+
+/***********************************************************************
+ *
+ * Function: flash_erase_block
+ *
+ * Purpose: Erase a block
+ *
+ * Processing:
+ *     Fill the pages of the block with 0xFF, clear their programmed
+ *     flags and bit flips, count the erase, and add the erase time.
+ *
+ * Parameters:
+ *     block: Block number
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE on good erase, otherwise FALSE
+ *
+ * Notes: Bad blocks are only erased if erasebadblocks is set.
+ *
+ **********************************************************************/
+BOOL_32 flash_erase_block(UNS_32 block)
+{
+  UNS_32 page, sector;
+
+  if ((pagebuff == NULL) || (block >= simgeom.num_blocks) ||
+      ((flash_is_bad_block(block) != FALSE) && (erasebadblocks == 0)))
+  {
+    return FALSE;
+  }
+
+  memset(pagebuff, 0xFF, pagebytes);
+  sector = block * simgeom.pages_per_block;
+  for (page = 0; page < simgeom.pages_per_block; page++)
+  {
+    if (sim_io((sector + page) * pagebytes, pagebuff, pagebytes,
+               TRUE) == FALSE)
+    {
+      return FALSE;
+    }
+    programmed[sector + page] = 0;
+    numflips[sector + page] = 0;
+  }
+
+  erasecnt[block]++;
+  sim_save_state(block);
+
+  simstats.erases++;
+  simstats.elapsed_ns += simcfg.timing.tbers_ns;
+
+  return TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: flash_is_bad_block
+ *
+ * Purpose: Check the bad block marker of a block
+ *
+ * Processing:
+ *     Read the marker byte in the spare area of the first two pages
+ *     of the block.
+ *
+ * Parameters:
+ *     block: Block number
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the block is bad, otherwise FALSE
+ *
+ * Notes: The marker check is not timed.
+ *
+ **********************************************************************/
+BOOL_32 flash_is_bad_block(UNS_32 block)
+{
+  UNS_32 offs, sector;
+  UNS_8 mark[2];
+
+  if ((pagebuff == NULL) || (block >= simgeom.num_blocks))
+  {
+    return TRUE;
+  }
+
+  offs = simgeom.data_bytes_per_page;
+  if (simcfg.device == NAND_SIM_SMALL_PAGE)
+  {
+    offs += SIM_SB_BADBLOCK_OFFS;
+  }
+  else
+  {
+    offs += SIM_LB_BADBLOCK_OFFS;
+  }
+
+  sector = block * simgeom.pages_per_block;
+  if ((sim_io((sector * pagebytes) + offs, &mark[0], 1, FALSE) ==
+       FALSE) ||
+      (sim_io(((sector + 1) * pagebytes) + offs, &mark[1], 1, FALSE) ==
+       FALSE))
+  {
+    return TRUE;
+  }
+
+  return (BOOL_32) ((mark[0] & mark[1]) != SIM_GOOD_BLOCK_MARKER);
+}
@@ -0,0 +1,125 @@
+/***********************************************************************
+ * $Id:: nand_sim.h                                                    $
+ *
+ * Project: Host NAND simulator
+ *
+ * Description:
+ *     A file backed NAND model for the host that implements the S1L
+ *     flash_xxx functions, so NAND code such as the S1L image and
+ *     configuration functions can be run and timed on a PC.
+ *
+ *     The model keeps the data and spare area of each page in a file
+ *     (or in memory), enforces that a page is programmed only once
+ *     between erases, keeps an erase counter per block, and adds the
+ *     typical array and bus times of each operation to a simulated
+ *     clock. Factory bad blocks get a bad block marker when a new
+ *     device is created, and bit flips can be injected at random on
+ *     reads or at a given bit. Bit flips within the ECC strength of
+ *     the controller are corrected, others fail the read.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#ifndef NAND_SIM_H
+#define NAND_SIM_H
+
+#include "lpc_types.h"
+#include "lpc_nandflash_params.h"
+
+#if defined (__cplusplus)
+extern "C"
+{
+#endif
+
+/***********************************************************************
+ * NAND simulator defines
+ **********************************************************************/
+
+/* Simulated devices */
+#define NAND_SIM_SMALL_PAGE    0 /* ST NAND256R3A, 512+16 byte pages */
+#define NAND_SIM_LARGE_PAGE    1 /* Micron MT29F2G08, 2048+64 byte pages */
+
+/* Largest number of bit flips kept per page */
+#define NAND_SIM_MAX_FLIPS     8
+
+/***********************************************************************
+ * NAND simulator types
+ **********************************************************************/
+
+/* Operation times, 0 selects the device default */
+typedef struct
+{
+  UNS_32 tr_ns;                 /* Array to page register read time */
+  UNS_32 tprog_ns;              /* Page program time */
+  UNS_32 tbers_ns;              /* Block erase time */
+  UNS_32 tcyc_ns;               /* Bus cycle time per byte */
+} NAND_SIM_TIMING_T;
+
+/* Simulator setup */
+typedef struct
+{
+  const char *path;             /* Backing file, NULL to keep in memory */
+  UNS_32 device;                /* NAND_SIM_xxx_PAGE */
+  UNS_32 num_blocks;            /* Number of blocks, 0 for the default */
+  const UNS_32 *bad_blocks;     /* Factory bad blocks */
+  UNS_32 num_bad;               /* Number of factory bad blocks */
+  UNS_32 flip_rate;             /* 1 in flip_rate reads flips a bit, 0
+                                   for none */
+  UNS_32 ecc_bits;              /* Bits corrected per ECC step, 0 for
+                                   the default */
+  UNS_32 ecc_step;              /* Bytes per ECC step, 0 for the
+                                   default */
+  UNS_32 seed;                  /* Random seed for the bit flips */
+  BOOL_32 strict;               /* TRUE to stop on a program that is
+                                   not after an erase */
+  NAND_SIM_TIMING_T timing;     /* Operation times */
+} NAND_SIM_CFG_T;
+
+/* Simulator counters */
+typedef struct
+{
+  UNS_64 elapsed_ns;            /* Simulated device time */
+  UNS_32 reads;                 /* Pages read */
+  UNS_32 programs;              /* Pages programmed */
+  UNS_32 erases;                /* Blocks erased */
+  UNS_32 flips;                 /* Bit flips injected */
+  UNS_32 corrected;             /* Reads with corrected bit flips */
+  UNS_32 uncorrectable;         /* Reads that failed ECC */
+  UNS_32 violations;            /* Programs of a page not erased */
+} NAND_SIM_STATS_T;
+
+/***********************************************************************
+ * NAND simulator functions
+ **********************************************************************/
+
+/* Select the simulated device, call before flash_init() */
+void nand_sim_setup(const NAND_SIM_CFG_T *cfg);
+
+/* Return the simulator counters */
+void nand_sim_get_stats(NAND_SIM_STATS_T *stats);
+
+/* Clear the simulator counters and clock */
+void nand_sim_reset_stats(void);
+
+/* Return the number of times a block has been erased */
+UNS_32 nand_sim_erase_count(UNS_32 block);
+
+/* Flip a bit of a page, returns FALSE if the page has too many flips */
+BOOL_32 nand_sim_flip_bit(UNS_32 sector,
+                          UNS_32 bit);
+
+#if defined (__cplusplus)
+}
+#endif /*__cplusplus */
+
+#endif /* NAND_SIM_H */
@@ -0,0 +1,381 @@
+/***********************************************************************
+ * $Id:: ring_stress.c                                                 $
+ *
+ * Project: Host SPSC ring stress test
+ *
+ * Description:
+ *     Runs the lpc_ring single-producer/single-consumer ring between
+ *     two POSIX threads on a PC. The producer writes a byte sequence
+ *     in random sized pieces, the consumer reads it back in random
+ *     sized pieces and checks every byte against the sequence, so a
+ *     lost, repeated or reordered byte is found.
+ *
+ *     Each side mixes all of its ring operations: the producer uses
+ *     lpc_ring_put and lpc_ring_reserve/lpc_ring_commit, the consumer
+ *     uses lpc_ring_get, lpc_ring_peek/lpc_ring_skip and
+ *     lpc_ring_peek_span/lpc_ring_release.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "lpc_ring.h"
+
+/***********************************************************************
+ * Package defines
+ **********************************************************************/
+
+/* Defaults */
+#define STRESS_DEF_BYTES       100000000
+#define STRESS_DEF_RING_SIZE   256
+#define STRESS_DEF_SEED        1
+
+/* Largest piece moved by one ring operation */
+#define STRESS_MAX_PIECE       97
+
+/***********************************************************************
+ * Package data
+ **********************************************************************/
+
+static LPC_SPSC_RING_T ring;
+static UNS_32 total_bytes = STRESS_DEF_BYTES;
+static UNS_32 seed = STRESS_DEF_SEED;
+
+/* Number of times the producer found the ring full */
+static UNS_32 prod_full;
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: stress_rand
+ *
+ * Purpose: Return a pseudo random number
+ *
+ * Processing:
+ *     Step a linear congruential generator. Each thread has its own
+ *     state.
+ *
+ * Parameters:
+ *     state : Pointer to generator state
+ *
+ * Outputs: None
+ *
+ * Returns: A 15-bit random number
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 stress_rand(UNS_32 *state)
+{
+  *state = (*state * 1103515245) + 12345;
+
+  return (*state >> 16) & 0x7FFF;
+}
+
+/***********************************************************************
+ *
+ * Function: stress_byte
+ *
+ * Purpose: Return the byte at a position of the test sequence
+ *
+ * Processing:
+ *     The high bits of the position are folded in, so a byte that is
+ *     off by a multiple of 256 positions does not match.
+ *
+ * Parameters:
+ *     pos : Byte position in the sequence
+ *
+ * Outputs: None
+ *
+ * Returns: The sequence byte
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_8 stress_byte(UNS_32 pos)
+{
+  return (UNS_8) (pos ^ (pos >> 8) ^ (pos >> 16) ^ (pos >> 24));
+}
+
+/***********************************************************************
+ *
+ * Function: stress_producer
+ *
+ * Purpose: Producer thread
+ *
+ * Processing:
+ *     Write the sequence into the ring in random sized pieces,
+ *     alternating between lpc_ring_put from a local buffer and
+ *     writing straight into a reserved span. Yield when the ring is
+ *     full.
+ *
+ * Parameters:
+ *     arg : Not used
+ *
+ * Outputs: None
+ *
+ * Returns: NULL
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void *stress_producer(void *arg)
+{
+  UNS_8 buff[STRESS_MAX_PIECE];
+  UNS_32 state = seed, pos = 0, want, done, idx;
+  UNS_8 *span;
+
+  (void) arg;
+
+  while (pos < total_bytes)
+  {
+    want = 1 + (stress_rand(&state) % STRESS_MAX_PIECE);
+    if (want > (total_bytes - pos))
+    {
+      want = total_bytes - pos;
+    }
+
+    if ((stress_rand(&state) & 1) != 0)
+    {
+      for (idx = 0; idx < want; idx++)
+      {
+        buff[idx] = stress_byte(pos + idx);
+      }
+      done = lpc_ring_put(&ring, buff, want);
+    }
+    else
+    {
+      done = lpc_ring_reserve(&ring, (void **) &span);
+      if (done > want)
+      {
+        done = want;
+      }
+      for (idx = 0; idx < done; idx++)
+      {
+        span[idx] = stress_byte(pos + idx);
+      }
+      lpc_ring_commit(&ring, done);
+    }
+
+    if (done == 0)
+    {
+      prod_full++;
+      sched_yield();
+    }
+    pos += done;
+  }
+
+  return NULL;
+}
+
+/***********************************************************************
+ *
+ * Function: stress_consumer
+ *
+ * Purpose: Consumer side of the test
+ *
+ * Processing:
+ *     Read the sequence back in random sized pieces, rotating between
+ *     lpc_ring_get, lpc_ring_peek followed by lpc_ring_skip, and
+ *     lpc_ring_peek_span followed by lpc_ring_release. Every byte is
+ *     checked before it is released. Yield when the ring is empty.
+ *
+ * Parameters:
+ *     empty : Where to place the number of times the ring was empty
+ *
+ * Outputs: None
+ *
+ * Returns: The position of the first bad byte, or total_bytes if the
+ *          whole sequence was read back
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 stress_consumer(UNS_32 *empty)
+{
+  UNS_8 buff[STRESS_MAX_PIECE];
+  UNS_32 state = seed ^ 0x5A5A5A5A, pos = 0, want, done, idx, op;
+  UNS_8 *data;
+
+  *empty = 0;
+  while (pos < total_bytes)
+  {
+    want = 1 + (stress_rand(&state) % STRESS_MAX_PIECE);
+    op = stress_rand(&state) % 3;
+    data = buff;
+
+    if (op == 0)
+    {
+      done = lpc_ring_get(&ring, buff, want);
+    }
+    else if (op == 1)
+    {
+      done = lpc_ring_peek(&ring, buff, want);
+    }
+    else
+    {
+      done = lpc_ring_peek_span(&ring, (void **) &data);
+      if (done > want)
+      {
+        done = want;
+      }
+    }
+
+    for (idx = 0; idx < done; idx++)
+    {
+      if (data[idx] != stress_byte(pos + idx))
+      {
+        return pos + idx;
+      }
+    }
+
+    /* Peeked data is still in the ring */
+    if (op == 1)
+    {
+      if (lpc_ring_skip(&ring, done) != done)
+      {
+        return pos;
+      }
+    }
+    else if (op == 2)
+    {
+      lpc_ring_release(&ring, done);
+    }
+
+    if (done == 0)
+    {
+      (*empty)++;
+      sched_yield();
+    }
+    pos += done;
+  }
+
+  return pos;
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: main
+ *
+ * Purpose: Stress test entry point
+ *
+ * Processing:
+ *     Parse the options, check that lpc_ring_init rejects a size that
+ *     is not a power of 2, then run the producer thread against the
+ *     consumer on the main thread and report the result.
+ *
+ * Parameters:
+ *     argc : Number of arguments
+ *     argv : Arguments
+ *
+ * Outputs: None
+ *
+ * Returns: 0 if the sequence was read back intact, otherwise 1
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+int main(int argc, char *argv[])
+{
+  UNS_32 ring_size = STRESS_DEF_RING_SIZE, bad, empty;
+  struct timespec start, end;
+  pthread_t producer;
+  UNS_8 *storage;
+  double secs;
+  int idx;
+
+  for (idx = 1; idx < argc; idx++)
+  {
+    if ((strcmp(argv[idx], "-n") == 0) && (idx + 1 < argc))
+    {
+      total_bytes = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-r") == 0) && (idx + 1 < argc))
+    {
+      ring_size = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else if ((strcmp(argv[idx], "-s") == 0) && (idx + 1 < argc))
+    {
+      seed = (UNS_32) strtoul(argv[++idx], NULL, 0);
+    }
+    else
+    {
+      printf("usage: ring_stress [-n bytes] [-r ring_size] [-s seed]\n");
+      return 1;
+    }
+  }
+
+  storage = (UNS_8 *) malloc(ring_size + 1);
+  if (storage == NULL)
+  {
+    printf("Out of memory for the ring\n");
+    return 1;
+  }
+
+  if (lpc_ring_init(&ring, storage, ring_size + 1) != _ERROR)
+  {
+    printf("lpc_ring_init accepted size %u\n", ring_size + 1);
+    return 1;
+  }
+  if (lpc_ring_init(&ring, storage, ring_size) != _NO_ERROR)
+  {
+    printf("Ring size must be a power of 2\n");
+    return 1;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (pthread_create(&producer, NULL, stress_producer, NULL) != 0)
+  {
+    printf("Can't start the producer thread\n");
+    return 1;
+  }
+  bad = stress_consumer(&empty);
+  if (bad != total_bytes)
+  {
+    printf("FAIL: bad byte at position %u\n", bad);
+    return 1;
+  }
+  pthread_join(producer, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  secs = (double) (end.tv_sec - start.tv_sec) +
+         ((double) (end.tv_nsec - start.tv_nsec) / 1e9);
+  printf("%u bytes through a %u byte ring in %.2f s, %.1f MB/s\n",
+         total_bytes, ring_size, secs,
+         (secs > 0.0) ? ((double) total_bytes / secs / 1e6) : 0.0);
+  printf("producer found the ring full %u times, consumer found it "
+         "empty %u times\n", prod_full, empty);
+
+  if (lpc_ring_count(&ring) != 0)
+  {
+    printf("FAIL: %u bytes left in the ring\n", lpc_ring_count(&ring));
+    return 1;
+  }
+  printf("ok\n");
+
+  free(storage);
+
+  return 0;
+}
@@ -0,0 +1,119 @@
+/***********************************************************************
+ * $Id:: lpc_bbt.h                                                     $
+ *
+ * Project: NAND bad block table
+ *
+ * Description:
+ *     Keeps the bad block state of a NAND device in a RAM bitmap, so a
+ *     bad block check is a bit test instead of a spare area read. The
+ *     table is built once by scanning the bad block markers, or is
+ *     loaded from a copy saved on the device.
+ *
+ *     When saving is enabled, the last LPC_BBT_RSVD_BLOCKS blocks of
+ *     the device hold a primary and a mirror copy of the table, each
+ *     with a version number. The copies are written one at a time, so
+ *     one of them is still good if power is lost during an update, and
+ *     the newest good copy is loaded. The reserved blocks are reported
+ *     as bad so they are never used for data.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#ifndef LPC_BBT_H
+#define LPC_BBT_H
+
+#include "lpc_types.h"
+
+#if defined (__cplusplus)
+extern "C"
+{
+#endif
+
+/***********************************************************************
+ * Bad block table defines
+ **********************************************************************/
+
+/* Largest number of blocks in a table */
+#define LPC_BBT_MAX_BLOCKS     8192
+
+/* Number of blocks at the end of the device reserved for the saved
+   copies of the table */
+#define LPC_BBT_RSVD_BLOCKS    4
+
+/* Signatures of the saved primary ("Bbt0") and mirror ("1tbB")
+   copies */
+#define LPC_BBT_MAGIC_PRI      0x30746242
+#define LPC_BBT_MAGIC_MIR      0x42627431
+
+/***********************************************************************
+ * Bad block table types
+ **********************************************************************/
+
+/* NAND device geometry and access functions used by the table */
+typedef struct
+{
+  UNS_32 num_blocks;            /* Number of blocks on the device */
+  UNS_32 pages_per_block;       /* Number of pages per block */
+  UNS_32 page_size;             /* Data bytes per page */
+  /* Read the bad block marker of a block, returns !0 if bad */
+  INT_32 (*marker_bad)(UNS_32 block);
+  /* Read a sector, returns >0 on pass */
+  INT_32 (*read_sector)(UNS_32 sector, UNS_8 *buff);
+  /* Write a sector, returns >0 on pass */
+  INT_32 (*write_sector)(UNS_32 sector, UNS_8 *buff);
+  /* Erase a block, returns !0 on pass */
+  INT_32 (*erase_block)(UNS_32 block);
+  UNS_8 *pagebuff;              /* Page sized work buffer */
+} LPC_BBT_DEV_T;
+
+/* Bad block table control structure */
+typedef struct
+{
+  LPC_BBT_DEV_T dev;            /* Device geometry and functions */
+  BOOL_32 save;                 /* TRUE to keep a copy on the device */
+  BOOL_32 busy;                 /* TRUE while the copies are written */
+  BOOL_32 dirty;                /* Table changed while being written */
+  UNS_32 first_rsvd;            /* First block reserved for the copies */
+  UNS_32 tblpages;              /* Pages used by a saved copy */
+  UNS_32 version;               /* Version of the saved copies */
+  INT_32 copyblk[2];            /* Primary and mirror blocks, or -1 */
+  UNS_32 map[LPC_BBT_MAX_BLOCKS / 32]; /* Bit per block, set if bad */
+} LPC_BBT_T;
+
+/***********************************************************************
+ * Bad block table functions
+ **********************************************************************/
+
+/* Setup a bad block table for a device, loading the saved copy or
+   scanning the bad block markers */
+STATUS lpc_bbt_init(LPC_BBT_T *bbt,
+                    const LPC_BBT_DEV_T *dev,
+                    BOOL_32 save);
+
+/* Returns TRUE if a block is bad or reserved for the table */
+BOOL_32 lpc_bbt_is_bad(LPC_BBT_T *bbt,
+                       UNS_32 block);
+
+/* Mark a block as bad or good, saving the table if it changes */
+void lpc_bbt_mark(LPC_BBT_T *bbt,
+                  UNS_32 block,
+                  BOOL_32 bad);
+
+/* Write both saved copies of the table with a new version */
+STATUS lpc_bbt_save(LPC_BBT_T *bbt);
+
+#if defined (__cplusplus)
+}
+#endif /*__cplusplus */
+
+#endif /* LPC_BBT_H */
@@ -0,0 +1,101 @@
+/***********************************************************************
+ * $Id:: lpc_bch.h                                                     $
+ *
+ * Project: NAND software BCH ECC generation and correction
+ *
+ * Description:
+ *     Generates, checks, and corrects multi-bit BCH ECCs for 512 byte
+ *     blocks of NAND data. The code is a binary BCH code over
+ *     GF(2^13) shortened to 512 data bytes and can correct 4 or 8 bit
+ *     errors per block, using 7 or 13 ECC bytes.
+ *
+ *     The ECC of an erased block (all 0xFF) is all 0xFF, so erased
+ *     pages decode without errors.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#ifndef LPC_BCH_H
+#define LPC_BCH_H
+
+#include "lpc_types.h"
+
+#if defined (__cplusplus)
+extern "C"
+{
+#endif
+
+/***********************************************************************
+ * BCH defines
+ **********************************************************************/
+
+/* Number of data bytes protected by one ECC */
+#define LPC_BCH_DATA_BYTES     512
+
+/* Largest supported number of correctable bits per block */
+#define LPC_BCH_MAX_T          8
+
+/* Largest number of ECC bytes per block */
+#define LPC_BCH_MAX_ECC_BYTES  13
+
+/* Number of 32-bit words in the LFSR remainder */
+#define LPC_BCH_ECC_WORDS      4
+
+/* Spare area layout for a 2048 byte page with a 64 byte spare area.
+   The ECCs of the 4 blocks in the page are packed at the end of the
+   spare area, block 0 first. For t = 8 the ECCs use bytes 12 to 63
+   and for t = 4 bytes 36 to 63. The bad block marker at byte 0 and
+   the bytes up to the first ECC are free. */
+#define LPC_BCH_OOB_SIZE       64
+#define LPC_BCH_OOB_BLOCKS     4
+#define LPC_BCH_OOB_ECC_OFFS(bch, blk) \
+  (LPC_BCH_OOB_SIZE - ((LPC_BCH_OOB_BLOCKS - (blk)) * (bch)->eccbytes))
+
+/***********************************************************************
+ * BCH types
+ **********************************************************************/
+
+/* BCH codec control structure */
+typedef struct
+{
+  INT_32 t;                     /* Correctable bits per block */
+  INT_32 deg;                   /* Generator degree (ECC bits) */
+  INT_32 eccbytes;              /* ECC bytes per block */
+  INT_32 eccwords;              /* Words used in the LFSR remainder */
+  UNS_8 erased[LPC_BCH_MAX_ECC_BYTES]; /* ECC mask for erased blocks */
+  UNS_32 lfsr[256][LPC_BCH_ECC_WORDS]; /* Parallel LFSR byte table */
+} LPC_BCH_T;
+
+/***********************************************************************
+ * BCH functions
+ **********************************************************************/
+
+/* Setup a BCH codec for t (4 or 8) correctable bits per block */
+STATUS lpc_bch_init(LPC_BCH_T *bch, INT_32 t);
+
+/* Generate the ECC for a 512 byte block of data */
+void lpc_bch_encode(LPC_BCH_T *bch,
+                    const UNS_8 *datbuf,
+                    UNS_8 *ecc);
+
+/* Check and correct a 512 byte block of data against its ECC, returns
+   the number of corrected bits or -1 if the block is not correctable */
+INT_32 lpc_bch_decode(LPC_BCH_T *bch,
+                      UNS_8 *datbuf,
+                      const UNS_8 *ecc);
+
+#if defined (__cplusplus)
+}
+#endif /*__cplusplus */
+
+#endif /* LPC_BCH_H */
@@ -95,6 +95,40 @@ extern "C"
 #define DEFAULT_CR_TIME 0xC000 // 12:00:00
 #define DEFAULT_CR_DATE 0x2C21 // January 1, 2002
 
+// Maximum number of file descriptors that can exist at the same time
+#ifndef FAT16_MAX_FILES
+#define FAT16_MAX_FILES 8
+#endif
+
+// Number of FAT windows cached per device and FAT sectors in each
+// window (a power of 2, 32 or less). The FAT cluster table is loaded
+// one window at a time as it is used.
+#ifndef FAT16_FAT_WINDOWS
+#define FAT16_FAT_WINDOWS 4
+#endif
+#ifndef FAT16_FAT_WIN_SECTORS
+#define FAT16_FAT_WIN_SECTORS 4
+#endif
+
+// Number of cluster runs indexed for each file open for reading.
+// Seeks inside the indexed runs need no FAT chain walk, seeks past
+// them walk the chain from the end of the last indexed run.
+#ifndef FAT16_MAX_EXTENTS
+#define FAT16_MAX_EXTENTS 16
+#endif
+
+// Number of free clusters a new file should have after its first
+// cluster, so it can grow without being fragmented
+#ifndef FAT16_ALLOC_RUN
+#define FAT16_ALLOC_RUN 32
+#endif
+
+// Number of hash buckets (power of 2) used to look up names in the
+// active directory of a file descriptor
+#ifndef FAT16_DIR_HASH_SIZE
+#define FAT16_DIR_HASH_SIZE 64
+#endif
+
 // FAT16 extended signature
 #define EXTENDED_SIG    0x29
 #define EXTENDED_SIG_IDX 0x26  // Extended signature index in data
@@ -183,6 +217,7 @@ typedef struct
 typedef void (*vvfunc)(void);
 typedef INT_32(*ivfunc)(void);
 typedef INT_32(*ivifunc)(void *, INT_32);
+typedef INT_32(*imsfunc)(UNS_32, void *, UNS_32);
 typedef struct
 {
   ivfunc init_func;
@@ -195,8 +230,41 @@ typedef struct
   vvfunc start_write_func;
   ivifunc read_func;
   ivifunc write_func;
+  imsfunc read_multi_func;   // Optional multi-sector read, or NULL
+  imsfunc write_multi_func;  // Optional multi-sector write, or NULL
 } DEVICE_FUNCS_TYPE;
 
+// Sector cache line tag
+typedef struct
+{
+  UNS_32   sector;         // Absolute sector number held in the line
+  UNS_32   stamp;          // LRU stamp, larger is more recently used
+  UNS_32   flags;          // Line valid and dirty flags
+} FAT16_CACHE_LINE_TYPE;
+
+// N-way set associative write-back sector cache, built in a caller
+// supplied buffer (see fat16_cache_init)
+typedef struct
+{
+  UNS_8    *data;          // Line data, one sector per line
+  FAT16_CACHE_LINE_TYPE *lines; // Line tags, set by set
+  UNS_32   ways;           // Lines per set, 0 = cache disabled
+  UNS_32   sets;           // Number of sets (power of 2)
+  UNS_32   stamp;          // LRU clock
+  UNS_32   hits;           // Sector accesses found in the cache
+  UNS_32   misses;         // Sector accesses that needed a line
+  UNS_32   writebacks;     // Dirty sectors written to the device
+} FAT16_CACHE_TYPE;
+
+// FAT window, an aligned block of FAT sectors cached in memory
+typedef struct
+{
+  UNS_16   *entries;       // Cluster entries in the window
+  UNS_32   block;          // Window number in the FAT, or 0xFFFFFFFF
+  UNS_32   stamp;          // LRU stamp, larger is more recently used
+  UNS_32   dirty;          // Changed flag for each sector in the window
+} FAT16_FATWIN_TYPE;
+
 // FAT device structure, used to bind a device driver to the FAT
 // driver
 typedef struct
@@ -208,12 +276,28 @@ typedef struct
   FATGEOM_TYPE pat_hdr;    // Partition header from selected part.
   FATDATA_TYPE cfat;       // Computed FAT architecture data
   DEVICE_FUNCS_TYPE func;  // Pointer to device driver functions
-  UNS_16   *clusters;      // Cached cluster table
+  FAT16_FATWIN_TYPE fat_win [FAT16_FAT_WINDOWS]; // FAT window cache
+  FAT16_FATWIN_TYPE *fat_win_last; // Most recently used FAT window
+  UNS_32   fat_stamp;      // FAT window LRU clock
+  UNS_32   fat_sec_shift;  // log2 of the cluster entries per sector
+  UNS_32   fat_win_shift;  // log2 of the cluster entries per window
+  UNS_32   *free_map;      // Cluster in use bitmap, or NULL if not built
+  UNS_32   free_count;     // Number of free clusters
+  UNS_32   free_hint;      // No free cluster below this cluster
+  FAT16_CACHE_TYPE cache;  // Sector cache between driver and device
 } FAT_DEVICE_TYPE;
 
 // File modes
 typedef enum {FINVALID, FREAD, FWRITE} FILE_MODE_TYPE;
 
+// Run of contiguous clusters in a file (extent)
+typedef struct
+{
+  UNS_32   file_cluster;   // Index of the first cluster in the file
+  UNS_16   cluster;        // First cluster number of the run
+  UNS_16   count;          // Number of clusters in the run
+} FAT16_EXTENT_TYPE;
+
 // File descriptor
 typedef struct
 {
@@ -228,6 +312,15 @@ typedef struct
   UNS_32   buf_index;      // Buffer read/write index
   ROOT_ENTRY_TYPE *dir_data; // Cached active directory structure
   INT_32   dir_index;      // Directory entry lookup index
+  UNS_16  *dir_hash;       // Directory name hash buckets and chains
+  INT_32   dir_hashed;     // Hash valid flag, if set, dir_hash is built
+  INT_32   dir_free;       // Lowest directory entry that may be free
+  UNS_32   buf_start;      // First unwritten byte in buffer (write mode)
+  UNS_16   prealloc_last;  // Last preallocated cluster, 0 if none
+  UNS_32   length;         // File length in bytes (read mode)
+  FAT16_EXTENT_TYPE extents [FAT16_MAX_EXTENTS]; // Cluster run index
+  INT_32   num_extents;    // Number of used extents
+  UNS_32   ext_clusters;   // Number of file clusters in the extents
 } FILE_TYPE;
 
 /***********************************************************************
@@ -247,6 +340,13 @@ FAT_DEVICE_TYPE * fat16_init_device(
   ivifunc read_func,         // Pointer for read of data
   ivifunc write_func);       // Pointer for write of data
 
+// Binds optional multi-sector transfer functions to the device. Each
+// function transfers a number of sectors starting at an absolute
+// sector and returns the number of sectors transferred
+void fat16_set_multi_funcs(FAT_DEVICE_TYPE *fat_data,
+                           imsfunc read_multi_func,
+                           imsfunc write_multi_func);
+
 // Shutdowns the FAT16 interface for the selected device (will destroy
 // the FAT device structure)
 void fat16_shutdown(FAT_DEVICE_TYPE *fat_data);
@@ -258,7 +358,7 @@ void fat16_shutdown(FAT_DEVICE_TYPE *fat_data);
 void fat16_get_status(FAT_DEVICE_TYPE *fat_data, UNS_8 *status,
                       UNS_8 *ptype, INT_32 pnum);
 
-// Set the active (FAT16) partition and cache cluster table
+// Set the active (FAT16) partition and setup the FAT window cache
 INT_32 fat16_set_partition(INT_32 partnum, FAT_DEVICE_TYPE *fat_data);
 
 //**********************************************************************
@@ -304,6 +404,9 @@ INT_32 fat16_read(FILE_TYPE *file_data, INT_32 bytes_to_copy,
 INT_32 fat16_write(FILE_TYPE *file_data, void *buffer_ptr,
                    INT_32 bytes_to_copy);
 
+// Reserves a contiguous run of clusters for a file being written
+INT_32 fat16_preallocate(FILE_TYPE *file_data, UNS_32 bytes);
+
 // Close a file that was open for reading or writing, or anything
 // else (will destroy the file descriptor)
 void fat16_close_file(FILE_TYPE *file_data);
@@ -317,8 +420,36 @@ INT_32 fat16_get_active_mbr(FAT_DEVICE_TYPE *fat_data,
 
 void fat16_save_all(FILE_TYPE *file_data, FAT_DEVICE_TYPE *fat_data);
 
+// Moves the read position of a file forward (or back) a number of
+// bytes
 INT_32 fat16_seek(FILE_TYPE *file_data, INT_32 seek_bytes);
 
+// Returns the read or write position of a file
+UNS_32 fat16_tell(FILE_TYPE *file_data);
+
+// Read data from a file starting at a byte offset in the file
+INT_32 fat16_read_at(FILE_TYPE *file_data, UNS_32 offset,
+                     INT_32 bytes_to_copy, void *buffer_ptr,
+                     INT_32 *bytes_copied, INT_32 *eof);
+
+// Returns the number of free clusters in the active partition
+UNS_32 fat16_get_free_clusters(FAT_DEVICE_TYPE *fat_data);
+
+/***********************************************************************
+ * Sector cache functions
+ **********************************************************************/
+// Sets up (or with a NULL buffer, disables) the sector cache in a
+// caller supplied buffer, returns the number of cache lines
+INT_32 fat16_cache_init(FAT_DEVICE_TYPE *fat_data, void *buffer,
+                        UNS_32 size, UNS_32 ways);
+
+// Writes all dirty cached sectors back to the device
+void fat16_cache_flush(FAT_DEVICE_TYPE *fat_data);
+
+// Returns the cache hit, miss, and write back counters
+void fat16_cache_get_stats(FAT_DEVICE_TYPE *fat_data, UNS_32 *hits,
+                           UNS_32 *misses, UNS_32 *writebacks);
+
 #if defined (__cplusplus)
 }
 #endif /*__cplusplus */
@@ -34,6 +34,20 @@ extern "C"
  **********************************************************************/
 #define PTAB_SIZE 512 // Size of MBR and boot records
 
+// FAT window block number of an unused window
+#define FAT16_FATWIN_NONE 0xFFFFFFFF
+
+// Bit for a cluster in its free cluster bitmap word
+#define FAT16_FREE_BIT(c) ((UNS_32) 1 << ((c) & 31))
+
+// End of a directory name hash chain
+#define FAT16_DIR_HASH_END 0xFFFF
+
+// Sector cache line size and line flags
+#define FAT16_CACHE_LINE_SIZE PTAB_SIZE
+#define FAT16_CACHE_VALID     0x1
+#define FAT16_CACHE_DIRTY     0x2
+
 /***********************************************************************
  * Support functions for the FAT16 driver
  **********************************************************************/
@@ -62,6 +76,20 @@ void fat16_read_sectors(FAT_DEVICE_TYPE *fat_data, void *data,
 void fat16_write_sectors(FAT_DEVICE_TYPE *fat_data, void *data,
                          UNS_32 first_sector, UNS_32 num_sectors);
 
+// Reads a number of sectors using the device multi-sector read
+// function if there is one
+void fat16_read_sectors_multi(FAT_DEVICE_TYPE *fat_data, void *data,
+                              UNS_32 first_sector, UNS_32 num_sectors);
+
+// Writes a number of sectors using the device multi-sector write
+// function if there is one
+void fat16_write_sectors_multi(FAT_DEVICE_TYPE *fat_data, void *data,
+                               UNS_32 first_sector,
+                               UNS_32 num_sectors);
+
+// Writes all dirty cache lines back to the device
+void fat16_cache_writeback(FAT_DEVICE_TYPE *fat_data);
+
 // Finds the next directory name in a path
 INT_32 fat16_parse_path(CHAR *path);
 
@@ -77,11 +105,30 @@ INT_32 fat16_name_check(CHAR *name, ROOT_ENTRY_TYPE *dir_data);
 // in the active directory
 INT_32 fat16_find_file(CHAR *name, FILE_TYPE *file_data);
 
+// Writes the unwritten part of the cluster buffer of a file being
+// written to its cluster
+void fat16_write_staged(FILE_TYPE *file_data);
+
+// Adds a directory entry to the directory name hash
+void fat16_dir_hash_add(FILE_TYPE *file_data, INT_32 dir_index);
+
+// Removes a directory entry from the directory name hash
+void fat16_dir_hash_remove(FILE_TYPE *file_data, INT_32 dir_index);
+
+// Builds the free cluster bitmap from the FAT
+void fat16_free_map_build(FAT_DEVICE_TYPE *fat_data);
+
 // Find the next free cluster in the cluster list. Searches down
 // from the passed cluster
 UNS_16 fat16_find_free_cluster(FAT_DEVICE_TYPE *fat_data,
                                UNS_16 cluster_start);
 
+// Finds the first run of free clusters of at least the passed size,
+// or the longest free run if there is none that long
+UNS_16 fat16_find_free_run(FAT_DEVICE_TYPE *fat_data,
+                           UNS_16 cluster_start, UNS_32 clusters,
+                           UNS_32 *run_len);
+
 // Allocates a new directory entry for the passed name
 INT_32 fat16_get_free_dir_entry(FILE_TYPE *file_data);
 
@@ -89,6 +136,19 @@ INT_32 fat16_get_free_dir_entry(FILE_TYPE *file_data);
 UNS_32 fat16_get_next_cluster(FAT_DEVICE_TYPE *fat_data,
                               UNS_16 cluster_num);
 
+// Sets the next cluster of a cluster in the cluster link chain
+void fat16_set_next_cluster(FAT_DEVICE_TYPE *fat_data,
+                            UNS_16 cluster_num, UNS_16 next_cluster);
+
+// Writes the changed FAT sectors back to all FAT copies
+void fat16_fat_writeback(FAT_DEVICE_TYPE *fat_data);
+
+// Builds the cluster run index of a file opened for reading
+void fat16_build_extents(FILE_TYPE *file_data);
+
+// Returns the cluster number of a cluster index in a file
+UNS_16 fat16_file_cluster(FILE_TYPE *file_data, UNS_32 file_cluster);
+
 // Support function to set up the first partition in the driver
 // to point to sector 1 for the boot record
 void fat16_set_no_mbr(FAT_DEVICE_TYPE *fat_data);
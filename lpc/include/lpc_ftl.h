@@ -0,0 +1,259 @@
+/***********************************************************************
+ * $Id:: lpc_ftl.h                                                     $
+ *
+ * Project: NAND flash translation layer
+ *
+ * Description:
+ *     Presents a range of NAND blocks as a block device of 512 byte
+ *     sectors that can be rewritten in place, for use with a FAT
+ *     volume or other rewritable data.
+ *
+ *     The FTL is log structured. A logical page is never rewritten in
+ *     place, each update is programmed to the next free page of the
+ *     active block and a page level logical to physical map is
+ *     updated in RAM. Sector writes smaller than a page are gathered
+ *     in a write buffer of LPC_FTL_WBUF_PAGES pages. The last page of
+ *     each block is a summary of the logical pages in the block.
+ *
+ *     When the number of free blocks drops to the reserve, garbage
+ *     collection picks a victim block (fewest valid pages, or the
+ *     best cost-benefit of age and free space), moves its valid pages
+ *     to the active block, and frees it. Free blocks are allocated
+ *     least erased first, and the data of a block that has fallen
+ *     LPC_FTL_WL_DELTA erases behind the most erased block is moved
+ *     so its block can be reused.
+ *
+ *     lpc_ftl_sync() writes the write buffer and a checkpoint of the
+ *     map. A checkpoint is only replaced once the new one is complete,
+ *     and blocks are only erased when nothing on the device refers to
+ *     them, so after a power loss the FTL mounts from the last
+ *     checkpoint and the block summaries written after it. Data in the
+ *     write buffer or in the unfinished active block since the last
+ *     checkpoint may be lost.
+ *
+ *     The device functions have the same form as the S1L flash_xxx
+ *     NAND functions, so the FTL can be bound directly to them. Page
+ *     buffers passed to them are 32-bit aligned.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#ifndef LPC_FTL_H
+#define LPC_FTL_H
+
+#include "lpc_types.h"
+#include "lpc_nandflash_params.h"
+
+#if defined (__cplusplus)
+extern "C"
+{
+#endif
+
+/***********************************************************************
+ * FTL defines
+ **********************************************************************/
+
+/* Size of a logical sector */
+#define LPC_FTL_SECTOR_SIZE    512
+
+/* Number of pages in the write buffer */
+#define LPC_FTL_WBUF_PAGES     4
+
+/* Free blocks kept back for garbage collection, in addition to the
+   blocks needed for a checkpoint */
+#define LPC_FTL_GC_RESERVE     2
+
+/* 1 / (1 << LPC_FTL_OP_SHIFT) of the good blocks are not mapped to
+   logical pages, so garbage collection always finds free space and
+   blocks that go bad can be replaced */
+#define LPC_FTL_OP_SHIFT       3
+
+/* Erase count spread at which the data of the least erased block is
+   moved */
+#define LPC_FTL_WL_DELTA       128
+
+/* Signatures of the checkpoint ("FtlC") and summary ("FtlS") pages */
+#define LPC_FTL_MAGIC_CKPT     0x436C7446
+#define LPC_FTL_MAGIC_SUM      0x536C7446
+
+/* Garbage collection victim policies */
+#define LPC_FTL_GC_GREEDY      0 /* Fewest valid pages */
+#define LPC_FTL_GC_COST_BENEFIT 1 /* Best free space times age */
+
+/***********************************************************************
+ * FTL types
+ **********************************************************************/
+
+/* NAND device range and access functions used by the FTL */
+typedef struct
+{
+  const NAND_GEOM_T *geom;      /* Device geometry */
+  UNS_32 first_block;           /* First block used by the FTL */
+  UNS_32 num_blocks;            /* Number of blocks used by the FTL */
+  UNS_32 gc_policy;             /* LPC_FTL_GC_xxx */
+  /* Read a page, returns >0 on pass */
+  int (*read_sector)(UNS_32 sector, void *buff, void *extra);
+  /* Write a page, returns >0 on pass */
+  int (*write_sector)(UNS_32 sector, void *buff, void *extra);
+  /* Erase a block, returns TRUE on pass */
+  BOOL_32 (*erase_block)(UNS_32 block);
+  /* Returns TRUE if a block is bad */
+  BOOL_32 (*is_bad_block)(UNS_32 block);
+} LPC_FTL_DEV_T;
+
+/* Block information, also saved in the checkpoint */
+typedef struct
+{
+  UNS_32 erases;                /* Number of times erased */
+  UNS_32 seq;                   /* Sequence number when allocated */
+  UNS_16 valid;                 /* Number of valid data pages */
+  UNS_8 state;                  /* Block state */
+  UNS_8 rsvd;
+} LPC_FTL_BLK_T;
+
+/* Write buffer page */
+typedef struct
+{
+  UNS_32 lpage;                 /* Logical page, or 0xFFFFFFFF */
+  UNS_32 mask;                  /* Bit per sector written */
+  UNS_32 stamp;                 /* LRU stamp */
+} LPC_FTL_WSLOT_T;
+
+/* Checkpoint header, at the start of the checkpoint data */
+typedef struct
+{
+  UNS_32 num_blocks;            /* Blocks used by the FTL */
+  UNS_32 pages_per_block;       /* Pages per block */
+  UNS_32 lpages;                /* Number of logical pages */
+  UNS_32 pages;                 /* Pages used by the checkpoint */
+  INT_32 open_block;            /* Active block, or -1 */
+  UNS_32 open_page;             /* Next free page of the active block */
+} LPC_FTL_CKHDR_T;
+
+/* FTL counters */
+typedef struct
+{
+  UNS_32 host_writes;           /* Sectors written by the caller */
+  UNS_32 page_writes;           /* Data pages programmed */
+  UNS_32 gc_writes;             /* Pages moved by garbage collection */
+  UNS_32 erases;                /* Blocks erased */
+  UNS_32 checkpoints;           /* Checkpoints written */
+  UNS_32 min_erases;            /* Erase count of least erased block */
+  UNS_32 max_erases;            /* Erase count of most erased block */
+  UNS_32 free_blocks;           /* Blocks free for allocation */
+} LPC_FTL_STATS_T;
+
+/* FTL control structure */
+typedef struct
+{
+  LPC_FTL_DEV_T dev;            /* Device range and functions */
+  UNS_32 ppb;                   /* Pages per block */
+  UNS_32 dpb;                   /* Data pages per block */
+  UNS_32 page_size;             /* Bytes per page */
+  UNS_32 spp;                   /* Sectors per page */
+  UNS_32 nblk;                  /* Number of blocks */
+  UNS_32 lpages;                /* Number of logical pages */
+  UNS_32 ckblocks;              /* Blocks used by a checkpoint */
+  UNS_32 *l2p;                  /* Logical to physical page map */
+  UNS_32 *p2l;                  /* Physical to logical page map */
+  LPC_FTL_BLK_T *blk;           /* Block information */
+  UNS_8 *wbuf;                  /* Write buffer pages */
+  UNS_8 *gcbuf;                 /* Page moved by garbage collection */
+  UNS_8 *iobuf;                 /* Checkpoint and mount page */
+  UNS_8 *rdbuf;                 /* Last page read for a part read */
+  UNS_32 *sumbuf;               /* Summary of the active block */
+  UNS_32 rdppn;                 /* Page in rdbuf, or 0xFFFFFFFF */
+  LPC_FTL_WSLOT_T wslot[LPC_FTL_WBUF_PAGES]; /* Write buffer pages */
+  UNS_32 wstamp;                /* Write buffer LRU clock */
+  INT_32 active;                /* Active block, or -1 */
+  UNS_32 wp;                    /* Next free page in the active block */
+  UNS_32 seq;                   /* Last used sequence number */
+  UNS_32 ckseq;                 /* Sequence number of the checkpoint */
+  LPC_FTL_CKHDR_T ckhdr;        /* Checkpoint header */
+  UNS_32 nfree;                 /* Number of free blocks */
+  UNS_32 max_erases;            /* Largest block erase count */
+  BOOL_32 in_gc;                /* TRUE during garbage collection */
+  BOOL_32 hold;                 /* Keep freed blocks until checkpoint */
+  BOOL_32 dirty;                /* Map changed since the checkpoint */
+  LPC_FTL_STATS_T stats;        /* Counters */
+} LPC_FTL_T;
+
+/***********************************************************************
+ * FTL functions
+ **********************************************************************/
+
+/* Returns the size of the work memory needed for a device */
+UNS_32 lpc_ftl_mem_size(const LPC_FTL_DEV_T *dev);
+
+/* Mount the FTL on a device from its last checkpoint, or format the
+   device if there is none and format is TRUE */
+STATUS lpc_ftl_init(LPC_FTL_T *ftl,
+                    const LPC_FTL_DEV_T *dev,
+                    void *mem,
+                    UNS_32 size,
+                    BOOL_32 format);
+
+/* Returns the number of logical sectors */
+UNS_32 lpc_ftl_sectors(LPC_FTL_T *ftl);
+
+/* Read sectors, returns the number of sectors read */
+INT_32 lpc_ftl_read(LPC_FTL_T *ftl,
+                    UNS_32 sector,
+                    void *buff,
+                    UNS_32 count);
+
+/* Write sectors, returns the number of sectors written */
+INT_32 lpc_ftl_write(LPC_FTL_T *ftl,
+                     UNS_32 sector,
+                     void *buff,
+                     UNS_32 count);
+
+/* Write the write buffer and a checkpoint of the map */
+STATUS lpc_ftl_sync(LPC_FTL_T *ftl);
+
+/* Return the FTL counters */
+void lpc_ftl_get_stats(LPC_FTL_T *ftl,
+                       LPC_FTL_STATS_T *stats);
+
+/***********************************************************************
+ * FTL device functions for lpc_fat16
+ **********************************************************************/
+
+/* Select the FTL used by the lpc_fat16 device functions */
+void lpc_ftl_fat_bind(LPC_FTL_T *ftl);
+
+/* Device functions for fat16_init_device and fat16_set_multi_funcs.
+   The shutdown function syncs the FTL. */
+INT_32 lpc_ftl_fat_init(void);
+void lpc_ftl_fat_shutdown(void);
+INT_32 lpc_ftl_fat_insert_ck(void);
+INT_32 lpc_ftl_fat_ready_ck(void);
+INT_32 lpc_ftl_fat_busy_ck(void);
+void lpc_ftl_fat_set_sector(UNS_32 sector);
+void lpc_ftl_fat_start(void);
+INT_32 lpc_ftl_fat_read(void *buff,
+                        INT_32 bytes);
+INT_32 lpc_ftl_fat_write(void *buff,
+                         INT_32 bytes);
+INT_32 lpc_ftl_fat_read_multi(UNS_32 sector,
+                              void *buff,
+                              UNS_32 count);
+INT_32 lpc_ftl_fat_write_multi(UNS_32 sector,
+                               void *buff,
+                               UNS_32 count);
+
+#if defined (__cplusplus)
+}
+#endif /*__cplusplus */
+
+#endif /* LPC_FTL_H */
@@ -9,8 +9,31 @@
  *     lpc_heap_init must be performed with the base heap address and
  *     the size of the heap in bytes.
  *
+ *     A size-class mode can be selected instead with
+ *     lpc_heap_init_mode. In this mode free chunks are kept on
+ *     segregated free lists (one per power-of-two size class) and each
+ *     chunk carries boundary tags, so allocation, free and coalescing
+ *     of neighbouring free chunks take a constant time independent of
+ *     the number of live allocations.
+ *
  *     All returned allocation areas are 32-bit aligned.
  *
+ *     Additional heaps (for example IRAM next to the SDRAM default
+ *     heap) can be set up with lpc_heap_create and allocated from with
+ *     lpc_new_in. A heap can be set for each placement hint with
+ *     lpc_heap_set_placement, so drivers can use lpc_new_placed to get
+ *     fast memory for small frequently used objects, or bulk memory for
+ *     large buffers, without knowing the memory map. lpc_free returns
+ *     an area to the heap it was allocated from.
+ *
+ *     When built with LPC_HEAP_STATS defined, the heap also records
+ *     usage statistics: bytes in use and their peak, per call site
+ *     allocation counts (use lpc_new_tagged or lpc_new_placed_tagged
+ *     to tag the call site), and the time spent in allocation and free
+ *     if a timer is set with lpc_heap_set_timer. The free chunk
+ *     histogram and fragmentation ratio are computed when the
+ *     statistics are read.
+ *
  ***********************************************************************
  * Software that is described herein is for illustrative purposes only
  * which provides customers with programming information regarding the
@@ -35,6 +58,75 @@ extern "C"
 #endif
 
 
+/***********************************************************************
+ * Heap types
+ **********************************************************************/
+
+/* Heap allocation modes */
+typedef enum
+{
+  LPC_HEAP_FIRST_FIT = 0, /* Linked list walk, first-fit (default) */
+  LPC_HEAP_SIZE_CLASS     /* Segregated size-class free lists */
+} LPC_HEAP_MODE_T;
+
+/* Memory placement hints */
+typedef enum
+{
+  LPC_MEM_FAST = 0, /* Small, frequently used objects (IRAM) */
+  LPC_MEM_BULK,     /* Large buffers (SDRAM) */
+  LPC_MEM_DMA,      /* Buffers and descriptors used by DMA */
+  LPC_MEM_TYPES
+} LPC_MEM_TYPE_T;
+
+/* Heap instance */
+typedef struct lpc_heap LPC_HEAP_T;
+
+#ifdef LPC_HEAP_STATS
+/* Number of call sites tracked by the heap statistics */
+#define LPC_HEAP_MAX_TAGS     16
+/* Number of free chunk size histogram buckets, bucket n counts chunks
+   of 2^n to (2^(n+1) - 1) bytes, the last bucket counts all larger
+   chunks */
+#define LPC_HEAP_HIST_BUCKETS 24
+/* Call site file name bytes kept in the binary dump */
+#define LPC_HEAP_TAG_NAME_LEN 16
+
+/* Binary statistics dump identifier ('HPST') and version */
+#define LPC_HEAP_DUMP_MAGIC   0x54535048
+#define LPC_HEAP_DUMP_VERSION 1
+/* Largest binary statistics dump size in bytes */
+#define LPC_HEAP_DUMP_MAX_SIZE (((19 + LPC_HEAP_HIST_BUCKETS) * 4) + \
+  (LPC_HEAP_MAX_TAGS * (LPC_HEAP_TAG_NAME_LEN + 12)))
+
+/* Per call site statistics */
+typedef struct
+{
+  const CHAR *file;        /* Call site file (0 = untagged lpc_new) */
+  UNS_32 line;             /* Call site line */
+  UNS_32 allocs;           /* Number of allocations */
+  UNS_32 bytes;            /* Number of bytes allocated */
+} LPC_HEAP_TAG_STATS_T;
+
+/* Heap statistics */
+typedef struct
+{
+  UNS_32 bytes_in_use;     /* Allocated bytes, including headers */
+  UNS_32 peak_bytes;       /* Peak of bytes_in_use */
+  UNS_32 alloc_calls;      /* Number of allocation requests */
+  UNS_32 free_calls;       /* Number of successful frees */
+  UNS_32 failed_allocs;    /* Number of failed allocation requests */
+  UNS_32 untracked_allocs; /* Allocations from sites beyond the table */
+  UNS_64 alloc_ticks;      /* Time spent in allocation (timer ticks) */
+  UNS_64 free_ticks;       /* Time spent in free (timer ticks) */
+  UNS_32 free_bytes;       /* Total free bytes (computed on read) */
+  UNS_32 largest_free;     /* Largest free chunk (computed on read) */
+  UNS_32 frag_permille;    /* 1000 * (1 - largest_free / free_bytes) */
+  UNS_32 free_hist[LPC_HEAP_HIST_BUCKETS]; /* Free chunk histogram */
+  UNS_32 num_tags;         /* Used entries in tags */
+  LPC_HEAP_TAG_STATS_T tags[LPC_HEAP_MAX_TAGS];
+} LPC_HEAP_STATS_T;
+#endif
+
 /***********************************************************************
  * Heap statistics
  **********************************************************************/
@@ -45,12 +137,36 @@ UNS_32 lpc_get_heapsize(void);
 /* Return the size of the largest unallocated heap chunk */
 UNS_32 lpc_get_largest_chunk(void);
 
+/* Return the size of the largest unallocated chunk of a heap */
+UNS_32 lpc_get_largest_chunk_in(LPC_HEAP_T *heap);
+
 /* Return the number of allocated items in the heap */
 UNS_32 lpc_get_allocated_count(void);
 
+/* Return the number of allocated items in a heap */
+UNS_32 lpc_get_allocated_count_in(LPC_HEAP_T *heap);
+
 /* Return the heap base address */
 void *lpc_get_heap_base(void);
 
+#ifdef LPC_HEAP_STATS
+/* Set the free running timer used to measure alloc and free time */
+void lpc_heap_set_timer(UNS_64 (*timer_func)(void));
+
+/* Get a copy of the heap statistics */
+void lpc_heap_get_stats(LPC_HEAP_STATS_T *stats);
+
+/* Get a copy of the statistics of a heap */
+void lpc_heap_get_stats_in(LPC_HEAP_T *heap, LPC_HEAP_STATS_T *stats);
+
+/* Clear the counters of all heaps, bytes in use are kept */
+void lpc_heap_reset_stats(void);
+
+/* Write the heap statistics in the binary dump format, returns the
+   number of bytes written (0 if the buffer is too small) */
+UNS_32 lpc_heap_stats_dump(UNS_8 *buff, UNS_32 buff_size);
+#endif
+
 /***********************************************************************
  * Heap functions
  **********************************************************************/
@@ -58,12 +174,59 @@ void *lpc_get_heap_base(void);
 /* Setup the heap area */
 void lpc_heap_init(void *base_addr, UNS_32 heap_size);
 
+/* Setup the heap area with a specific allocation mode */
+void lpc_heap_init_mode(void *base_addr,
+                        UNS_32 heap_size,
+                        LPC_HEAP_MODE_T mode);
+
+/* Setup an additional heap area, returns 0 if it is too small */
+LPC_HEAP_T *lpc_heap_create(void *base_addr, UNS_32 heap_size);
+
+/* Setup an additional heap area with a specific allocation mode */
+LPC_HEAP_T *lpc_heap_create_mode(void *base_addr,
+                                 UNS_32 heap_size,
+                                 LPC_HEAP_MODE_T mode);
+
+/* Set the heap used for a placement hint (0 = default heap) */
+void lpc_heap_set_placement(LPC_MEM_TYPE_T mem_type, LPC_HEAP_T *heap);
+
 /* Get an allocated area from the heap */
 void *lpc_new(UNS_32 size_in_bytes);
 
-/* Return an allocated area to the heap */
+/* Get an allocated area from a specific heap */
+void *lpc_new_in(LPC_HEAP_T *heap, UNS_32 size_in_bytes);
+
+/* Get an allocated area from the heap for a placement hint */
+void *lpc_new_placed(UNS_32 size_in_bytes, LPC_MEM_TYPE_T mem_type);
+
+/* Return an allocated area to the heap it was allocated from */
 INT_32 lpc_free(void *free_addr);
 
+#ifdef LPC_HEAP_STATS
+/* Get an allocated area from the heap for a specific call site */
+void *lpc_new_tag(UNS_32 size_in_bytes, const CHAR *file, UNS_32 line);
+
+/* Get an allocated area for a placement hint and a call site */
+void *lpc_new_placed_tag(UNS_32 size_in_bytes,
+                         LPC_MEM_TYPE_T mem_type,
+                         const CHAR *file,
+                         UNS_32 line);
+
+/* Get an allocated area from the heap, tagged with the call site */
+#define lpc_new_tagged(size) \
+  lpc_new_tag((size), (const CHAR *) __FILE__, __LINE__)
+
+/* Get an allocated area for a placement hint, tagged with the call
+   site */
+#define lpc_new_placed_tagged(size, mem_type) \
+  lpc_new_placed_tag((size), (mem_type), (const CHAR *) __FILE__, \
+                     __LINE__)
+#else
+#define lpc_new_tagged(size) lpc_new(size)
+#define lpc_new_placed_tagged(size, mem_type) \
+  lpc_new_placed((size), (mem_type))
+#endif
+
 #if defined (__cplusplus)
 }
 #endif /*__cplusplus */
@@ -4,7 +4,8 @@
  * Project: NAND software ECC generation and correction
  *
  * Description:
- *     Generates, checks, and corrects 512 byte ECCs.
+ *     Generates, checks, and corrects 512 byte ECCs. Also generates
+ *     256 byte ECCs in the SLC hardware ECC layout.
  *
  ***********************************************************************
  * Software that is described herein is for illustrative purposes only
@@ -43,6 +44,10 @@ void lpc_eccinittables(void);
 UNS_32 lpc_eccgenerate512(LPC_ECC512 eccbuf,
                           UNS_8 *datbuf);
 
+/* Generate a software ECC for 256 bytes of data in the SLC hardware
+   ECC layout */
+UNS_32 lpc_eccgenerate256(UNS_8 *datbuf);
+
 /* ECC error check types */
 typedef enum
 {
@@ -58,6 +58,8 @@ extern "C"
 /* Alternate NAND command defines */
 #define LPCNAND_CMD_PAGE_READ1    0x00
 #define LPCNAND_CMD_PAGE_READ2    0x30
+#define LPCNAND_CMD_CACHE_READ    0x31
+#define LPCNAND_CMD_CACHE_END     0x3F
 #define LPCNAND_CMD_RANDOM_READ1  0x05
 #define LPCNAND_CMD_RANDOM_READ2  0xE0
 #define LPCNAND_CMD_STATUS        0x70
@@ -0,0 +1,114 @@
+/***********************************************************************
+ * $Id:: lpc_pool.h                                                    $
+ *
+ * Project: Fixed-size object pool manager
+ *
+ * Description:
+ *     This package provides pools of fixed-size objects. A pool is
+ *     created for a number of objects of a single size and alignment,
+ *     and objects are allocated and returned to the pool in constant
+ *     time through a free list threaded through the unused objects.
+ *     Pools never fragment the main heap and can be used from
+ *     interrupt handlers, as interrupts are only masked around the
+ *     free list update.
+ *
+ *     Each pool keeps an in-use bit per object after the objects in
+ *     its storage, so returning an object that is already free (or
+ *     was never allocated) is rejected instead of corrupting the free
+ *     list.
+ *
+ *     Pool storage can be supplied by the caller (lpc_pool_init) or
+ *     allocated once from the heap (lpc_pool_create).
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#ifndef LPC_POOL_H
+#define LPC_POOL_H
+
+#include "lpc_types.h"
+
+#if defined (__cplusplus)
+extern "C"
+{
+#endif
+
+/***********************************************************************
+ * Pool types
+ **********************************************************************/
+
+/* Pool control structure */
+typedef struct
+{
+  void   *free_list;       /* First free object (0 = pool empty) */
+  UNS_8  *first_obj;       /* Address of the first object */
+  UNS_8  *last_obj;        /* Address of the last object */
+  UNS_32 *in_use;          /* In-use bit per object */
+  UNS_32 obj_size;         /* Object stride in bytes */
+  UNS_32 num_objs;         /* Total number of objects */
+  UNS_32 free_count;       /* Number of free objects */
+} LPC_POOL_T;
+
+/***********************************************************************
+ * Pool defines
+ **********************************************************************/
+
+/* Object stride for objects of 'size' bytes aligned on 'align' bytes.
+   An object is at least large enough to hold the free list link. */
+#define LPC_POOL_OBJ_SIZE(size, align) \
+  (((((size) < sizeof(void *)) ? sizeof(void *) : (size)) + \
+    (align) - 1) & ~((align) - 1))
+
+/* Size in bytes of the in-use bits of 'num' objects */
+#define LPC_POOL_MAP_SIZE(num) ((((num) + 31) / 32) * sizeof(UNS_32))
+
+/* Storage size in bytes needed for 'num' objects of 'size' bytes
+   aligned on 'align' bytes and their in-use bits, for storage of any
+   alignment */
+#define LPC_POOL_STORAGE_SIZE(num, size, align) \
+  (((num) * LPC_POOL_OBJ_SIZE(size, align)) + \
+   LPC_POOL_MAP_SIZE(num) + (align) - 1)
+
+/***********************************************************************
+ * Pool functions
+ **********************************************************************/
+
+/* Setup a pool in caller supplied storage, returns number of objects */
+UNS_32 lpc_pool_init(LPC_POOL_T *pool,
+                     void *storage,
+                     UNS_32 storage_size,
+                     UNS_32 obj_size,
+                     UNS_32 align);
+
+/* Create a pool of objects with storage allocated from the heap */
+LPC_POOL_T *lpc_pool_create(UNS_32 num_objs,
+                            UNS_32 obj_size,
+                            UNS_32 align);
+
+/* Destroy a pool created with lpc_pool_create */
+void lpc_pool_destroy(LPC_POOL_T *pool);
+
+/* Get an object from a pool */
+void *lpc_pool_alloc(LPC_POOL_T *pool);
+
+/* Return an object to a pool */
+INT_32 lpc_pool_free(LPC_POOL_T *pool, void *obj);
+
+/* Return the number of free objects in a pool */
+UNS_32 lpc_pool_get_free_count(LPC_POOL_T *pool);
+
+#if defined (__cplusplus)
+}
+#endif /*__cplusplus */
+
+#endif /* LPC_POOL_H */
@@ -16,10 +16,18 @@
  *         RING_PUTC_MULTIPLE: Add multiple elements to buffer.
  *         RING_GETC_MULTIPLE: Remove multiple elements from buffer.
  *
+ *     It also provides a single-producer/single-consumer ring
+ *     (LPC_SPSC_RING_T, lpc_ring_* functions) for data passed from
+ *     one interrupt handler to one task or the reverse. The producer
+ *     only changes the head count and the consumer only changes the
+ *     tail count, so no locking is needed between the two. Data is
+ *     copied in bulk, split at most once at the wrap point.
+ *
  * Notes:
  *    The user of this ring buffer is responsible for specifying
  *    the ring buffer size and for providing the memory space used
- *    to store ring buffer data.
+ *    to store ring buffer data. The single-producer/single-consumer
+ *    ring size must be a power of 2.
  *
  ***********************************************************************
  * Software that is described herein is for illustrative purposes only
@@ -225,6 +233,101 @@ typedef struct RING_S
     ((RING_T*)ring)->count -= (nbytes);\
   }
 
+/***********************************************************************
+ * 3. Single-Producer/Single-Consumer Ring Buffer
+ **********************************************************************/
+
+/*
+ * Single-producer/single-consumer ring buffer structure. The head and
+ * tail are free running byte counts, the ring index is the count
+ * masked with the ring size - 1.
+ */
+typedef struct
+{
+  volatile UNS_32 head; // bytes written, only changed by the producer
+  volatile UNS_32 tail; // bytes read, only changed by the consumer
+  UNS_32 mask;          // ring size - 1
+  UNS_8 *data;          // pointer to data buffer
+} LPC_SPSC_RING_T;
+
+/*
+ * 3.1. Initialize ring buffer, size must be a power of 2.
+ */
+STATUS lpc_ring_init(LPC_SPSC_RING_T *ring, void *buffer, UNS_32 size);
+
+/*
+ * 3.2. Drain ring buffer (consumer side).
+ */
+void lpc_ring_flush(LPC_SPSC_RING_T *ring);
+
+/*
+ * 3.3. Return the number of bytes in the buffer.
+ */
+UNS_32 lpc_ring_count(LPC_SPSC_RING_T *ring);
+
+/*
+ * 3.4. Return the number of free bytes in the buffer.
+ */
+UNS_32 lpc_ring_space(LPC_SPSC_RING_T *ring);
+
+/*
+ * 3.5. Put up to nbytes into the buffer (producer side), returns the
+ *      number of bytes put.
+ */
+UNS_32 lpc_ring_put(LPC_SPSC_RING_T *ring,
+                    const void *buffer,
+                    UNS_32 nbytes);
+
+/*
+ * 3.6. Get up to nbytes from the buffer (consumer side), returns the
+ *      number of bytes read.
+ */
+UNS_32 lpc_ring_get(LPC_SPSC_RING_T *ring,
+                    void *buffer,
+                    UNS_32 nbytes);
+
+/*
+ * 3.7. Copy up to nbytes from the buffer without removing them
+ *      (consumer side), returns the number of bytes copied.
+ */
+UNS_32 lpc_ring_peek(LPC_SPSC_RING_T *ring,
+                     void *buffer,
+                     UNS_32 nbytes);
+
+/*
+ * 3.8. Remove up to nbytes from the buffer (consumer side), returns
+ *      the number of bytes removed.
+ */
+UNS_32 lpc_ring_skip(LPC_SPSC_RING_T *ring, UNS_32 nbytes);
+
+/*
+ * 3.9. Reserve the contiguous free span at the head of the buffer
+ *      (producer side). The span address is returned in *span and the
+ *      span size in bytes is returned, 0 if the buffer is full. The
+ *      span stops at the end of the ring storage, so a wrapping write
+ *      needs two reserves.
+ */
+UNS_32 lpc_ring_reserve(LPC_SPSC_RING_T *ring, void **span);
+
+/*
+ * 3.10. Commit nbytes written into a reserved span (producer side).
+ */
+void lpc_ring_commit(LPC_SPSC_RING_T *ring, UNS_32 nbytes);
+
+/*
+ * 3.11. Return the contiguous span of data at the tail of the buffer
+ *       without removing it (consumer side). The span address is
+ *       returned in *span and the span size in bytes is returned, 0
+ *       if the buffer is empty.
+ */
+UNS_32 lpc_ring_peek_span(LPC_SPSC_RING_T *ring, void **span);
+
+/*
+ * 3.12. Release nbytes of a peeked span back to the producer
+ *       (consumer side).
+ */
+void lpc_ring_release(LPC_SPSC_RING_T *ring, UNS_32 nbytes);
+
 #if defined (__cplusplus)
 }
 #endif /*__cplusplus */
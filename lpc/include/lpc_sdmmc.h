@@ -221,6 +221,7 @@ typedef enum
 /* class 8 */
 /* This is basically the same command as for MMC with some quirks. */
 #define SD_SEND_RELATIVE_ADDR     3   /* ac                      R6  */
+#define SD_SWITCH                 6   /* adtc [31:0]  mode/func  R1  */
 #define SD_CMD8                   8   /* bcr  [31:0]  OCR        R3  */
 
 /* Application commands */
@@ -0,0 +1,644 @@
+/***********************************************************************
+ * $Id:: lpc_bbt.c                                                     $
+ *
+ * Project: NAND bad block table
+ *
+ * Description:
+ *     See the header file for a description of this package.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include "lpc_bbt.h"
+
+/***********************************************************************
+ * Package types
+ **********************************************************************/
+
+/* Header at the start of a saved copy, followed by the bitmap */
+typedef struct
+{
+  UNS_32 magic;                 /* LPC_BBT_MAGIC_PRI or _MIR */
+  UNS_32 version;               /* Incremented on each save */
+  UNS_32 num_blocks;            /* Blocks covered by the bitmap */
+  UNS_32 check;                 /* Check value of version and bitmap */
+} BBT_HDR_T;
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: bbt_map_words
+ *
+ * Purpose: Return the number of bitmap words used by the device
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     bbt : Pointer to bad block table
+ *
+ * Outputs: None
+ *
+ * Returns: Number of 32-bit bitmap words
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 bbt_map_words(LPC_BBT_T *bbt)
+{
+  return (bbt->dev.num_blocks + 31) / 32;
+}
+
+/***********************************************************************
+ *
+ * Function: bbt_check
+ *
+ * Purpose: Compute the check value of a saved copy
+ *
+ * Processing:
+ *     Sum the version and bitmap words and return the complement, so
+ *     an erased page never checks good.
+ *
+ * Parameters:
+ *     bbt     : Pointer to bad block table
+ *     version : Version of the copy
+ *
+ * Outputs: None
+ *
+ * Returns: The check value
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 bbt_check(LPC_BBT_T *bbt, UNS_32 version)
+{
+  UNS_32 idx, sum = version;
+
+  for (idx = 0; idx < bbt_map_words(bbt); idx++)
+  {
+    sum += bbt->map[idx];
+  }
+
+  return ~sum;
+}
+
+/***********************************************************************
+ *
+ * Function: bbt_set
+ *
+ * Purpose: Set or clear the bit of a block
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     bbt   : Pointer to bad block table
+ *     block : Block number
+ *     bad   : TRUE to set the bit
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the bit changed, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 bbt_set(LPC_BBT_T *bbt, UNS_32 block, BOOL_32 bad)
+{
+  UNS_32 old, bit = (UNS_32) 1 << (block & 0x1F);
+
+  old = bbt->map[block >> 5];
+  if (bad == TRUE)
+  {
+    bbt->map[block >> 5] |= bit;
+  }
+  else
+  {
+    bbt->map[block >> 5] &= ~bit;
+  }
+
+  return (BOOL_32) (old != bbt->map[block >> 5]);
+}
+
+/***********************************************************************
+ *
+ * Function: bbt_copy_page
+ *
+ * Purpose: Move one page of a saved copy between the work buffer and
+ *          the header and bitmap
+ *
+ * Processing:
+ *     The saved copy is the header followed by the bitmap, spread over
+ *     as many pages as needed. Bytes past the bitmap are 0xFF.
+ *
+ * Parameters:
+ *     bbt    : Pointer to bad block table
+ *     hdr    : Pointer to the header of the copy
+ *     page   : Page of the copy
+ *     toflash: TRUE to fill the work buffer, FALSE to fill the header
+ *              and bitmap from it
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void bbt_copy_page(LPC_BBT_T *bbt, BBT_HDR_T *hdr, UNS_32 page,
+                          BOOL_32 toflash)
+{
+  UNS_8 *p8, *buff = bbt->dev.pagebuff;
+  UNS_32 idx, pos, mapbytes = bbt_map_words(bbt) * 4;
+
+  for (idx = 0; idx < bbt->dev.page_size; idx++)
+  {
+    pos = (page * bbt->dev.page_size) + idx;
+    if (pos < sizeof(BBT_HDR_T))
+    {
+      p8 = (UNS_8 *) hdr + pos;
+    }
+    else if ((pos - sizeof(BBT_HDR_T)) < mapbytes)
+    {
+      p8 = (UNS_8 *) bbt->map + (pos - sizeof(BBT_HDR_T));
+    }
+    else
+    {
+      p8 = NULL;
+    }
+
+    if (toflash == TRUE)
+    {
+      buff[idx] = (p8 != NULL) ? *p8 : 0xFF;
+    }
+    else if (p8 != NULL)
+    {
+      *p8 = buff[idx];
+    }
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: bbt_read_copy
+ *
+ * Purpose: Load the bitmap from a saved copy
+ *
+ * Processing:
+ *     Read each page of the copy into the header and bitmap and check
+ *     the result.
+ *
+ * Parameters:
+ *     bbt   : Pointer to bad block table
+ *     block : Block holding the copy
+ *
+ * Outputs: The bitmap is overwritten even if the copy is bad.
+ *
+ * Returns: TRUE if the copy was good, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 bbt_read_copy(LPC_BBT_T *bbt, UNS_32 block)
+{
+  BBT_HDR_T hdr;
+  UNS_32 page;
+
+  for (page = 0; page < bbt->tblpages; page++)
+  {
+    if (bbt->dev.read_sector((block * bbt->dev.pages_per_block) + page,
+                             bbt->dev.pagebuff) <= 0)
+    {
+      return FALSE;
+    }
+
+    bbt_copy_page(bbt, &hdr, page, FALSE);
+  }
+
+  return (BOOL_32) (hdr.check == bbt_check(bbt, hdr.version));
+}
+
+/***********************************************************************
+ *
+ * Function: bbt_load
+ *
+ * Purpose: Load the newest good saved copy of the table
+ *
+ * Processing:
+ *     Read the header of each reserved block and note the copies and
+ *     the highest version seen. Find the newest copy that checks good,
+ *     then check the other copies of the same version and use them as
+ *     the primary and mirror copies. The newest copy is read again
+ *     last, as a copy that does not check good leaves the bitmap
+ *     corrupt. If the primary or mirror copy is missing, save the
+ *     table again to repair it.
+ *
+ * Parameters:
+ *     bbt : Pointer to bad block table
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if a copy was loaded, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 bbt_load(LPC_BBT_T *bbt)
+{
+  BBT_HDR_T hdr;
+  UNS_32 blk, cblk[LPC_BBT_RSVD_BLOCKS], ver[LPC_BBT_RSVD_BLOCKS];
+  UNS_32 cmagic[LPC_BBT_RSVD_BLOCKS];
+  INT_32 idx, cnt, best;
+
+  /* Find the copies */
+  cnt = 0;
+  for (blk = bbt->first_rsvd; blk < bbt->dev.num_blocks; blk++)
+  {
+    if (bbt->dev.read_sector(blk * bbt->dev.pages_per_block,
+                             bbt->dev.pagebuff) <= 0)
+    {
+      continue;
+    }
+
+    bbt_copy_page(bbt, &hdr, 0, FALSE);
+    if (((hdr.magic != LPC_BBT_MAGIC_PRI) &&
+         (hdr.magic != LPC_BBT_MAGIC_MIR)) ||
+        (hdr.num_blocks != bbt->dev.num_blocks))
+    {
+      continue;
+    }
+
+    if (hdr.version > bbt->version)
+    {
+      bbt->version = hdr.version;
+    }
+
+    cblk[cnt] = blk;
+    ver[cnt] = hdr.version;
+    cmagic[cnt] = hdr.magic;
+    cnt++;
+  }
+
+  /* Find the newest good copy */
+  best = 0;
+  while (cnt > 0)
+  {
+    best = 0;
+    for (idx = 1; idx < cnt; idx++)
+    {
+      if (ver[idx] > ver[best])
+      {
+        best = idx;
+      }
+    }
+
+    if (bbt_read_copy(bbt, cblk[best]) == TRUE)
+    {
+      break;
+    }
+
+    cnt--;
+    cblk[best] = cblk[cnt];
+    ver[best] = ver[cnt];
+    cmagic[best] = cmagic[cnt];
+  }
+
+  if (cnt == 0)
+  {
+    return FALSE;
+  }
+
+  /* Use the good copies of that version */
+  for (idx = 0; idx < cnt; idx++)
+  {
+    if ((idx != best) && (ver[idx] == ver[best]) &&
+        (bbt_read_copy(bbt, cblk[idx]) == TRUE))
+    {
+      bbt->copyblk[(cmagic[idx] == LPC_BBT_MAGIC_PRI) ? 0 : 1] =
+        (INT_32) cblk[idx];
+    }
+  }
+  bbt->copyblk[(cmagic[best] == LPC_BBT_MAGIC_PRI) ? 0 : 1] =
+    (INT_32) cblk[best];
+  if (bbt_read_copy(bbt, cblk[best]) == FALSE)
+  {
+    return FALSE;
+  }
+
+  /* Repair a missing or old copy */
+  if ((bbt->copyblk[0] < 0) || (bbt->copyblk[1] < 0))
+  {
+    lpc_bbt_save(bbt);
+  }
+
+  return TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: bbt_write_copy
+ *
+ * Purpose: Write one saved copy of the table
+ *
+ * Processing:
+ *     Use the block of the copy, or the highest good reserved block not
+ *     used by the other copy. Erase it and write the header and bitmap.
+ *     A block that fails is marked bad and the next one is tried.
+ *
+ * Parameters:
+ *     bbt  : Pointer to bad block table
+ *     copy : 0 for the primary copy, 1 for the mirror copy
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the copy was written, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 bbt_write_copy(LPC_BBT_T *bbt, INT_32 copy)
+{
+  BBT_HDR_T hdr;
+  UNS_32 page, blk;
+  BOOL_32 ok;
+
+  hdr.magic = (copy == 0) ? LPC_BBT_MAGIC_PRI : LPC_BBT_MAGIC_MIR;
+  hdr.version = bbt->version;
+  hdr.num_blocks = bbt->dev.num_blocks;
+
+  while (1)
+  {
+    if (bbt->copyblk[copy] < 0)
+    {
+      /* Pick a block for the copy */
+      blk = bbt->dev.num_blocks;
+      while (blk > bbt->first_rsvd)
+      {
+        blk--;
+        if (((bbt->map[blk >> 5] & ((UNS_32) 1 << (blk & 0x1F))) == 0) &&
+            ((INT_32) blk != bbt->copyblk[1 - copy]))
+        {
+          bbt->copyblk[copy] = (INT_32) blk;
+          break;
+        }
+      }
+
+      if (bbt->copyblk[copy] < 0)
+      {
+        return FALSE;
+      }
+    }
+    blk = (UNS_32) bbt->copyblk[copy];
+
+    ok = (BOOL_32) (bbt->dev.erase_block(blk) != 0);
+    hdr.check = bbt_check(bbt, hdr.version);
+    for (page = 0; (page < bbt->tblpages) && (ok == TRUE); page++)
+    {
+      bbt_copy_page(bbt, &hdr, page, TRUE);
+      ok = (BOOL_32) (bbt->dev.write_sector(
+             (blk * bbt->dev.pages_per_block) + page,
+             bbt->dev.pagebuff) > 0);
+    }
+
+    if (ok == TRUE)
+    {
+      return TRUE;
+    }
+
+    /* Retire the block and try another one */
+    if (bbt_set(bbt, blk, TRUE) == TRUE)
+    {
+      bbt->dirty = TRUE;
+    }
+    bbt->copyblk[copy] = -1;
+  }
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: lpc_bbt_init
+ *
+ * Purpose: Setup a bad block table for a device
+ *
+ * Processing:
+ *     When saving is enabled, load the newest good saved copy. If there
+ *     is none, clear the bitmap and read the bad block marker of each
+ *     block, then save the table when saving is enabled.
+ *
+ * Parameters:
+ *     bbt  : Pointer to bad block table to setup
+ *     dev  : Pointer to device geometry and functions
+ *     save : TRUE to keep a copy of the table on the device
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if the table was setup, or _ERROR if the device
+ *          is not supported.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+STATUS lpc_bbt_init(LPC_BBT_T *bbt,
+                    const LPC_BBT_DEV_T *dev,
+                    BOOL_32 save)
+{
+  UNS_32 idx;
+
+  if ((dev->num_blocks > LPC_BBT_MAX_BLOCKS) ||
+      (dev->num_blocks <= LPC_BBT_RSVD_BLOCKS))
+  {
+    return _ERROR;
+  }
+
+  bbt->dev = *dev;
+  bbt->save = save;
+  bbt->busy = FALSE;
+  bbt->dirty = FALSE;
+  bbt->version = 0;
+  bbt->copyblk[0] = -1;
+  bbt->copyblk[1] = -1;
+  bbt->first_rsvd = dev->num_blocks;
+  bbt->tblpages = (sizeof(BBT_HDR_T) + (bbt_map_words(bbt) * 4) +
+                   dev->page_size - 1) / dev->page_size;
+
+  if (save == TRUE)
+  {
+    if (bbt->tblpages > dev->pages_per_block)
+    {
+      return _ERROR;
+    }
+
+    bbt->first_rsvd = dev->num_blocks - LPC_BBT_RSVD_BLOCKS;
+    if (bbt_load(bbt) == TRUE)
+    {
+      return _NO_ERROR;
+    }
+  }
+
+  /* Scan the bad block markers */
+  for (idx = 0; idx < (LPC_BBT_MAX_BLOCKS / 32); idx++)
+  {
+    bbt->map[idx] = 0;
+  }
+  for (idx = 0; idx < dev->num_blocks; idx++)
+  {
+    if (dev->marker_bad(idx) != 0)
+    {
+      bbt_set(bbt, idx, TRUE);
+    }
+  }
+
+  if (save == TRUE)
+  {
+    lpc_bbt_save(bbt);
+  }
+
+  return _NO_ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_bbt_is_bad
+ *
+ * Purpose: Check if a block is bad
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     bbt   : Pointer to bad block table
+ *     block : Block number
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the block is bad or reserved for the table,
+ *          otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+BOOL_32 lpc_bbt_is_bad(LPC_BBT_T *bbt,
+                       UNS_32 block)
+{
+  if (block >= bbt->first_rsvd)
+  {
+    return TRUE;
+  }
+
+  return (BOOL_32) ((bbt->map[block >> 5] >> (block & 0x1F)) & 0x1);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_bbt_mark
+ *
+ * Purpose: Mark a block as bad or good
+ *
+ * Processing:
+ *     Update the bit of the block and save the table if the bit
+ *     changed and saving is enabled.
+ *
+ * Parameters:
+ *     bbt   : Pointer to bad block table
+ *     block : Block number
+ *     bad   : TRUE to mark the block bad, FALSE to mark it good
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void lpc_bbt_mark(LPC_BBT_T *bbt,
+                  UNS_32 block,
+                  BOOL_32 bad)
+{
+  if (block >= bbt->dev.num_blocks)
+  {
+    return;
+  }
+
+  if ((bbt_set(bbt, block, bad) == TRUE) && (bbt->save == TRUE))
+  {
+    lpc_bbt_save(bbt);
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_bbt_save
+ *
+ * Purpose: Write both saved copies of the table
+ *
+ * Processing:
+ *     Increment the version and write the primary copy, then the
+ *     mirror copy. If the table changes while the copies are written,
+ *     for example when a table block fails and is marked bad by the
+ *     device functions, write the copies again.
+ *
+ * Parameters:
+ *     bbt : Pointer to bad block table
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if both copies were written, otherwise _ERROR
+ *
+ * Notes: A call made while the copies are being written only flags
+ *        the table as changed.
+ *
+ **********************************************************************/
+STATUS lpc_bbt_save(LPC_BBT_T *bbt)
+{
+  STATUS status;
+  INT_32 copy, tries = 0;
+
+  if (bbt->save == FALSE)
+  {
+    return _NO_ERROR;
+  }
+
+  if (bbt->busy == TRUE)
+  {
+    bbt->dirty = TRUE;
+    return _NO_ERROR;
+  }
+
+  bbt->busy = TRUE;
+  do
+  {
+    bbt->dirty = FALSE;
+    bbt->version++;
+    status = _NO_ERROR;
+    for (copy = 0; copy < 2; copy++)
+    {
+      if (bbt_write_copy(bbt, copy) == FALSE)
+      {
+        status = _ERROR;
+      }
+    }
+
+    tries++;
+  }
+  while ((bbt->dirty == TRUE) && (tries < LPC_BBT_RSVD_BLOCKS));
+  bbt->busy = FALSE;
+
+  return status;
+}
@@ -0,0 +1,682 @@
+/***********************************************************************
+ * $Id:: lpc_bch.c                                                     $
+ *
+ * Project: NAND software BCH ECC generation and correction
+ *
+ * Description:
+ *     See the header file for a description of this package.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include "lpc_bch.h"
+
+/***********************************************************************
+ * Package defines
+ **********************************************************************/
+
+/* Galois field GF(2^13) with primitive polynomial
+   x^13 + x^4 + x^3 + x + 1 */
+#define BCH_M                13
+#define BCH_N                ((1 << BCH_M) - 1)
+#define BCH_POLY             0x201B
+
+/* Number of data bits in a block */
+#define BCH_DATA_BITS        (LPC_BCH_DATA_BYTES * 8)
+
+/***********************************************************************
+ * Package data
+ **********************************************************************/
+
+/* Galois field antilog and log tables, shared by all codecs */
+static UNS_16 bch_alog[BCH_N + 1];
+static UNS_16 bch_log[BCH_N + 1];
+static BOOL_32 bch_gf_ready = FALSE;
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: lpc_bch_gf_init
+ *
+ * Purpose: Generate the Galois field lookup tables
+ *
+ * Processing:
+ *     Step through the powers of the primitive element, reducing by
+ *     the field polynomial, and record each power and its log.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void lpc_bch_gf_init(void)
+{
+  UNS_32 x = 1;
+  INT_32 idx;
+
+  for (idx = 0; idx < BCH_N; idx++)
+  {
+    bch_alog[idx] = (UNS_16) x;
+    bch_log[x] = (UNS_16) idx;
+    x = x << 1;
+    if ((x & (1 << BCH_M)) != 0)
+    {
+      x = x ^ BCH_POLY;
+    }
+  }
+  bch_alog[BCH_N] = 1;
+  bch_log[0] = 0;
+
+  bch_gf_ready = TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_bch_gf_mul
+ *
+ * Purpose: Multiply two Galois field elements
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     a : First element
+ *     b : Second element
+ *
+ * Outputs: None
+ *
+ * Returns: The product of a and b
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 lpc_bch_gf_mul(UNS_32 a, UNS_32 b)
+{
+  UNS_32 sum;
+
+  if ((a == 0) || (b == 0))
+  {
+    return 0;
+  }
+
+  sum = (UNS_32) bch_log[a] + (UNS_32) bch_log[b];
+  if (sum >= BCH_N)
+  {
+    sum -= BCH_N;
+  }
+
+  return bch_alog[sum];
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_bch_gf_div
+ *
+ * Purpose: Divide two Galois field elements
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     a : Dividend
+ *     b : Divisor, must not be 0
+ *
+ * Outputs: None
+ *
+ * Returns: a divided by b
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 lpc_bch_gf_div(UNS_32 a, UNS_32 b)
+{
+  UNS_32 diff;
+
+  if (a == 0)
+  {
+    return 0;
+  }
+
+  diff = (UNS_32) bch_log[a] + BCH_N - (UNS_32) bch_log[b];
+  if (diff >= BCH_N)
+  {
+    diff -= BCH_N;
+  }
+
+  return bch_alog[diff];
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_bch_shift
+ *
+ * Purpose: Shift an LFSR remainder left
+ *
+ * Processing:
+ *     Shift the remainder words left by the number of bits, moving
+ *     the top bits of each word into the word before it.
+ *
+ * Parameters:
+ *     r     : Remainder words, most significant word first
+ *     words : Number of remainder words
+ *     bits  : Number of bits to shift (1 to 31)
+ *
+ * Outputs: The shifted remainder is returned in r.
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void lpc_bch_shift(UNS_32 *r, INT_32 words, INT_32 bits)
+{
+  INT_32 idx;
+
+  for (idx = 0; idx < (words - 1); idx++)
+  {
+    r[idx] = (r[idx] << bits) | (r[idx + 1] >> (32 - bits));
+  }
+  r[words - 1] = r[words - 1] << bits;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_bch_genpoly
+ *
+ * Purpose: Generate the BCH generator polynomial
+ *
+ * Processing:
+ *     The generator is the product of (x - a^r) over the roots r in
+ *     the cyclotomic cosets of 1, 3, ..., 2t - 1. Each coset is
+ *     added once. The product coefficients are 0 or 1 and are
+ *     returned left aligned in LFSR remainder words, without the
+ *     leading x^deg term.
+ *
+ * Parameters:
+ *     t     : Correctable bits per block
+ *     gbits : Where to return the generator coefficient bits
+ *
+ * Outputs: The coefficients are returned in gbits.
+ *
+ * Returns: The degree of the generator polynomial.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 lpc_bch_genpoly(INT_32 t, UNS_32 *gbits)
+{
+  UNS_32 g[(LPC_BCH_MAX_T * BCH_M) + 1];
+  UNS_32 roots[LPC_BCH_MAX_T * BCH_M];
+  INT_32 nroots, deg, idx, odd, bit;
+  UNS_32 r;
+
+  /* Collect the roots */
+  nroots = 0;
+  for (odd = 1; odd < (2 * t); odd += 2)
+  {
+    r = (UNS_32) odd;
+    for (idx = 0; idx < nroots; idx++)
+    {
+      if (roots[idx] == r)
+      {
+        break;
+      }
+    }
+
+    /* Add the coset if the root is not already in an earlier one */
+    if (idx == nroots)
+    {
+      do
+      {
+        roots[nroots] = r;
+        nroots++;
+        r = (r * 2) % BCH_N;
+      } while (r != (UNS_32) odd);
+    }
+  }
+
+  /* Multiply out the product, g(x) = 1 to start */
+  g[0] = 1;
+  deg = 0;
+  for (idx = 0; idx < nroots; idx++)
+  {
+    g[deg + 1] = 1;
+    for (bit = deg; bit > 0; bit--)
+    {
+      g[bit] = g[bit - 1] ^ lpc_bch_gf_mul(g[bit], bch_alog[roots[idx]]);
+    }
+    g[0] = lpc_bch_gf_mul(g[0], bch_alog[roots[idx]]);
+    deg++;
+  }
+
+  /* Coefficient of x^k goes to bit (deg - 1 - k) from the top */
+  for (idx = 0; idx < LPC_BCH_ECC_WORDS; idx++)
+  {
+    gbits[idx] = 0;
+  }
+  for (bit = 0; bit < deg; bit++)
+  {
+    if (g[bit] != 0)
+    {
+      idx = deg - 1 - bit;
+      gbits[idx / 32] |= 0x80000000 >> (idx % 32);
+    }
+  }
+
+  return deg;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_bch_remainder
+ *
+ * Purpose: Compute the LFSR remainder of a block of data
+ *
+ * Processing:
+ *     For each data byte, the top byte of the remainder is XOR'ed with
+ *     the data byte to index the parallel LFSR table, the remainder is
+ *     shifted left by 8 bits and the table entry is XOR'ed in.
+ *
+ * Parameters:
+ *     bch    : Pointer to BCH codec
+ *     datbuf : 512 byte block of data
+ *     ecc    : Where to place the remainder bytes
+ *
+ * Outputs: The remainder is returned in ecc, most significant byte
+ *          first.
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void lpc_bch_remainder(LPC_BCH_T *bch,
+                              const UNS_8 *datbuf,
+                              UNS_8 *ecc)
+{
+  UNS_32 r[LPC_BCH_ECC_WORDS];
+  const UNS_32 *tab;
+  INT_32 idx, words = bch->eccwords;
+
+  for (idx = 0; idx < LPC_BCH_ECC_WORDS; idx++)
+  {
+    r[idx] = 0;
+  }
+
+  for (idx = 0; idx < LPC_BCH_DATA_BYTES; idx++)
+  {
+    tab = bch->lfsr[(r[0] >> 24) ^ datbuf[idx]];
+    lpc_bch_shift(r, words, 8);
+    r[0] ^= tab[0];
+    r[1] ^= tab[1];
+    r[2] ^= tab[2];
+    r[3] ^= tab[3];
+  }
+
+  for (idx = 0; idx < bch->eccbytes; idx++)
+  {
+    ecc[idx] = (UNS_8) (r[idx / 4] >> (24 - (8 * (idx % 4))));
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_bch_berlekamp
+ *
+ * Purpose: Find the error locator polynomial from the syndromes
+ *
+ * Processing:
+ *     Run the Berlekamp-Massey algorithm over the 2t syndromes.
+ *
+ * Parameters:
+ *     t    : Correctable bits per block
+ *     s    : Syndromes S1 to S2t in s[1] to s[2t]
+ *     elp  : Where to return the error locator polynomial
+ *
+ * Outputs: The error locator coefficients are returned in elp.
+ *
+ * Returns: The degree of the error locator polynomial.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 lpc_bch_berlekamp(INT_32 t, const UNS_32 *s, UNS_32 *elp)
+{
+  UNS_32 b[(2 * LPC_BCH_MAX_T) + 1], tmp[(2 * LPC_BCH_MAX_T) + 1];
+  UNS_32 d, bd, scale;
+  INT_32 n, idx, len, m;
+
+  for (idx = 0; idx <= (2 * t); idx++)
+  {
+    elp[idx] = 0;
+    b[idx] = 0;
+  }
+  elp[0] = 1;
+  b[0] = 1;
+  len = 0;
+  m = 1;
+  bd = 1;
+
+  for (n = 0; n < (2 * t); n++)
+  {
+    /* Discrepancy */
+    d = s[n + 1];
+    for (idx = 1; idx <= len; idx++)
+    {
+      d ^= lpc_bch_gf_mul(elp[idx], s[n + 1 - idx]);
+    }
+
+    if (d == 0)
+    {
+      m++;
+    }
+    else
+    {
+      scale = lpc_bch_gf_div(d, bd);
+      for (idx = 0; idx <= (2 * t); idx++)
+      {
+        tmp[idx] = elp[idx];
+      }
+      for (idx = m; idx <= (2 * t); idx++)
+      {
+        elp[idx] ^= lpc_bch_gf_mul(scale, b[idx - m]);
+      }
+
+      if ((2 * len) <= n)
+      {
+        len = n + 1 - len;
+        for (idx = 0; idx <= (2 * t); idx++)
+        {
+          b[idx] = tmp[idx];
+        }
+        bd = d;
+        m = 1;
+      }
+      else
+      {
+        m++;
+      }
+    }
+  }
+
+  return len;
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: lpc_bch_init
+ *
+ * Purpose: Setup a BCH codec
+ *
+ * Processing:
+ *     Generate the Galois field tables if needed and the generator
+ *     polynomial for t. Build the parallel LFSR table, where entry v
+ *     is the remainder of v(x) * x^deg divided by the generator,
+ *     using a bit serial LFSR. Finally compute the ECC of an erased
+ *     block to use as the erased block mask.
+ *
+ * Parameters:
+ *     bch : Pointer to BCH codec to setup
+ *     t   : Correctable bits per block, 4 or 8
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if the codec was setup, or _ERROR if t is not
+ *          supported.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+STATUS lpc_bch_init(LPC_BCH_T *bch, INT_32 t)
+{
+  UNS_32 gbits[LPC_BCH_ECC_WORDS];
+  UNS_8 ff[LPC_BCH_DATA_BYTES];
+  UNS_32 *r, fb;
+  INT_32 v, bit, idx;
+
+  if ((t != 4) && (t != 8))
+  {
+    return _ERROR;
+  }
+
+  if (bch_gf_ready == FALSE)
+  {
+    lpc_bch_gf_init();
+  }
+
+  bch->t = t;
+  bch->deg = lpc_bch_genpoly(t, gbits);
+  bch->eccbytes = (bch->deg + 7) / 8;
+  bch->eccwords = (bch->deg + 31) / 32;
+
+  /* Parallel LFSR table */
+  for (v = 0; v < 256; v++)
+  {
+    r = bch->lfsr[v];
+    for (idx = 0; idx < LPC_BCH_ECC_WORDS; idx++)
+    {
+      r[idx] = 0;
+    }
+
+    for (bit = 7; bit >= 0; bit--)
+    {
+      fb = (r[0] >> 31) ^ (((UNS_32) v >> bit) & 0x1);
+      lpc_bch_shift(r, bch->eccwords, 1);
+      if (fb != 0)
+      {
+        for (idx = 0; idx < LPC_BCH_ECC_WORDS; idx++)
+        {
+          r[idx] ^= gbits[idx];
+        }
+      }
+    }
+  }
+
+  /* Erased block mask, so an erased block has an all 0xFF ECC */
+  for (idx = 0; idx < bch->eccbytes; idx++)
+  {
+    bch->erased[idx] = 0;
+  }
+  for (idx = 0; idx < LPC_BCH_DATA_BYTES; idx++)
+  {
+    ff[idx] = 0xFF;
+  }
+  lpc_bch_remainder(bch, ff, bch->erased);
+  for (idx = 0; idx < bch->eccbytes; idx++)
+  {
+    bch->erased[idx] ^= 0xFF;
+  }
+
+  return _NO_ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_bch_encode
+ *
+ * Purpose: Generate the ECC for a 512 byte block of data
+ *
+ * Processing:
+ *     Compute the LFSR remainder of the data and XOR in the erased
+ *     block mask.
+ *
+ * Parameters:
+ *     bch    : Pointer to BCH codec
+ *     datbuf : 512 byte block of data
+ *     ecc    : Where to place the ECC (eccbytes long)
+ *
+ * Outputs: The ECC is returned in ecc.
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void lpc_bch_encode(LPC_BCH_T *bch,
+                    const UNS_8 *datbuf,
+                    UNS_8 *ecc)
+{
+  INT_32 idx;
+
+  lpc_bch_remainder(bch, datbuf, ecc);
+  for (idx = 0; idx < bch->eccbytes; idx++)
+  {
+    ecc[idx] ^= bch->erased[idx];
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_bch_decode
+ *
+ * Purpose: Check and correct a 512 byte block of data
+ *
+ * Processing:
+ *     Regenerate the ECC and compare it with the stored ECC. If they
+ *     match, return at once. Otherwise compute the syndromes from the
+ *     difference, find the error locator with Berlekamp-Massey and
+ *     search for its roots with a Chien search limited to the bit
+ *     positions of the shortened code word. If the number of roots
+ *     matches the locator degree, flip the data bits in error.
+ *
+ * Parameters:
+ *     bch    : Pointer to BCH codec
+ *     datbuf : 512 byte block of data to check and correct
+ *     ecc    : ECC read with the data
+ *
+ * Outputs: Errors in datbuf are corrected.
+ *
+ * Returns: The number of corrected bits (including bits in the ECC),
+ *          0 if there were no errors, or -1 if the block is not
+ *          correctable.
+ *
+ * Notes: The data is not changed if the block is not correctable.
+ *
+ **********************************************************************/
+INT_32 lpc_bch_decode(LPC_BCH_T *bch,
+                      UNS_8 *datbuf,
+                      const UNS_8 *ecc)
+{
+  UNS_8 diff[LPC_BCH_MAX_ECC_BYTES];
+  UNS_32 s[(2 * LPC_BCH_MAX_T) + 1], elp[(2 * LPC_BCH_MAX_T) + 1];
+  UNS_32 reg[LPC_BCH_MAX_T + 1], errpos[LPC_BCH_MAX_T];
+  UNS_32 any, sum, pos;
+  INT_32 idx, bit, len, nerr, t = bch->t, deg = bch->deg;
+
+  /* Compare the ECCs, ignoring the pad bits in the last byte */
+  lpc_bch_encode(bch, datbuf, diff);
+  for (idx = 0; idx < bch->eccbytes; idx++)
+  {
+    diff[idx] ^= ecc[idx];
+  }
+  diff[bch->eccbytes - 1] &= (UNS_8) (0xFF << ((8 - (deg % 8)) % 8));
+
+  any = 0;
+  for (idx = 0; idx < bch->eccbytes; idx++)
+  {
+    any |= diff[idx];
+  }
+  if (any == 0)
+  {
+    return 0;
+  }
+
+  /* Odd syndromes, ECC bit k is the coefficient of x^(deg - 1 - k) */
+  for (idx = 0; idx <= (2 * t); idx++)
+  {
+    s[idx] = 0;
+  }
+  for (bit = 0; bit < deg; bit++)
+  {
+    if ((diff[bit / 8] & (0x80 >> (bit % 8))) != 0)
+    {
+      pos = (UNS_32) (deg - 1 - bit);
+      for (idx = 1; idx < (2 * t); idx += 2)
+      {
+        s[idx] ^= bch_alog[(pos * (UNS_32) idx) % BCH_N];
+      }
+    }
+  }
+
+  /* Even syndromes are squares of earlier ones */
+  for (idx = 2; idx <= (2 * t); idx += 2)
+  {
+    s[idx] = lpc_bch_gf_mul(s[idx / 2], s[idx / 2]);
+  }
+
+  len = lpc_bch_berlekamp(t, s, elp);
+  if ((len > t) || (len == 0))
+  {
+    return -1;
+  }
+
+  /* Chien search over the used code word positions, reg[i] holds the
+     log of elp[i] * a^(-i * pos) */
+  for (idx = 1; idx <= len; idx++)
+  {
+    reg[idx] = bch_log[elp[idx]];
+  }
+
+  nerr = 0;
+  for (pos = 0; (pos < (UNS_32) (deg + BCH_DATA_BITS)) && (nerr < len);
+       pos++)
+  {
+    sum = 1;
+    for (idx = 1; idx <= len; idx++)
+    {
+      if (elp[idx] != 0)
+      {
+        sum ^= bch_alog[reg[idx]];
+        reg[idx] += BCH_N - (UNS_32) idx;
+        if (reg[idx] >= BCH_N)
+        {
+          reg[idx] -= BCH_N;
+        }
+      }
+    }
+
+    if (sum == 0)
+    {
+      errpos[nerr] = pos;
+      nerr++;
+    }
+  }
+
+  if (nerr != len)
+  {
+    return -1;
+  }
+
+  /* Correct the data bits, data bit 0 of byte 0 is the highest power */
+  for (idx = 0; idx < nerr; idx++)
+  {
+    if (errpos[idx] >= (UNS_32) deg)
+    {
+      pos = (BCH_DATA_BITS - 1) - (errpos[idx] - (UNS_32) deg);
+      datbuf[pos / 8] ^= (UNS_8) (0x80 >> (pos % 8));
+    }
+  }
+
+  return nerr;
+}
@@ -563,6 +563,7 @@ BMP_T *bmp_allocate_structure(INT_32 xsize,
                (ctable_size * sizeof(BMP_COLOR_TABLE_T)) +
                (xsize * ysize * dentry_size / 8) + 8;
 
-  /* Return pointer to allocated structure */
-  return (BMP_T *) lpc_new(alloc_size);
+  /* Return pointer to allocated structure, image data is large so
+     prefer bulk memory */
+  return (BMP_T *) lpc_new_placed_tagged(alloc_size, LPC_MEM_BULK);
 }
@@ -4,7 +4,8 @@
  * Project: FAT16 driver
  *
  * Description:
- *  This package uses heap functions in lpc_heap.c
+ *  This package uses heap functions in lpc_heap.c and takes file
+ *  descriptors from a fixed pool (lpc_pool.c)
  *  All filenames must be in uppercase letters and 8.3 format
  *
  * Software that is described herein is for illustrative purposes only
@@ -20,6 +21,7 @@
  **********************************************************************/
 #include "lpc_types.h"
 #include "lpc_heap.h"
+#include "lpc_pool.h"
 #include "lpc_fat16.h"
 #include "lpc_fat16_private.h"
 
@@ -68,6 +70,15 @@
 #define FSNAME_OFS    (LABEL_OFS + LABEL_SZ)
 #define FSNAME_SZ     8
 
+//**********************************************************************
+// Local data
+//**********************************************************************
+// File descriptor pool and its storage
+static LPC_POOL_T fat16_file_pool;
+static UNS_32 fat16_file_storage [LPC_POOL_STORAGE_SIZE(FAT16_MAX_FILES,
+                                  sizeof(FILE_TYPE), sizeof(UNS_32)) /
+                                  sizeof(UNS_32)];
+
 //**********************************************************************
 // Public functions
 //**********************************************************************
@@ -134,7 +145,7 @@ FAT_DEVICE_TYPE * fat16_init_device(
   if (init_func() == 1)
   {
     // Device initiailized, allocate the device data structure
-    fat_data = lpc_new(sizeof(FAT_DEVICE_TYPE));
+    fat_data = lpc_new_tagged(sizeof(FAT_DEVICE_TYPE));
 
     if (fat_data != NULL)
     {
@@ -154,9 +165,22 @@ FAT_DEVICE_TYPE * fat16_init_device(
       fat_data->func.read_func        = read_func;
       fat_data->func.write_func       = write_func;
 
+      // Multi-sector functions are optional, see
+      // fat16_set_multi_funcs
+      fat_data->func.read_multi_func  = NULL;
+      fat_data->func.write_multi_func = NULL;
+
       // Set active partition to (-1), disable commit
       fat_data->fat_commit = 0;
 
+      // The sector cache is disabled until fat16_cache_init is
+      // called with a buffer
+      fat_data->cache.ways = 0;
+      fat_data->cache.sets = 0;
+      fat_data->cache.hits = 0;
+      fat_data->cache.misses = 0;
+      fat_data->cache.writebacks = 0;
+
       // Read MBR and populate MBR structure
       fat16_read_mbr(fat_data);
     }
@@ -165,6 +189,46 @@ FAT_DEVICE_TYPE * fat16_init_device(
   return fat_data;
 }
 
+/***********************************************************************
+ *
+ * Function: fat16_set_multi_funcs
+ *
+ * Purpose:
+ *  Binds optional multi-sector transfer functions to the device.
+ *
+ * Processing:
+ *  Save the function pointers in the FAT device structure.
+ *
+ * Parameters:
+ *  fat_data         : Pointer to a FAT data structure
+ *  read_multi_func  : Pointer to multi-sector read function, or NULL
+ *  write_multi_func : Pointer to multi-sector write function, or NULL
+ *
+ * Outputs:
+ *  Data in fat_data will be updated.
+ *
+ * Returns:
+ *  Nothing
+ *
+ * Notes:
+ *  Each function is called with an absolute starting sector, a data
+ *  buffer, and a number of sectors. It performs the whole transfer
+ *  (including any busy waits) and returns the number of sectors it
+ *  transferred, which may be less than requested. A return value of 0
+ *  or less makes the driver transfer the rest of the sectors one at a
+ *  time with the single sector functions. They are used for cluster
+ *  data and for FAT and directory write back. Without them, all
+ *  transfers are done one sector at a time.
+ *
+ **********************************************************************/
+void fat16_set_multi_funcs(FAT_DEVICE_TYPE *fat_data,
+                           imsfunc read_multi_func,
+                           imsfunc write_multi_func)
+{
+  fat_data->func.read_multi_func  = read_multi_func;
+  fat_data->func.write_multi_func = write_multi_func;
+}
+
 /***********************************************************************
  *
  * Function: fat16_shutdown
@@ -173,9 +237,9 @@ FAT_DEVICE_TYPE * fat16_init_device(
  *  Shutdown the FAT16 interface for the selected device.
  *
  * Processing:
- *  If the commit flag is set, write the cached FAT cluster table back
- *  to the device. Free the allocated memory for the cluster table and
- *  device structure.
+ *  Write the changed FAT sectors back to the device. Flush the sector
+ *  cache. Free the allocated memory for the FAT windows and device
+ *  structure.
  *
  * Parameters:
  *  fat_data : Pointer to a FAT data structure
@@ -192,29 +256,23 @@ FAT_DEVICE_TYPE * fat16_init_device(
  **********************************************************************/
 void fat16_shutdown(FAT_DEVICE_TYPE *fat_data)
 {
-  // If the commit flag in the FAT device structure is set, then a
-  // write operation occurred to the device and the cached FAT cluster
-  // table needs to be written back to the device before shutdown
-  if (fat_data->fat_commit != 0)
+  // Write the changed FAT sectors back to the device - although only
+  // FAT1 is used, all FAT copies are written so they stay consistent
+  // in other machines
+  if (fat_data->act_part >= 0)
   {
-    // Write FAT back to the device - although only FAT1 is used,
-    // this routine will write all FAT copies back to the device
-    // so they stay consistent in other machines
-    fat16_write_sectors(fat_data, fat_data->clusters,
-                        fat_data->cfat.first_fat1_sector,
-                        fat_data->cfat.fat_sectors);
-
-    // Does more than 1 FAT need to be written?
-    if (fat_data->pat_hdr.fat_copies > 1)
+    fat16_fat_writeback(fat_data);
+
+    // Destroy the FAT windows and free cluster bitmap
+    lpc_free(fat_data->fat_win [0].entries);
+    if (fat_data->free_map != NULL)
     {
-      fat16_write_sectors(fat_data, fat_data->clusters,
-                          fat_data->cfat.first_fat2_sector,
-                          fat_data->cfat.fat_sectors);
+      lpc_free(fat_data->free_map);
     }
   }
 
-  // Destroy cached cluster allocation
-  lpc_free(fat_data->clusters);
+  // Write any sectors still held in the cache to the device
+  fat16_cache_flush(fat_data);
 
   // Destroy the FAT device structure
   lpc_free(fat_data);
@@ -278,8 +336,8 @@ void fat16_get_status(FAT_DEVICE_TYPE *fat_data, UNS_8 *status,
  *  for the partition will be determined and the appropriate sector
  *  containing the boot record will be read from the device. Once the
  *  boot record has been read in, the partition dimensions are
- *  computed. Appropriate space for the FAT cluster table is allocated
- *  and the cluster table is cached in memory.
+ *  computed. Memory for the FAT windows is allocated, the windows are
+ *  loaded from the FAT as clusters are used.
  *
  * Parameters:
  *  partnum  : Partition number of set (1 - 4) on this device
@@ -297,9 +355,10 @@ void fat16_get_status(FAT_DEVICE_TYPE *fat_data, UNS_8 *status,
  **********************************************************************/
 INT_32 fat16_set_partition(INT_32 partnum, FAT_DEVICE_TYPE *fat_data)
 {
-  UNS_32 table_size;
+  UNS_32 table_size, idx;
   UNS_8 data [PTAB_SIZE];
   FATGEOM_TYPE *fg;
+  UNS_16 *entries;
   INT_32 valid = 0;
 
   // Reset partnum to work with indices
@@ -311,6 +370,18 @@ INT_32 fat16_set_partition(INT_32 partnum, FAT_DEVICE_TYPE *fat_data)
        (fat_data->part [partnum].partype == FAT16_EXDOS) ||
        (fat_data->part [partnum].partype == FAT16_GT32M)))
   {
+    // Write back and release the FAT windows of a previous partition
+    if (fat_data->act_part >= 0)
+    {
+      fat16_fat_writeback(fat_data);
+      lpc_free(fat_data->fat_win [0].entries);
+      if (fat_data->free_map != NULL)
+      {
+        lpc_free(fat_data->free_map);
+      }
+      fat_data->act_part = -1;
+    }
+
     // Set the sector to the start of the partition
     fat_data->func.set_sector_func(
       fat_data->part [partnum].mbr_sec_offset);
@@ -426,15 +497,41 @@ INT_32 fat16_set_partition(INT_32 partnum, FAT_DEVICE_TYPE *fat_data)
       (UNS_16) fat_data->pat_hdr.sectors_cluster *
       (UNS_16) fat_data->pat_hdr.bytes_sector;
 
-    // Compute the required size of the file cluster table
-    table_size = (UNS_32)(fat_data->cfat.fat_sectors *
+    // Compute the cluster entries per FAT sector and FAT window
+    fat_data->fat_sec_shift = 0;
+    while ((UNS_32)(2 << fat_data->fat_sec_shift) <
+           fat_data->pat_hdr.bytes_sector)
+    {
+      fat_data->fat_sec_shift++;
+    }
+    fat_data->fat_win_shift = fat_data->fat_sec_shift;
+    while ((UNS_32)(1 << (fat_data->fat_win_shift -
+                          fat_data->fat_sec_shift)) <
+           FAT16_FAT_WIN_SECTORS)
+    {
+      fat_data->fat_win_shift++;
+    }
+
+    // Allocate the FAT windows, they are loaded on first use
+    table_size = (UNS_32)(FAT16_FAT_WIN_SECTORS *
                           (UNS_32) fat_data->pat_hdr.bytes_sector);
-    fat_data->clusters = (UNS_16 *) lpc_new(table_size);
+    entries = (UNS_16 *) lpc_new_placed_tagged(
+                            table_size * FAT16_FAT_WINDOWS, LPC_MEM_BULK);
+    for (idx = 0; idx < FAT16_FAT_WINDOWS; idx++)
+    {
+      fat_data->fat_win [idx].entries =
+        &entries [idx << fat_data->fat_win_shift];
+      fat_data->fat_win [idx].block = FAT16_FATWIN_NONE;
+      fat_data->fat_win [idx].stamp = 0;
+      fat_data->fat_win [idx].dirty = 0;
+    }
+    fat_data->fat_win_last = &fat_data->fat_win [0];
+    fat_data->fat_stamp = 0;
 
-    // Read cluster data into file cluster table
-    fat16_read_sectors(fat_data, fat_data->clusters,
-                       fat_data->cfat.first_fat1_sector,
-                       fat_data->cfat.fat_sectors);
+    // The free cluster bitmap is built on the first allocation
+    fat_data->free_map = (UNS_32 *) NULL;
+    fat_data->free_count = 0;
+    fat_data->free_hint = CLUSTERU_MIN;
 
     // Save new active partition number
     fat_data->act_part = (INT_8) partnum;
@@ -454,7 +551,8 @@ INT_32 fat16_set_partition(INT_32 partnum, FAT_DEVICE_TYPE *fat_data)
  *  Creates a file structure with the device and FAT data.
  *
  * Processing:
- *  Allocates memory for a new file descriptor. Sets the initial file
+ *  Gets a new file descriptor from the file descriptor pool (the pool
+ *  is setup on first use). Sets the initial file
  *  mode to FINVALID. Links the FAT device structure to the file
  *  descriptor. Sets up and caches the default directory used with the
  *  file descriptor as the root directory with an initial directory
@@ -469,7 +567,7 @@ INT_32 fat16_set_partition(INT_32 partnum, FAT_DEVICE_TYPE *fat_data)
  *
  * Returns:
  *  A pointer to a new file descriptor or NULL if there was not enough
- *  memory available.
+ *  memory available or FAT16_MAX_FILES descriptors already exist.
  *
  * Notes:
  *  None
@@ -480,12 +578,21 @@ FILE_TYPE * fat16_create_new_file_descriptor(FAT_DEVICE_TYPE *fat_data)
   FILE_TYPE *file_data;
   UNS_32 table_size;
 
+  // Setup the file descriptor pool on first use
+  if (fat16_file_pool.num_objs == 0)
+  {
+    lpc_pool_init(&fat16_file_pool, fat16_file_storage,
+                  sizeof(fat16_file_storage), sizeof(FILE_TYPE),
+                  sizeof(UNS_32));
+  }
+
   // Allocate a new file data structure
-  file_data = lpc_new(sizeof(FILE_TYPE));
+  file_data = (FILE_TYPE *) lpc_pool_alloc(&fat16_file_pool);
   if (file_data != (FILE_TYPE *) NULL)
   {
     // Mode is initially invalid
     file_data->fmode = FINVALID;
+    file_data->num_extents = 0;
 
     // Save binded FAT/device structure
     file_data->fat_data = fat_data;
@@ -494,20 +601,28 @@ FILE_TYPE * fat16_create_new_file_descriptor(FAT_DEVICE_TYPE *fat_data)
     file_data->sector_dir = fat_data->cfat.first_root_sector;
 
     // Create data buffer pointer and clear buffer index
-    file_data->data = (UNS_8 *) lpc_new((INT_32)
-                                        file_data->fat_data->cfat.cluster_size);
+    file_data->data = (UNS_8 *) lpc_new_placed_tagged((UNS_32)
+                                        file_data->fat_data->cfat.cluster_size,
+                                        LPC_MEM_BULK);
 
     // Compute required size of the directory listing and
     // allocate a new directory table
     table_size = fat_data->cfat.root_sectors *
                  (UNS_32) fat_data->pat_hdr.bytes_sector;
-    file_data->dir_data = (ROOT_ENTRY_TYPE *) lpc_new(
-                            table_size);
+    file_data->dir_data = (ROOT_ENTRY_TYPE *) lpc_new_placed_tagged(
+                            table_size, LPC_MEM_BULK);
 
     // Cache in the directory table
     fat16_read_sectors(fat_data, file_data->dir_data,
                        file_data->sector_dir, fat_data->cfat.root_sectors);
 
+    // Allocate the directory name hash, built on first lookup
+    file_data->dir_hash = (UNS_16 *) lpc_new_placed_tagged(
+                            (FAT16_DIR_HASH_SIZE +
+                             (UNS_32) fat_data->pat_hdr.root_entries) *
+                            sizeof(UNS_16), LPC_MEM_BULK);
+    file_data->dir_hashed = 0;
+
     // Clear initial directory index
     file_data->dir_index = 0;
 
@@ -564,9 +679,10 @@ void fat16_destroy_file_descriptor(FILE_TYPE *file_data)
     // Destroy the data and directory
     lpc_free(file_data->data);
     lpc_free(file_data->dir_data);
+    lpc_free(file_data->dir_hash);
 
-    // Destroy the file data structure
-    lpc_free(file_data);
+    // Return the file data structure to the pool
+    lpc_pool_free(&fat16_file_pool, file_data);
   }
 }
 
@@ -639,6 +755,7 @@ INT_32 fat16_cd(CHAR *path, FILE_TYPE *file_data)
     fat16_read_sectors(file_data->fat_data,
                        file_data->dir_data, file_data->sector_dir,
                        file_data->fat_data->cfat.root_sectors);
+    file_data->dir_hashed = 0;
 
     index = 1;
     valid = 1;
@@ -691,6 +808,7 @@ INT_32 fat16_cd(CHAR *path, FILE_TYPE *file_data)
         fat16_read_sectors(file_data->fat_data,
                            file_data->dir_data, file_data->sector_dir,
                            file_data->fat_data->cfat.root_sectors);
+        file_data->dir_hashed = 0;
 
         // Update index, skip past delimiters
         index = index + size;
@@ -722,6 +840,7 @@ INT_32 fat16_cd(CHAR *path, FILE_TYPE *file_data)
       fat16_read_sectors(file_data->fat_data,
                          file_data->dir_data, file_data->sector_dir,
                          file_data->fat_data->cfat.root_sectors);
+      file_data->dir_hashed = 0;
     }
 
     valid = 0;
@@ -940,7 +1059,8 @@ INT_32 fat16_delete(FILE_TYPE *file_data, CHAR *name)
                        file_data->fat_data, cluster_num);
 
       // Free this cluster
-      file_data->fat_data->clusters [cluster_num] = CLUSTER_AV;
+      fat16_set_next_cluster(file_data->fat_data, cluster_num,
+                             CLUSTER_AV);
 
       // Exit conditions
       if (next_cluster > CLUSTERR_MAX)
@@ -954,6 +1074,7 @@ INT_32 fat16_delete(FILE_TYPE *file_data, CHAR *name)
     }
 
     // Free up the directory entry
+    fat16_dir_hash_remove(file_data, dir_index);
     file_data->dir_data [dir_index].name [0] = DIR_ERASED;
 
     // Update FAT and directory update flags
@@ -991,6 +1112,7 @@ INT_32 fat16_delete(FILE_TYPE *file_data, CHAR *name)
  **********************************************************************/
 INT_32 fat16_open_file(CHAR *name, FILE_TYPE *file_data, INT_32 mode)
 {
+  UNS_32 run_len;
   INT_32 dir_index, index;
   INT_32 valid = 0;
 
@@ -1033,13 +1155,17 @@ INT_32 fat16_open_file(CHAR *name, FILE_TYPE *file_data, INT_32 mode)
         // Save filesize
         file_data->filesize =
           file_data->dir_data [dir_index].filesize;
+        file_data->length = file_data->filesize;
 
         // Perform an initial cluster read
-        fat16_read_sectors(file_data->fat_data,
-                           file_data->data,
-                           fat16_translate_cluster_to_sector(
-                             file_data->fat_data, file_data->clusternum),
-                           (UNS_32) file_data->fat_data->pat_hdr.sectors_cluster);
+        fat16_read_sectors_multi(file_data->fat_data,
+                                 file_data->data,
+                                 fat16_translate_cluster_to_sector(
+                                   file_data->fat_data, file_data->clusternum),
+                                 (UNS_32) file_data->fat_data->pat_hdr.sectors_cluster);
+
+        // Index the cluster runs of the file for seeks
+        fat16_build_extents(file_data);
 
         valid = 1;
       }
@@ -1053,9 +1179,11 @@ INT_32 fat16_open_file(CHAR *name, FILE_TYPE *file_data, INT_32 mode)
         fat16_delete(file_data, name);
       }
 
-      // Find a free cluster to point the file to
-      file_data->clusternum = fat16_find_free_cluster(
-                                file_data->fat_data, 0);
+      // Start the file at a run of free clusters, so it can grow
+      // without being fragmented
+      file_data->clusternum = fat16_find_free_run(
+                                file_data->fat_data, 0, FAT16_ALLOC_RUN,
+                                &run_len);
 
       // Only continue if there is enough room left
       if (file_data->clusternum != 0)
@@ -1072,6 +1200,8 @@ INT_32 fat16_open_file(CHAR *name, FILE_TYPE *file_data, INT_32 mode)
 
           // Clear initial filesize of written data
           file_data->filesize = 0;
+          file_data->buf_start = 0;
+          file_data->prealloc_last = 0;
 
           // Save some basic directory information
           file_data->dir_data [dir_index].attribute =
@@ -1100,11 +1230,13 @@ INT_32 fat16_open_file(CHAR *name, FILE_TYPE *file_data, INT_32 mode)
           // Convert name to correct space padded format
           fat16_name_break(name,
                            file_data->dir_data [dir_index].name);
+          fat16_dir_hash_add(file_data, dir_index);
 
           // Also tag the present cluster as 'used' by linking
           // to itself
-          file_data->fat_data->clusters [file_data->clusternum] =
-            file_data->clusternum;
+          fat16_set_next_cluster(file_data->fat_data,
+                                 file_data->clusternum,
+                                 file_data->clusternum);
         }
       }
     }
@@ -1143,7 +1275,9 @@ INT_32 fat16_open_file(CHAR *name, FILE_TYPE *file_data, INT_32 mode)
 INT_32 fat16_read(FILE_TYPE *file_data, INT_32 bytes_to_copy,
                   void *buffer_ptr, INT_32 *bytes_copied, INT_32 *eof)
 {
-  INT_32 index;
+  INT_32 index, size;
+  UNS_32 cluster_size, clusters;
+  UNS_16 first_cluster;
   UNS_8 *buffer = (UNS_8 *) buffer_ptr;
   INT_32 valid = 0;
 
@@ -1156,44 +1290,84 @@ INT_32 fat16_read(FILE_TYPE *file_data, INT_32 bytes_to_copy,
   {
     valid = 1;
     index = 0;
+    cluster_size = file_data->fat_data->cfat.cluster_size;
 
     // Copy out the specified number of bytes or until file end
     while ((bytes_to_copy > 0) && (file_data->filesize > 0))
     {
+      // Can whole clusters be read straight into the caller buffer?
+      if ((file_data->buf_index >= cluster_size) &&
+          ((UNS_32) bytes_to_copy >= cluster_size) &&
+          (file_data->filesize >= cluster_size))
+      {
+        // Find the run of following clusters that are contiguous
+        // on the device and fit in the buffer and the file
+        first_cluster = fat16_get_next_cluster(file_data->fat_data,
+                                               file_data->clusternum);
+        file_data->clusternum = first_cluster;
+        clusters = 1;
+        while ((((clusters + 1) * cluster_size) <=
+                (UNS_32) bytes_to_copy) &&
+               (((clusters + 1) * cluster_size) <=
+                file_data->filesize) &&
+               (fat16_get_next_cluster(file_data->fat_data,
+                                       file_data->clusternum) ==
+                (UNS_32)(file_data->clusternum + 1)))
+        {
+          file_data->clusternum++;
+          clusters++;
+        }
+
+        // Read the run, the cluster buffer stays empty
+        fat16_read_sectors_multi(file_data->fat_data, &buffer [index],
+                                 fat16_translate_cluster_to_sector(
+                                   file_data->fat_data, first_cluster),
+                                 clusters *
+                                 file_data->fat_data->pat_hdr.sectors_cluster);
+
+        // Update filesize and bytes copied
+        size = (INT_32)(clusters * cluster_size);
+        index += size;
+        file_data->filesize -= (UNS_32) size;
+        bytes_to_copy -= size;
+        *bytes_copied = *bytes_copied + size;
+      }
       // Does a new cluster need to be read in?
-      if (file_data->buf_index >=
-          (INT_32) file_data->fat_data->cfat.cluster_size)
+      else if (file_data->buf_index >= cluster_size)
       {
         // Entire cluster buffer has been emptied, buffer a
         // new cluster and reset index
         file_data->buf_index = 0;
         file_data->clusternum = fat16_get_next_cluster(
                                   file_data->fat_data, file_data->clusternum);
-        fat16_read_sectors(file_data->fat_data,
-                           file_data->data,
-                           fat16_translate_cluster_to_sector(
-                             file_data->fat_data, file_data->clusternum),
-                           (UNS_32) file_data->fat_data->pat_hdr.sectors_cluster);
+        fat16_read_sectors_multi(file_data->fat_data,
+                                 file_data->data,
+                                 fat16_translate_cluster_to_sector(
+                                   file_data->fat_data, file_data->clusternum),
+                                 (UNS_32) file_data->fat_data->pat_hdr.sectors_cluster);
       }
       else
       {
-        // Start reading data up to the filesize limit or the
-        // copy size, whichever comes first
-        while ((bytes_to_copy > 0) &&
-               (file_data->filesize > 0) &&
-               (file_data->buf_index <
-                file_data->fat_data->cfat.cluster_size))
+        // Copy data up to the filesize limit, the copy size, or
+        // the end of the cluster buffer, whichever comes first
+        size = (INT_32)(cluster_size - file_data->buf_index);
+        if (size > bytes_to_copy)
         {
-          buffer [index] =
-            file_data->data [file_data->buf_index];
-
-          // Update buffered index, filesize, and bytes copied
-          index++;
-          file_data->buf_index++;
-          file_data->filesize--;
-          bytes_to_copy--;
-          *bytes_copied = *bytes_copied + 1;
+          size = bytes_to_copy;
+        }
+        if ((UNS_32) size > file_data->filesize)
+        {
+          size = (INT_32) file_data->filesize;
         }
+        fat16_moveto(&file_data->data [file_data->buf_index],
+                     &buffer [index], size);
+
+        // Update buffered index, filesize, and bytes copied
+        index += size;
+        file_data->buf_index += (UNS_32) size;
+        file_data->filesize -= (UNS_32) size;
+        bytes_to_copy -= size;
+        *bytes_copied = *bytes_copied + size;
       }
     }
   }
@@ -1236,8 +1410,9 @@ INT_32 fat16_read(FILE_TYPE *file_data, INT_32 bytes_to_copy,
 INT_32 fat16_write(FILE_TYPE *file_data, void *buffer_ptr,
                    INT_32 bytes_to_copy)
 {
-  INT_32 index;
-  UNS_16 next_cluster, save_cluster;
+  INT_32 index, size;
+  UNS_32 cluster_size, sector_size, clusters, sectors;
+  UNS_16 next_cluster, save_cluster, first_cluster;
   UNS_8 *buffer = (UNS_8 *) buffer_ptr;
   INT_32 valid = 0;
 
@@ -1246,42 +1421,53 @@ INT_32 fat16_write(FILE_TYPE *file_data, void *buffer_ptr,
   {
     valid = 1;
     index = 0;
+    cluster_size = file_data->fat_data->cfat.cluster_size;
+    sector_size = (UNS_32) file_data->fat_data->pat_hdr.bytes_sector;
 
     // Continue copying until buffer is empty or an error occurs
     while ((bytes_to_copy > 0) && (valid == 1))
     {
       // Is the data ready to write?
-      if (file_data->buf_index >=
-          file_data->fat_data->cfat.cluster_size)
+      if (file_data->buf_index >= cluster_size)
       {
-        // Buffer is the size of a cluster, write data
-        fat16_write_sectors(file_data->fat_data,
-                            file_data->data,
-                            fat16_translate_cluster_to_sector(
-                              file_data->fat_data, file_data->clusternum),
-                            (UNS_32) file_data->fat_data->pat_hdr.sectors_cluster);
+        // Buffer is the size of a cluster, write the data that has
+        // not been written straight from the caller buffer
+        fat16_write_staged(file_data);
 
         // Clear buffer index
         file_data->buf_index = 0;
+        file_data->buf_start = 0;
 
-        // Get next free cluster number
-        next_cluster = fat16_find_free_cluster(
-                         file_data->fat_data, file_data->clusternum);
-
-        // Is cluster valid (indicating the device is not full)?
-        if (next_cluster > 0)
+        // Use the next preallocated cluster, it is already linked
+        if ((file_data->prealloc_last != 0) &&
+            (file_data->clusternum < file_data->prealloc_last))
         {
-          // Cluster is good, setup link to cluster
-          file_data->fat_data->clusters [file_data->clusternum]
-          = next_cluster;
-          file_data->clusternum = next_cluster;
-
-          // Temporarily tag present cluster as 'pointing to
-          // itself' so the clear logic can clear it if needed
-          file_data->fat_data->clusters [next_cluster] =
-            next_cluster;
+          file_data->clusternum++;
+          next_cluster = file_data->clusternum;
         }
         else
+        {
+          // Get next free cluster number
+          file_data->prealloc_last = 0;
+          next_cluster = fat16_find_free_cluster(
+                           file_data->fat_data, file_data->clusternum);
+
+          // Is cluster valid (indicating the device is not full)?
+          if (next_cluster > 0)
+          {
+            // Cluster is good, setup link to cluster
+            fat16_set_next_cluster(file_data->fat_data,
+                                   file_data->clusternum, next_cluster);
+            file_data->clusternum = next_cluster;
+
+            // Temporarily tag present cluster as 'pointing to
+            // itself' so the clear logic can clear it if needed
+            fat16_set_next_cluster(file_data->fat_data, next_cluster,
+                                   next_cluster);
+          }
+        }
+
+        if (next_cluster == 0)
         {
           // No more free clusters, error
           valid = 0;
@@ -1289,6 +1475,7 @@ INT_32 fat16_write(FILE_TYPE *file_data, void *buffer_ptr,
           // Since there is no more room, remove the file from
           // the device completely (by clearing the directory
           // entry and allocated FAT clusters)
+          fat16_dir_hash_remove(file_data, file_data->file_dir_entry);
           file_data->dir_data [file_data->file_dir_entry].name [0] =
             DIR_ERASED;
 
@@ -1299,7 +1486,8 @@ INT_32 fat16_write(FILE_TYPE *file_data, void *buffer_ptr,
           {
             save_cluster = fat16_get_next_cluster(
                              file_data->fat_data, next_cluster);
-            file_data->fat_data->clusters [next_cluster] = 0;
+            fat16_set_next_cluster(file_data->fat_data, next_cluster,
+                                   CLUSTER_AV);
             next_cluster = save_cluster;
           }
 
@@ -1307,17 +1495,204 @@ INT_32 fat16_write(FILE_TYPE *file_data, void *buffer_ptr,
           file_data->fmode = FINVALID;
         }
       }
+      // Streaming into preallocated clusters, write out the whole
+      // sectors staged in the buffer as soon as they are complete
+      else if ((file_data->prealloc_last != 0) &&
+               ((file_data->buf_index % sector_size) == 0) &&
+               (file_data->buf_start < file_data->buf_index))
+      {
+        fat16_write_sectors_multi(file_data->fat_data,
+                                  &file_data->data [file_data->buf_start],
+                                  fat16_translate_cluster_to_sector(
+                                    file_data->fat_data, file_data->clusternum) +
+                                  (file_data->buf_start / sector_size),
+                                  (file_data->buf_index -
+                                   file_data->buf_start) / sector_size);
+        file_data->buf_start = file_data->buf_index;
+      }
+      // Streaming into preallocated clusters, write whole sectors
+      // straight from the caller buffer to the following sectors
+      // of the reserved run, across cluster boundaries
+      else if ((file_data->prealloc_last != 0) &&
+               ((file_data->buf_index % sector_size) == 0) &&
+               ((UNS_32) bytes_to_copy >= sector_size))
+      {
+        sectors = (UNS_32) bytes_to_copy / sector_size;
+        clusters = (((UNS_32)(file_data->prealloc_last -
+                              file_data->clusternum) + 1) * cluster_size -
+                    file_data->buf_index) / sector_size;
+        if (sectors > clusters)
+        {
+          sectors = clusters;
+        }
+
+        fat16_write_sectors_multi(file_data->fat_data, &buffer [index],
+                                  fat16_translate_cluster_to_sector(
+                                    file_data->fat_data, file_data->clusternum) +
+                                  (file_data->buf_index / sector_size),
+                                  sectors);
+
+        // Move to the cluster holding the last written sector, a
+        // full last cluster is left with an empty buffer
+        size = (INT_32)(sectors * sector_size);
+        clusters = (file_data->buf_index + (UNS_32) size - 1) /
+                   cluster_size;
+        file_data->clusternum += (UNS_16) clusters;
+        file_data->buf_index += (UNS_32) size - (clusters * cluster_size);
+        file_data->buf_start = file_data->buf_index;
+        index += size;
+        file_data->filesize += (UNS_32) size;
+        bytes_to_copy -= size;
+      }
+      // Can whole clusters be written straight from the caller
+      // buffer? The last cluster of the write is always staged, so
+      // fat16_close_file writes it
+      else if ((file_data->buf_index == 0) &&
+               ((UNS_32) bytes_to_copy > cluster_size))
+      {
+        // Extend the run while the following clusters are free
+        first_cluster = file_data->clusternum;
+        clusters = 1;
+        while ((((clusters + 1) * cluster_size) <
+                (UNS_32) bytes_to_copy) &&
+               (fat16_find_free_cluster(file_data->fat_data,
+                                        file_data->clusternum) ==
+                (UNS_32)(file_data->clusternum + 1)))
+        {
+          next_cluster = file_data->clusternum + 1;
+          fat16_set_next_cluster(file_data->fat_data,
+                                 file_data->clusternum, next_cluster);
+          fat16_set_next_cluster(file_data->fat_data, next_cluster,
+                                 next_cluster);
+          file_data->clusternum = next_cluster;
+          clusters++;
+        }
+
+        fat16_write_sectors_multi(file_data->fat_data, &buffer [index],
+                                  fat16_translate_cluster_to_sector(
+                                    file_data->fat_data, first_cluster),
+                                  clusters *
+                                  file_data->fat_data->pat_hdr.sectors_cluster);
+
+        // The last cluster of the run is full and already written
+        size = (INT_32)(clusters * cluster_size);
+        index += size;
+        file_data->buf_index = cluster_size;
+        file_data->buf_start = cluster_size;
+        file_data->filesize += (UNS_32) size;
+        bytes_to_copy -= size;
+      }
       else
       {
-        // Keep moving data into the work buffer
-        file_data->data [file_data->buf_index] = buffer [index];
+        // Keep moving data into the work buffer, when streaming
+        // only up to the end of the present sector
+        size = (INT_32)(cluster_size - file_data->buf_index);
+        if (file_data->prealloc_last != 0)
+        {
+          size = (INT_32)(sector_size -
+                          (file_data->buf_index % sector_size));
+        }
+        if (size > bytes_to_copy)
+        {
+          size = bytes_to_copy;
+        }
+        fat16_moveto(&buffer [index],
+                     &file_data->data [file_data->buf_index], size);
 
         // update counters
-        index++;
-        file_data->buf_index++;
-        file_data->filesize++;
-        bytes_to_copy--;
+        index += size;
+        file_data->buf_index += (UNS_32) size;
+        file_data->filesize += (UNS_32) size;
+        bytes_to_copy -= size;
+      }
+    }
+  }
+
+  return valid;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_preallocate
+ *
+ * Purpose:
+ *  Reserves a contiguous run of clusters for a file being written.
+ *
+ * Processing:
+ *  Free the cluster allocated when the file was opened and find a run
+ *  of free clusters large enough for the passed size. If there is no
+ *  such run, tag the original cluster as used again and exit with an
+ *  error. Otherwise link the clusters of the run to each other (the
+ *  last one to itself, like the last cluster of a file being
+ *  written), start the file at the run, and write the FAT changes to
+ *  the device.
+ *
+ * Parameters:
+ *  file_data : Pointer to a file data structure
+ *  bytes     : Number of bytes to reserve
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  '1' if the clusters were reserved, '0' if the file is not open for
+ *  writing, data has already been written to it or reserved for it,
+ *  or there is no free run large enough.
+ *
+ * Notes:
+ *  Writes to the reserved clusters are streamed straight to their
+ *  sectors without FAT or directory updates. Writes past the reserved
+ *  clusters allocate clusters as normal. Reserved clusters that were
+ *  not used are freed when the file is closed.
+ *
+ **********************************************************************/
+INT_32 fat16_preallocate(FILE_TYPE *file_data, UNS_32 bytes)
+{
+  UNS_32 clusters, run_len, idx;
+  UNS_16 first_cluster;
+  INT_32 valid = 0;
+
+  if ((file_data->fmode == FWRITE) && (file_data->filesize == 0) &&
+      (file_data->buf_index == 0) && (file_data->prealloc_last == 0) &&
+      (bytes > 0))
+  {
+    clusters = (bytes + file_data->fat_data->cfat.cluster_size - 1) /
+               file_data->fat_data->cfat.cluster_size;
+
+    // The first cluster can be part of the run
+    fat16_set_next_cluster(file_data->fat_data, file_data->clusternum,
+                           CLUSTER_AV);
+    first_cluster = fat16_find_free_run(file_data->fat_data, 0,
+                                        clusters, &run_len);
+    if (run_len < clusters)
+    {
+      // Not enough room, keep the original first cluster
+      fat16_set_next_cluster(file_data->fat_data, file_data->clusternum,
+                             file_data->clusternum);
+    }
+    else
+    {
+      valid = 1;
+
+      // Link the run and tag the last cluster
+      for (idx = 0; idx < (clusters - 1); idx++)
+      {
+        fat16_set_next_cluster(file_data->fat_data,
+                               (UNS_16)(first_cluster + idx),
+                               (UNS_16)(first_cluster + idx + 1));
       }
+      file_data->prealloc_last = (UNS_16)(first_cluster + clusters - 1);
+      fat16_set_next_cluster(file_data->fat_data,
+                             file_data->prealloc_last,
+                             file_data->prealloc_last);
+
+      // Start the file at the run
+      file_data->clusternum = first_cluster;
+      file_data->dir_data [file_data->file_dir_entry].clusternum =
+        first_cluster;
+
+      // Write the chain to the device now, not during the writes
+      fat16_fat_writeback(file_data->fat_data);
     }
   }
 
@@ -1344,12 +1719,13 @@ INT_32 fat16_write(FILE_TYPE *file_data, void *buffer_ptr,
  *  Nothing
  *
  * Notes:
- *  None
+ *  Preallocated clusters past the last written cluster are freed.
  *
  **********************************************************************/
 void fat16_close_file(FILE_TYPE *file_data)
 {
   INT_32 i;
+  UNS_16 cluster;
 
   // If the last operation was a write operation, update the DIR
   // structure
@@ -1364,15 +1740,22 @@ void fat16_close_file(FILE_TYPE *file_data)
     }
 
     // Write cluster to device
-    fat16_write_sectors(file_data->fat_data,
-                        file_data->data,
-                        fat16_translate_cluster_to_sector(
-                          file_data->fat_data, file_data->clusternum),
-                        (UNS_32) file_data->fat_data->pat_hdr.sectors_cluster);
+    fat16_write_staged(file_data);
 
     // Set the present cluster to the last flasg in the list
-    file_data->fat_data->clusters [file_data->clusternum] =
-      CLUSTER_MAX;
+    fat16_set_next_cluster(file_data->fat_data, file_data->clusternum,
+                           CLUSTER_MAX);
+
+    // Free the preallocated clusters that were not used
+    if (file_data->prealloc_last != 0)
+    {
+      for (cluster = file_data->clusternum + 1;
+           cluster <= file_data->prealloc_last; cluster++)
+      {
+        fat16_set_next_cluster(file_data->fat_data, cluster, CLUSTER_AV);
+      }
+      file_data->prealloc_last = 0;
+    }
 
     // Update file size in directory structure
     file_data->dir_data [file_data->file_dir_entry].filesize =
@@ -1383,6 +1766,9 @@ void fat16_close_file(FILE_TYPE *file_data)
     file_data->fat_data->fat_commit = 1;
   }
 
+  // Write the file data held in the sector cache to the device
+  fat16_cache_flush(file_data->fat_data);
+
   file_data->fmode = FINVALID;
 }
 
@@ -1452,8 +1838,12 @@ INT_32 fat16_get_active_mbr(FAT_DEVICE_TYPE *fat_data,
   {
     fat16_set_no_mbr(fat_data);
 
-    // Read sector 1 again
-    fat16_read_sectors(fat_data, &data, 1, 1);
+    // Read sector 0 again (the sector size is not known until a
+    // partition is set, so read it as the MBR is read)
+    fat_data->func.set_sector_func(0);
+    fat_data->func.start_read_func();
+    fat16_wait_busy(fat_data);
+    fat_data->func.read_func(data, PTAB_SIZE);
 
     // Is extended signature valid?
     if (data [EXTENDED_SIG_IDX] == EXTENDED_SIG)
@@ -1497,32 +1887,21 @@ void fat16_save_all(FILE_TYPE *file_data, FAT_DEVICE_TYPE *fat_data)
   // changed
   if (file_data->dir_commit == 1)
   {
-    fat16_write_sectors(file_data->fat_data,
-                        file_data->dir_data, file_data->sector_dir,
-                        file_data->fat_data->cfat.root_sectors);
+    fat16_write_sectors_multi(file_data->fat_data,
+                              file_data->dir_data, file_data->sector_dir,
+                              file_data->fat_data->cfat.root_sectors);
   }
 
   // If the commit flag in the FAT device structure is set, then a
-  // write operation occurred to the device and the cached FAT cluster
-  // table needs to be written back to the device before shutdown
+  // write operation occurred to the device and the changed FAT
+  // sectors need to be written back to all FAT copies
   if (fat_data->fat_commit != 0)
   {
-    // Write FAT back to the device - although only FAT1 is used,
-    // this routine will write all FAT copies back to the device
-    // so they stay consistent in other machines
-    fat16_write_sectors(fat_data, fat_data->clusters,
-                        fat_data->cfat.first_fat1_sector,
-                        fat_data->cfat.fat_sectors);
-
-    // Does more than 1 FAT need to be written?
-    if (fat_data->pat_hdr.fat_copies > 1)
-    {
-      fat16_write_sectors(fat_data, fat_data->clusters,
-                          fat_data->cfat.first_fat2_sector,
-                          fat_data->cfat.fat_sectors);
-    }
+    fat16_fat_writeback(fat_data);
   }
 
+  // Write any sectors still held in the cache to the device
+  fat16_cache_flush(fat_data);
 }
 
 /***********************************************************************
@@ -1533,58 +1912,361 @@ void fat16_save_all(FILE_TYPE *file_data, FAT_DEVICE_TYPE *fat_data)
  *  Seek data pointer.
  *
  * Processing:
- *  See function.
+ *  Compute the new read position from the present position and check
+ *  it is in the file. Find the cluster holding the position from the
+ *  cluster run index. If the position is at a cluster boundary past
+ *  the first cluster, leave the cluster buffer empty at the previous
+ *  cluster so the next read fetches (or reads directly) the cluster
+ *  at the position. Otherwise load the cluster, unless it is already
+ *  buffered, and set the buffer index to the position.
  *
  * Parameters:
- *  file_data     : Pointer to a file data structure
- *  bytes_to_copy : Number of bytes to copy
- *  buffer_ptr    : Pointer to buffer to copy
- *  bytes_copied  : Pointer to where to return number of bytes copied
- *  eof           : Pointer to end of file flag, set on eof
+ *  file_data  : Pointer to a file data structure
+ *  seek_bytes : Number of bytes to move forward (negative to move back)
  *
  * Outputs:
  *  None
  *
  * Returns:
- *  '1' if the operation was successful, '0' otherwise.
+ *  '1' if the operation was successful, '0' if the file is not open
+ *  for reading or the new position is outside of the file.
  *
  * Notes:
- *  None
+ *  Only the cluster at the new position is read from the device.
  *
  **********************************************************************/
 INT_32 fat16_seek(FILE_TYPE *file_data, INT_32 seek_bytes)
 {
-  INT_32 valid = 1;
-  INT_32 remain_buf_data;
+  UNS_32 cluster_size, pos, file_cluster, offset;
+  UNS_16 cluster;
+  INT_32 valid = 0;
 
-  // Copy out the specified number of bytes or until file end
-  while (seek_bytes > 0)
+  // Only continue if the file is open for read operations
+  if (file_data->fmode == FREAD)
   {
-    remain_buf_data = file_data->fat_data->cfat.cluster_size - file_data->buf_index;
-    if (seek_bytes > remain_buf_data)
+    pos = file_data->length - file_data->filesize;
+    if (((seek_bytes < 0) && ((UNS_32) -seek_bytes <= pos)) ||
+        ((seek_bytes >= 0) &&
+         ((UNS_32) seek_bytes <= file_data->filesize)))
     {
-      file_data->buf_index = 0;
-      file_data->clusternum = fat16_get_next_cluster(
-                                file_data->fat_data, file_data->clusternum);
-      if (seek_bytes < (file_data->fat_data->cfat.cluster_size * 2))
+      valid = 1;
+      pos = (UNS_32)((INT_32) pos + seek_bytes);
+      cluster_size = file_data->fat_data->cfat.cluster_size;
+      file_cluster = pos / cluster_size;
+      offset = pos - (file_cluster * cluster_size);
+
+      if ((offset == 0) && (file_cluster > 0))
       {
-        fat16_read_sectors(file_data->fat_data,
-                           file_data->data,
-                           fat16_translate_cluster_to_sector(
-                             file_data->fat_data, file_data->clusternum),
-                           (UNS_32) file_data->fat_data->pat_hdr.sectors_cluster);
+        // Cluster boundary, the next read gets the next cluster
+        file_data->clusternum = fat16_file_cluster(file_data,
+                                                   file_cluster - 1);
+        file_data->buf_index = cluster_size;
+      }
+      else if (file_data->length > 0)
+      {
+        // Load the cluster, unless it is already buffered
+        cluster = fat16_file_cluster(file_data, file_cluster);
+        if ((cluster != file_data->clusternum) ||
+            (file_data->buf_index >= cluster_size))
+        {
+          file_data->clusternum = cluster;
+          fat16_read_sectors_multi(file_data->fat_data,
+                                   file_data->data,
+                                   fat16_translate_cluster_to_sector(
+                                     file_data->fat_data, cluster),
+                                   (UNS_32) file_data->fat_data->pat_hdr.sectors_cluster);
+        }
+        file_data->buf_index = offset;
       }
-      seek_bytes -= remain_buf_data;
-      file_data->filesize -= remain_buf_data;
+
+      file_data->filesize = file_data->length - pos;
     }
-    else
+  }
+
+  return valid;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_tell
+ *
+ * Purpose:
+ *  Returns the read or write position of a file.
+ *
+ * Processing:
+ *  For a file open for reading, return the file length less the
+ *  bytes left to read. For a file open for writing, return the number
+ *  of bytes written.
+ *
+ * Parameters:
+ *  file_data : Pointer to a file data structure
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  The byte position in the file, or 0 if the file is not open.
+ *
+ * Notes:
+ *  None
+ *
+ **********************************************************************/
+UNS_32 fat16_tell(FILE_TYPE *file_data)
+{
+  UNS_32 pos = 0;
+
+  if (file_data->fmode == FREAD)
+  {
+    pos = file_data->length - file_data->filesize;
+  }
+  else if (file_data->fmode == FWRITE)
+  {
+    pos = file_data->filesize;
+  }
+
+  return pos;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_read_at
+ *
+ * Purpose:
+ *  Read data from a file starting at a byte offset in the file.
+ *
+ * Processing:
+ *  Seek to the offset and read the data from there.
+ *
+ * Parameters:
+ *  file_data     : Pointer to a file data structure
+ *  offset        : Byte offset in the file to read from
+ *  bytes_to_copy : Number of bytes to copy
+ *  buffer_ptr    : Pointer to buffer to copy
+ *  bytes_copied  : Pointer to where to return number of bytes copied
+ *  eof           : Pointer to end of file flag, set on eof
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  '1' if the operation was successful, '0' if the file is not open
+ *  for reading or the offset is past the end of the file.
+ *
+ * Notes:
+ *  The read position is left after the data that was read.
+ *
+ **********************************************************************/
+INT_32 fat16_read_at(FILE_TYPE *file_data, UNS_32 offset,
+                     INT_32 bytes_to_copy, void *buffer_ptr,
+                     INT_32 *bytes_copied, INT_32 *eof)
+{
+  INT_32 valid = 0;
+
+  *bytes_copied = 0;
+  *eof = 0;
+
+  if ((file_data->fmode == FREAD) && (offset <= file_data->length))
+  {
+    valid = fat16_seek(file_data, (INT_32) offset -
+                       (INT_32) fat16_tell(file_data));
+    if (valid == 1)
     {
-      file_data->buf_index += seek_bytes;
-      file_data->filesize -= seek_bytes;
-      seek_bytes = 0;
+      valid = fat16_read(file_data, bytes_to_copy, buffer_ptr,
+                         bytes_copied, eof);
     }
   }
 
   return valid;
 }
 
+/***********************************************************************
+ *
+ * Function: fat16_get_free_clusters
+ *
+ * Purpose:
+ *  Returns the number of free clusters in the active partition.
+ *
+ * Processing:
+ *  Build the free cluster bitmap if needed and return the free
+ *  cluster count kept with it.
+ *
+ * Parameters:
+ *  fat_data : Pointer to a FAT data structure
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  The number of free clusters.
+ *
+ * Notes:
+ *  The first call (or first file write) walks the whole FAT, later
+ *  calls are immediate.
+ *
+ **********************************************************************/
+UNS_32 fat16_get_free_clusters(FAT_DEVICE_TYPE *fat_data)
+{
+  if (fat_data->free_map == NULL)
+  {
+    fat16_free_map_build(fat_data);
+  }
+
+  return fat_data->free_count;
+}
+
+//**********************************************************************
+// Sector cache functions
+//**********************************************************************
+
+/***********************************************************************
+ *
+ * Function: fat16_cache_init
+ *
+ * Purpose:
+ *  Sets up the sector cache in a caller supplied buffer.
+ *
+ * Processing:
+ *  Flush and disable any existing cache. Compute the number of cache
+ *  lines that fit in the buffer (each line needs a sector of data and
+ *  a tag), round the number of sets down to a power of 2, and place
+ *  the line data at the start of the buffer and the tags after it.
+ *  Mark all lines invalid and clear the counters.
+ *
+ * Parameters:
+ *  fat_data : Pointer to a FAT data structure
+ *  buffer   : Word aligned cache buffer, or NULL to disable the cache
+ *  size     : Size of the buffer in bytes
+ *  ways     : Number of lines per set (associativity)
+ *
+ * Outputs:
+ *  The cache structure in fat_data will be updated.
+ *
+ * Returns:
+ *  The number of cache lines, or 0 if the cache is disabled.
+ *
+ * Notes:
+ *  The buffer can be in any memory (IRAM for a small fast cache or
+ *  SDRAM for a large one) and must stay valid until the cache is
+ *  disabled or the device is shut down. The cache only handles 512
+ *  byte sectors, other sector sizes bypass it.
+ *
+ **********************************************************************/
+INT_32 fat16_cache_init(FAT_DEVICE_TYPE *fat_data, void *buffer,
+                        UNS_32 size, UNS_32 ways)
+{
+  FAT16_CACHE_TYPE *cache = &fat_data->cache;
+  UNS_32 lines, sets, idx;
+
+  // Write back and drop the present cache contents
+  fat16_cache_flush(fat_data);
+  cache->ways = 0;
+  cache->sets = 0;
+
+  if ((buffer == NULL) || (ways == 0))
+  {
+    return 0;
+  }
+
+  // Number of sets that fit, rounded down to a power of 2
+  lines = size / (FAT16_CACHE_LINE_SIZE +
+                  sizeof(FAT16_CACHE_LINE_TYPE));
+  if (lines < ways)
+  {
+    return 0;
+  }
+  sets = 1;
+  while ((sets * 2) <= (lines / ways))
+  {
+    sets = sets * 2;
+  }
+  lines = sets * ways;
+
+  // Line data first to keep it aligned, then the tags
+  cache->data = (UNS_8 *) buffer;
+  cache->lines = (FAT16_CACHE_LINE_TYPE *)
+                 &cache->data [lines * FAT16_CACHE_LINE_SIZE];
+  for (idx = 0; idx < lines; idx++)
+  {
+    cache->lines [idx].sector = 0;
+    cache->lines [idx].stamp = 0;
+    cache->lines [idx].flags = 0;
+  }
+
+  cache->stamp = 0;
+  cache->hits = 0;
+  cache->misses = 0;
+  cache->writebacks = 0;
+  cache->sets = sets;
+  cache->ways = ways;
+
+  return (INT_32) lines;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_cache_flush
+ *
+ * Purpose:
+ *  Writes all dirty cached sectors back to the device.
+ *
+ * Processing:
+ *  If the cache is enabled, write back all dirty lines.
+ *
+ * Parameters:
+ *  fat_data : Pointer to a FAT data structure
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Nothing
+ *
+ * Notes:
+ *  This is called from fat16_close_file, fat16_save_all and
+ *  fat16_shutdown. The cached FAT cluster table and directories are
+ *  not part of the sector cache and are written by those functions
+ *  first.
+ *
+ **********************************************************************/
+void fat16_cache_flush(FAT_DEVICE_TYPE *fat_data)
+{
+  if (fat_data->cache.ways != 0)
+  {
+    fat16_cache_writeback(fat_data);
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_cache_get_stats
+ *
+ * Purpose:
+ *  Returns the sector cache counters.
+ *
+ * Processing:
+ *  See function.
+ *
+ * Parameters:
+ *  fat_data   : Pointer to a FAT data structure
+ *  hits       : Pointer to where to return the hit count
+ *  misses     : Pointer to where to return the miss count
+ *  writebacks : Pointer to where to return the write back count
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Nothing
+ *
+ * Notes:
+ *  The counters are cleared by fat16_cache_init.
+ *
+ **********************************************************************/
+void fat16_cache_get_stats(FAT_DEVICE_TYPE *fat_data, UNS_32 *hits,
+                           UNS_32 *misses, UNS_32 *writebacks)
+{
+  *hits = fat_data->cache.hits;
+  *misses = fat_data->cache.misses;
+  *writebacks = fat_data->cache.writebacks;
+}
+
@@ -18,6 +18,7 @@
  * use without further testing or modification.
  **********************************************************************/
 #include "lpc_types.h"
+#include "lpc_heap.h"
 #include "lpc_fat16_private.h"
 
 
@@ -33,7 +34,10 @@
  *  Simple data movement routine.
  *
  * Processing:
- *  Move a number of bytes from the source to destination.
+ *  Move a number of bytes from the source to destination. If both
+ *  addresses have the same word alignment, move bytes up to a word
+ *  boundary, then 4 words at a time and single words. Move the
+ *  remaining bytes one at a time.
  *
  * Parameters:
  *  source : Source address
@@ -53,10 +57,47 @@
 void fat16_moveto(void *source, void *dest, INT_32 size)
 {
   UNS_8 *cdest, *csource;
+  UNS_32 *wdest, *wsource;
 
   cdest = (UNS_8 *) dest;
   csource = (UNS_8 *) source;
 
+  if ((((UNS_32) cdest ^ (UNS_32) csource) & 0x3) == 0)
+  {
+    while ((size > 0) && (((UNS_32) cdest & 0x3) != 0))
+    {
+      *cdest = *csource;
+      cdest++;
+      csource++;
+      size--;
+    }
+
+    wdest = (UNS_32 *) cdest;
+    wsource = (UNS_32 *) csource;
+
+    while (size >= 16)
+    {
+      wdest [0] = wsource [0];
+      wdest [1] = wsource [1];
+      wdest [2] = wsource [2];
+      wdest [3] = wsource [3];
+      wdest += 4;
+      wsource += 4;
+      size -= 16;
+    }
+
+    while (size >= 4)
+    {
+      *wdest = *wsource;
+      wdest++;
+      wsource++;
+      size -= 4;
+    }
+
+    cdest = (UNS_8 *) wdest;
+    csource = (UNS_8 *) wsource;
+  }
+
   while (size > 0)
   {
     *cdest = *csource;
@@ -258,19 +299,21 @@ void fat16_read_mbr(FAT_DEVICE_TYPE *fat_data)
 
 /***********************************************************************
  *
- * Function: fat16_read_sectors
+ * Function: fat16_dev_read_sectors
  *
  * Purpose:
- *  Reads a number of sectors from a device into a buffer.
+ *  Reads a number of sectors from the device into a buffer.
  *
  * Processing:
- *  See function.
+ *  For each sector, set the sector number in the device, issue a read
+ *  command, wait for the device, and read the sector data.
  *
  * Parameters:
  *  fat_data     : Pointer to a device data structure
  *  data         : Pointer to data buffer to fill
  *  first_sector : Starting absolute sector to read
  *  num_sectors  : Number of sectors to read
+ *  sector_size  : Size of a sector in bytes
  *
  * Outputs:
  *  None
@@ -279,11 +322,13 @@ void fat16_read_mbr(FAT_DEVICE_TYPE *fat_data)
  *  Nothing
  *
  * Notes:
- *  None
+ *  This bypasses the sector cache.
  *
  **********************************************************************/
-void fat16_read_sectors(FAT_DEVICE_TYPE *fat_data, void *data,
-                        UNS_32 first_sector, UNS_32 num_sectors)
+static void fat16_dev_read_sectors(FAT_DEVICE_TYPE *fat_data, void *data,
+                                   UNS_32 first_sector,
+                                   UNS_32 num_sectors,
+                                   INT_32 sector_size)
 {
   INT_32 index = 0;
   UNS_8 *data8 = (UNS_8 *) data;
@@ -301,7 +346,7 @@ void fat16_read_sectors(FAT_DEVICE_TYPE *fat_data, void *data,
 
     // Read the sector data and update buffer index
     index = index + fat_data->func.read_func(&data8 [index],
-                                             (INT_32) fat_data->pat_hdr.bytes_sector);
+                                             sector_size);
 
     // Update counters
     first_sector++;
@@ -311,19 +356,22 @@ void fat16_read_sectors(FAT_DEVICE_TYPE *fat_data, void *data,
 
 /***********************************************************************
  *
- * Function: fat16_write_sectors
+ * Function: fat16_dev_write_sectors
  *
  * Purpose:
- *  Writes a number of sectors from a buffer to a device.
+ *  Writes a number of sectors from a buffer to the device.
  *
  * Processing:
- *  See function.
+ *  For each sector, set the sector number in the device, issue a write
+ *  command, wait for the device, write the sector data, and wait for
+ *  the write to complete.
  *
  * Parameters:
  *  fat_data     : Pointer to a device data structure
  *  data         : Pointer to data buffer to copy from
  *  first_sector : Starting absolute sector to write
  *  num_sectors  : Number of sectors to write
+ *  sector_size  : Size of a sector in bytes
  *
  * Outputs:
  *  None
@@ -332,11 +380,13 @@ void fat16_read_sectors(FAT_DEVICE_TYPE *fat_data, void *data,
  *  Nothing
  *
  * Notes:
- *  None
+ *  This bypasses the sector cache.
  *
  **********************************************************************/
-void fat16_write_sectors(FAT_DEVICE_TYPE *fat_data, void *data,
-                         UNS_32 first_sector, UNS_32 num_sectors)
+static void fat16_dev_write_sectors(FAT_DEVICE_TYPE *fat_data,
+                                    void *data, UNS_32 first_sector,
+                                    UNS_32 num_sectors,
+                                    INT_32 sector_size)
 {
   INT_32 index = 0;
   UNS_8 *data8 = (UNS_8 *) data;
@@ -354,7 +404,7 @@ void fat16_write_sectors(FAT_DEVICE_TYPE *fat_data, void *data,
 
     // Put data in the write buffer
     index = index + fat_data->func.write_func(&data8 [index],
-                                              (INT_32) fat_data->pat_hdr.bytes_sector);
+                                              sector_size);
 
     // Wait for write to complete
     fat16_wait_busy(fat_data);
@@ -367,62 +417,110 @@ void fat16_write_sectors(FAT_DEVICE_TYPE *fat_data, void *data,
 
 /***********************************************************************
  *
- * Function: fat16_parse_path
+ * Function: fat16_cache_line
  *
  * Purpose:
- *  Finds the next directory name in a path.
+ *  Returns the cache line holding a sector, allocating one if needed.
  *
  * Processing:
- *  See function.
+ *  Select the set from the low bits of the sector number and search
+ *  its ways for the sector. On a hit, refresh the line LRU stamp and
+ *  return it. On a miss, use a free way or the least recently used
+ *  way of the set. A dirty victim is written back to the device
+ *  first. If load is set, the sector is read from the device into the
+ *  line.
  *
  * Parameters:
- *  path : a path name string
+ *  fat_data : Pointer to a device data structure
+ *  sector   : Absolute sector number
+ *  load     : Read the sector from the device on a miss if set
  *
  * Outputs:
- *  None
+ *  The cache line tags and counters will be updated.
  *
  * Returns:
- *  Size of data parsed if the operation was successful, otherwise -1.
+ *  The index of the cache line holding the sector.
  *
  * Notes:
- *  None
+ *  The LRU clock wraps after 2^32 accesses, which only makes one
+ *  replacement choice in each set less than ideal.
  *
  **********************************************************************/
-INT_32 fat16_parse_path(CHAR *path)
+static UNS_32 fat16_cache_line(FAT_DEVICE_TYPE *fat_data,
+                               UNS_32 sector, INT_32 load)
 {
-  INT_32 i;
+  FAT16_CACHE_TYPE *cache = &fat_data->cache;
+  FAT16_CACHE_LINE_TYPE *line;
+  UNS_32 first, way, victim;
 
-  // Find name up to next whitespace or '/' character
-  i = 0;
-  while ((i < 8) && (path [i] != '/') && (path [i] != '\0'))
+  // Sets are a power of 2, so no divide is needed
+  first = (sector & (cache->sets - 1)) * cache->ways;
+  victim = first;
+  cache->stamp++;
+
+  for (way = first; way < (first + cache->ways); way++)
   {
-    // So far, size is valid
-    i++;
+    line = &cache->lines [way];
+    if ((line->flags & FAT16_CACHE_VALID) == 0)
+    {
+      // Free way, use it if the sector is not found
+      victim = way;
+    }
+    else if (line->sector == sector)
+    {
+      // Sector is in the cache
+      line->stamp = cache->stamp;
+      cache->hits++;
+      return way;
+    }
+    else if (((cache->lines [victim].flags & FAT16_CACHE_VALID) != 0)
+             && (line->stamp < cache->lines [victim].stamp))
+    {
+      // Older than the present victim
+      victim = way;
+    }
   }
 
-  // Was the size valid
-  if (i >= 8)
+  cache->misses++;
+  line = &cache->lines [victim];
+
+  // Write back the evicted sector if it has changed
+  if ((line->flags & (FAT16_CACHE_VALID | FAT16_CACHE_DIRTY)) ==
+      (FAT16_CACHE_VALID | FAT16_CACHE_DIRTY))
   {
-    i = -1;
+    fat16_dev_write_sectors(fat_data,
+                            &cache->data [victim * FAT16_CACHE_LINE_SIZE],
+                            line->sector, 1, FAT16_CACHE_LINE_SIZE);
+    cache->writebacks++;
   }
 
-  return i;
+  if (load != 0)
+  {
+    fat16_dev_read_sectors(fat_data,
+                           &cache->data [victim * FAT16_CACHE_LINE_SIZE],
+                           sector, 1, FAT16_CACHE_LINE_SIZE);
+  }
+
+  line->sector = sector;
+  line->stamp = cache->stamp;
+  line->flags = FAT16_CACHE_VALID;
+
+  return victim;
 }
 
 /***********************************************************************
  *
- * Function: fat16_name_break
+ * Function: fat16_cache_writeback
  *
  * Purpose:
- *  Converts a filename in unpadded 8.3 format to a format that is
- *  compatible with a directory format.
+ *  Writes all dirty cache lines back to the device.
  *
  * Processing:
- *  See function.
+ *  Write each valid and dirty cache line to the device and clear its
+ *  dirty flag. The lines stay valid.
  *
  * Parameters:
- *  full_name : a name string in unpadded 8.3 format
- *  name      : a name string in padded 8.3 format
+ *  fat_data : Pointer to a device data structure
  *
  * Outputs:
  *  None
@@ -434,308 +532,1548 @@ INT_32 fat16_parse_path(CHAR *path)
  *  None
  *
  **********************************************************************/
-void fat16_name_break(CHAR *full_name, CHAR *name)
+void fat16_cache_writeback(FAT_DEVICE_TYPE *fat_data)
 {
-  INT_32 i, index;
+  FAT16_CACHE_TYPE *cache = &fat_data->cache;
+  UNS_32 idx;
 
-  // Copy the name (up to the dot) into vname, pad up to 8 chars
-  // with spaces
-  index = 0;
-  for (i = 0; i < 8; i++)
+  for (idx = 0; idx < (cache->sets * cache->ways); idx++)
   {
-    if ((full_name [index] == '\0') || (full_name [index] == '.'))
-    {
-      // Pad rest of the name with spaces
-      name [i] = ' ';
-    }
-    else
+    if ((cache->lines [idx].flags & FAT16_CACHE_DIRTY) != 0)
     {
-      // Use original name
-      name [i] = full_name [index];
-      index++;
+      fat16_dev_write_sectors(fat_data,
+                              &cache->data [idx * FAT16_CACHE_LINE_SIZE],
+                              cache->lines [idx].sector, 1,
+                              FAT16_CACHE_LINE_SIZE);
+      cache->lines [idx].flags &= ~FAT16_CACHE_DIRTY;
+      cache->writebacks++;
     }
   }
+}
 
-  // Skip to extension if '.' was found
-  if (full_name [index] == '.')
+/***********************************************************************
+ *
+ * Function: fat16_read_sectors
+ *
+ * Purpose:
+ *  Reads a number of sectors from a device into a buffer.
+ *
+ * Processing:
+ *  If the sector cache is not enabled or the sector size does not
+ *  match the cache line size, read the sectors from the device.
+ *  Otherwise, get the cache line for each sector (loading it from the
+ *  device on a miss) and copy the line into the buffer.
+ *
+ * Parameters:
+ *  fat_data     : Pointer to a device data structure
+ *  data         : Pointer to data buffer to fill
+ *  first_sector : Starting absolute sector to read
+ *  num_sectors  : Number of sectors to read
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Nothing
+ *
+ * Notes:
+ *  None
+ *
+ **********************************************************************/
+void fat16_read_sectors(FAT_DEVICE_TYPE *fat_data, void *data,
+                        UNS_32 first_sector, UNS_32 num_sectors)
+{
+  UNS_8 *data8 = (UNS_8 *) data;
+  UNS_32 idx;
+
+  if ((fat_data->cache.ways == 0) ||
+      (fat_data->pat_hdr.bytes_sector != FAT16_CACHE_LINE_SIZE))
   {
-    index++;
+    fat16_dev_read_sectors(fat_data, data, first_sector, num_sectors,
+                           (INT_32) fat_data->pat_hdr.bytes_sector);
   }
-
-  // Extension
-  for (i = 0; i < 3; i++)
+  else
   {
-    if (full_name [index] != '\0')
-    {
-      name [8 + i] = full_name [index];
-      index++;
-    }
-    else
+    while (num_sectors > 0)
     {
-      name [8 + i] = ' ';
+      idx = fat16_cache_line(fat_data, first_sector, 1);
+      fat16_moveto(&fat_data->cache.data [idx * FAT16_CACHE_LINE_SIZE],
+                   data8, FAT16_CACHE_LINE_SIZE);
+
+      // Update counters
+      data8 += FAT16_CACHE_LINE_SIZE;
+      first_sector++;
+      num_sectors--;
     }
   }
-
-  // Terminate name and extension strings
-  name [12] = '\0';
 }
 
 /***********************************************************************
  *
- * Function: fat16_name_check
+ * Function: fat16_write_sectors
  *
  * Purpose:
- *  Compares a passed name in padded 8.3 format with a name in a
- *  directory entry structure.
+ *  Writes a number of sectors from a buffer to a device.
  *
  * Processing:
- *  Compare the first 11 characters of the passed name with the 11
- *  characters in the passed directory structure.
+ *  If the sector cache is not enabled or the sector size does not
+ *  match the cache line size, write the sectors to the device.
+ *  Otherwise, get the cache line for each sector (without loading it,
+ *  as the whole sector is replaced), copy the data into the line and
+ *  mark it dirty. Dirty lines are written to the device when they are
+ *  evicted or flushed.
  *
  * Parameters:
- *  name     : Padded 8.3 name
- *  dir_data : Pointer to a directory structure
+ *  fat_data     : Pointer to a device data structure
+ *  data         : Pointer to data buffer to copy from
+ *  first_sector : Starting absolute sector to write
+ *  num_sectors  : Number of sectors to write
  *
  * Outputs:
  *  None
  *
  * Returns:
- *  '1' if the name matches the directory entry name
+ *  Nothing
  *
  * Notes:
  *  None
  *
  **********************************************************************/
-INT_32 fat16_name_check(CHAR *name, ROOT_ENTRY_TYPE *dir_data)
+void fat16_write_sectors(FAT_DEVICE_TYPE *fat_data, void *data,
+                         UNS_32 first_sector, UNS_32 num_sectors)
 {
-  return fat16_compare(name, dir_data->name, 11);
+  UNS_8 *data8 = (UNS_8 *) data;
+  UNS_32 idx;
+
+  if ((fat_data->cache.ways == 0) ||
+      (fat_data->pat_hdr.bytes_sector != FAT16_CACHE_LINE_SIZE))
+  {
+    fat16_dev_write_sectors(fat_data, data, first_sector, num_sectors,
+                            (INT_32) fat_data->pat_hdr.bytes_sector);
+  }
+  else
+  {
+    while (num_sectors > 0)
+    {
+      idx = fat16_cache_line(fat_data, first_sector, 0);
+      fat16_moveto(data8,
+                   &fat_data->cache.data [idx * FAT16_CACHE_LINE_SIZE],
+                   FAT16_CACHE_LINE_SIZE);
+      fat_data->cache.lines [idx].flags |= FAT16_CACHE_DIRTY;
+
+      // Update counters
+      data8 += FAT16_CACHE_LINE_SIZE;
+      first_sector++;
+      num_sectors--;
+    }
+  }
 }
 
 /***********************************************************************
  *
- * Function: fat16_find_file
+ * Function: fat16_cache_sync
  *
  * Purpose:
- *  Finds and returns the directory structure of the passed name in the
- *  active directory.
+ *  Makes the sector cache coherent with a direct device transfer.
  *
  * Processing:
- *  See function.
+ *  For each valid cache line holding a sector in the transfer range,
+ *  either drop the line (the device copy is about to be replaced) or
+ *  write it back if it is dirty (the device copy is about to be
+ *  read).
  *
  * Parameters:
- *  name      : Unpadded 8.3 name to search for in the directory
- *  file_data : Pointer to a file data structure
+ *  fat_data     : Pointer to a device data structure
+ *  first_sector : Starting absolute sector of the transfer
+ *  num_sectors  : Number of sectors in the transfer
+ *  drop         : Drop the lines if set, write back dirty lines if 0
  *
  * Outputs:
- *  If the file was found, the structure pointed to by newdir will be
- *  populated with the file/directory information.
+ *  The cache line tags will be updated.
  *
  * Returns:
- *  Index to matching directory structure in active dir, or (-1) if a
- *  match was not found.
+ *  Nothing
  *
  * Notes:
  *  None
  *
  **********************************************************************/
-INT_32 fat16_find_file(CHAR *name, FILE_TYPE *file_data)
+static void fat16_cache_sync(FAT_DEVICE_TYPE *fat_data,
+                             UNS_32 first_sector, UNS_32 num_sectors,
+                             INT_32 drop)
 {
-  INT_32 dir_index, found;
-  CHAR vname [16];
-
-  found = -1;
-
-  // Break name into a format that can be easily compared
-  fat16_name_break(name, vname);
+  FAT16_CACHE_TYPE *cache = &fat_data->cache;
+  UNS_32 idx;
 
-  // Process directory entries
-  dir_index = 0;
-  while (dir_index <
-         (INT_32) file_data->fat_data->pat_hdr.root_entries)
+  for (idx = 0; idx < (cache->sets * cache->ways); idx++)
   {
-    // Is this entry valid (not an erased entry and not an LFN
-    // entry)
-    if ((file_data->dir_data [dir_index].name [0] != (char) DIR_FREE) &&
-        (file_data->dir_data [dir_index].name [0] != (char) DIR_ERASED) &&
-        (file_data->dir_data [dir_index].attribute != ATTB_LFN))
+    if (((cache->lines [idx].flags & FAT16_CACHE_VALID) != 0) &&
+        (cache->lines [idx].sector >= first_sector) &&
+        (cache->lines [idx].sector < (first_sector + num_sectors)))
     {
-      // Check for matching name
-      if (fat16_name_check(vname,
-                           &file_data->dir_data [dir_index]) == 1)
+      if (drop != 0)
       {
-        // Name matches a directory entry, use it
-        found = dir_index;
-
-        // Force exit from loop
-        dir_index =
-          (INT_32) file_data->fat_data->pat_hdr.root_entries;
+        cache->lines [idx].flags = 0;
+      }
+      else if ((cache->lines [idx].flags & FAT16_CACHE_DIRTY) != 0)
+      {
+        fat16_dev_write_sectors(fat_data,
+                                &cache->data [idx * FAT16_CACHE_LINE_SIZE],
+                                cache->lines [idx].sector, 1,
+                                FAT16_CACHE_LINE_SIZE);
+        cache->lines [idx].flags &= ~FAT16_CACHE_DIRTY;
+        cache->writebacks++;
       }
     }
-
-    dir_index++;
   }
-
-  return found;
 }
 
 /***********************************************************************
  *
- * Function: fat16_find_free_cluster
+ * Function: fat16_read_sectors_multi
  *
  * Purpose:
- *  Find the next free cluster in the cluster list. Searches down from
- *  the passed cluster.
+ *  Reads a number of sectors using the device multi-sector read
+ *  function if there is one.
  *
  * Processing:
- *  See function.
+ *  If the device has no multi-sector read function, use
+ *  fat16_read_sectors. Otherwise, write back any dirty cached sectors
+ *  in the range and read the sectors directly from the device with as
+ *  few multi-sector reads as the device allows. If the device stops
+ *  transferring, read the remaining sectors one at a time.
  *
  * Parameters:
- *  fat_data      : Pointer to a FAT device structure
- *  cluster_start : Starting cluster in list where to search
+ *  fat_data     : Pointer to a device data structure
+ *  data         : Pointer to data buffer to fill
+ *  first_sector : Starting absolute sector to read
+ *  num_sectors  : Number of sectors to read
  *
  * Outputs:
  *  None
  *
  * Returns:
- *  Next free cluster, or '0' if a free cluster was not found
+ *  Nothing
  *
  * Notes:
- *  None
+ *  Use this for cluster sized and larger transfers. These bypass the
+ *  sector cache so they do not evict directory and FAT sectors.
  *
  **********************************************************************/
-UNS_16 fat16_find_free_cluster(FAT_DEVICE_TYPE *fat_data,
-                               UNS_16 cluster_start)
+void fat16_read_sectors_multi(FAT_DEVICE_TYPE *fat_data, void *data,
+                              UNS_32 first_sector, UNS_32 num_sectors)
 {
-  UNS_16 found_cluster;
-  INT_32 exit = 0;
+  UNS_8 *data8 = (UNS_8 *) data;
+  INT_32 done;
 
-  // Start searching from top-down on cluster list
-  found_cluster = cluster_start;
-  while ((found_cluster < fat_data->cfat.clusters) &&
-         (exit == 0))
+  if (fat_data->func.read_multi_func == NULL)
   {
-    if (fat_data->clusters [(INT_32) found_cluster] ==
-        0)
-    {
-      // Cluster is free, so use it
-      exit = 1;
-    }
-    else
-    {
-      // Cluster not free, check next cluster
-      found_cluster++;
-    }
+    fat16_read_sectors(fat_data, data, first_sector, num_sectors);
   }
-
-  // Only continue if a free cluster was not found
-  if ((exit == 0) && (cluster_start >= CLUSTERU_MIN))
+  else
   {
-    // Try finding a cluster at the top of the list
-    found_cluster = CLUSTERU_MIN;
-    while ((found_cluster < cluster_start)
-           && (exit == 0))
+    fat16_cache_sync(fat_data, first_sector, num_sectors, 0);
+
+    while (num_sectors > 0)
     {
-      if (fat_data->clusters [(INT_32) found_cluster]
-          == 0)
-      {
-        // Cluster is free, so use it
-        exit = 1;
-      }
-      else
+      done = fat_data->func.read_multi_func(first_sector, data8,
+                                            num_sectors);
+      if ((done <= 0) || ((UNS_32) done > num_sectors))
       {
-        // Cluster not free, check next cluster
-        found_cluster++;
+        // Device could not transfer, use the single sector path
+        fat16_dev_read_sectors(fat_data, data8, first_sector,
+                               num_sectors,
+                               (INT_32) fat_data->pat_hdr.bytes_sector);
+        done = (INT_32) num_sectors;
       }
-    }
-  }
 
-  // Was a free cluster ever found?
-  if (exit == 0)
-  {
-    // No free clusters, return 0
-    found_cluster = 0;
+      // Update counters
+      data8 += (UNS_32) done * fat_data->pat_hdr.bytes_sector;
+      first_sector += (UNS_32) done;
+      num_sectors -= (UNS_32) done;
+    }
   }
-
-  return found_cluster;
 }
 
 /***********************************************************************
  *
- * Function: fat16_get_free_dir_entry
+ * Function: fat16_write_sectors_multi
  *
  * Purpose:
- *  Allocates a new directory entry for the passed name.
+ *  Writes a number of sectors using the device multi-sector write
+ *  function if there is one.
  *
  * Processing:
- *  See function.
+ *  If the device has no multi-sector write function, use
+ *  fat16_write_sectors. Otherwise, drop any cached copies of the
+ *  sectors in the range and write the sectors directly to the device
+ *  with as few multi-sector writes as the device allows. If the
+ *  device stops transferring, write the remaining sectors one at a
+ *  time.
  *
  * Parameters:
- *  file_data : Pointer to a file data structure
+ *  fat_data     : Pointer to a device data structure
+ *  data         : Pointer to data buffer to copy from
+ *  first_sector : Starting absolute sector to write
+ *  num_sectors  : Number of sectors to write
  *
  * Outputs:
  *  None
  *
  * Returns:
- *  The index of the added dir entry, or (-1) if unsuccessful.
+ *  Nothing
  *
  * Notes:
- *  None
+ *  Use this for cluster sized and larger transfers. These bypass the
+ *  sector cache so they do not evict directory and FAT sectors.
  *
  **********************************************************************/
-INT_32 fat16_get_free_dir_entry(FILE_TYPE *file_data)
+void fat16_write_sectors_multi(FAT_DEVICE_TYPE *fat_data, void *data,
+                               UNS_32 first_sector,
+                               UNS_32 num_sectors)
 {
-  INT_32 index = 0;
-  INT_32 valid = -1;
+  UNS_8 *data8 = (UNS_8 *) data;
+  INT_32 done;
 
-  // Loop through the entrie directory looking for the first free
-  // directory entry
-  while (index < (INT_32) file_data->fat_data->pat_hdr.root_entries)
+  if (fat_data->func.write_multi_func == NULL)
   {
-    if ((file_data->dir_data [index].name [0] == (char) DIR_FREE) ||
-        (file_data->dir_data [index].name [0] == (char) DIR_ERASED))
+    fat16_write_sectors(fat_data, data, first_sector, num_sectors);
+  }
+  else
+  {
+    fat16_cache_sync(fat_data, first_sector, num_sectors, 1);
+
+    while (num_sectors > 0)
     {
-      // Free entry, set return value to entry index
-      valid = index;
+      done = fat_data->func.write_multi_func(first_sector, data8,
+                                             num_sectors);
+      if ((done <= 0) || ((UNS_32) done > num_sectors))
+      {
+        // Device could not transfer, use the single sector path
+        fat16_dev_write_sectors(fat_data, data8, first_sector,
+                                num_sectors,
+                                (INT_32) fat_data->pat_hdr.bytes_sector);
+        done = (INT_32) num_sectors;
+      }
 
-      // Force exit condition
-      index = (INT_32) file_data->fat_data->pat_hdr.root_entries;
+      // Update counters
+      data8 += (UNS_32) done * fat_data->pat_hdr.bytes_sector;
+      first_sector += (UNS_32) done;
+      num_sectors -= (UNS_32) done;
     }
-
-    // Next index
-    index++;
   }
-
-  return valid;
 }
 
 /***********************************************************************
  *
- * Function: fat16_get_next_cluster
+ * Function: fat16_write_staged
  *
  * Purpose:
- *  Returns the next cluster in a cluster link chain.
+ *  Writes the unwritten part of the cluster buffer of a file being
+ *  written to its cluster.
  *
  * Processing:
- *  See function.
+ *  Write the sectors of the cluster buffer from the sector holding
+ *  the first unwritten byte to the end of the cluster. Sectors before
+ *  it were written straight from the caller buffer and are skipped.
  *
  * Parameters:
- *  fat_data    : Pointer to a FAT device structure
- *  cluster_num : Cluster number to use for next cluster search
+ *  file_data : Pointer to a file data structure
  *
  * Outputs:
  *  None
  *
  * Returns:
- *  The next cluster in the list.
+ *  Nothing
  *
  * Notes:
  *  None
  *
  **********************************************************************/
-UNS_32 fat16_get_next_cluster(FAT_DEVICE_TYPE *fat_data,
-                              UNS_16 cluster_num)
+void fat16_write_staged(FILE_TYPE *file_data)
 {
-  return fat_data->clusters [(INT_32) cluster_num];
+  UNS_32 sector;
+
+  sector = file_data->buf_start /
+           (UNS_32) file_data->fat_data->pat_hdr.bytes_sector;
+  if (sector < (UNS_32) file_data->fat_data->pat_hdr.sectors_cluster)
+  {
+    fat16_write_sectors_multi(file_data->fat_data,
+                              &file_data->data [sector *
+                                file_data->fat_data->pat_hdr.bytes_sector],
+                              fat16_translate_cluster_to_sector(
+                                file_data->fat_data, file_data->clusternum) +
+                              sector,
+                              (UNS_32) file_data->fat_data->pat_hdr.sectors_cluster -
+                              sector);
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_parse_path
+ *
+ * Purpose:
+ *  Finds the next directory name in a path.
+ *
+ * Processing:
+ *  See function.
+ *
+ * Parameters:
+ *  path : a path name string
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Size of data parsed if the operation was successful, otherwise -1.
+ *
+ * Notes:
+ *  None
+ *
+ **********************************************************************/
+INT_32 fat16_parse_path(CHAR *path)
+{
+  INT_32 i;
+
+  // Find name up to next whitespace or '/' character
+  i = 0;
+  while ((i < 8) && (path [i] != '/') && (path [i] != '\0'))
+  {
+    // So far, size is valid
+    i++;
+  }
+
+  // Was the size valid
+  if (i >= 8)
+  {
+    i = -1;
+  }
+
+  return i;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_name_break
+ *
+ * Purpose:
+ *  Converts a filename in unpadded 8.3 format to a format that is
+ *  compatible with a directory format.
+ *
+ * Processing:
+ *  See function.
+ *
+ * Parameters:
+ *  full_name : a name string in unpadded 8.3 format
+ *  name      : a name string in padded 8.3 format
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Nothing
+ *
+ * Notes:
+ *  None
+ *
+ **********************************************************************/
+void fat16_name_break(CHAR *full_name, CHAR *name)
+{
+  INT_32 i, index;
+
+  // Copy the name (up to the dot) into vname, pad up to 8 chars
+  // with spaces
+  index = 0;
+  for (i = 0; i < 8; i++)
+  {
+    if ((full_name [index] == '\0') || (full_name [index] == '.'))
+    {
+      // Pad rest of the name with spaces
+      name [i] = ' ';
+    }
+    else
+    {
+      // Use original name
+      name [i] = full_name [index];
+      index++;
+    }
+  }
+
+  // Skip to extension if '.' was found
+  if (full_name [index] == '.')
+  {
+    index++;
+  }
+
+  // Extension
+  for (i = 0; i < 3; i++)
+  {
+    if (full_name [index] != '\0')
+    {
+      name [8 + i] = full_name [index];
+      index++;
+    }
+    else
+    {
+      name [8 + i] = ' ';
+    }
+  }
+
+  // Terminate name and extension strings
+  name [12] = '\0';
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_name_check
+ *
+ * Purpose:
+ *  Compares a passed name in padded 8.3 format with a name in a
+ *  directory entry structure.
+ *
+ * Processing:
+ *  Compare the first 11 characters of the passed name with the 11
+ *  characters in the passed directory structure.
+ *
+ * Parameters:
+ *  name     : Padded 8.3 name
+ *  dir_data : Pointer to a directory structure
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  '1' if the name matches the directory entry name
+ *
+ * Notes:
+ *  None
+ *
+ **********************************************************************/
+INT_32 fat16_name_check(CHAR *name, ROOT_ENTRY_TYPE *dir_data)
+{
+  return fat16_compare(name, dir_data->name, 11);
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_dir_hash_name
+ *
+ * Purpose:
+ *  Returns the hash bucket of a padded 8.3 name.
+ *
+ * Processing:
+ *  Hash the 11 name and extension characters and limit the hash to
+ *  the number of buckets.
+ *
+ * Parameters:
+ *  name : Padded 8.3 name
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  The hash bucket index.
+ *
+ * Notes:
+ *  None
+ *
+ **********************************************************************/
+static UNS_32 fat16_dir_hash_name(CHAR *name)
+{
+  UNS_32 hash = 0;
+  INT_32 idx;
+
+  for (idx = 0; idx < 11; idx++)
+  {
+    hash = (hash * 31) + (UNS_8) name [idx];
+  }
+
+  return (hash ^ (hash >> 7)) & (FAT16_DIR_HASH_SIZE - 1);
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_dir_hash_build
+ *
+ * Purpose:
+ *  Builds the name hash of the active directory.
+ *
+ * Processing:
+ *  Clear the hash buckets. Add every used directory entry (not free,
+ *  erased, or an LFN entry) to the chain of its name bucket, from the
+ *  last entry to the first so each chain is in entry order. Save the
+ *  lowest free or erased entry as the free entry hint.
+ *
+ * Parameters:
+ *  file_data : Pointer to a file data structure
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Nothing
+ *
+ * Notes:
+ *  The hash is built on the first lookup after a directory is cached
+ *  in.
+ *
+ **********************************************************************/
+static void fat16_dir_hash_build(FILE_TYPE *file_data)
+{
+  UNS_16 *chain;
+  UNS_32 bucket;
+  INT_32 dir_index;
+
+  chain = &file_data->dir_hash [FAT16_DIR_HASH_SIZE];
+  for (bucket = 0; bucket < FAT16_DIR_HASH_SIZE; bucket++)
+  {
+    file_data->dir_hash [bucket] = FAT16_DIR_HASH_END;
+  }
+
+  dir_index = (INT_32) file_data->fat_data->pat_hdr.root_entries;
+  file_data->dir_free = dir_index;
+  while (dir_index > 0)
+  {
+    dir_index--;
+    if ((file_data->dir_data [dir_index].name [0] == (char) DIR_FREE) ||
+        (file_data->dir_data [dir_index].name [0] == (char) DIR_ERASED))
+    {
+      file_data->dir_free = dir_index;
+    }
+    else if (file_data->dir_data [dir_index].attribute != ATTB_LFN)
+    {
+      bucket = fat16_dir_hash_name(file_data->dir_data [dir_index].name);
+      chain [dir_index] = file_data->dir_hash [bucket];
+      file_data->dir_hash [bucket] = (UNS_16) dir_index;
+    }
+  }
+
+  file_data->dir_hashed = 1;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_dir_hash_add
+ *
+ * Purpose:
+ *  Adds a directory entry to the directory name hash.
+ *
+ * Processing:
+ *  If the hash has been built, link the entry into the chain of its
+ *  name bucket, keeping the chain in entry order.
+ *
+ * Parameters:
+ *  file_data : Pointer to a file data structure
+ *  dir_index : Index of the directory entry, with its name set
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Nothing
+ *
+ * Notes:
+ *  None
+ *
+ **********************************************************************/
+void fat16_dir_hash_add(FILE_TYPE *file_data, INT_32 dir_index)
+{
+  UNS_16 *link;
+
+  if (file_data->dir_hashed == 1)
+  {
+    link = &file_data->dir_hash [fat16_dir_hash_name(
+                                   file_data->dir_data [dir_index].name)];
+    while ((*link != FAT16_DIR_HASH_END) && (*link < dir_index))
+    {
+      link = &file_data->dir_hash [FAT16_DIR_HASH_SIZE + *link];
+    }
+
+    file_data->dir_hash [FAT16_DIR_HASH_SIZE + dir_index] = *link;
+    *link = (UNS_16) dir_index;
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_dir_hash_remove
+ *
+ * Purpose:
+ *  Removes a directory entry from the directory name hash.
+ *
+ * Processing:
+ *  If the hash has been built, unlink the entry from the chain of its
+ *  name bucket and lower the free entry hint to the entry.
+ *
+ * Parameters:
+ *  file_data : Pointer to a file data structure
+ *  dir_index : Index of the directory entry, before its name is erased
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Nothing
+ *
+ * Notes:
+ *  None
+ *
+ **********************************************************************/
+void fat16_dir_hash_remove(FILE_TYPE *file_data, INT_32 dir_index)
+{
+  UNS_16 *link;
+
+  if (file_data->dir_hashed == 1)
+  {
+    link = &file_data->dir_hash [fat16_dir_hash_name(
+                                   file_data->dir_data [dir_index].name)];
+    while ((*link != FAT16_DIR_HASH_END) && (*link != dir_index))
+    {
+      link = &file_data->dir_hash [FAT16_DIR_HASH_SIZE + *link];
+    }
+
+    if (*link != FAT16_DIR_HASH_END)
+    {
+      *link = file_data->dir_hash [FAT16_DIR_HASH_SIZE + dir_index];
+    }
+
+    if (dir_index < file_data->dir_free)
+    {
+      file_data->dir_free = dir_index;
+    }
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_find_file
+ *
+ * Purpose:
+ *  Finds and returns the directory structure of the passed name in the
+ *  active directory.
+ *
+ * Processing:
+ *  Build the directory name hash if needed. Compare the name with the
+ *  directory entries in the chain of its hash bucket.
+ *
+ * Parameters:
+ *  name      : Unpadded 8.3 name to search for in the directory
+ *  file_data : Pointer to a file data structure
+ *
+ * Outputs:
+ *  If the file was found, the structure pointed to by newdir will be
+ *  populated with the file/directory information.
+ *
+ * Returns:
+ *  Index to matching directory structure in active dir, or (-1) if a
+ *  match was not found.
+ *
+ * Notes:
+ *  None
+ *
+ **********************************************************************/
+INT_32 fat16_find_file(CHAR *name, FILE_TYPE *file_data)
+{
+  INT_32 dir_index, found;
+  CHAR vname [16];
+
+  found = -1;
+
+  // Break name into a format that can be easily compared
+  fat16_name_break(name, vname);
+
+  if (file_data->dir_hashed == 0)
+  {
+    fat16_dir_hash_build(file_data);
+  }
+
+  // Process the directory entries with the same name hash
+  dir_index = file_data->dir_hash [fat16_dir_hash_name(vname)];
+  while (dir_index != FAT16_DIR_HASH_END)
+  {
+    // Check for matching name
+    if (fat16_name_check(vname,
+                         &file_data->dir_data [dir_index]) == 1)
+    {
+      // Name matches a directory entry, use it
+      found = dir_index;
+
+      // Force exit from loop
+      dir_index = FAT16_DIR_HASH_END;
+    }
+    else
+    {
+      dir_index = file_data->dir_hash [FAT16_DIR_HASH_SIZE + dir_index];
+    }
+  }
+
+  return found;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_free_map_build
+ *
+ * Purpose:
+ *  Builds the free cluster bitmap from the FAT.
+ *
+ * Processing:
+ *  Allocate a bitmap with one bit for each cluster number. Mark the
+ *  two reserved cluster numbers and the bits past the last cluster as
+ *  used. Walk the FAT and mark each cluster that is not free as used,
+ *  counting the free clusters. Set the free hint to the first
+ *  cluster.
+ *
+ * Parameters:
+ *  fat_data : Pointer to a FAT device structure
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Nothing
+ *
+ * Notes:
+ *  The bitmap is built on the first cluster allocation (or free
+ *  cluster query), so mounting and read only use do not walk the
+ *  FAT.
+ *
+ **********************************************************************/
+void fat16_free_map_build(FAT_DEVICE_TYPE *fat_data)
+{
+  UNS_32 words, idx, last;
+
+  last = fat_data->cfat.clusters + CLUSTERU_MIN;
+  words = (last + 31) >> 5;
+  fat_data->free_map = (UNS_32 *) lpc_new_placed_tagged(words * 4,
+                                                        LPC_MEM_BULK);
+
+  for (idx = 0; idx < words; idx++)
+  {
+    fat_data->free_map [idx] = 0;
+  }
+
+  // Cluster numbers 0 and 1 and those past the end are never free
+  fat_data->free_map [0] = 0x3;
+  for (idx = last; idx < (words * 32); idx++)
+  {
+    fat_data->free_map [idx >> 5] |= FAT16_FREE_BIT(idx);
+  }
+
+  fat_data->free_count = 0;
+  for (idx = CLUSTERU_MIN; idx < last; idx++)
+  {
+    if (fat16_get_next_cluster(fat_data, (UNS_16) idx) == CLUSTER_AV)
+    {
+      fat_data->free_count++;
+    }
+    else
+    {
+      fat_data->free_map [idx >> 5] |= FAT16_FREE_BIT(idx);
+    }
+  }
+
+  fat_data->free_hint = CLUSTERU_MIN;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_free_map_search
+ *
+ * Purpose:
+ *  Finds the first free cluster in a range of the free cluster bitmap.
+ *
+ * Processing:
+ *  Skip bitmap words with all clusters used, then find the lowest
+ *  free cluster in the first word with a free cluster.
+ *
+ * Parameters:
+ *  fat_data : Pointer to a FAT device structure
+ *  first    : First cluster of the range
+ *  last     : Cluster after the end of the range
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  The first free cluster in the range, or '0' if there is none.
+ *
+ * Notes:
+ *  None
+ *
+ **********************************************************************/
+static UNS_32 fat16_free_map_search(FAT_DEVICE_TYPE *fat_data,
+                                    UNS_32 first, UNS_32 last)
+{
+  UNS_32 word, bit;
+
+  while (first < last)
+  {
+    // Ignore the clusters below first in its word
+    word = fat_data->free_map [first >> 5] |
+           (FAT16_FREE_BIT(first) - 1);
+    if (word == 0xFFFFFFFF)
+    {
+      first = (first | 31) + 1;
+    }
+    else
+    {
+      bit = 0;
+      while ((word & ((UNS_32) 1 << bit)) != 0)
+      {
+        bit++;
+      }
+
+      first = (first & ~31) + bit;
+      if (first < last)
+      {
+        return first;
+      }
+    }
+  }
+
+  return 0;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_find_free_cluster
+ *
+ * Purpose:
+ *  Find the next free cluster in the cluster list. Searches down from
+ *  the passed cluster.
+ *
+ * Processing:
+ *  Build the free cluster bitmap if needed. Search the bitmap from the
+ *  passed cluster (or the free hint, if it is higher) to the end of
+ *  the partition, then from the free hint up to the passed cluster.
+ *  If the search started at the free hint, move the hint up to the
+ *  found cluster.
+ *
+ * Parameters:
+ *  fat_data      : Pointer to a FAT device structure
+ *  cluster_start : Starting cluster in list where to search
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Next free cluster, or '0' if a free cluster was not found
+ *
+ * Notes:
+ *  Passing the last cluster of a file makes the following cluster the
+ *  first choice, which keeps the file contiguous.
+ *
+ **********************************************************************/
+UNS_16 fat16_find_free_cluster(FAT_DEVICE_TYPE *fat_data,
+                               UNS_16 cluster_start)
+{
+  UNS_32 found, first, last;
+
+  if (fat_data->free_map == NULL)
+  {
+    fat16_free_map_build(fat_data);
+  }
+
+  last = fat_data->cfat.clusters + CLUSTERU_MIN;
+  first = cluster_start;
+  if (first <= fat_data->free_hint)
+  {
+    first = fat_data->free_hint;
+  }
+
+  // Search down to the end of the list, then wrap to the hint
+  found = fat16_free_map_search(fat_data, first, last);
+  if ((found == 0) && (first > fat_data->free_hint))
+  {
+    found = fat16_free_map_search(fat_data, fat_data->free_hint, first);
+    first = fat_data->free_hint;
+  }
+
+  if ((found != 0) && (first == fat_data->free_hint))
+  {
+    // Nothing is free between the hint and the found cluster
+    fat_data->free_hint = found;
+  }
+
+  return (UNS_16) found;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_find_free_run
+ *
+ * Purpose:
+ *  Finds the first run of free clusters of at least the passed size,
+ *  or the longest free run if there is none that long.
+ *
+ * Processing:
+ *  Build the free cluster bitmap if needed. Starting at the passed
+ *  cluster and wrapping around at the end of the partition, find each
+ *  free cluster and count the free clusters that follow it. Stop at
+ *  the first run that is long enough, otherwise keep the longest run.
+ *
+ * Parameters:
+ *  fat_data      : Pointer to a FAT device structure
+ *  cluster_start : Starting cluster in list where to search
+ *  clusters      : Wanted number of clusters in the run
+ *  run_len       : Pointer to where to return the run length
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  First cluster of the run, or '0' if there are no free clusters.
+ *
+ * Notes:
+ *  Runs do not wrap around the end of the partition. The clusters are
+ *  not allocated by this function.
+ *
+ **********************************************************************/
+UNS_16 fat16_find_free_run(FAT_DEVICE_TYPE *fat_data,
+                           UNS_16 cluster_start, UNS_32 clusters,
+                           UNS_32 *run_len)
+{
+  UNS_32 found, len, pos, last, end;
+  UNS_32 best = 0, best_len = 0;
+  INT_32 pass;
+
+  if (fat_data->free_map == NULL)
+  {
+    fat16_free_map_build(fat_data);
+  }
+
+  last = fat_data->cfat.clusters + CLUSTERU_MIN;
+  pos = cluster_start;
+  if (pos < fat_data->free_hint)
+  {
+    pos = fat_data->free_hint;
+  }
+  end = last;
+
+  for (pass = 0; (pass < 2) && (best_len < clusters); pass++)
+  {
+    found = fat16_free_map_search(fat_data, pos, end);
+    while ((found != 0) && (best_len < clusters))
+    {
+      // Count the free clusters in this run
+      len = 1;
+      while (((found + len) < last) && (len < clusters) &&
+             ((fat_data->free_map [(found + len) >> 5] &
+               FAT16_FREE_BIT(found + len)) == 0))
+      {
+        len++;
+      }
+
+      if (len > best_len)
+      {
+        best = found;
+        best_len = len;
+      }
+
+      found = fat16_free_map_search(fat_data, found + len, end);
+    }
+
+    // Wrap around to the part of the list before the start
+    end = pos;
+    pos = fat_data->free_hint;
+  }
+
+  *run_len = best_len;
+
+  return (UNS_16) best;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_fat_win_writeback
+ *
+ * Purpose:
+ *  Writes the changed sectors of a FAT window back to the device.
+ *
+ * Processing:
+ *  Find each run of changed sectors in the window and write it to
+ *  every FAT copy on the device. Clear the changed flags.
+ *
+ * Parameters:
+ *  fat_data : Pointer to a FAT device structure
+ *  win      : Pointer to the FAT window
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Nothing
+ *
+ * Notes:
+ *  None
+ *
+ **********************************************************************/
+static void fat16_fat_win_writeback(FAT_DEVICE_TYPE *fat_data,
+                                    FAT16_FATWIN_TYPE *win)
+{
+  UNS_32 first, sec, run, copy, fat_sector;
+  UNS_32 sec_entries = 1 << fat_data->fat_sec_shift;
+
+  first = win->block * FAT16_FAT_WIN_SECTORS;
+  sec = 0;
+  while (win->dirty != 0)
+  {
+    if ((win->dirty & ((UNS_32) 1 << sec)) == 0)
+    {
+      sec++;
+    }
+    else
+    {
+      // Find the end of this run of changed sectors
+      run = 0;
+      while (((sec + run) < FAT16_FAT_WIN_SECTORS) &&
+             ((win->dirty & ((UNS_32) 1 << (sec + run))) != 0))
+      {
+        win->dirty &= ~((UNS_32) 1 << (sec + run));
+        run++;
+      }
+
+      // Write the run to each FAT copy
+      fat_sector = fat_data->cfat.first_fat1_sector + first + sec;
+      for (copy = 0; copy < fat_data->pat_hdr.fat_copies; copy++)
+      {
+        fat16_write_sectors_multi(fat_data,
+                                  &win->entries [sec * sec_entries],
+                                  fat_sector, run);
+        fat_sector += fat_data->cfat.fat_sectors;
+      }
+
+      sec += run;
+    }
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_fat_window
+ *
+ * Purpose:
+ *  Returns the FAT window for a block of the FAT, loading it if
+ *  needed.
+ *
+ * Processing:
+ *  If the most recently used window holds the block, use it.
+ *  Otherwise search the windows for the block. If it is not cached,
+ *  write back the least recently used window if it has changes and
+ *  load the block from the first FAT into it.
+ *
+ * Parameters:
+ *  fat_data : Pointer to a FAT device structure
+ *  block    : Window number in the FAT
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Pointer to the FAT window holding the block.
+ *
+ * Notes:
+ *  The last window of the FAT may be shorter than the others.
+ *
+ **********************************************************************/
+static FAT16_FATWIN_TYPE *fat16_fat_window(FAT_DEVICE_TYPE *fat_data,
+                                           UNS_32 block)
+{
+  FAT16_FATWIN_TYPE *win, *victim;
+  UNS_32 first, count;
+  INT_32 idx;
+
+  fat_data->fat_stamp++;
+  win = fat_data->fat_win_last;
+  if (win->block != block)
+  {
+    // Search the windows, keeping track of the oldest one
+    victim = &fat_data->fat_win [0];
+    win = (FAT16_FATWIN_TYPE *) NULL;
+    for (idx = 0; idx < FAT16_FAT_WINDOWS; idx++)
+    {
+      if (fat_data->fat_win [idx].block == block)
+      {
+        win = &fat_data->fat_win [idx];
+      }
+      else if (fat_data->fat_win [idx].stamp < victim->stamp)
+      {
+        victim = &fat_data->fat_win [idx];
+      }
+    }
+
+    if (win == NULL)
+    {
+      // Not cached, reuse the oldest window
+      win = victim;
+      fat16_fat_win_writeback(fat_data, win);
+
+      first = block * FAT16_FAT_WIN_SECTORS;
+      count = fat_data->cfat.fat_sectors - first;
+      if (count > FAT16_FAT_WIN_SECTORS)
+      {
+        count = FAT16_FAT_WIN_SECTORS;
+      }
+      fat16_read_sectors_multi(fat_data, win->entries,
+                               fat_data->cfat.first_fat1_sector + first,
+                               count);
+      win->block = block;
+    }
+
+    fat_data->fat_win_last = win;
+  }
+
+  win->stamp = fat_data->fat_stamp;
+
+  return win;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_get_free_dir_entry
+ *
+ * Purpose:
+ *  Allocates a new directory entry for the passed name.
+ *
+ * Processing:
+ *  Build the directory name hash if needed. Search for the first free
+ *  or erased entry from the free entry hint and move the hint past
+ *  it, as the entry will be used.
+ *
+ * Parameters:
+ *  file_data : Pointer to a file data structure
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  The index of the added dir entry, or (-1) if unsuccessful.
+ *
+ * Notes:
+ *  The caller sets the entry name and adds it to the name hash with
+ *  fat16_dir_hash_add.
+ *
+ **********************************************************************/
+INT_32 fat16_get_free_dir_entry(FILE_TYPE *file_data)
+{
+  INT_32 index;
+  INT_32 valid = -1;
+
+  if (file_data->dir_hashed == 0)
+  {
+    fat16_dir_hash_build(file_data);
+  }
+
+  // Loop through the directory from the hint looking for the first
+  // free directory entry
+  index = file_data->dir_free;
+  while (index < (INT_32) file_data->fat_data->pat_hdr.root_entries)
+  {
+    if ((file_data->dir_data [index].name [0] == (char) DIR_FREE) ||
+        (file_data->dir_data [index].name [0] == (char) DIR_ERASED))
+    {
+      // Free entry, set return value to entry index
+      valid = index;
+
+      // Force exit condition
+      index = (INT_32) file_data->fat_data->pat_hdr.root_entries;
+    }
+
+    // Next index
+    index++;
+  }
+
+  // Entries before the hint are all used
+  if (valid >= 0)
+  {
+    file_data->dir_free = valid + 1;
+  }
+  else
+  {
+    file_data->dir_free = (INT_32) file_data->fat_data->pat_hdr.root_entries;
+  }
+
+  return valid;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_get_next_cluster
+ *
+ * Purpose:
+ *  Returns the next cluster in a cluster link chain.
+ *
+ * Processing:
+ *  See function.
+ *
+ * Parameters:
+ *  fat_data    : Pointer to a FAT device structure
+ *  cluster_num : Cluster number to use for next cluster search
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  The next cluster in the list.
+ *
+ * Notes:
+ *  None
+ *
+ **********************************************************************/
+UNS_32 fat16_get_next_cluster(FAT_DEVICE_TYPE *fat_data,
+                              UNS_16 cluster_num)
+{
+  FAT16_FATWIN_TYPE *win;
+
+  win = fat16_fat_window(fat_data,
+                         (UNS_32) cluster_num >> fat_data->fat_win_shift);
+
+  return win->entries [cluster_num &
+                       ((1 << fat_data->fat_win_shift) - 1)];
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_set_next_cluster
+ *
+ * Purpose:
+ *  Sets the next cluster of a cluster in the cluster link chain.
+ *
+ * Processing:
+ *  Get the FAT window holding the cluster entry, update the entry and
+ *  mark the FAT sector holding it as changed. Set the FAT commit flag.
+ *  If the free cluster bitmap has been built, update it, the free
+ *  count, and the free hint.
+ *
+ * Parameters:
+ *  fat_data     : Pointer to a FAT device structure
+ *  cluster_num  : Cluster number to update
+ *  next_cluster : New next cluster (or cluster flag) value
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Nothing
+ *
+ * Notes:
+ *  The change reaches the device when the window is evicted or when
+ *  fat16_fat_writeback is called.
+ *
+ **********************************************************************/
+void fat16_set_next_cluster(FAT_DEVICE_TYPE *fat_data,
+                            UNS_16 cluster_num, UNS_16 next_cluster)
+{
+  FAT16_FATWIN_TYPE *win;
+  UNS_32 idx;
+
+  win = fat16_fat_window(fat_data,
+                         (UNS_32) cluster_num >> fat_data->fat_win_shift);
+  idx = cluster_num & ((1 << fat_data->fat_win_shift) - 1);
+
+  win->entries [idx] = next_cluster;
+  win->dirty |= (UNS_32) 1 << (idx >> fat_data->fat_sec_shift);
+  fat_data->fat_commit = 1;
+
+  // Keep the free cluster bitmap, count, and hint up to date
+  if (fat_data->free_map != NULL)
+  {
+    idx = FAT16_FREE_BIT(cluster_num);
+    if (next_cluster == CLUSTER_AV)
+    {
+      if ((fat_data->free_map [cluster_num >> 5] & idx) != 0)
+      {
+        fat_data->free_map [cluster_num >> 5] &= ~idx;
+        fat_data->free_count++;
+        if (cluster_num < fat_data->free_hint)
+        {
+          fat_data->free_hint = cluster_num;
+        }
+      }
+    }
+    else if ((fat_data->free_map [cluster_num >> 5] & idx) == 0)
+    {
+      fat_data->free_map [cluster_num >> 5] |= idx;
+      fat_data->free_count--;
+    }
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_fat_writeback
+ *
+ * Purpose:
+ *  Writes the changed FAT sectors back to all FAT copies.
+ *
+ * Processing:
+ *  Write back the changed sectors of each FAT window and clear the
+ *  FAT commit flag. The windows stay cached.
+ *
+ * Parameters:
+ *  fat_data : Pointer to a FAT device structure
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Nothing
+ *
+ * Notes:
+ *  None
+ *
+ **********************************************************************/
+void fat16_fat_writeback(FAT_DEVICE_TYPE *fat_data)
+{
+  INT_32 idx;
+
+  for (idx = 0; idx < FAT16_FAT_WINDOWS; idx++)
+  {
+    fat16_fat_win_writeback(fat_data, &fat_data->fat_win [idx]);
+  }
+
+  fat_data->fat_commit = 0;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_build_extents
+ *
+ * Purpose:
+ *  Builds the cluster run index of a file opened for reading.
+ *
+ * Processing:
+ *  Walk the cluster chain of the file from its first cluster. Each
+ *  run of clusters that follow each other on the device is saved as
+ *  one extent with the file cluster index it starts at. Stop at the
+ *  end of the file or when all extents are used, and save the number
+ *  of file clusters covered by the extents.
+ *
+ * Parameters:
+ *  file_data : Pointer to a file data structure
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  Nothing
+ *
+ * Notes:
+ *  The file length and first cluster (clusternum) must be set before
+ *  this is called.
+ *
+ **********************************************************************/
+void fat16_build_extents(FILE_TYPE *file_data)
+{
+  FAT16_EXTENT_TYPE *ext;
+  UNS_32 clusters, idx, next;
+  UNS_16 cluster;
+
+  clusters = (file_data->length +
+              file_data->fat_data->cfat.cluster_size - 1) /
+             file_data->fat_data->cfat.cluster_size;
+  cluster = file_data->clusternum;
+  file_data->num_extents = 0;
+  idx = 0;
+
+  while ((idx < clusters) && (file_data->num_extents < FAT16_MAX_EXTENTS))
+  {
+    // Start a new run at this cluster
+    ext = &file_data->extents [file_data->num_extents];
+    ext->file_cluster = idx;
+    ext->cluster = cluster;
+    ext->count = 1;
+    idx++;
+
+    // Add the following clusters while they are contiguous
+    next = fat16_get_next_cluster(file_data->fat_data, cluster);
+    while ((idx < clusters) && (next == (UNS_32)(cluster + 1)) &&
+           (ext->count < 0xFFFF))
+    {
+      cluster++;
+      ext->count++;
+      idx++;
+      next = fat16_get_next_cluster(file_data->fat_data, cluster);
+    }
+
+    file_data->num_extents++;
+    cluster = (UNS_16) next;
+  }
+
+  file_data->ext_clusters = idx;
+}
+
+/***********************************************************************
+ *
+ * Function: fat16_file_cluster
+ *
+ * Purpose:
+ *  Returns the cluster number of a cluster index in a file.
+ *
+ * Processing:
+ *  Binary search the extents for the last run starting at or before
+ *  the file cluster. If the cluster is in that run, compute it from
+ *  the run start. Otherwise the cluster is past the indexed runs, so
+ *  walk the cluster chain from the last cluster of the last run.
+ *
+ * Parameters:
+ *  file_data    : Pointer to a file data structure
+ *  file_cluster : Index of the cluster in the file (0 = first)
+ *
+ * Outputs:
+ *  None
+ *
+ * Returns:
+ *  The cluster number.
+ *
+ * Notes:
+ *  The file must have at least one cluster and the extents must have
+ *  been built with fat16_build_extents.
+ *
+ **********************************************************************/
+UNS_16 fat16_file_cluster(FILE_TYPE *file_data, UNS_32 file_cluster)
+{
+  FAT16_EXTENT_TYPE *ext;
+  INT_32 low, high, mid;
+  UNS_32 idx;
+  UNS_16 cluster;
+
+  low = 0;
+  high = file_data->num_extents - 1;
+  while (low < high)
+  {
+    mid = (low + high + 1) >> 1;
+    if (file_data->extents [mid].file_cluster <= file_cluster)
+    {
+      low = mid;
+    }
+    else
+    {
+      high = mid - 1;
+    }
+  }
+
+  ext = &file_data->extents [low];
+  idx = file_cluster - ext->file_cluster;
+  if (idx < ext->count)
+  {
+    cluster = (UNS_16)(ext->cluster + idx);
+  }
+  else
+  {
+    // Past the indexed runs, follow the chain from the last one
+    cluster = (UNS_16)(ext->cluster + ext->count - 1);
+    for (idx = ext->count - 1; idx < (file_cluster - ext->file_cluster);
+         idx++)
+    {
+      cluster = (UNS_16) fat16_get_next_cluster(file_data->fat_data,
+                                                cluster);
+    }
+  }
+
+  return cluster;
 }
 
 /***********************************************************************
@@ -0,0 +1,2352 @@
+/***********************************************************************
+ * $Id:: lpc_ftl.c                                                     $
+ *
+ * Project: NAND flash translation layer
+ *
+ * Description:
+ *     See the header file for a description of this package.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include "lpc_ftl.h"
+
+/***********************************************************************
+ * Package defines
+ **********************************************************************/
+
+/* Unmapped logical or physical page */
+#define FTL_NONE               0xFFFFFFFF
+
+/* Block states */
+#define FTL_BLK_FREE           0 /* Free, erased when allocated */
+#define FTL_BLK_ACTIVE         1 /* Receiving data pages */
+#define FTL_BLK_FULL           2 /* Holds valid data pages */
+#define FTL_BLK_PENDING        3 /* No valid pages, not yet reusable */
+#define FTL_BLK_CKPT           4 /* Holds the checkpoint */
+#define FTL_BLK_CKNEW          5 /* Receiving a new checkpoint */
+#define FTL_BLK_RELOC          6 /* Failed, valid pages to be moved */
+#define FTL_BLK_RETIRED        7 /* Bad, never used */
+
+/* Words in the header of a checkpoint or summary page */
+#define FTL_HDR_WORDS          4
+
+/* Number of times a failed program or checkpoint is retried */
+#define FTL_RETRIES            4
+
+/* FTL used by the lpc_fat16 device functions */
+static LPC_FTL_T *fatftl = (LPC_FTL_T *) NULL;
+
+/* Next sector for the lpc_fat16 read and write functions */
+static UNS_32 fatsector;
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: ftl_copy
+ *
+ * Purpose: Copy bytes
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     dst : Destination
+ *     src : Source
+ *     len : Number of bytes to copy
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void ftl_copy(UNS_8 *dst, const UNS_8 *src, UNS_32 len)
+{
+  while (len > 0)
+  {
+    *dst++ = *src++;
+    len--;
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_fill
+ *
+ * Purpose: Fill bytes with a value
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     dst : Destination
+ *     val : Fill value
+ *     len : Number of bytes to fill
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void ftl_fill(UNS_8 *dst, UNS_8 val, UNS_32 len)
+{
+  while (len > 0)
+  {
+    *dst++ = val;
+    len--;
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_read_page
+ *
+ * Purpose: Read a page of a block
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     ftl   : Pointer to FTL
+ *     block : Block number in the FTL range
+ *     page  : Page in the block
+ *     buff  : Where to place the page data
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the page was read, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 ftl_read_page(LPC_FTL_T *ftl, UNS_32 block, UNS_32 page,
+                             void *buff)
+{
+  UNS_32 sector = ((ftl->dev.first_block + block) * ftl->ppb) + page;
+
+  return (BOOL_32) (ftl->dev.read_sector(sector, buff, NULL) > 0);
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_write_page
+ *
+ * Purpose: Write a page of a block
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     ftl   : Pointer to FTL
+ *     block : Block number in the FTL range
+ *     page  : Page in the block
+ *     buff  : Page data
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the page was written, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 ftl_write_page(LPC_FTL_T *ftl, UNS_32 block, UNS_32 page,
+                              void *buff)
+{
+  UNS_32 sector = ((ftl->dev.first_block + block) * ftl->ppb) + page;
+
+  return (BOOL_32) (ftl->dev.write_sector(sector, buff, NULL) > 0);
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_page_check
+ *
+ * Purpose: Compute the check value of a checkpoint or summary page
+ *
+ * Processing:
+ *     Sum the sequence number, index, and data words of the page and
+ *     return the complement, so an erased page never checks good.
+ *
+ * Parameters:
+ *     ftl  : Pointer to FTL
+ *     page : Page data
+ *
+ * Outputs: None
+ *
+ * Returns: The check value
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 ftl_page_check(LPC_FTL_T *ftl, const UNS_32 *page)
+{
+  UNS_32 idx, sum = page[1] + page[2];
+
+  for (idx = FTL_HDR_WORDS; idx < (ftl->page_size / 4); idx++)
+  {
+    sum += page[idx];
+  }
+
+  return ~sum;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_page_good
+ *
+ * Purpose: Check the signature and check value of a page
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     ftl   : Pointer to FTL
+ *     page  : Page data
+ *     magic : Expected signature
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the page is good, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 ftl_page_good(LPC_FTL_T *ftl, const UNS_32 *page,
+                             UNS_32 magic)
+{
+  return (BOOL_32) ((page[0] == magic) && (page[1] != 0) &&
+                    (page[3] == ftl_page_check(ftl, page)));
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_ck_pages
+ *
+ * Purpose: Return the number of pages in a checkpoint
+ *
+ * Processing:
+ *     A checkpoint is the checkpoint header, the block information,
+ *     and the logical to physical map, spread over as many pages as
+ *     needed after the page header.
+ *
+ * Parameters:
+ *     ftl    : Pointer to FTL
+ *     lpages : Number of logical pages
+ *
+ * Outputs: None
+ *
+ * Returns: Number of pages
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 ftl_ck_pages(LPC_FTL_T *ftl, UNS_32 lpages)
+{
+  UNS_32 bytes, payload = ftl->page_size - (FTL_HDR_WORDS * 4);
+
+  bytes = sizeof(LPC_FTL_CKHDR_T) + (ftl->nblk * sizeof(LPC_FTL_BLK_T)) +
+          (lpages * 4);
+
+  return (bytes + payload - 1) / payload;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_ck_copy
+ *
+ * Purpose: Move one page of a checkpoint between a page buffer and the
+ *          checkpoint header, block information, and map
+ *
+ * Processing:
+ *     Copy the part of each checkpoint area that falls in the page.
+ *     When filling the page, bytes past the end are 0xFF.
+ *
+ * Parameters:
+ *     ftl  : Pointer to FTL
+ *     page : Page of the checkpoint
+ *     buff : Page buffer
+ *     load : TRUE to fill the checkpoint areas, FALSE to fill the page
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void ftl_ck_copy(LPC_FTL_T *ftl, UNS_32 page, UNS_32 *buff,
+                        BOOL_32 load)
+{
+  UNS_8 *area[3], *p8 = (UNS_8 *) &buff[FTL_HDR_WORDS];
+  UNS_32 size[3], idx, lo, hi, start = 0;
+  UNS_32 payload = ftl->page_size - (FTL_HDR_WORDS * 4);
+  UNS_32 off = page * payload;
+
+  area[0] = (UNS_8 *) &ftl->ckhdr;
+  size[0] = sizeof(LPC_FTL_CKHDR_T);
+  area[1] = (UNS_8 *) ftl->blk;
+  size[1] = ftl->nblk * sizeof(LPC_FTL_BLK_T);
+  area[2] = (UNS_8 *) ftl->l2p;
+  size[2] = ftl->lpages * 4;
+
+  if (load == FALSE)
+  {
+    ftl_fill(p8, 0xFF, payload);
+  }
+
+  for (idx = 0; idx < 3; idx++)
+  {
+    lo = (off > start) ? off : start;
+    hi = start + size[idx];
+    if (hi > (off + payload))
+    {
+      hi = off + payload;
+    }
+
+    if (lo < hi)
+    {
+      if (load == TRUE)
+      {
+        ftl_copy(area[idx] + (lo - start), p8 + (lo - off), hi - lo);
+      }
+      else
+      {
+        ftl_copy(p8 + (lo - off), area[idx] + (lo - start), hi - lo);
+      }
+    }
+
+    start += size[idx];
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_set_state
+ *
+ * Purpose: Change the state of a block
+ *
+ * Processing:
+ *     Update the free block count and the block state.
+ *
+ * Parameters:
+ *     ftl   : Pointer to FTL
+ *     block : Block number
+ *     state : New state
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void ftl_set_state(LPC_FTL_T *ftl, UNS_32 block, UNS_8 state)
+{
+  if (ftl->blk[block].state == FTL_BLK_FREE)
+  {
+    ftl->nfree--;
+  }
+  if (state == FTL_BLK_FREE)
+  {
+    ftl->nfree++;
+  }
+
+  ftl->blk[block].state = state;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_release
+ *
+ * Purpose: Free the blocks waiting for their data to be safe
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes:
+ *     Only call this when the pages that replaced the data in the
+ *     pending blocks are in a closed block or in a checkpoint.
+ *
+ **********************************************************************/
+static void ftl_release(LPC_FTL_T *ftl)
+{
+  UNS_32 block;
+
+  for (block = 0; block < ftl->nblk; block++)
+  {
+    if (ftl->blk[block].state == FTL_BLK_PENDING)
+    {
+      ftl_set_state(ftl, block, FTL_BLK_FREE);
+    }
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_alloc_block
+ *
+ * Purpose: Allocate and erase a free block
+ *
+ * Processing:
+ *     If no block is active and no failure is being held, all data is
+ *     in closed blocks, so free the pending blocks. Pick the free block
+ *     with the lowest erase count and erase it. A block that fails to
+ *     erase is retired and another block is tried.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *
+ * Outputs: None
+ *
+ * Returns: Block number, or -1 if there are no free blocks
+ *
+ * Notes:
+ *     The block is returned in the active state with a new sequence
+ *     number.
+ *
+ **********************************************************************/
+static INT_32 ftl_alloc_block(LPC_FTL_T *ftl)
+{
+  LPC_FTL_BLK_T *pblk;
+  UNS_32 block;
+  INT_32 best;
+
+  if ((ftl->active < 0) && (ftl->hold == FALSE))
+  {
+    ftl_release(ftl);
+  }
+
+  while (ftl->nfree > 0)
+  {
+    best = -1;
+    for (block = 0; block < ftl->nblk; block++)
+    {
+      if ((ftl->blk[block].state == FTL_BLK_FREE) &&
+          ((best < 0) ||
+           (ftl->blk[block].erases < ftl->blk[best].erases)))
+      {
+        best = (INT_32) block;
+      }
+    }
+
+    if (ftl->dev.erase_block(ftl->dev.first_block + best) == FALSE)
+    {
+      ftl_set_state(ftl, best, FTL_BLK_RETIRED);
+      continue;
+    }
+
+    pblk = &ftl->blk[best];
+    pblk->erases++;
+    if (pblk->erases > ftl->max_erases)
+    {
+      ftl->max_erases = pblk->erases;
+    }
+    ftl->seq++;
+    pblk->seq = ftl->seq;
+    pblk->valid = 0;
+    ftl_set_state(ftl, best, FTL_BLK_ACTIVE);
+    ftl->stats.erases++;
+
+    /* The read buffer may hold a page of the erased block */
+    if ((ftl->rdppn != FTL_NONE) &&
+        ((ftl->rdppn / ftl->ppb) == (UNS_32) best))
+    {
+      ftl->rdppn = FTL_NONE;
+    }
+
+    return best;
+  }
+
+  return -1;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_unmap
+ *
+ * Purpose: Drop a physical page that no longer holds current data
+ *
+ * Processing:
+ *     Clear the reverse map entry and count down the valid pages of
+ *     the block. A closed block with no valid pages waits until the
+ *     new data is safe before it is reused, a failed block with no
+ *     valid pages is retired. When the last failed block is retired,
+ *     stop holding the pending blocks.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *     ppn : Physical page number
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void ftl_unmap(LPC_FTL_T *ftl, UNS_32 ppn)
+{
+  UNS_32 block = ppn / ftl->ppb;
+
+  ftl->p2l[ppn] = FTL_NONE;
+  ftl->blk[block].valid--;
+  if (ftl->blk[block].valid == 0)
+  {
+    if (ftl->blk[block].state == FTL_BLK_FULL)
+    {
+      ftl_set_state(ftl, block, FTL_BLK_PENDING);
+    }
+    else if (ftl->blk[block].state == FTL_BLK_RELOC)
+    {
+      ftl_set_state(ftl, block, FTL_BLK_RETIRED);
+
+      /* Once no failed block holds data, the moved pages are
+         covered by the next summary */
+      block = 0;
+      while ((block < ftl->nblk) &&
+             (ftl->blk[block].state != FTL_BLK_RELOC))
+      {
+        block++;
+      }
+      if (block == ftl->nblk)
+      {
+        ftl->hold = FALSE;
+      }
+    }
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_write_summary
+ *
+ * Purpose: Write the summary page of the active block
+ *
+ * Processing:
+ *     Write the logical page of each data page in the last page of
+ *     the block, with the block sequence number and erase count.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the summary was written, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 ftl_write_summary(LPC_FTL_T *ftl)
+{
+  UNS_32 block = (UNS_32) ftl->active;
+
+  ftl->sumbuf[0] = LPC_FTL_MAGIC_SUM;
+  ftl->sumbuf[1] = ftl->blk[block].seq;
+  ftl->sumbuf[2] = ftl->blk[block].erases;
+  ftl->sumbuf[3] = ftl_page_check(ftl, ftl->sumbuf);
+
+  return ftl_write_page(ftl, block, ftl->dpb, ftl->sumbuf);
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_fail_active
+ *
+ * Purpose: Stop using the active block after a program failure
+ *
+ * Processing:
+ *     The valid pages of the block can still be read, so mark it to
+ *     have them moved by garbage collection and retire it then. Try to
+ *     write the summary of the pages programmed so far. If there is no
+ *     summary, hold the pending blocks until the pages are moved or a
+ *     checkpoint is written.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void ftl_fail_active(LPC_FTL_T *ftl)
+{
+  UNS_32 block = (UNS_32) ftl->active;
+
+  if (ftl->blk[block].valid == 0)
+  {
+    ftl_set_state(ftl, block, FTL_BLK_RETIRED);
+  }
+  else
+  {
+    ftl_set_state(ftl, block, FTL_BLK_RELOC);
+    if ((ftl->wp == ftl->dpb) || (ftl_write_summary(ftl) == FALSE))
+    {
+      ftl->hold = TRUE;
+    }
+  }
+  ftl->active = -1;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_close
+ *
+ * Purpose: Close the active block once its data pages are used
+ *
+ * Processing:
+ *     Write the summary page. Once it is written, the data of the
+ *     pending blocks is safe and they can be freed.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void ftl_close(LPC_FTL_T *ftl)
+{
+  UNS_32 block = (UNS_32) ftl->active;
+
+  if (ftl_write_summary(ftl) == FALSE)
+  {
+    ftl_fail_active(ftl);
+    return;
+  }
+
+  ftl->active = -1;
+  if (ftl->blk[block].valid > 0)
+  {
+    ftl_set_state(ftl, block, FTL_BLK_FULL);
+  }
+  else
+  {
+    ftl_set_state(ftl, block, FTL_BLK_PENDING);
+  }
+
+  if (ftl->hold == FALSE)
+  {
+    ftl_release(ftl);
+  }
+}
+
+/* Garbage collection, checkpoints, and page programming call each
+   other */
+static void ftl_gc(LPC_FTL_T *ftl);
+static STATUS ftl_ckpt(LPC_FTL_T *ftl);
+
+/***********************************************************************
+ *
+ * Function: ftl_prog
+ *
+ * Purpose: Program a logical page
+ *
+ * Processing:
+ *     If there is no active block, make room with garbage collection
+ *     and allocate one. Program the data in the next free page and
+ *     retry in a new block if that fails. Map the logical page to the
+ *     new page and drop the old page. Close the block when its data
+ *     pages are used.
+ *
+ * Parameters:
+ *     ftl   : Pointer to FTL
+ *     lpage : Logical page
+ *     data  : Page data, 32-bit aligned
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the page was programmed, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 ftl_prog(LPC_FTL_T *ftl, UNS_32 lpage, void *data)
+{
+  UNS_32 ppn, tries;
+  INT_32 block;
+
+  for (tries = 0; tries < FTL_RETRIES; tries++)
+  {
+    if ((ftl->active < 0) && (ftl->in_gc == FALSE))
+    {
+      ftl_gc(ftl);
+    }
+
+    /* Garbage collection may have left a block active */
+    if (ftl->active < 0)
+    {
+      block = ftl_alloc_block(ftl);
+      if (block < 0)
+      {
+        return FALSE;
+      }
+
+      ftl->active = block;
+      ftl->wp = 0;
+      ftl_fill((UNS_8 *) ftl->sumbuf, 0xFF, ftl->page_size);
+    }
+
+    if (ftl_write_page(ftl, (UNS_32) ftl->active, ftl->wp, data) ==
+        FALSE)
+    {
+      ftl_fail_active(ftl);
+      continue;
+    }
+
+    ppn = ((UNS_32) ftl->active * ftl->ppb) + ftl->wp;
+    if (ftl->l2p[lpage] != FTL_NONE)
+    {
+      ftl_unmap(ftl, ftl->l2p[lpage]);
+    }
+    ftl->l2p[lpage] = ppn;
+    ftl->p2l[ppn] = lpage;
+    ftl->blk[ftl->active].valid++;
+    ftl->sumbuf[FTL_HDR_WORDS + ftl->wp] = lpage;
+    ftl->wp++;
+    ftl->dirty = TRUE;
+    ftl->stats.page_writes++;
+
+    if (ftl->wp == ftl->dpb)
+    {
+      ftl_close(ftl);
+    }
+
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_gc_victim
+ *
+ * Purpose: Pick the block to be collected
+ *
+ * Processing:
+ *     A failed block is always picked first. If allowed and the least
+ *     erased block holding data is LPC_FTL_WL_DELTA erases behind the
+ *     most erased block, pick it so its cold data moves and the block
+ *     is reused. Otherwise pick the closed block with the fewest valid
+ *     pages, or with cost-benefit the block with the most free space
+ *     times age per valid page.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *     wl  : TRUE to allow a wear levelling move
+ *
+ * Outputs: None
+ *
+ * Returns: Block number, or -1 if there is nothing to collect
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 ftl_gc_victim(LPC_FTL_T *ftl, BOOL_32 wl)
+{
+  LPC_FTL_BLK_T *pblk, *pbest;
+  UNS_64 score, bscore;
+  UNS_32 block;
+  INT_32 best = -1, cold = -1;
+
+  for (block = 0; block < ftl->nblk; block++)
+  {
+    pblk = &ftl->blk[block];
+    if (pblk->state == FTL_BLK_RELOC)
+    {
+      return (INT_32) block;
+    }
+    if (pblk->state != FTL_BLK_FULL)
+    {
+      continue;
+    }
+
+    if ((cold < 0) || (pblk->erases < ftl->blk[cold].erases))
+    {
+      cold = (INT_32) block;
+    }
+
+    if (pblk->valid >= ftl->dpb)
+    {
+      continue;
+    }
+
+    if (best < 0)
+    {
+      best = (INT_32) block;
+    }
+    else if (ftl->dev.gc_policy == LPC_FTL_GC_COST_BENEFIT)
+    {
+      /* Compare (free * age / valid) without dividing */
+      pbest = &ftl->blk[best];
+      score = (UNS_64) (ftl->dpb - pblk->valid) *
+              (UNS_64) (ftl->seq - pblk->seq) * (UNS_64) pbest->valid;
+      bscore = (UNS_64) (ftl->dpb - pbest->valid) *
+               (UNS_64) (ftl->seq - pbest->seq) * (UNS_64) pblk->valid;
+      if (score > bscore)
+      {
+        best = (INT_32) block;
+      }
+    }
+    else if (pblk->valid < ftl->blk[best].valid)
+    {
+      best = (INT_32) block;
+    }
+  }
+
+  if ((wl == TRUE) && (cold >= 0) &&
+      ((ftl->max_erases - ftl->blk[cold].erases) > LPC_FTL_WL_DELTA))
+  {
+    return cold;
+  }
+
+  return best;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_gc_block
+ *
+ * Purpose: Move the valid pages of a block
+ *
+ * Processing:
+ *     Read each valid page and program it again. Moving the last
+ *     valid page releases or retires the block.
+ *
+ * Parameters:
+ *     ftl   : Pointer to FTL
+ *     block : Block number
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if all pages were moved, otherwise FALSE
+ *
+ * Notes:
+ *     A page that fails to read is moved as read.
+ *
+ **********************************************************************/
+static BOOL_32 ftl_gc_block(LPC_FTL_T *ftl, UNS_32 block)
+{
+  UNS_32 page, lpage;
+
+  for (page = 0; page < ftl->dpb; page++)
+  {
+    lpage = ftl->p2l[(block * ftl->ppb) + page];
+    if (lpage == FTL_NONE)
+    {
+      continue;
+    }
+
+    ftl_read_page(ftl, block, page, ftl->gcbuf);
+    if (ftl_prog(ftl, lpage, ftl->gcbuf) == FALSE)
+    {
+      return FALSE;
+    }
+    ftl->stats.gc_writes++;
+  }
+
+  return TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_gc
+ *
+ * Purpose: Collect blocks until there are enough free blocks
+ *
+ * Processing:
+ *     Keep LPC_FTL_GC_RESERVE blocks plus the blocks for the next
+ *     checkpoint free. Collect victims until there are more free
+ *     blocks than that and the pages of failed blocks have been moved,
+ *     or there is nothing left to collect. If a failure is being held,
+ *     write a checkpoint first so the held blocks can be reused.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void ftl_gc(LPC_FTL_T *ftl)
+{
+  BOOL_32 wl = TRUE;
+  INT_32 block;
+
+  ftl->in_gc = TRUE;
+
+  /* A checkpoint makes the held blocks reusable */
+  if (ftl->hold == TRUE)
+  {
+    ftl_ckpt(ftl);
+  }
+
+  while ((ftl->nfree <= (LPC_FTL_GC_RESERVE + ftl->ckblocks)) ||
+         (ftl->hold == TRUE))
+  {
+    block = ftl_gc_victim(ftl, wl);
+    if (block < 0)
+    {
+      break;
+    }
+
+    if (ftl_gc_block(ftl, (UNS_32) block) == FALSE)
+    {
+      break;
+    }
+    wl = FALSE;
+  }
+  ftl->in_gc = FALSE;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_ckpt
+ *
+ * Purpose: Write a checkpoint
+ *
+ * Processing:
+ *     Write the checkpoint header, block information, and map to
+ *     newly allocated blocks, each page with a header and check value.
+ *     If a page fails, retire its block and start again. Once the new
+ *     checkpoint is complete, free the blocks of the old one and the
+ *     pending blocks.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if the checkpoint was written, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS ftl_ckpt(LPC_FTL_T *ftl)
+{
+  UNS_32 *p32 = (UNS_32 *) ftl->iobuf;
+  UNS_32 block, page, seq, tries;
+  INT_32 cblk = -1;
+  BOOL_32 good;
+
+  ftl->ckhdr.num_blocks = ftl->nblk;
+  ftl->ckhdr.pages_per_block = ftl->ppb;
+  ftl->ckhdr.lpages = ftl->lpages;
+  ftl->ckhdr.pages = ftl_ck_pages(ftl, ftl->lpages);
+
+  for (tries = 0; tries < FTL_RETRIES; tries++)
+  {
+    ftl->ckhdr.open_block = ftl->active;
+    ftl->ckhdr.open_page = ftl->wp;
+    ftl->seq++;
+    seq = ftl->seq;
+    good = TRUE;
+
+    for (page = 0; (page < ftl->ckhdr.pages) && (good == TRUE); page++)
+    {
+      if ((page % ftl->ppb) == 0)
+      {
+        cblk = ftl_alloc_block(ftl);
+        if (cblk < 0)
+        {
+          break;
+        }
+        ftl_set_state(ftl, (UNS_32) cblk, FTL_BLK_CKNEW);
+      }
+
+      p32[0] = LPC_FTL_MAGIC_CKPT;
+      p32[1] = seq;
+      p32[2] = page;
+      ftl_ck_copy(ftl, page, p32, FALSE);
+      p32[3] = ftl_page_check(ftl, p32);
+
+      if (ftl_write_page(ftl, (UNS_32) cblk, page % ftl->ppb, p32) ==
+          FALSE)
+      {
+        ftl_set_state(ftl, (UNS_32) cblk, FTL_BLK_RETIRED);
+        good = FALSE;
+      }
+    }
+
+    if ((good == TRUE) && (cblk >= 0))
+    {
+      for (block = 0; block < ftl->nblk; block++)
+      {
+        if (ftl->blk[block].state == FTL_BLK_CKNEW)
+        {
+          ftl_set_state(ftl, block, FTL_BLK_CKPT);
+        }
+        else if ((ftl->blk[block].state == FTL_BLK_CKPT) ||
+                 (ftl->blk[block].state == FTL_BLK_PENDING))
+        {
+          ftl_set_state(ftl, block, FTL_BLK_FREE);
+        }
+      }
+
+      ftl->ckseq = seq;
+      ftl->hold = FALSE;
+      ftl->dirty = FALSE;
+      ftl->stats.checkpoints++;
+      return _NO_ERROR;
+    }
+
+    /* Drop the partial checkpoint */
+    for (block = 0; block < ftl->nblk; block++)
+    {
+      if (ftl->blk[block].state == FTL_BLK_CKNEW)
+      {
+        ftl_set_state(ftl, block, FTL_BLK_FREE);
+      }
+    }
+
+    if (cblk < 0)
+    {
+      break;
+    }
+  }
+
+  return _ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_ck_find
+ *
+ * Purpose: Find the block holding a page of a checkpoint
+ *
+ * Processing:
+ *     The mount scan left the sequence number and page index of the
+ *     first page of each block in the reverse map.
+ *
+ * Parameters:
+ *     ftl  : Pointer to FTL
+ *     seq  : Sequence number of the checkpoint
+ *     page : Page of the checkpoint at the start of the block
+ *
+ * Outputs: None
+ *
+ * Returns: Block number, or -1 if not found
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 ftl_ck_find(LPC_FTL_T *ftl, UNS_32 seq, UNS_32 page)
+{
+  UNS_32 block, *info;
+
+  for (block = 0; block < ftl->nblk; block++)
+  {
+    info = &ftl->p2l[block * ftl->ppb];
+    if ((info[0] == seq) && (info[1] == page))
+    {
+      return (INT_32) block;
+    }
+  }
+
+  return -1;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_ck_load
+ *
+ * Purpose: Load a checkpoint
+ *
+ * Processing:
+ *     Read the first page and check that the checkpoint header matches
+ *     the device. Then read each page into the checkpoint areas,
+ *     checking that every page belongs to the checkpoint.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *     seq : Sequence number of the checkpoint
+ *
+ * Outputs: The map and block information are overwritten even if the
+ *          checkpoint is bad.
+ *
+ * Returns: TRUE if the checkpoint was loaded, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 ftl_ck_load(LPC_FTL_T *ftl, UNS_32 seq)
+{
+  UNS_32 *p32 = (UNS_32 *) ftl->iobuf;
+  UNS_32 page;
+  INT_32 block = -1;
+
+  for (page = 0; (page == 0) || (page < ftl->ckhdr.pages); page++)
+  {
+    if ((page % ftl->ppb) == 0)
+    {
+      block = ftl_ck_find(ftl, seq, page);
+      if (block < 0)
+      {
+        return FALSE;
+      }
+    }
+
+    if ((ftl_read_page(ftl, (UNS_32) block, page % ftl->ppb, p32) ==
+         FALSE) ||
+        (ftl_page_good(ftl, p32, LPC_FTL_MAGIC_CKPT) == FALSE) ||
+        (p32[1] != seq) || (p32[2] != page))
+    {
+      return FALSE;
+    }
+
+    if (page == 0)
+    {
+      ftl_copy((UNS_8 *) &ftl->ckhdr, (UNS_8 *) &p32[FTL_HDR_WORDS],
+               sizeof(LPC_FTL_CKHDR_T));
+      if ((ftl->ckhdr.num_blocks != ftl->nblk) ||
+          (ftl->ckhdr.pages_per_block != ftl->ppb) ||
+          (ftl->ckhdr.lpages == 0) ||
+          (ftl->ckhdr.lpages > (ftl->nblk * ftl->dpb)) ||
+          (ftl->ckhdr.pages != ftl_ck_pages(ftl, ftl->ckhdr.lpages)))
+      {
+        return FALSE;
+      }
+      ftl->lpages = ftl->ckhdr.lpages;
+    }
+
+    ftl_ck_copy(ftl, page, p32, TRUE);
+  }
+
+  return TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_replay
+ *
+ * Purpose: Map the data pages of a block from its summary
+ *
+ * Processing:
+ *     Read the summary page and map each logical page listed from the
+ *     first page on to its data page. Restore the block erase count
+ *     and sequence number.
+ *
+ * Parameters:
+ *     ftl   : Pointer to FTL
+ *     block : Block number
+ *     first : First data page to map
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void ftl_replay(LPC_FTL_T *ftl, UNS_32 block, UNS_32 first)
+{
+  UNS_32 *p32 = (UNS_32 *) ftl->iobuf;
+  UNS_32 page, lpage;
+
+  if ((ftl_read_page(ftl, block, ftl->dpb, p32) == FALSE) ||
+      (ftl_page_good(ftl, p32, LPC_FTL_MAGIC_SUM) == FALSE))
+  {
+    return;
+  }
+
+  for (page = first; page < ftl->dpb; page++)
+  {
+    lpage = p32[FTL_HDR_WORDS + page];
+    if (lpage < ftl->lpages)
+    {
+      ftl->l2p[lpage] = (block * ftl->ppb) + page;
+    }
+  }
+
+  ftl->blk[block].seq = p32[1];
+  ftl->blk[block].erases = p32[2];
+  ftl->dirty = TRUE;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_mount
+ *
+ * Purpose: Rebuild the FTL state from the device
+ *
+ * Processing:
+ *     Read the first and last page of each good block and note the
+ *     checkpoint and summary pages found in the reverse map, which is
+ *     rebuilt later. Load the newest checkpoint that is complete. Then
+ *     apply the summary of the block that was active at the checkpoint
+ *     from the page it had reached, and the summaries of the blocks
+ *     allocated after the checkpoint in the order they were allocated.
+ *     Rebuild the reverse map, valid page counts, and block states
+ *     from the map.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if a checkpoint was loaded, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS ftl_mount(LPC_FTL_T *ftl)
+{
+  UNS_32 *p32 = (UNS_32 *) ftl->iobuf;
+  UNS_32 block, lpage, ppn, *info, seq, last, maxseq = 0;
+  LPC_FTL_BLK_T *pblk;
+  INT_32 next;
+
+  /* Find the checkpoint and summary pages */
+  for (block = 0; block < ftl->nblk; block++)
+  {
+    info = &ftl->p2l[block * ftl->ppb];
+    info[0] = 0;
+    info[1] = 0;
+    info[2] = 0;
+    info[3] = (UNS_32) ftl->dev.is_bad_block(ftl->dev.first_block +
+                                             block);
+    if (info[3] != FALSE)
+    {
+      continue;
+    }
+
+    if ((ftl_read_page(ftl, block, 0, p32) == TRUE) &&
+        (ftl_page_good(ftl, p32, LPC_FTL_MAGIC_CKPT) == TRUE) &&
+        ((p32[2] % ftl->ppb) == 0))
+    {
+      info[0] = p32[1];
+      info[1] = p32[2];
+      maxseq = (p32[1] > maxseq) ? p32[1] : maxseq;
+    }
+
+    if ((ftl_read_page(ftl, block, ftl->dpb, p32) == TRUE) &&
+        (ftl_page_good(ftl, p32, LPC_FTL_MAGIC_SUM) == TRUE))
+    {
+      info[2] = p32[1];
+      maxseq = (p32[1] > maxseq) ? p32[1] : maxseq;
+    }
+  }
+
+  /* Load the newest complete checkpoint */
+  last = FTL_NONE;
+  do
+  {
+    seq = 0;
+    for (block = 0; block < ftl->nblk; block++)
+    {
+      info = &ftl->p2l[block * ftl->ppb];
+      if ((info[0] < last) && (info[0] > seq))
+      {
+        seq = info[0];
+      }
+    }
+
+    if (seq == 0)
+    {
+      return _ERROR;
+    }
+    last = seq;
+  } while (ftl_ck_load(ftl, seq) == FALSE);
+  ftl->ckseq = seq;
+
+  /* Blocks not retired or holding the checkpoint start free */
+  ftl->nfree = 0;
+  for (block = 0; block < ftl->nblk; block++)
+  {
+    info = &ftl->p2l[block * ftl->ppb];
+    pblk = &ftl->blk[block];
+    pblk->valid = 0;
+    if ((pblk->state != FTL_BLK_RETIRED) &&
+        (pblk->state != FTL_BLK_RELOC))
+    {
+      pblk->state = FTL_BLK_FREE;
+    }
+    if (info[3] != FALSE)
+    {
+      pblk->state = FTL_BLK_RETIRED;
+    }
+    else if (info[0] == seq)
+    {
+      pblk->state = FTL_BLK_CKPT;
+    }
+    if (pblk->seq > maxseq)
+    {
+      maxseq = pblk->seq;
+    }
+  }
+
+  /* Apply the rest of the block active at the checkpoint */
+  block = (UNS_32) ftl->ckhdr.open_block;
+  if ((ftl->ckhdr.open_block >= 0) && (block < ftl->nblk) &&
+      (ftl->blk[block].state == FTL_BLK_FREE) &&
+      (ftl->p2l[block * ftl->ppb + 2] == ftl->blk[block].seq))
+  {
+    ftl_replay(ftl, block, ftl->ckhdr.open_page);
+  }
+
+  /* Apply the blocks closed after the checkpoint, oldest first */
+  last = seq;
+  do
+  {
+    next = -1;
+    for (block = 0; block < ftl->nblk; block++)
+    {
+      info = &ftl->p2l[block * ftl->ppb];
+      if ((info[2] > last) && (ftl->blk[block].state == FTL_BLK_FREE) &&
+          ((next < 0) ||
+           (info[2] < ftl->p2l[(UNS_32) next * ftl->ppb + 2])))
+      {
+        next = (INT_32) block;
+      }
+    }
+
+    if (next >= 0)
+    {
+      last = ftl->p2l[(UNS_32) next * ftl->ppb + 2];
+      ftl_replay(ftl, (UNS_32) next, 0);
+    }
+  } while (next >= 0);
+
+  /* Rebuild the reverse map and valid page counts */
+  for (ppn = 0; ppn < (ftl->nblk * ftl->ppb); ppn++)
+  {
+    ftl->p2l[ppn] = FTL_NONE;
+  }
+  for (lpage = 0; lpage < ftl->lpages; lpage++)
+  {
+    ppn = ftl->l2p[lpage];
+    if (ppn == FTL_NONE)
+    {
+      continue;
+    }
+
+    block = ppn / ftl->ppb;
+    if ((block >= ftl->nblk) || ((ppn % ftl->ppb) >= ftl->dpb) ||
+        (ftl->blk[block].state == FTL_BLK_CKPT))
+    {
+      ftl->l2p[lpage] = FTL_NONE;
+      continue;
+    }
+
+    if (ftl->p2l[ppn] != FTL_NONE)
+    {
+      ftl->l2p[ftl->p2l[ppn]] = FTL_NONE;
+      ftl->blk[block].valid--;
+    }
+    ftl->p2l[ppn] = lpage;
+    ftl->blk[block].valid++;
+  }
+
+  /* Set the block states from the valid pages */
+  ftl->max_erases = 0;
+  for (block = 0; block < ftl->nblk; block++)
+  {
+    pblk = &ftl->blk[block];
+    if ((pblk->state == FTL_BLK_FREE) && (pblk->valid > 0))
+    {
+      pblk->state = FTL_BLK_FULL;
+    }
+    else if ((pblk->state == FTL_BLK_RELOC) && (pblk->valid == 0))
+    {
+      pblk->state = FTL_BLK_RETIRED;
+    }
+    else if ((pblk->state == FTL_BLK_RETIRED) && (pblk->valid > 0))
+    {
+      pblk->state = FTL_BLK_RELOC;
+    }
+
+    if (pblk->state == FTL_BLK_FREE)
+    {
+      ftl->nfree++;
+    }
+    if ((pblk->state != FTL_BLK_RETIRED) &&
+        (pblk->erases > ftl->max_erases))
+    {
+      ftl->max_erases = pblk->erases;
+    }
+  }
+
+  ftl->seq = maxseq;
+  ftl->ckblocks = (ftl->ckhdr.pages + ftl->ppb - 1) / ftl->ppb;
+
+  return _NO_ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_format
+ *
+ * Purpose: Erase the device and write an empty checkpoint
+ *
+ * Processing:
+ *     Erase each good block, retiring the bad ones. Size the logical
+ *     pages to leave room for two checkpoints, the garbage collection
+ *     reserve, the active block, and the overprovisioned blocks. Then
+ *     write a checkpoint with nothing mapped.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if the device was formatted, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static STATUS ftl_format(LPC_FTL_T *ftl)
+{
+  UNS_32 block, ppn, rsvd, ckmax, good = 0;
+  LPC_FTL_BLK_T *pblk;
+
+  for (block = 0; block < ftl->nblk; block++)
+  {
+    pblk = &ftl->blk[block];
+    pblk->erases = 0;
+    pblk->seq = 0;
+    pblk->valid = 0;
+    pblk->rsvd = 0;
+    pblk->state = FTL_BLK_RETIRED;
+
+    if ((ftl->dev.is_bad_block(ftl->dev.first_block + block) == FALSE) &&
+        (ftl->dev.erase_block(ftl->dev.first_block + block) == TRUE))
+    {
+      pblk->erases = 1;
+      pblk->state = FTL_BLK_FREE;
+      good++;
+    }
+  }
+
+  ckmax = (ftl_ck_pages(ftl, ftl->nblk * ftl->dpb) + ftl->ppb - 1) /
+          ftl->ppb;
+  rsvd = (2 * ckmax) + LPC_FTL_GC_RESERVE + 1 +
+         (good >> LPC_FTL_OP_SHIFT);
+  if (good <= (rsvd + 1))
+  {
+    return _ERROR;
+  }
+
+  ftl->lpages = (good - rsvd) * ftl->dpb;
+  for (ppn = 0; ppn < ftl->lpages; ppn++)
+  {
+    ftl->l2p[ppn] = FTL_NONE;
+  }
+  for (ppn = 0; ppn < (ftl->nblk * ftl->ppb); ppn++)
+  {
+    ftl->p2l[ppn] = FTL_NONE;
+  }
+
+  ftl->nfree = good;
+  ftl->max_erases = 1;
+  ftl->seq = 0;
+  ftl->ckblocks = (ftl_ck_pages(ftl, ftl->lpages) + ftl->ppb - 1) /
+                  ftl->ppb;
+
+  return ftl_ckpt(ftl);
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_find_slot
+ *
+ * Purpose: Find the write buffer page of a logical page
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     ftl   : Pointer to FTL
+ *     lpage : Logical page
+ *
+ * Outputs: None
+ *
+ * Returns: Write buffer page index, or -1 if not buffered
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 ftl_find_slot(LPC_FTL_T *ftl, UNS_32 lpage)
+{
+  INT_32 idx;
+
+  for (idx = 0; idx < LPC_FTL_WBUF_PAGES; idx++)
+  {
+    if (ftl->wslot[idx].lpage == lpage)
+    {
+      return idx;
+    }
+  }
+
+  return -1;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_flush_slot
+ *
+ * Purpose: Program a write buffer page
+ *
+ * Processing:
+ *     Fill the sectors not written from the current copy of the page,
+ *     then program the page.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *     idx : Write buffer page index
+ *
+ * Outputs: None
+ *
+ * Returns: TRUE if the page was programmed, otherwise FALSE
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static BOOL_32 ftl_flush_slot(LPC_FTL_T *ftl, INT_32 idx)
+{
+  LPC_FTL_WSLOT_T *pslot = &ftl->wslot[idx];
+  UNS_8 *buff = ftl->wbuf + ((UNS_32) idx * ftl->page_size);
+  UNS_32 sec, ppn, full = ((UNS_32) 1 << ftl->spp) - 1;
+  BOOL_32 good;
+
+  if (pslot->lpage == FTL_NONE)
+  {
+    return TRUE;
+  }
+
+  ppn = ftl->l2p[pslot->lpage];
+  if ((pslot->mask != full) && (ppn != FTL_NONE))
+  {
+    ftl_read_page(ftl, ppn / ftl->ppb, ppn % ftl->ppb, ftl->gcbuf);
+    for (sec = 0; sec < ftl->spp; sec++)
+    {
+      if ((pslot->mask & ((UNS_32) 1 << sec)) == 0)
+      {
+        ftl_copy(buff + (sec * LPC_FTL_SECTOR_SIZE),
+                 ftl->gcbuf + (sec * LPC_FTL_SECTOR_SIZE),
+                 LPC_FTL_SECTOR_SIZE);
+      }
+    }
+  }
+
+  good = ftl_prog(ftl, pslot->lpage, buff);
+  pslot->lpage = FTL_NONE;
+
+  return good;
+}
+
+/***********************************************************************
+ *
+ * Function: ftl_get_slot
+ *
+ * Purpose: Return the write buffer page of a logical page
+ *
+ * Processing:
+ *     If the page is not buffered, use a free write buffer page, or
+ *     program the least recently used one, and start it erased.
+ *
+ * Parameters:
+ *     ftl   : Pointer to FTL
+ *     lpage : Logical page
+ *
+ * Outputs: None
+ *
+ * Returns: Write buffer page index, or -1 on a program failure
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static INT_32 ftl_get_slot(LPC_FTL_T *ftl, UNS_32 lpage)
+{
+  INT_32 idx, best;
+
+  best = ftl_find_slot(ftl, lpage);
+  if (best >= 0)
+  {
+    return best;
+  }
+
+  best = 0;
+  for (idx = 0; idx < LPC_FTL_WBUF_PAGES; idx++)
+  {
+    if (ftl->wslot[idx].lpage == FTL_NONE)
+    {
+      best = idx;
+      break;
+    }
+    if (ftl->wslot[idx].stamp < ftl->wslot[best].stamp)
+    {
+      best = idx;
+    }
+  }
+
+  if (ftl_flush_slot(ftl, best) == FALSE)
+  {
+    return -1;
+  }
+
+  ftl->wslot[best].lpage = lpage;
+  ftl->wslot[best].mask = 0;
+  ftl_fill(ftl->wbuf + ((UNS_32) best * ftl->page_size), 0xFF,
+           ftl->page_size);
+
+  return best;
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_mem_size
+ *
+ * Purpose: Return the size of the work memory needed for a device
+ *
+ * Processing:
+ *     The work memory holds the logical and physical page maps, the
+ *     block information, the write buffer, and 4 page buffers.
+ *
+ * Parameters:
+ *     dev : Device range and functions
+ *
+ * Outputs: None
+ *
+ * Returns: Size in bytes
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+UNS_32 lpc_ftl_mem_size(const LPC_FTL_DEV_T *dev)
+{
+  UNS_32 ppb = dev->geom->pages_per_block;
+
+  return (dev->num_blocks * (ppb - 1) * 4) +
+         (dev->num_blocks * ppb * 4) +
+         (dev->num_blocks * sizeof(LPC_FTL_BLK_T)) +
+         ((LPC_FTL_WBUF_PAGES + 4) * dev->geom->data_bytes_per_page);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_init
+ *
+ * Purpose: Mount the FTL on a device
+ *
+ * Processing:
+ *     Check the geometry and work memory and lay out the maps and
+ *     buffers in the work memory. Mount from the last checkpoint, or
+ *     format the device if that fails and formatting is allowed.
+ *
+ * Parameters:
+ *     ftl    : Pointer to FTL to setup
+ *     dev    : Device range and functions
+ *     mem    : Work memory, 32-bit aligned
+ *     size   : Size of the work memory, see lpc_ftl_mem_size()
+ *     format : TRUE to format the device if it has no checkpoint
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if the FTL is ready, otherwise _ERROR
+ *
+ * Notes:
+ *     Formatting erases every good block in the range.
+ *
+ **********************************************************************/
+STATUS lpc_ftl_init(LPC_FTL_T *ftl,
+                    const LPC_FTL_DEV_T *dev,
+                    void *mem,
+                    UNS_32 size,
+                    BOOL_32 format)
+{
+  INT_32 idx;
+
+  ftl->dev = *dev;
+  ftl->ppb = dev->geom->pages_per_block;
+  ftl->dpb = ftl->ppb - 1;
+  ftl->page_size = dev->geom->data_bytes_per_page;
+  ftl->spp = ftl->page_size / LPC_FTL_SECTOR_SIZE;
+  ftl->nblk = dev->num_blocks;
+
+  if ((ftl->spp == 0) || (ftl->spp > 16) ||
+      ((ftl->page_size % LPC_FTL_SECTOR_SIZE) != 0) ||
+      (ftl->ppb < 4) || (ftl->nblk == 0) ||
+      (((UNS_32) mem & 0x3) != 0) || (size < lpc_ftl_mem_size(dev)))
+  {
+    return _ERROR;
+  }
+
+  /* Lay out the work memory */
+  ftl->l2p = (UNS_32 *) mem;
+  ftl->p2l = ftl->l2p + (ftl->nblk * ftl->dpb);
+  ftl->blk = (LPC_FTL_BLK_T *) (ftl->p2l + (ftl->nblk * ftl->ppb));
+  ftl->wbuf = (UNS_8 *) (ftl->blk + ftl->nblk);
+  ftl->gcbuf = ftl->wbuf + (LPC_FTL_WBUF_PAGES * ftl->page_size);
+  ftl->iobuf = ftl->gcbuf + ftl->page_size;
+  ftl->rdbuf = ftl->iobuf + ftl->page_size;
+  ftl->sumbuf = (UNS_32 *) (ftl->rdbuf + ftl->page_size);
+
+  for (idx = 0; idx < LPC_FTL_WBUF_PAGES; idx++)
+  {
+    ftl->wslot[idx].lpage = FTL_NONE;
+    ftl->wslot[idx].stamp = 0;
+  }
+  ftl->wstamp = 0;
+  ftl->rdppn = FTL_NONE;
+  ftl->active = -1;
+  ftl->wp = 0;
+  ftl->in_gc = FALSE;
+  ftl->hold = FALSE;
+  ftl->dirty = FALSE;
+  ftl->lpages = 0;
+  ftl->ckhdr.pages = 0;
+  ftl_fill((UNS_8 *) &ftl->stats, 0, sizeof(ftl->stats));
+
+  if (ftl_mount(ftl) == _NO_ERROR)
+  {
+    return _NO_ERROR;
+  }
+
+  if (format == TRUE)
+  {
+    return ftl_format(ftl);
+  }
+
+  return _ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_sectors
+ *
+ * Purpose: Return the number of logical sectors
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *
+ * Outputs: None
+ *
+ * Returns: Number of 512 byte sectors
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+UNS_32 lpc_ftl_sectors(LPC_FTL_T *ftl)
+{
+  return ftl->lpages * ftl->spp;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_read
+ *
+ * Purpose: Read sectors
+ *
+ * Processing:
+ *     Take each sector from the write buffer if it was written there.
+ *     Read whole aligned pages directly into the caller buffer. Read
+ *     other sectors through the read buffer, which keeps the last page
+ *     read. Sectors never written read as 0xFF.
+ *
+ * Parameters:
+ *     ftl    : Pointer to FTL
+ *     sector : First sector
+ *     buff   : Where to place the sector data
+ *     count  : Number of sectors
+ *
+ * Outputs: None
+ *
+ * Returns: Number of sectors read
+ *
+ * Notes:
+ *     Reading stops at the end of the device or a failed page read.
+ *
+ **********************************************************************/
+INT_32 lpc_ftl_read(LPC_FTL_T *ftl,
+                    UNS_32 sector,
+                    void *buff,
+                    UNS_32 count)
+{
+  UNS_8 *p8 = (UNS_8 *) buff;
+  UNS_32 lpage, sec, ppn, num, done = 0;
+  INT_32 idx;
+
+  while ((count > 0) && (sector < (ftl->lpages * ftl->spp)))
+  {
+    lpage = sector / ftl->spp;
+    sec = sector % ftl->spp;
+    ppn = ftl->l2p[lpage];
+    idx = ftl_find_slot(ftl, lpage);
+    num = 1;
+
+    if ((idx >= 0) && ((ftl->wslot[idx].mask & ((UNS_32) 1 << sec)) != 0))
+    {
+      ftl_copy(p8, ftl->wbuf + ((UNS_32) idx * ftl->page_size) +
+               (sec * LPC_FTL_SECTOR_SIZE), LPC_FTL_SECTOR_SIZE);
+    }
+    else if ((sec == 0) && (count >= ftl->spp) && (idx < 0) &&
+             (((UNS_32) p8 & 0x3) == 0))
+    {
+      num = ftl->spp;
+      if (ppn == FTL_NONE)
+      {
+        ftl_fill(p8, 0xFF, ftl->page_size);
+      }
+      else if (ftl_read_page(ftl, ppn / ftl->ppb, ppn % ftl->ppb, p8) ==
+               FALSE)
+      {
+        break;
+      }
+    }
+    else if (ppn == FTL_NONE)
+    {
+      ftl_fill(p8, 0xFF, LPC_FTL_SECTOR_SIZE);
+    }
+    else
+    {
+      if (ftl->rdppn != ppn)
+      {
+        ftl->rdppn = FTL_NONE;
+        if (ftl_read_page(ftl, ppn / ftl->ppb, ppn % ftl->ppb,
+                          ftl->rdbuf) == FALSE)
+        {
+          break;
+        }
+        ftl->rdppn = ppn;
+      }
+      ftl_copy(p8, ftl->rdbuf + (sec * LPC_FTL_SECTOR_SIZE),
+               LPC_FTL_SECTOR_SIZE);
+    }
+
+    p8 += num * LPC_FTL_SECTOR_SIZE;
+    sector += num;
+    count -= num;
+    done += num;
+  }
+
+  return (INT_32) done;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_write
+ *
+ * Purpose: Write sectors
+ *
+ * Processing:
+ *     Program whole aligned pages directly from the caller buffer and
+ *     drop any buffered copy. Place other sectors in the write buffer
+ *     and program a buffered page once all its sectors are written.
+ *
+ * Parameters:
+ *     ftl    : Pointer to FTL
+ *     sector : First sector
+ *     buff   : Sector data
+ *     count  : Number of sectors
+ *
+ * Outputs: None
+ *
+ * Returns: Number of sectors written
+ *
+ * Notes:
+ *     Writing stops at the end of the device or a program failure.
+ *     Call lpc_ftl_sync() to make the data safe from a power loss.
+ *
+ **********************************************************************/
+INT_32 lpc_ftl_write(LPC_FTL_T *ftl,
+                     UNS_32 sector,
+                     void *buff,
+                     UNS_32 count)
+{
+  UNS_8 *p8 = (UNS_8 *) buff;
+  UNS_32 lpage, sec, num, done = 0, full = ((UNS_32) 1 << ftl->spp) - 1;
+  INT_32 idx;
+
+  while ((count > 0) && (sector < (ftl->lpages * ftl->spp)))
+  {
+    lpage = sector / ftl->spp;
+    sec = sector % ftl->spp;
+
+    if ((sec == 0) && (count >= ftl->spp) &&
+        (((UNS_32) p8 & 0x3) == 0))
+    {
+      num = ftl->spp;
+      idx = ftl_find_slot(ftl, lpage);
+      if (idx >= 0)
+      {
+        ftl->wslot[idx].lpage = FTL_NONE;
+      }
+
+      if (ftl_prog(ftl, lpage, p8) == FALSE)
+      {
+        break;
+      }
+    }
+    else
+    {
+      num = 1;
+      idx = ftl_get_slot(ftl, lpage);
+      if (idx < 0)
+      {
+        break;
+      }
+
+      ftl_copy(ftl->wbuf + ((UNS_32) idx * ftl->page_size) +
+               (sec * LPC_FTL_SECTOR_SIZE), p8, LPC_FTL_SECTOR_SIZE);
+      ftl->wslot[idx].mask |= (UNS_32) 1 << sec;
+      ftl->wstamp++;
+      ftl->wslot[idx].stamp = ftl->wstamp;
+
+      if ((ftl->wslot[idx].mask == full) &&
+          (ftl_flush_slot(ftl, idx) == FALSE))
+      {
+        break;
+      }
+    }
+
+    ftl->stats.host_writes += num;
+    p8 += num * LPC_FTL_SECTOR_SIZE;
+    sector += num;
+    count -= num;
+    done += num;
+  }
+
+  return (INT_32) done;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_sync
+ *
+ * Purpose: Write the write buffer and a checkpoint of the map
+ *
+ * Processing:
+ *     Program each buffered page. If the map changed since the last
+ *     checkpoint, write a new one.
+ *
+ * Parameters:
+ *     ftl : Pointer to FTL
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if all data is safe, otherwise _ERROR
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+STATUS lpc_ftl_sync(LPC_FTL_T *ftl)
+{
+  STATUS status = _NO_ERROR;
+  INT_32 idx;
+
+  for (idx = 0; idx < LPC_FTL_WBUF_PAGES; idx++)
+  {
+    if (ftl_flush_slot(ftl, idx) == FALSE)
+    {
+      status = _ERROR;
+    }
+  }
+
+  if ((ftl->dirty == TRUE) && (ftl_ckpt(ftl) != _NO_ERROR))
+  {
+    status = _ERROR;
+  }
+
+  return status;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_get_stats
+ *
+ * Purpose: Return the FTL counters
+ *
+ * Processing:
+ *     Copy the counters and find the erase count range of the blocks
+ *     in use.
+ *
+ * Parameters:
+ *     ftl   : Pointer to FTL
+ *     stats : Where to place the counters
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void lpc_ftl_get_stats(LPC_FTL_T *ftl,
+                       LPC_FTL_STATS_T *stats)
+{
+  UNS_32 block;
+
+  *stats = ftl->stats;
+  stats->min_erases = FTL_NONE;
+  stats->max_erases = 0;
+  for (block = 0; block < ftl->nblk; block++)
+  {
+    if (ftl->blk[block].state == FTL_BLK_RETIRED)
+    {
+      continue;
+    }
+
+    if (ftl->blk[block].erases < stats->min_erases)
+    {
+      stats->min_erases = ftl->blk[block].erases;
+    }
+    if (ftl->blk[block].erases > stats->max_erases)
+    {
+      stats->max_erases = ftl->blk[block].erases;
+    }
+  }
+  stats->free_blocks = ftl->nfree;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_fat_bind
+ *
+ * Purpose: Select the FTL used by the lpc_fat16 device functions
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     ftl : Pointer to a mounted FTL, or NULL
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void lpc_ftl_fat_bind(LPC_FTL_T *ftl)
+{
+  fatftl = ftl;
+  fatsector = 0;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_fat_init
+ *
+ * Purpose: lpc_fat16 device init function
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: 1 if an FTL is bound, otherwise 0
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+INT_32 lpc_ftl_fat_init(void)
+{
+  return (fatftl != NULL) ? 1 : 0;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_fat_shutdown
+ *
+ * Purpose: lpc_fat16 device shutdown function
+ *
+ * Processing:
+ *     Sync the bound FTL.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void lpc_ftl_fat_shutdown(void)
+{
+  if (fatftl != NULL)
+  {
+    lpc_ftl_sync(fatftl);
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_fat_insert_ck
+ *
+ * Purpose: lpc_fat16 device insertion check function
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: 1 if an FTL is bound, otherwise 0
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+INT_32 lpc_ftl_fat_insert_ck(void)
+{
+  return lpc_ftl_fat_init();
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_fat_ready_ck
+ *
+ * Purpose: lpc_fat16 device ready check function
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: 1 if an FTL is bound, otherwise 0
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+INT_32 lpc_ftl_fat_ready_ck(void)
+{
+  return lpc_ftl_fat_init();
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_fat_busy_ck
+ *
+ * Purpose: lpc_fat16 device busy check function
+ *
+ * Processing:
+ *     Transfers complete before the read and write functions return,
+ *     so the device is never busy.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: 0
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+INT_32 lpc_ftl_fat_busy_ck(void)
+{
+  return 0;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_fat_set_sector
+ *
+ * Purpose: lpc_fat16 device sector set function
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector : Sector for the next read or write
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void lpc_ftl_fat_set_sector(UNS_32 sector)
+{
+  fatsector = sector;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_fat_start
+ *
+ * Purpose: lpc_fat16 device read and write start function
+ *
+ * Processing:
+ *     Nothing to do, the transfer is done by the read and write
+ *     functions.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void lpc_ftl_fat_start(void)
+{
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_fat_read
+ *
+ * Purpose: lpc_fat16 device read function
+ *
+ * Processing:
+ *     Read the whole sectors in the byte count from the current
+ *     sector and move past them.
+ *
+ * Parameters:
+ *     buff  : Where to place the data
+ *     bytes : Number of bytes to read
+ *
+ * Outputs: None
+ *
+ * Returns: Number of bytes read
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+INT_32 lpc_ftl_fat_read(void *buff,
+                        INT_32 bytes)
+{
+  INT_32 done;
+
+  done = lpc_ftl_read(fatftl, fatsector, buff,
+                      (UNS_32) bytes / LPC_FTL_SECTOR_SIZE);
+  fatsector += (UNS_32) done;
+
+  return done * LPC_FTL_SECTOR_SIZE;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_fat_write
+ *
+ * Purpose: lpc_fat16 device write function
+ *
+ * Processing:
+ *     Write the whole sectors in the byte count at the current sector
+ *     and move past them.
+ *
+ * Parameters:
+ *     buff  : Data to write
+ *     bytes : Number of bytes to write
+ *
+ * Outputs: None
+ *
+ * Returns: Number of bytes written
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+INT_32 lpc_ftl_fat_write(void *buff,
+                         INT_32 bytes)
+{
+  INT_32 done;
+
+  done = lpc_ftl_write(fatftl, fatsector, buff,
+                       (UNS_32) bytes / LPC_FTL_SECTOR_SIZE);
+  fatsector += (UNS_32) done;
+
+  return done * LPC_FTL_SECTOR_SIZE;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_fat_read_multi
+ *
+ * Purpose: lpc_fat16 multi-sector read function
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector : First sector
+ *     buff   : Where to place the data
+ *     count  : Number of sectors
+ *
+ * Outputs: None
+ *
+ * Returns: Number of sectors read
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+INT_32 lpc_ftl_fat_read_multi(UNS_32 sector,
+                              void *buff,
+                              UNS_32 count)
+{
+  return lpc_ftl_read(fatftl, sector, buff, count);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ftl_fat_write_multi
+ *
+ * Purpose: lpc_fat16 multi-sector write function
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     sector : First sector
+ *     buff   : Data to write
+ *     count  : Number of sectors
+ *
+ * Outputs: None
+ *
+ * Returns: Number of sectors written
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+INT_32 lpc_ftl_fat_write_multi(UNS_32 sector,
+                               void *buff,
+                               UNS_32 count)
+{
+  return lpc_ftl_write(fatftl, sector, buff, count);
+}
@@ -35,14 +35,52 @@ typedef struct
                                 (heap_base = no previous entry) */
 } HEAP_DESCRIPTOR_T;
 
+/* Size-class mode chunk header. The chunk size includes this header
+   and is always a multiple of 4, so the 2 low bits hold the chunk
+   state. The free list links are only valid in free chunks, and free
+   chunks also have a copy of their size (footer) in the last word. */
+typedef struct sc_chunk
+{
+  UNS_32 size_flags;           /* Chunk size | SC_USED | SC_PREV_USED */
+  struct sc_chunk *next_free;  /* Next free chunk in the same class */
+  struct sc_chunk *prev_free;  /* Previous free chunk in the same class */
+} SC_CHUNK_T;
+
+/* Heap instance */
+struct lpc_heap
+{
+  HEAP_DESCRIPTOR_T *heap_base;  /* Heap base address */
+  UNS_32 heap_size_saved;        /* Heap size */
+  LPC_HEAP_MODE_T heap_mode;     /* Selected allocation mode */
+  SC_CHUNK_T *sc_bins[32];       /* Size-class mode free list heads, one
+                                    per power-of-two class */
+  UNS_32 sc_bin_map;             /* Size-class mode bitmap of non-empty
+                                    free lists */
+  SC_CHUNK_T *sc_heap_end;       /* Size-class mode end of heap
+                                    (epilogue header) */
+  UNS_32 sc_alloc_count;         /* Size-class mode number of allocated
+                                    chunks */
+  struct lpc_heap *next_heap;    /* Next created heap (0 = last) */
+#ifdef LPC_HEAP_STATS
+  LPC_HEAP_STATS_T heap_stats;   /* Recorded heap statistics */
+#endif
+};
+
 /***********************************************************************
  * Package data
  **********************************************************************/
 
-/* Heap base address */
-HEAP_DESCRIPTOR_T *heap_base;
-/* Heap size */
-UNS_32 heap_size_saved;
+/* Default heap, used by lpc_new and set up by lpc_heap_init */
+static LPC_HEAP_T default_heap;
+/* List of heaps set up with lpc_heap_create */
+static LPC_HEAP_T *heap_list;
+/* Heap used for each placement hint (0 = default heap) */
+static LPC_HEAP_T *mem_heaps[LPC_MEM_TYPES];
+
+#ifdef LPC_HEAP_STATS
+/* Timer used to measure alloc and free time */
+static UNS_64 (*heap_timer)(void);
+#endif
 
 /***********************************************************************
  * Package defines
@@ -55,6 +93,20 @@ UNS_32 heap_size_saved;
 /* Smallest heap descriptor entry */
 #define SMALLEST_ENTRY_SIZE (HEAP_HEAD_SIZE + sizeof (UNS_32))
 
+/* Size-class chunk state flags */
+#define SC_USED             0x1
+#define SC_PREV_USED        0x2
+#define SC_FLAGS_MASK       0x3
+/* Size-class chunk header size (in front of the allocated area) */
+#define SC_HEAD_SIZE        (sizeof (UNS_32))
+/* Smallest size-class chunk, must hold the links and a footer */
+#define SC_MIN_CHUNK        ((sizeof (SC_CHUNK_T) + sizeof (UNS_32) + 3) & \
+                             ~3)
+/* Size-class chunk accessors */
+#define SC_SIZE(c)          ((c)->size_flags & ~SC_FLAGS_MASK)
+#define SC_NEXT(c)          ((SC_CHUNK_T *) ((UNS_8 *) (c) + SC_SIZE(c)))
+#define SC_FOOTER(c)        ((UNS_32 *) ((UNS_8 *) (c) + SC_SIZE(c)) - 1)
+
 /***********************************************************************
  * Private functions
  **********************************************************************/
@@ -70,6 +122,7 @@ UNS_32 heap_size_saved;
  *     required size available is found.
  *
  * Parameters:
+ *     heap          : Heap instance
  *     size_in_bytes : Byte size of the requested allocation area
  *
  * Outputs: None
@@ -80,13 +133,14 @@ UNS_32 heap_size_saved;
  * Notes: None
  *
  **********************************************************************/
-HEAP_DESCRIPTOR_T *lpc_find_free_entry(UNS_32 size_in_bytes)
+HEAP_DESCRIPTOR_T *lpc_find_free_entry(LPC_HEAP_T *heap,
+                                       UNS_32 size_in_bytes)
 {
   HEAP_DESCRIPTOR_T *found_ptr;
   INT_32 found = 0;
 
   /* Start at top of list */
-  found_ptr = heap_base;
+  found_ptr = heap->heap_base;
 
   /* Loop through entries */
   while (found == 0)
@@ -127,6 +181,7 @@ HEAP_DESCRIPTOR_T *lpc_find_free_entry(UNS_32 size_in_bytes)
  *     the start of a new available heap chunk entry.
  *
  * Parameters:
+ *     heap          : Heap instance
  *     size_in_bytes : Where to insert in the linked list
  *
  * Outputs: None
@@ -138,7 +193,7 @@ HEAP_DESCRIPTOR_T *lpc_find_free_entry(UNS_32 size_in_bytes)
  * Notes: None
  *
  **********************************************************************/
-void *lpc_heap_insert_entry(UNS_32 size_in_bytes)
+void *lpc_heap_insert_entry(LPC_HEAP_T *heap, UNS_32 size_in_bytes)
 {
   HEAP_DESCRIPTOR_T *insert_ptr, *save_entry, *new_entry;
   UNS_32 heap_chunk_size, return_address = 0;
@@ -151,7 +206,7 @@ void *lpc_heap_insert_entry(UNS_32 size_in_bytes)
   }
 
   /* See if a chunk of heap memory with the required size exists */
-  insert_ptr = lpc_find_free_entry(size_in_bytes);
+  insert_ptr = lpc_find_free_entry(heap, size_in_bytes);
 
   /* Only insert the heap entry if space is available */
   if (insert_ptr != HEAP_POINTER_NULL)
@@ -212,11 +267,11 @@ void *lpc_heap_insert_entry(UNS_32 size_in_bytes)
          (new_entry->next_descriptor))->prev_descriptor =
            new_entry;
       }
-
-      /* Set return address past the heap descriptor */
-      return_address = (UNS_32) insert_ptr + HEAP_HEAD_SIZE;
     }
 
+    /* Set return address past the heap descriptor */
+    return_address = (UNS_32) insert_ptr + HEAP_HEAD_SIZE;
+
     /* Set this entire chunk as allocated */
     insert_ptr->entry_size = 0;
   }
@@ -239,6 +294,7 @@ void *lpc_heap_insert_entry(UNS_32 size_in_bytes)
  *     entry exists, the address of the heap descriptor is returned.
  *
  * Parameters:
+ *     heap            : Heap instance
  *     data_entry_addr : Address of an allocated data entry in the heap
  *
  * Outputs: None
@@ -248,9 +304,10 @@ void *lpc_heap_insert_entry(UNS_32 size_in_bytes)
  * Notes: None
  *
  **********************************************************************/
-HEAP_DESCRIPTOR_T *lpc_find_entry(UNS_32 *data_entry_addr)
+HEAP_DESCRIPTOR_T *lpc_find_entry(LPC_HEAP_T *heap,
+                                  UNS_32 *data_entry_addr)
 {
-  HEAP_DESCRIPTOR_T *search_heap_ptr = heap_base;
+  HEAP_DESCRIPTOR_T *search_heap_ptr = heap->heap_base;
   HEAP_DESCRIPTOR_T *found_heap_ptr = HEAP_POINTER_NULL;
 
   /* Loop until match is found or all entries exhausted */
@@ -288,6 +345,7 @@ HEAP_DESCRIPTOR_T *lpc_find_entry(UNS_32 *data_entry_addr)
  *      performed for each case. See the function for more details.
  *
  * Parameters:
+ *     heap            : Heap instance
  *     heap_entry_addr : Address of a data entry to return to the heap
  *                       chunk list
  *
@@ -298,13 +356,13 @@ HEAP_DESCRIPTOR_T *lpc_find_entry(UNS_32 *data_entry_addr)
  * Notes: None
  *
  **********************************************************************/
-INT_32 lpc_remove_entry(UNS_32 *heap_entry_addr)
+INT_32 lpc_remove_entry(LPC_HEAP_T *heap, UNS_32 *heap_entry_addr)
 {
   HEAP_DESCRIPTOR_T *found_ptr, *next_ptr, *prev_ptr, *saved_ptr;
   INT_32 status = 0;
 
   /* Determine if the chunk to deallocate is valid */
-  found_ptr = lpc_find_entry(heap_entry_addr);
+  found_ptr = lpc_find_entry(heap, heap_entry_addr);
 
   /* If the chunk is valid, then deallocate it */
   if (found_ptr != HEAP_POINTER_NULL)
@@ -325,13 +383,13 @@ INT_32 lpc_remove_entry(UNS_32 *heap_entry_addr)
         * The previous entry and next entry are both not used */
 
     /* First or only entry cases */
-    if (found_ptr == heap_base)
+    if (found_ptr == heap->heap_base)
     {
       if (next_ptr == HEAP_POINTER_NULL)
       {
         /* This is the only heap entry (first entry only)
            Simply restore heap size to full size */
-        found_ptr->entry_size = heap_size_saved;
+        found_ptr->entry_size = heap->heap_size_saved;
       }
       else if (next_ptr->entry_size == 0)
       {
@@ -365,7 +423,7 @@ INT_32 lpc_remove_entry(UNS_32 *heap_entry_addr)
         else
         {
           /* This entry is the only entry in the list */
-          found_ptr->entry_size = heap_size_saved;
+          found_ptr->entry_size = heap->heap_size_saved;
         }
       }
     }
@@ -377,15 +435,19 @@ INT_32 lpc_remove_entry(UNS_32 *heap_entry_addr)
       if (prev_ptr->entry_size == 0)
       {
         /* Previous descriptor is used, so just clear the
-           present entry */
-        found_ptr->entry_size = 0;
+           present entry by restoring its size up to the end of
+           the heap */
+        found_ptr->entry_size = heap->heap_size_saved -
+                                ((UNS_32) found_ptr -
+                                 (UNS_32) heap->heap_base);
       }
       else
       {
         /* Previous entry is not used, so merge this entry
            and the previous entry */
-        prev_ptr->entry_size = heap_size_saved -
-                               ((UNS_32) prev_ptr - (UNS_32) heap_base);
+        prev_ptr->entry_size = heap->heap_size_saved -
+                               ((UNS_32) prev_ptr -
+                                (UNS_32) heap->heap_base);
 
         /* Previous entry is now the last entry */
         prev_ptr->next_descriptor = HEAP_POINTER_NULL;
@@ -432,8 +494,9 @@ INT_32 lpc_remove_entry(UNS_32 *heap_entry_addr)
         {
           /* No entry after the next entry, so this entry
              will become the last entry */
-          found_ptr->entry_size = heap_size_saved -
-                                  ((UNS_32) found_ptr - (UNS_32) heap_base);
+          found_ptr->entry_size = heap->heap_size_saved -
+                                  ((UNS_32) found_ptr -
+                                   (UNS_32) heap->heap_base);
           found_ptr->next_descriptor = HEAP_POINTER_NULL;
         }
         else
@@ -461,8 +524,9 @@ INT_32 lpc_remove_entry(UNS_32 *heap_entry_addr)
         {
           /* No entry after the next entry, so this entry
              will become the last entry */
-          prev_ptr->entry_size = heap_size_saved -
-                                 ((UNS_32) prev_ptr - (UNS_32) heap_base);
+          prev_ptr->entry_size = heap->heap_size_saved -
+                                 ((UNS_32) prev_ptr -
+                                  (UNS_32) heap->heap_base);
           prev_ptr->next_descriptor = HEAP_POINTER_NULL;
         }
         else
@@ -487,166 +551,414 @@ INT_32 lpc_remove_entry(UNS_32 *heap_entry_addr)
 }
 
 /***********************************************************************
- * Public functions
+ *
+ * Function: lpc_sc_msb
+ *
+ * Purpose: Returns the index of the most significant set bit
+ *
+ * Processing:
+ *     A fixed 5 step binary search is used to locate the highest set
+ *     bit, so the cost does not depend on the value.
+ *
+ * Parameters:
+ *     value : Value to check, must not be 0
+ *
+ * Outputs: None
+ *
+ * Returns: Bit index (0 to 31) of the most significant set bit.
+ *
+ * Notes: None
+ *
  **********************************************************************/
+static UNS_32 lpc_sc_msb(UNS_32 value)
+{
+  UNS_32 idx = 0;
+
+  if ((value & 0xFFFF0000) != 0)
+  {
+    value = value >> 16;
+    idx += 16;
+  }
+  if ((value & 0xFF00) != 0)
+  {
+    value = value >> 8;
+    idx += 8;
+  }
+  if ((value & 0xF0) != 0)
+  {
+    value = value >> 4;
+    idx += 4;
+  }
+  if ((value & 0xC) != 0)
+  {
+    value = value >> 2;
+    idx += 2;
+  }
+  if ((value & 0x2) != 0)
+  {
+    idx += 1;
+  }
+
+  return idx;
+}
 
 /***********************************************************************
  *
- * Function: lpc_get_heapsize
+ * Function: lpc_sc_link
  *
- * Purpose: Returns the size of the heap.
+ * Purpose: Adds a free chunk to the head of its size class list
  *
  * Processing:
- *     See function.
+ *     The size class is the index of the most significant bit of the
+ *     chunk size. The chunk is pushed on the head of the class list
+ *     and the class is flagged as non-empty in the bin bitmap.
  *
- * Parameters: None
+ * Parameters:
+ *     heap  : Heap instance
+ *     chunk : Free chunk to add (size must already be set)
  *
  * Outputs: None
  *
- * Returns: The size of the heap area in bytes.
+ * Returns: Nothing
  *
  * Notes: None
  *
  **********************************************************************/
-UNS_32 lpc_get_heapsize(void)
+static void lpc_sc_link(LPC_HEAP_T *heap, SC_CHUNK_T *chunk)
 {
-  return heap_size_saved;
+  UNS_32 cls = lpc_sc_msb(SC_SIZE(chunk));
+
+  chunk->prev_free = (SC_CHUNK_T *) 0;
+  chunk->next_free = heap->sc_bins[cls];
+  if (heap->sc_bins[cls] != (SC_CHUNK_T *) 0)
+  {
+    heap->sc_bins[cls]->prev_free = chunk;
+  }
+  heap->sc_bins[cls] = chunk;
+  heap->sc_bin_map |= _BIT(cls);
 }
 
 /***********************************************************************
  *
- * Function: lpc_get_largest_chunk
+ * Function: lpc_sc_unlink
  *
- * Purpose:
- *     Returns the largest available chunk in the heap.
+ * Purpose: Removes a free chunk from its size class list
  *
  * Processing:
- *     This function traverses through the heap list. If an entry has an
- *     available size of greater than 0 bytes, then the entry is assumed
- *     as free and the size of the chunk is compared to the running size
- *     count. If the size is larger, the running size count is updated
- *     with the new size.
+ *     The chunk is unlinked using its double links. If the class list
+ *     becomes empty, the class bit in the bin bitmap is cleared.
  *
- * Parameters: None
+ * Parameters:
+ *     heap  : Heap instance
+ *     chunk : Free chunk to remove
  *
  * Outputs: None
  *
- * Returns: The size of the largest chunk available in the heap area
- *          in bytes.
+ * Returns: Nothing
  *
  * Notes: None
  *
  **********************************************************************/
-UNS_32 lpc_get_largest_chunk(void)
+static void lpc_sc_unlink(LPC_HEAP_T *heap, SC_CHUNK_T *chunk)
 {
-  HEAP_DESCRIPTOR_T *heap_ptr;
-  UNS_32 max_chunk_size = 0;
-
-  /* Start at top of heap list */
-  heap_ptr = heap_base;
+  UNS_32 cls = lpc_sc_msb(SC_SIZE(chunk));
 
-  /* Go through all the entries */
-  while (heap_ptr != HEAP_POINTER_NULL)
+  if (chunk->prev_free != (SC_CHUNK_T *) 0)
   {
-    if (heap_ptr->entry_size > max_chunk_size)
+    chunk->prev_free->next_free = chunk->next_free;
+  }
+  else
+  {
+    heap->sc_bins[cls] = chunk->next_free;
+    if (heap->sc_bins[cls] == (SC_CHUNK_T *) 0)
     {
-      /* This chunk is larger than the last saved chunk size */
-      max_chunk_size = heap_ptr->entry_size;
+      heap->sc_bin_map &= ~_BIT(cls);
     }
+  }
 
-    /* Next heap entry */
-    heap_ptr = heap_ptr->next_descriptor;
+  if (chunk->next_free != (SC_CHUNK_T *) 0)
+  {
+    chunk->next_free->prev_free = chunk->prev_free;
   }
+}
 
-  /* Largest available chunk size is adjusted by the required space
-     needed for the heap descriptor */
-  return max_chunk_size;
+/***********************************************************************
+ *
+ * Function: lpc_sc_init
+ *
+ * Purpose: Setup the heap area for size-class mode
+ *
+ * Processing:
+ *     The heap area is aligned to a 32-bit boundary. The last word of
+ *     the heap is reserved for an always allocated epilogue header
+ *     that stops coalescing at the end of the heap. The remaining area
+ *     is added as a single free chunk.
+ *
+ * Parameters:
+ *     heap      : Heap instance
+ *     base_addr : Base address of where heap starts
+ *     heap_size : Size of heap area in bytes
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void lpc_sc_init(LPC_HEAP_T *heap,
+                        void *base_addr,
+                        UNS_32 heap_size)
+{
+  SC_CHUNK_T *chunk;
+  UNS_32 adjust, idx;
+
+  for (idx = 0; idx < 32; idx++)
+  {
+    heap->sc_bins[idx] = (SC_CHUNK_T *) 0;
+  }
+  heap->sc_bin_map = 0;
+  heap->sc_alloc_count = 0;
+
+  /* Align the heap start and size to 32-bits */
+  adjust = (0 - (UNS_32) (UNS_8 *) base_addr) & 0x3;
+  chunk = (SC_CHUNK_T *) ((UNS_8 *) base_addr + adjust);
+  heap_size = (heap_size - adjust) & ~0x3;
+
+  /* Epilogue header at the end of the heap */
+  heap->sc_heap_end = (SC_CHUNK_T *) ((UNS_8 *) chunk + heap_size -
+                                      SC_HEAD_SIZE);
+
+  if (heap_size < (SC_MIN_CHUNK + SC_HEAD_SIZE))
+  {
+    /* Too small to hold any chunk */
+    heap->sc_heap_end = chunk;
+    heap->sc_heap_end->size_flags = SC_USED | SC_PREV_USED;
+  }
+  else
+  {
+    chunk->size_flags = (heap_size - SC_HEAD_SIZE) | SC_PREV_USED;
+    *SC_FOOTER(chunk) = SC_SIZE(chunk);
+    heap->sc_heap_end->size_flags = SC_USED;
+    lpc_sc_link(heap, chunk);
+  }
 }
 
 /***********************************************************************
  *
- * Function: lpc_get_allocated_count
+ * Function: lpc_sc_new
  *
- * Purpose:
- *     Return the number of allocated items in the heap.
+ * Purpose: Get an allocated area from the heap in size-class mode
  *
  * Processing:
- *     This function traverses through the heap list. If an entry has
- *     an available size of 0 bytes, then the entry is assumed as
- *     allocated and the allocated count is incremented.
+ *     The requested size is rounded up to a 32-bit multiple and the
+ *     chunk header is added. The head of the free list for the size
+ *     class of the request is used if it is large enough, otherwise
+ *     the first non-empty larger class is found from the bin bitmap;
+ *     any chunk in a larger class is guaranteed to fit. The chunk is
+ *     split if the remainder can hold another chunk, and the remainder
+ *     is returned to its own size class list.
  *
- * Parameters: None
+ * Parameters:
+ *     heap          : Heap instance
+ *     size_in_bytes : Byte size of the requested allocation area
  *
  * Outputs: None
  *
- * Returns: The number of allocated heap entries.
+ * Returns: A pointer to the allocated data area or NULL if there is
+ *          no room for the data entry.
  *
  * Notes: None
  *
  **********************************************************************/
-UNS_32 lpc_get_allocated_count(void)
+static void *lpc_sc_new(LPC_HEAP_T *heap, UNS_32 size_in_bytes)
 {
-  HEAP_DESCRIPTOR_T *heap_ptr;
-  UNS_32 heap_entries = 0;
+  SC_CHUNK_T *chunk, *rem;
+  UNS_32 req, cls, mask, chunk_size;
 
-  /* Start at top of heap list */
-  heap_ptr = heap_base;
+  /* Chunk size needed, including the header */
+  req = ((size_in_bytes + 3) & ~0x3) + SC_HEAD_SIZE;
+  if ((req < size_in_bytes) || (req > 0x7FFFFFFF))
+  {
+    /* Request wrapped around or is unreasonably large */
+    return (void *) 0;
+  }
+  if (req < SC_MIN_CHUNK)
+  {
+    req = SC_MIN_CHUNK;
+  }
 
-  /* Go through all the entries */
-  while (heap_ptr != HEAP_POINTER_NULL)
+  /* Try the head of the matching class first */
+  cls = lpc_sc_msb(req);
+  chunk = heap->sc_bins[cls];
+  if ((chunk == (SC_CHUNK_T *) 0) || (SC_SIZE(chunk) < req))
   {
-    if (heap_ptr->entry_size == 0)
+    /* Use the first chunk of the next larger non-empty class */
+    if (cls >= 31)
     {
-      /* This is an used chunk */
-      heap_entries++;
+      return (void *) 0;
+    }
+    mask = heap->sc_bin_map & ~(_BIT(cls + 1) - 1);
+    if (mask == 0)
+    {
+      return (void *) 0;
     }
+    chunk = heap->sc_bins[lpc_sc_msb(mask & (~mask + 1))];
+  }
 
-    /* Next heap entry */
-    heap_ptr = heap_ptr->next_descriptor;
+  lpc_sc_unlink(heap, chunk);
+  chunk_size = SC_SIZE(chunk);
+
+  if ((chunk_size - req) >= SC_MIN_CHUNK)
+  {
+    /* Split off the unused part as a new free chunk */
+    rem = (SC_CHUNK_T *) ((UNS_8 *) chunk + req);
+    rem->size_flags = (chunk_size - req) | SC_PREV_USED;
+    *SC_FOOTER(rem) = SC_SIZE(rem);
+    lpc_sc_link(heap, rem);
+    chunk_size = req;
+  }
+  else
+  {
+    /* Whole chunk is used, tell the following chunk */
+    SC_NEXT(chunk)->size_flags |= SC_PREV_USED;
   }
 
-  /* Largest available chunk size is adjusted by the required space
-     needed for the heap descriptor */
-  return heap_entries;
+  chunk->size_flags = chunk_size | SC_USED |
+                      (chunk->size_flags & SC_PREV_USED);
+  heap->sc_alloc_count++;
+
+  return (UNS_8 *) chunk + SC_HEAD_SIZE;
 }
 
 /***********************************************************************
  *
- * Function: lpc_get_heap_base
+ * Function: lpc_sc_free
  *
- * Purpose: Return the heap base address.
+ * Purpose: Returns an allocated area to the heap in size-class mode
  *
  * Processing:
- *     See function.
+ *     The address is checked against the heap bounds and the chunk
+ *     state. The chunk is merged with the following chunk if that is
+ *     free, and with the previous chunk if the chunk header indicates
+ *     it is free (its size is read from its footer). The merged chunk
+ *     is added to its size class list.
  *
- * Parameters: None
+ * Parameters:
+ *     heap      : Heap instance
+ *     free_addr : Address of allocated entry to return to heap
  *
  * Outputs: None
  *
- * Returns: The base address of where heap memory starts.
+ * Returns: '1' if the entry was removed, otherwise '0'.
  *
  * Notes: None
  *
  **********************************************************************/
-void *lpc_get_heap_base(void)
+static INT_32 lpc_sc_free(LPC_HEAP_T *heap, void *free_addr)
 {
-  return heap_base;
+  SC_CHUNK_T *chunk, *next, *prev;
+  UNS_32 size;
+
+  chunk = (SC_CHUNK_T *) ((UNS_8 *) free_addr - SC_HEAD_SIZE);
+  if (((UNS_8 *) chunk < (UNS_8 *) heap->heap_base) ||
+      (chunk >= heap->sc_heap_end) ||
+      (((UNS_32) (UNS_8 *) free_addr & 0x3) != 0) ||
+      ((chunk->size_flags & SC_USED) == 0))
+  {
+    /* Not an allocated chunk of this heap */
+    return 0;
+  }
+
+  size = SC_SIZE(chunk);
+
+  /* Merge with the following chunk */
+  next = SC_NEXT(chunk);
+  if ((next->size_flags & SC_USED) == 0)
+  {
+    lpc_sc_unlink(heap, next);
+    size += SC_SIZE(next);
+  }
+
+  /* Merge with the previous chunk */
+  if ((chunk->size_flags & SC_PREV_USED) == 0)
+  {
+    prev = (SC_CHUNK_T *) ((UNS_8 *) chunk -
+                           *((UNS_32 *) chunk - 1));
+    lpc_sc_unlink(heap, prev);
+    size += SC_SIZE(prev);
+    chunk = prev;
+  }
+
+  /* Free chunks never have a free neighbour, so the previous chunk
+     is always in use here */
+  chunk->size_flags = size | SC_PREV_USED;
+  *SC_FOOTER(chunk) = size;
+  SC_NEXT(chunk)->size_flags &= ~SC_PREV_USED;
+  lpc_sc_link(heap, chunk);
+  heap->sc_alloc_count--;
+
+  return 1;
 }
 
 /***********************************************************************
  *
- * Function: lpc_heap_init
+ * Function: lpc_sc_largest_chunk
  *
- * Purpose: Setup the heap area.
+ * Purpose: Returns the largest free chunk in size-class mode
  *
  * Processing:
- *     The heap base address and size counters are set with the passed
- *     parameter values. The first entry of the heap is set up with an
- *     unallocated heap list entry.
+ *     The largest chunk can only be in the highest non-empty class,
+ *     so only that class list is traversed.
  *
  * Parameters:
+ *     heap : Heap instance
+ *
+ * Outputs: None
+ *
+ * Returns: The size of the largest free chunk in bytes.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 lpc_sc_largest_chunk(LPC_HEAP_T *heap)
+{
+  SC_CHUNK_T *chunk;
+  UNS_32 max_chunk_size = 0;
+
+  if (heap->sc_bin_map != 0)
+  {
+    chunk = heap->sc_bins[lpc_sc_msb(heap->sc_bin_map)];
+    while (chunk != (SC_CHUNK_T *) 0)
+    {
+      if (SC_SIZE(chunk) > max_chunk_size)
+      {
+        max_chunk_size = SC_SIZE(chunk);
+      }
+      chunk = chunk->next_free;
+    }
+  }
+
+  return max_chunk_size;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_heap_setup
+ *
+ * Purpose: Setup a heap instance
+ *
+ * Processing:
+ *     The heap base address, size and mode are saved. For the
+ *     first-fit mode, the first entry of the heap is set up with an
+ *     unallocated heap list entry. For the size-class mode, the heap
+ *     is set up as a single free chunk on the size class lists.
+ *
+ * Parameters:
+ *     heap      : Heap instance
  *     base_addr : Base address of where heap starts
  *     heap_size : Size of heap area in bytes
+ *     mode      : LPC_HEAP_FIRST_FIT or LPC_HEAP_SIZE_CLASS
  *
  * Outputs: None
  *
@@ -655,13 +967,33 @@ void *lpc_get_heap_base(void)
  * Notes: None
  *
  **********************************************************************/
-void lpc_heap_init(void *base_addr, UNS_32 heap_size)
+static void lpc_heap_setup(LPC_HEAP_T *heap,
+                           void *base_addr,
+                           UNS_32 heap_size,
+                           LPC_HEAP_MODE_T mode)
 {
   HEAP_DESCRIPTOR_T *heap_ptr;
+#ifdef LPC_HEAP_STATS
+  UNS_8 *clr = (UNS_8 *) &heap->heap_stats;
+  UNS_32 idx;
+
+  /* A new heap starts with no recorded statistics */
+  for (idx = 0; idx < sizeof(heap->heap_stats); idx++)
+  {
+    clr[idx] = 0;
+  }
+#endif
+
+  /* Save heap base address, size and mode */
+  heap->heap_base = (HEAP_DESCRIPTOR_T *) base_addr;
+  heap->heap_size_saved = heap_size;
+  heap->heap_mode = mode;
 
-  /* Save heap base address and size */
-  heap_base = (HEAP_DESCRIPTOR_T *) base_addr;
-  heap_size_saved = heap_size;
+  if (mode == LPC_HEAP_SIZE_CLASS)
+  {
+    lpc_sc_init(heap, base_addr, heap_size);
+    return;
+  }
 
   /* Setup first link in heap list */
   heap_ptr = (HEAP_DESCRIPTOR_T *) base_addr;
@@ -678,49 +1010,1257 @@ void lpc_heap_init(void *base_addr, UNS_32 heap_size)
 
 /***********************************************************************
  *
- * Function: lpc_new
+ * Function: lpc_heap_owner
  *
- * Purpose: Get an allocated area from the heap.
+ * Purpose: Finds the heap that contains an address
+ *
+ * Processing:
+ *     The heaps set up with lpc_heap_create are checked for an area
+ *     that contains the address. If none does, the default heap is
+ *     used.
+ *
+ * Parameters:
+ *     addr : Address of an allocated data entry
+ *
+ * Outputs: None
+ *
+ * Returns: The heap the address belongs to.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static LPC_HEAP_T *lpc_heap_owner(void *addr)
+{
+  LPC_HEAP_T *heap = heap_list;
+
+  while (heap != (LPC_HEAP_T *) 0)
+  {
+    if (((UNS_8 *) addr >= (UNS_8 *) heap->heap_base) &&
+        ((UNS_8 *) addr < ((UNS_8 *) heap->heap_base +
+                           heap->heap_size_saved)))
+    {
+      return heap;
+    }
+    heap = heap->next_heap;
+  }
+
+  return &default_heap;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_heap_alloc
+ *
+ * Purpose: Get an allocated area from the heap in the active mode
  *
  * Processing:
  *     See function.
  *
  * Parameters:
- *     size_in_bytes : Byte size of the requested allocation chunk
+ *     heap          : Heap instance
+ *     size_in_bytes : Byte size of the requested allocation area
  *
  * Outputs: None
  *
- * Returns: A pointer to the allocated chunk, or '0' if no room is
- *          available.
+ * Returns: A pointer to the allocated data area or NULL if there is
+ *          no room for the data entry.
  *
  * Notes: None
  *
  **********************************************************************/
-void *lpc_new(UNS_32 size_in_bytes)
+static void *lpc_heap_alloc(LPC_HEAP_T *heap, UNS_32 size_in_bytes)
 {
-  return (void *) lpc_heap_insert_entry(size_in_bytes);
+  if (heap->heap_mode == LPC_HEAP_SIZE_CLASS)
+  {
+    return lpc_sc_new(heap, size_in_bytes);
+  }
+
+  return (void *) lpc_heap_insert_entry(heap, size_in_bytes);
 }
 
 /***********************************************************************
  *
- * Function: lpc_free
+ * Function: lpc_heap_release
  *
- * Purpose: Returns an allocated entry of memory to the heap.
+ * Purpose: Returns an allocated area to the heap in the active mode
  *
  * Processing:
  *     See function.
  *
  * Parameters:
+ *     heap      : Heap instance
  *     free_addr : Address of allocated entry to return to heap
  *
  * Outputs: None
  *
- * Returns: '1' if the entry was deleted, otherwise '0'.
+ * Returns: '1' if the entry was removed, otherwise '0'.
  *
  * Notes: None
  *
  **********************************************************************/
-INT_32 lpc_free(void *free_addr)
+static INT_32 lpc_heap_release(LPC_HEAP_T *heap, void *free_addr)
+{
+  if (heap->heap_mode == LPC_HEAP_SIZE_CLASS)
+  {
+    return lpc_sc_free(heap, free_addr);
+  }
+
+  return lpc_remove_entry(heap, free_addr);
+}
+
+#ifdef LPC_HEAP_STATS
+/***********************************************************************
+ *
+ * Function: lpc_entry_size
+ *
+ * Purpose: Returns the chunk size of an allocated data entry
+ *
+ * Processing:
+ *     In size-class mode, the size is read from the chunk header. In
+ *     first-fit mode, the heap descriptor is found and the size is the
+ *     distance to the next descriptor or to the end of the heap.
+ *
+ * Parameters:
+ *     heap            : Heap instance
+ *     data_entry_addr : Address of an allocated data entry in the heap
+ *
+ * Outputs: None
+ *
+ * Returns: The chunk size in bytes including the header, or 0 if the
+ *          address is not an allocated entry.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 lpc_entry_size(LPC_HEAP_T *heap, void *data_entry_addr)
+{
+  HEAP_DESCRIPTOR_T *entry;
+  SC_CHUNK_T *chunk;
+  UNS_32 size = 0;
+
+  if (heap->heap_mode == LPC_HEAP_SIZE_CLASS)
+  {
+    chunk = (SC_CHUNK_T *) ((UNS_8 *) data_entry_addr - SC_HEAD_SIZE);
+    if (((UNS_8 *) chunk >= (UNS_8 *) heap->heap_base) &&
+        (chunk < heap->sc_heap_end) &&
+        ((chunk->size_flags & SC_USED) != 0))
+    {
+      size = SC_SIZE(chunk);
+    }
+  }
+  else
+  {
+    entry = lpc_find_entry(heap, data_entry_addr);
+    if (entry != HEAP_POINTER_NULL)
+    {
+      if (entry->next_descriptor != HEAP_POINTER_NULL)
+      {
+        size = (UNS_8 *) entry->next_descriptor - (UNS_8 *) entry;
+      }
+      else
+      {
+        size = ((UNS_8 *) heap->heap_base + heap->heap_size_saved) -
+               (UNS_8 *) entry;
+      }
+    }
+  }
+
+  return size;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_stats_add_free
+ *
+ * Purpose: Adds a free chunk to the computed statistics
+ *
+ * Processing:
+ *     The chunk is counted in the histogram bucket of its size and
+ *     the free byte and largest free chunk values are updated.
+ *
+ * Parameters:
+ *     stats : Statistics to update
+ *     size  : Free chunk size in bytes
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void lpc_stats_add_free(LPC_HEAP_STATS_T *stats, UNS_32 size)
+{
+  UNS_32 bucket;
+
+  if (size != 0)
+  {
+    bucket = lpc_sc_msb(size);
+    if (bucket >= LPC_HEAP_HIST_BUCKETS)
+    {
+      bucket = LPC_HEAP_HIST_BUCKETS - 1;
+    }
+    stats->free_hist[bucket]++;
+
+    stats->free_bytes += size;
+    if (size > stats->largest_free)
+    {
+      stats->largest_free = size;
+    }
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_stats_put32
+ *
+ * Purpose: Writes a 32-bit value in little-endian byte order
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     buff : Where to write the value
+ *     val  : Value to write
+ *
+ * Outputs: None
+ *
+ * Returns: Pointer to the byte following the value.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_8 *lpc_stats_put32(UNS_8 *buff, UNS_32 val)
+{
+  buff[0] = (UNS_8) val;
+  buff[1] = (UNS_8) (val >> 8);
+  buff[2] = (UNS_8) (val >> 16);
+  buff[3] = (UNS_8) (val >> 24);
+
+  return buff + 4;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_heap_new_tag
+ *
+ * Purpose: Get an allocated area from a heap for a call site
+ *
+ * Processing:
+ *     The allocation is timed with the statistics timer. On success,
+ *     the chunk size is added to the bytes in use and the peak value
+ *     is updated. The allocation is then added to the entry of the
+ *     call site, creating the entry if needed.
+ *
+ * Parameters:
+ *     heap          : Heap instance
+ *     size_in_bytes : Byte size of the requested allocation chunk
+ *     file          : Call site file name (0 = untagged)
+ *     line          : Call site line number
+ *
+ * Outputs: None
+ *
+ * Returns: A pointer to the allocated chunk, or '0' if no room is
+ *          available.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void *lpc_heap_new_tag(LPC_HEAP_T *heap,
+                              UNS_32 size_in_bytes,
+                              const CHAR *file,
+                              UNS_32 line)
+{
+  LPC_HEAP_TAG_STATS_T *tag = (LPC_HEAP_TAG_STATS_T *) 0;
+  void *new_addr;
+  UNS_64 start = 0;
+  UNS_32 size, idx;
+
+  if (heap_timer != 0)
+  {
+    start = heap_timer();
+  }
+  new_addr = lpc_heap_alloc(heap, size_in_bytes);
+  if (heap_timer != 0)
+  {
+    heap->heap_stats.alloc_ticks += heap_timer() - start;
+  }
+
+  heap->heap_stats.alloc_calls++;
+  if (new_addr == (void *) 0)
+  {
+    heap->heap_stats.failed_allocs++;
+    return new_addr;
+  }
+
+  size = lpc_entry_size(heap, new_addr);
+  heap->heap_stats.bytes_in_use += size;
+  if (heap->heap_stats.bytes_in_use > heap->heap_stats.peak_bytes)
+  {
+    heap->heap_stats.peak_bytes = heap->heap_stats.bytes_in_use;
+  }
+
+  /* Find or add the call site entry */
+  for (idx = 0; idx < heap->heap_stats.num_tags; idx++)
+  {
+    if ((heap->heap_stats.tags[idx].file == file) &&
+        (heap->heap_stats.tags[idx].line == line))
+    {
+      tag = &heap->heap_stats.tags[idx];
+    }
+  }
+  if ((tag == (LPC_HEAP_TAG_STATS_T *) 0) &&
+      (heap->heap_stats.num_tags < LPC_HEAP_MAX_TAGS))
+  {
+    tag = &heap->heap_stats.tags[heap->heap_stats.num_tags];
+    tag->file = file;
+    tag->line = line;
+    heap->heap_stats.num_tags++;
+  }
+
+  if (tag != (LPC_HEAP_TAG_STATS_T *) 0)
+  {
+    tag->allocs++;
+    tag->bytes += size;
+  }
+  else
+  {
+    heap->heap_stats.untracked_allocs++;
+  }
+
+  return new_addr;
+}
+#endif
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: lpc_get_heapsize
+ *
+ * Purpose: Returns the size of the heap.
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: The size of the heap area in bytes.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+UNS_32 lpc_get_heapsize(void)
+{
+  return default_heap.heap_size_saved;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_get_largest_chunk
+ *
+ * Purpose:
+ *     Returns the largest available chunk in the default heap.
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: The size of the largest chunk available in the heap area
+ *          in bytes.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+UNS_32 lpc_get_largest_chunk(void)
+{
+  return lpc_get_largest_chunk_in(&default_heap);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_get_largest_chunk_in
+ *
+ * Purpose:
+ *     Returns the largest available chunk in the heap.
+ *
+ * Processing:
+ *     In size-class mode, only the highest non-empty class is checked.
+ *     Otherwise, this function traverses through the heap list. If an
+ *     entry has an available size of greater than 0 bytes, then the
+ *     entry is assumed as free and the size of the chunk is compared
+ *     to the running size count. If the size is larger, the running
+ *     size count is updated with the new size.
+ *
+ * Parameters:
+ *     heap : Heap instance
+ *
+ * Outputs: None
+ *
+ * Returns: The size of the largest chunk available in the heap area
+ *          in bytes.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+UNS_32 lpc_get_largest_chunk_in(LPC_HEAP_T *heap)
+{
+  HEAP_DESCRIPTOR_T *heap_ptr;
+  UNS_32 max_chunk_size = 0;
+
+  if (heap->heap_mode == LPC_HEAP_SIZE_CLASS)
+  {
+    return lpc_sc_largest_chunk(heap);
+  }
+
+  /* Start at top of heap list */
+  heap_ptr = heap->heap_base;
+
+  /* Go through all the entries */
+  while (heap_ptr != HEAP_POINTER_NULL)
+  {
+    if (heap_ptr->entry_size > max_chunk_size)
+    {
+      /* This chunk is larger than the last saved chunk size */
+      max_chunk_size = heap_ptr->entry_size;
+    }
+
+    /* Next heap entry */
+    heap_ptr = heap_ptr->next_descriptor;
+  }
+
+  /* Largest available chunk size is adjusted by the required space
+     needed for the heap descriptor */
+  return max_chunk_size;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_get_allocated_count
+ *
+ * Purpose:
+ *     Return the number of allocated items in the default heap.
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: The number of allocated heap entries.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+UNS_32 lpc_get_allocated_count(void)
+{
+  return lpc_get_allocated_count_in(&default_heap);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_get_allocated_count_in
+ *
+ * Purpose:
+ *     Return the number of allocated items in the heap.
+ *
+ * Processing:
+ *     In size-class mode, a running allocation count is returned.
+ *     Otherwise, this function traverses through the heap list. If an
+ *     entry has an available size of 0 bytes, then the entry is
+ *     assumed as allocated and the allocated count is incremented.
+ *
+ * Parameters:
+ *     heap : Heap instance
+ *
+ * Outputs: None
+ *
+ * Returns: The number of allocated heap entries.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+UNS_32 lpc_get_allocated_count_in(LPC_HEAP_T *heap)
+{
+  HEAP_DESCRIPTOR_T *heap_ptr;
+  UNS_32 heap_entries = 0;
+
+  if (heap->heap_mode == LPC_HEAP_SIZE_CLASS)
+  {
+    return heap->sc_alloc_count;
+  }
+
+  /* Start at top of heap list */
+  heap_ptr = heap->heap_base;
+
+  /* Go through all the entries */
+  while (heap_ptr != HEAP_POINTER_NULL)
+  {
+    if (heap_ptr->entry_size == 0)
+    {
+      /* This is an used chunk */
+      heap_entries++;
+    }
+
+    /* Next heap entry */
+    heap_ptr = heap_ptr->next_descriptor;
+  }
+
+  /* Largest available chunk size is adjusted by the required space
+     needed for the heap descriptor */
+  return heap_entries;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_get_heap_base
+ *
+ * Purpose: Return the heap base address.
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: The base address of where heap memory starts.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void *lpc_get_heap_base(void)
+{
+  return default_heap.heap_base;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_heap_init
+ *
+ * Purpose: Setup the heap area.
+ *
+ * Processing:
+ *     The heap base address and size counters are set with the passed
+ *     parameter values. The first entry of the heap is set up with an
+ *     unallocated heap list entry.
+ *
+ * Parameters:
+ *     base_addr : Base address of where heap starts
+ *     heap_size : Size of heap area in bytes
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void lpc_heap_init(void *base_addr, UNS_32 heap_size)
+{
+  lpc_heap_init_mode(base_addr, heap_size, LPC_HEAP_FIRST_FIT);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_heap_init_mode
+ *
+ * Purpose: Setup the heap area with a specific allocation mode.
+ *
+ * Processing:
+ *     The default heap used by lpc_new is set up with the passed
+ *     area and mode.
+ *
+ * Parameters:
+ *     base_addr : Base address of where heap starts
+ *     heap_size : Size of heap area in bytes
+ *     mode      : LPC_HEAP_FIRST_FIT or LPC_HEAP_SIZE_CLASS
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: The mode must not be changed while allocations are active.
+ *
+ **********************************************************************/
+void lpc_heap_init_mode(void *base_addr,
+                        UNS_32 heap_size,
+                        LPC_HEAP_MODE_T mode)
+{
+  lpc_heap_setup(&default_heap, base_addr, heap_size, mode);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_heap_create
+ *
+ * Purpose: Setup an additional heap area.
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     base_addr : Base address of where heap starts
+ *     heap_size : Size of heap area in bytes
+ *
+ * Outputs: None
+ *
+ * Returns: The heap instance, or '0' if the area is too small.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+LPC_HEAP_T *lpc_heap_create(void *base_addr, UNS_32 heap_size)
+{
+  return lpc_heap_create_mode(base_addr, heap_size, LPC_HEAP_FIRST_FIT);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_heap_create_mode
+ *
+ * Purpose: Setup an additional heap area with a specific allocation
+ *          mode.
+ *
+ * Processing:
+ *     The heap instance is placed at the 32-bit aligned start of the
+ *     area and the remaining area is set up as the heap. The heap is
+ *     added to the list of heaps searched by lpc_free.
+ *
+ * Parameters:
+ *     base_addr : Base address of where heap starts
+ *     heap_size : Size of heap area in bytes
+ *     mode      : LPC_HEAP_FIRST_FIT or LPC_HEAP_SIZE_CLASS
+ *
+ * Outputs: None
+ *
+ * Returns: The heap instance, or '0' if the area is too small.
+ *
+ * Notes: The heap area must not overlap the default heap or another
+ *        heap.
+ *
+ **********************************************************************/
+LPC_HEAP_T *lpc_heap_create_mode(void *base_addr,
+                                 UNS_32 heap_size,
+                                 LPC_HEAP_MODE_T mode)
+{
+  LPC_HEAP_T *heap, *search;
+  UNS_32 adjust, head_size;
+
+  /* Space used by the instance, including the alignment of the area
+     start */
+  adjust = (0 - (UNS_32) (UNS_8 *) base_addr) & 0x3;
+  head_size = adjust + ((sizeof(LPC_HEAP_T) + 3) & ~0x3);
+  if (heap_size < (head_size + SC_MIN_CHUNK + SC_HEAD_SIZE))
+  {
+    return (LPC_HEAP_T *) 0;
+  }
+
+  heap = (LPC_HEAP_T *) ((UNS_8 *) base_addr + adjust);
+  lpc_heap_setup(heap, (UNS_8 *) base_addr + head_size,
+                 heap_size - head_size, mode);
+
+  /* Add the heap to the list if it is not already there */
+  search = heap_list;
+  while ((search != (LPC_HEAP_T *) 0) && (search != heap))
+  {
+    search = search->next_heap;
+  }
+  if (search == (LPC_HEAP_T *) 0)
+  {
+    heap->next_heap = heap_list;
+    heap_list = heap;
+  }
+
+  return heap;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_heap_set_placement
+ *
+ * Purpose: Set the heap used for a placement hint.
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     mem_type : Placement hint
+ *     heap     : Heap to use for the hint (0 = default heap)
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void lpc_heap_set_placement(LPC_MEM_TYPE_T mem_type, LPC_HEAP_T *heap)
+{
+  if ((UNS_32) mem_type < LPC_MEM_TYPES)
+  {
+    mem_heaps[mem_type] = heap;
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_heap_new_site
+ *
+ * Purpose: Get an allocated area from a heap for a call site.
+ *
+ * Processing:
+ *     The call site is recorded only when the heap statistics are
+ *     built in.
+ *
+ * Parameters:
+ *     heap          : Heap instance
+ *     size_in_bytes : Byte size of the requested allocation chunk
+ *     file          : Call site file name (0 = untagged)
+ *     line          : Call site line number
+ *
+ * Outputs: None
+ *
+ * Returns: A pointer to the allocated chunk, or '0' if no room is
+ *          available.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void *lpc_heap_new_site(LPC_HEAP_T *heap,
+                               UNS_32 size_in_bytes,
+                               const CHAR *file,
+                               UNS_32 line)
+{
+#ifdef LPC_HEAP_STATS
+  return lpc_heap_new_tag(heap, size_in_bytes, file, line);
+#else
+  return lpc_heap_alloc(heap, size_in_bytes);
+#endif
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_heap_new_placed
+ *
+ * Purpose: Get an allocated area for a placement hint and call site.
+ *
+ * Processing:
+ *     The allocation is made from the heap set for the hint with
+ *     lpc_heap_set_placement, or from the default heap if no heap is
+ *     set. If the heap for LPC_MEM_FAST or LPC_MEM_BULK is full, the
+ *     default heap is tried next. LPC_MEM_DMA allocations never fall
+ *     back, as the default heap may not be usable by DMA.
+ *
+ * Parameters:
+ *     size_in_bytes : Byte size of the requested allocation chunk
+ *     mem_type      : Placement hint
+ *     file          : Call site file name (0 = untagged)
+ *     line          : Call site line number
+ *
+ * Outputs: None
+ *
+ * Returns: A pointer to the allocated chunk, or '0' if no room is
+ *          available.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void *lpc_heap_new_placed(UNS_32 size_in_bytes,
+                                 LPC_MEM_TYPE_T mem_type,
+                                 const CHAR *file,
+                                 UNS_32 line)
+{
+  LPC_HEAP_T *heap = (LPC_HEAP_T *) 0;
+  void *new_addr;
+
+  if ((UNS_32) mem_type < LPC_MEM_TYPES)
+  {
+    heap = mem_heaps[mem_type];
+  }
+  if (heap == (LPC_HEAP_T *) 0)
+  {
+    return lpc_heap_new_site(&default_heap, size_in_bytes, file, line);
+  }
+
+  new_addr = lpc_heap_new_site(heap, size_in_bytes, file, line);
+  if ((new_addr == (void *) 0) && (mem_type != LPC_MEM_DMA))
+  {
+    new_addr = lpc_heap_new_site(&default_heap, size_in_bytes, file,
+                                 line);
+  }
+
+  return new_addr;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_new
+ *
+ * Purpose: Get an allocated area from the heap.
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     size_in_bytes : Byte size of the requested allocation chunk
+ *
+ * Outputs: None
+ *
+ * Returns: A pointer to the allocated chunk, or '0' if no room is
+ *          available.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void *lpc_new(UNS_32 size_in_bytes)
+{
+  return lpc_new_in(&default_heap, size_in_bytes);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_new_in
+ *
+ * Purpose: Get an allocated area from a specific heap.
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     heap          : Heap instance
+ *     size_in_bytes : Byte size of the requested allocation chunk
+ *
+ * Outputs: None
+ *
+ * Returns: A pointer to the allocated chunk, or '0' if no room is
+ *          available.
+ *
+ * Notes: The chunk is returned with lpc_free.
+ *
+ **********************************************************************/
+void *lpc_new_in(LPC_HEAP_T *heap, UNS_32 size_in_bytes)
+{
+  return lpc_heap_new_site(heap, size_in_bytes, (const CHAR *) 0, 0);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_new_placed
+ *
+ * Purpose: Get an allocated area from the heap for a placement hint.
+ *
+ * Processing:
+ *     See lpc_heap_new_placed.
+ *
+ * Parameters:
+ *     size_in_bytes : Byte size of the requested allocation chunk
+ *     mem_type      : Placement hint
+ *
+ * Outputs: None
+ *
+ * Returns: A pointer to the allocated chunk, or '0' if no room is
+ *          available.
+ *
+ * Notes: The chunk is returned with lpc_free.
+ *
+ **********************************************************************/
+void *lpc_new_placed(UNS_32 size_in_bytes, LPC_MEM_TYPE_T mem_type)
+{
+  return lpc_heap_new_placed(size_in_bytes, mem_type,
+                             (const CHAR *) 0, 0);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_free
+ *
+ * Purpose: Returns an allocated entry of memory to the heap.
+ *
+ * Processing:
+ *     The heap that contains the address is found and the entry is
+ *     returned to it.
+ *
+ * Parameters:
+ *     free_addr : Address of allocated entry to return to heap
+ *
+ * Outputs: None
+ *
+ * Returns: '1' if the entry was deleted, otherwise '0'.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+INT_32 lpc_free(void *free_addr)
+{
+  LPC_HEAP_T *heap = lpc_heap_owner(free_addr);
+#ifdef LPC_HEAP_STATS
+  INT_32 status;
+  UNS_64 start = 0;
+  UNS_32 size;
+
+  size = lpc_entry_size(heap, free_addr);
+  if (heap_timer != 0)
+  {
+    start = heap_timer();
+  }
+  status = lpc_heap_release(heap, free_addr);
+  if (heap_timer != 0)
+  {
+    heap->heap_stats.free_ticks += heap_timer() - start;
+  }
+
+  if (status != 0)
+  {
+    heap->heap_stats.free_calls++;
+    heap->heap_stats.bytes_in_use -= size;
+  }
+
+  return status;
+#else
+  return lpc_heap_release(heap, free_addr);
+#endif
+}
+
+#ifdef LPC_HEAP_STATS
+/***********************************************************************
+ *
+ * Function: lpc_heap_set_timer
+ *
+ * Purpose: Set the timer used to measure alloc and free time.
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     timer_func : Function returning a free running tick count, or
+ *                  0 to disable time measurement
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void lpc_heap_set_timer(UNS_64 (*timer_func)(void))
+{
+  heap_timer = timer_func;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_heap_get_stats
+ *
+ * Purpose: Get a copy of the default heap statistics.
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     stats : Where to return the statistics
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void lpc_heap_get_stats(LPC_HEAP_STATS_T *stats)
+{
+  lpc_heap_get_stats_in(&default_heap, stats);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_heap_get_stats_in
+ *
+ * Purpose: Get a copy of the statistics of a heap.
+ *
+ * Processing:
+ *     The recorded counters are copied. The free chunks are then
+ *     walked (heap list in first-fit mode, class lists in size-class
+ *     mode) to build the free chunk histogram, the free byte count and
+ *     the largest free chunk, from which the fragmentation ratio is
+ *     computed.
+ *
+ * Parameters:
+ *     heap  : Heap instance
+ *     stats : Where to return the statistics
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void lpc_heap_get_stats_in(LPC_HEAP_T *heap, LPC_HEAP_STATS_T *stats)
+{
+  HEAP_DESCRIPTOR_T *heap_ptr;
+  SC_CHUNK_T *chunk;
+  UNS_32 idx;
+
+  *stats = heap->heap_stats;
+  stats->free_bytes = 0;
+  stats->largest_free = 0;
+  stats->frag_permille = 0;
+  for (idx = 0; idx < LPC_HEAP_HIST_BUCKETS; idx++)
+  {
+    stats->free_hist[idx] = 0;
+  }
+
+  if (heap->heap_mode == LPC_HEAP_SIZE_CLASS)
+  {
+    for (idx = 0; idx < 32; idx++)
+    {
+      chunk = heap->sc_bins[idx];
+      while (chunk != (SC_CHUNK_T *) 0)
+      {
+        lpc_stats_add_free(stats, SC_SIZE(chunk));
+        chunk = chunk->next_free;
+      }
+    }
+  }
+  else
+  {
+    heap_ptr = heap->heap_base;
+    while (heap_ptr != HEAP_POINTER_NULL)
+    {
+      lpc_stats_add_free(stats, heap_ptr->entry_size);
+      heap_ptr = heap_ptr->next_descriptor;
+    }
+  }
+
+  if (stats->free_bytes != 0)
+  {
+    stats->frag_permille = (UNS_32) (((UNS_64) 1000 *
+                           (stats->free_bytes - stats->largest_free)) /
+                           stats->free_bytes);
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_heap_reset_stats
+ *
+ * Purpose: Clear the heap counters.
+ *
+ * Processing:
+ *     The counters and call site entries of all heaps are cleared.
+ *     The bytes in use are kept and become the new peak value.
+ *
+ * Parameters: None
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+void lpc_heap_reset_stats(void)
+{
+  LPC_HEAP_T *heap = &default_heap;
+  UNS_8 *clr;
+  UNS_32 in_use, idx;
+
+  while (heap != (LPC_HEAP_T *) 0)
+  {
+    clr = (UNS_8 *) &heap->heap_stats;
+    in_use = heap->heap_stats.bytes_in_use;
+    for (idx = 0; idx < sizeof(heap->heap_stats); idx++)
+    {
+      clr[idx] = 0;
+    }
+    heap->heap_stats.bytes_in_use = in_use;
+    heap->heap_stats.peak_bytes = in_use;
+
+    /* Next created heap */
+    if (heap == &default_heap)
+    {
+      heap = heap_list;
+    }
+    else
+    {
+      heap = heap->next_heap;
+    }
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_heap_stats_dump
+ *
+ * Purpose: Write the default heap statistics in the binary dump format.
+ *
+ * Processing:
+ *     The dump is a sequence of little-endian 32-bit words: magic,
+ *     version, heap size, mode, bytes in use, peak bytes, alloc calls,
+ *     free calls, failed allocs, untracked allocs, alloc ticks (low,
+ *     high), free ticks (low, high), free bytes, largest free chunk,
+ *     fragmentation (per mille), the number of histogram buckets and
+ *     the buckets, and the number of call sites. Each call site is
+ *     LPC_HEAP_TAG_NAME_LEN bytes of the file name (the end of the name
+ *     if it is longer, zero padded) followed by the line, allocation
+ *     count and byte count words.
+ *
+ * Parameters:
+ *     buff      : Where to write the dump
+ *     buff_size : Size of buff in bytes
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes written, or 0 if buff is too small.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+UNS_32 lpc_heap_stats_dump(UNS_8 *buff, UNS_32 buff_size)
+{
+  LPC_HEAP_STATS_T stats;
+  LPC_HEAP_TAG_STATS_T *tag;
+  UNS_8 *out = buff;
+  UNS_32 idx, len, need;
+
+  lpc_heap_get_stats(&stats);
+
+  need = ((19 + LPC_HEAP_HIST_BUCKETS) * 4) +
+         (stats.num_tags * (LPC_HEAP_TAG_NAME_LEN + 12));
+  if (buff_size < need)
+  {
+    return 0;
+  }
+
+  out = lpc_stats_put32(out, LPC_HEAP_DUMP_MAGIC);
+  out = lpc_stats_put32(out, LPC_HEAP_DUMP_VERSION);
+  out = lpc_stats_put32(out, default_heap.heap_size_saved);
+  out = lpc_stats_put32(out, (UNS_32) default_heap.heap_mode);
+  out = lpc_stats_put32(out, stats.bytes_in_use);
+  out = lpc_stats_put32(out, stats.peak_bytes);
+  out = lpc_stats_put32(out, stats.alloc_calls);
+  out = lpc_stats_put32(out, stats.free_calls);
+  out = lpc_stats_put32(out, stats.failed_allocs);
+  out = lpc_stats_put32(out, stats.untracked_allocs);
+  out = lpc_stats_put32(out, (UNS_32) stats.alloc_ticks);
+  out = lpc_stats_put32(out, (UNS_32) (stats.alloc_ticks >> 32));
+  out = lpc_stats_put32(out, (UNS_32) stats.free_ticks);
+  out = lpc_stats_put32(out, (UNS_32) (stats.free_ticks >> 32));
+  out = lpc_stats_put32(out, stats.free_bytes);
+  out = lpc_stats_put32(out, stats.largest_free);
+  out = lpc_stats_put32(out, stats.frag_permille);
+  out = lpc_stats_put32(out, LPC_HEAP_HIST_BUCKETS);
+  for (idx = 0; idx < LPC_HEAP_HIST_BUCKETS; idx++)
+  {
+    out = lpc_stats_put32(out, stats.free_hist[idx]);
+  }
+  out = lpc_stats_put32(out, stats.num_tags);
+
+  for (idx = 0; idx < stats.num_tags; idx++)
+  {
+    tag = &stats.tags[idx];
+
+    /* Keep the end of the file name, it is the most specific part */
+    len = 0;
+    if (tag->file != (const CHAR *) 0)
+    {
+      while (tag->file[len] != 0)
+      {
+        len++;
+      }
+    }
+    need = 0;
+    if (len > LPC_HEAP_TAG_NAME_LEN)
+    {
+      need = len - LPC_HEAP_TAG_NAME_LEN;
+    }
+    for (len = 0; len < LPC_HEAP_TAG_NAME_LEN; len++)
+    {
+      if ((tag->file != (const CHAR *) 0) &&
+          (tag->file[need] != 0))
+      {
+        *out = (UNS_8) tag->file[need];
+        need++;
+      }
+      else
+      {
+        *out = 0;
+      }
+      out++;
+    }
+
+    out = lpc_stats_put32(out, tag->line);
+    out = lpc_stats_put32(out, tag->allocs);
+    out = lpc_stats_put32(out, tag->bytes);
+  }
+
+  return (UNS_32) (out - buff);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_new_tag
+ *
+ * Purpose: Get an allocated area from the heap for a call site.
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     size_in_bytes : Byte size of the requested allocation chunk
+ *     file          : Call site file name (0 = untagged)
+ *     line          : Call site line number
+ *
+ * Outputs: None
+ *
+ * Returns: A pointer to the allocated chunk, or '0' if no room is
+ *          available.
+ *
+ * Notes: Normally used through the lpc_new_tagged macro.
+ *
+ **********************************************************************/
+void *lpc_new_tag(UNS_32 size_in_bytes, const CHAR *file, UNS_32 line)
+{
+  return lpc_heap_new_tag(&default_heap, size_in_bytes, file, line);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_new_placed_tag
+ *
+ * Purpose: Get an allocated area for a placement hint and call site.
+ *
+ * Processing:
+ *     See lpc_heap_new_placed.
+ *
+ * Parameters:
+ *     size_in_bytes : Byte size of the requested allocation chunk
+ *     mem_type      : Placement hint
+ *     file          : Call site file name (0 = untagged)
+ *     line          : Call site line number
+ *
+ * Outputs: None
+ *
+ * Returns: A pointer to the allocated chunk, or '0' if no room is
+ *          available.
+ *
+ * Notes: Normally used through the lpc_new_placed_tagged macro.
+ *
+ **********************************************************************/
+void *lpc_new_placed_tag(UNS_32 size_in_bytes,
+                         LPC_MEM_TYPE_T mem_type,
+                         const CHAR *file,
+                         UNS_32 line)
 {
-  return lpc_remove_entry(free_addr);
+  return lpc_heap_new_placed(size_in_bytes, mem_type, file, line);
 }
+#endif
@@ -25,14 +25,14 @@
 * Local data and types
 **********************************************************************/
 
-/* Generated parity lookup tables used in software mode */
-static unsigned char P1Otab[256];
-static unsigned char P1Etab[256];
-static unsigned char P2Otab[256];
-static unsigned char P2Etab[256];
-static unsigned char P4Otab[256];
-static unsigned char P4Etab[256];
-static unsigned char PBytetab[256];
+/* Generated column parity lookup table used in software mode. Bits 0
+   to 5 hold the column parities of a byte in SLC hardware ECC order
+   (CP1E, CP1O, CP2E, CP2O, CP4E, CP4O) and bit 6 holds the parity of
+   all 8 bits of the byte. */
+static UNS_8 ECCColtab[256];
+
+/* Number of 32-bit words folded per group in lpc_eccFold() */
+#define ECC_GROUP_WORDS 8
 
 /* Bit isolation macro for table generation */
 #define ISOLATEBIT(x, y) (unsigned char) ((y >> x) & 0x1)
@@ -144,6 +144,155 @@ static UNS_8 lpc_eccGenParityBit8(UNS_8 data)
   return par;
 }
 
+/***********************************************************************
+ *
+ * Function: lpc_eccParity32
+ *
+ * Purpose: Generate XOR parity bit for 32 bits
+ *
+ * Processing:
+ *     Fold the word down to a byte and look up the byte parity.
+ *
+ * Parameters:
+ *  v : 32-bit value
+ *
+ * Outputs: None
+ *
+ * Returns: The XOR'ed bit value of the 32 bits
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 lpc_eccParity32(UNS_32 v)
+{
+  v = v ^ (v >> 16);
+  v = v ^ (v >> 8);
+
+  return (UNS_32) (ECCColtab[v & 0xFF] >> 6);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_eccFold
+ *
+ * Purpose: Generate the row and column parities for a block of data
+ *
+ * Processing:
+ *     The block is read 8 words at a time. Within a group, the words
+ *     are folded with XOR trees into the group total and the odd
+ *     parity words for word index bits 0 to 2. The group total is
+ *     then folded into the odd parity words for the higher word index
+ *     bits using a mask made from the group number. The odd parity
+ *     word for each row address bit covers all bytes whose address
+ *     has that bit set, and the even parity word is the total XOR'ed
+ *     with it. Address bits 0 and 1 select the byte lane inside a
+ *     word and are taken from the total with lane masks. The column
+ *     parities come from a single table lookup on the total folded
+ *     down to a byte.
+ *
+ * Parameters:
+ *  datbuf : Data to generate the parities for
+ *  words  : Number of 32-bit words in the block (multiple of 8)
+ *  lpeven : Where to return the even row parities, bit n is the
+ *           parity of the bytes with address bit n clear
+ *  lpodd  : Where to return the odd row parities, bit n is the
+ *           parity of the bytes with address bit n set
+ *
+ * Outputs: The row parities are returned in lpeven and lpodd.
+ *
+ * Returns: The column parities in SLC hardware ECC order.
+ *
+ * Notes:
+ *     Aligned buffers are read as little endian words, as used by
+ *     the ARM9 core. Unaligned buffers are assembled a byte at a
+ *     time.
+ *
+ **********************************************************************/
+static UNS_32 lpc_eccFold(const UNS_8 *datbuf,
+                          INT_32 words,
+                          UNS_32 *lpeven,
+                          UNS_32 *lpodd)
+{
+  const UNS_32 *dat32 = (const UNS_32 *) datbuf;
+  UNS_32 w[ECC_GROUP_WORDS], lpw[16];
+  UNS_32 total, grp, mask, even, odd;
+  INT_32 idx, bit, group, gbits;
+  BOOL_32 aligned = (((UNS_32) datbuf & 0x3) == 0);
+
+  /* Number of word index bits above the group */
+  gbits = 0;
+  while ((ECC_GROUP_WORDS << gbits) < words)
+  {
+    gbits++;
+  }
+
+  total = 0;
+  for (bit = 0; bit < (3 + gbits); bit++)
+  {
+    lpw[bit] = 0;
+  }
+
+  for (group = 0; group < (words / ECC_GROUP_WORDS); group++)
+  {
+    if (aligned == TRUE)
+    {
+      for (idx = 0; idx < ECC_GROUP_WORDS; idx++)
+      {
+        w[idx] = dat32[idx];
+      }
+      dat32 += ECC_GROUP_WORDS;
+    }
+    else
+    {
+      for (idx = 0; idx < ECC_GROUP_WORDS; idx++)
+      {
+        w[idx] = (UNS_32) datbuf[0] | ((UNS_32) datbuf[1] << 8) |
+                 ((UNS_32) datbuf[2] << 16) |
+                 ((UNS_32) datbuf[3] << 24);
+        datbuf += 4;
+      }
+    }
+
+    /* Odd parity words for word index bits 0 to 2 */
+    odd = w[1] ^ w[3] ^ w[5] ^ w[7];
+    even = w[0] ^ w[2] ^ w[4] ^ w[6];
+    grp = odd ^ even;
+    lpw[0] ^= odd;
+    lpw[1] ^= w[2] ^ w[3] ^ w[6] ^ w[7];
+    lpw[2] ^= w[4] ^ w[5] ^ w[6] ^ w[7];
+
+    /* Odd parity words for the group number bits */
+    for (bit = 0; bit < gbits; bit++)
+    {
+      mask = 0 - (((UNS_32) group >> bit) & 0x1);
+      lpw[3 + bit] ^= grp & mask;
+    }
+
+    total ^= grp;
+  }
+
+  /* Address bits 0 and 1 select the byte lane */
+  odd = lpc_eccParity32(total & 0xFF00FF00) |
+        (lpc_eccParity32(total & 0xFFFF0000) << 1);
+  even = lpc_eccParity32(total & 0x00FF00FF) |
+         (lpc_eccParity32(total & 0x0000FFFF) << 1);
+
+  /* Address bits 2 and up select the word */
+  for (bit = 0; bit < (3 + gbits); bit++)
+  {
+    odd |= lpc_eccParity32(lpw[bit]) << (2 + bit);
+    even |= lpc_eccParity32(total ^ lpw[bit]) << (2 + bit);
+  }
+
+  *lpeven = even;
+  *lpodd = odd;
+
+  total = total ^ (total >> 16);
+  total = total ^ (total >> 8);
+
+  return (UNS_32) (ECCColtab[total & 0xFF] & 0x3F);
+}
+
 /***********************************************************************
 * Public functions
 **********************************************************************/
@@ -170,22 +319,23 @@ void lpc_eccinittables(void)
 {
   INT_32 idx;
 
-  /* All tables */
+  /* Combined column and byte parity table */
   for (idx = 0; idx < 256; idx++)
   {
-    P1Otab[idx] = lpc_eccGenParityBit4(ISOLATEBIT(7, idx), ISOLATEBIT(5, idx),
-                                       ISOLATEBIT(3, idx), ISOLATEBIT(1, idx));
-    P1Etab[idx] = lpc_eccGenParityBit4(ISOLATEBIT(6, idx), ISOLATEBIT(4, idx),
-                                       ISOLATEBIT(2, idx), ISOLATEBIT(0, idx));
-    P2Otab[idx] = lpc_eccGenParityBit4(ISOLATEBIT(7, idx), ISOLATEBIT(6, idx),
-                                       ISOLATEBIT(3, idx), ISOLATEBIT(2, idx));
-    P2Etab[idx] = lpc_eccGenParityBit4(ISOLATEBIT(5, idx), ISOLATEBIT(4, idx),
-                                       ISOLATEBIT(1, idx), ISOLATEBIT(0, idx));
-    P4Otab[idx] = lpc_eccGenParityBit4(ISOLATEBIT(7, idx), ISOLATEBIT(6, idx),
-                                       ISOLATEBIT(5, idx), ISOLATEBIT(4, idx));
-    P4Etab[idx] = lpc_eccGenParityBit4(ISOLATEBIT(3, idx), ISOLATEBIT(2, idx),
-                                       ISOLATEBIT(1, idx), ISOLATEBIT(0, idx));
-    PBytetab[idx] = lpc_eccGenParityBit8((UNS_8) idx);
+    ECCColtab[idx] = (UNS_8)
+      ((lpc_eccGenParityBit4(ISOLATEBIT(6, idx), ISOLATEBIT(4, idx),
+                             ISOLATEBIT(2, idx), ISOLATEBIT(0, idx)) << 0) |
+       (lpc_eccGenParityBit4(ISOLATEBIT(7, idx), ISOLATEBIT(5, idx),
+                             ISOLATEBIT(3, idx), ISOLATEBIT(1, idx)) << 1) |
+       (lpc_eccGenParityBit4(ISOLATEBIT(5, idx), ISOLATEBIT(4, idx),
+                             ISOLATEBIT(1, idx), ISOLATEBIT(0, idx)) << 2) |
+       (lpc_eccGenParityBit4(ISOLATEBIT(7, idx), ISOLATEBIT(6, idx),
+                             ISOLATEBIT(3, idx), ISOLATEBIT(2, idx)) << 3) |
+       (lpc_eccGenParityBit4(ISOLATEBIT(3, idx), ISOLATEBIT(2, idx),
+                             ISOLATEBIT(1, idx), ISOLATEBIT(0, idx)) << 4) |
+       (lpc_eccGenParityBit4(ISOLATEBIT(7, idx), ISOLATEBIT(6, idx),
+                             ISOLATEBIT(5, idx), ISOLATEBIT(4, idx)) << 5) |
+       (lpc_eccGenParityBit8((UNS_8) idx) << 6));
   }
 }
 
@@ -196,133 +346,79 @@ void lpc_eccinittables(void)
  * Purpose: Generate a software ECC for a 512 byte block of data
  *
  * Processing:
- *     See function.
+ *     Generate the row and column parities a word at a time and
+ *     split them into the even and odd ECC words.
  *
- * Parameters: TBD
+ * Parameters:
+ *  eccbuf : Where to place the generated ECC
+ *  datbuf : 512 byte block of data
  *
- * Outputs: None
+ * Outputs: The ECC is returned in eccbuf.
  *
- * Returns: Nothing
+ * Returns: Always 1
  *
- * Notes: None
+ * Notes: lpc_eccinittables() must be called first.
  *
  **********************************************************************/
 UNS_32 lpc_eccgenerate512(LPC_ECC512 eccbuf,
                           UNS_8 *datbuf)
 {
-  /* Correct parity generation algorithm */
-  INT_32 idx;
-  UNS_8 P1O, P1E, P2O, P2E, P4O, P4E, P8O, P8E, P16O, P16E, P32O, P32E;
-  UNS_8 P64O, P64E, P128O, P128E, P256O, P256E, P512O, P512E;
-  UNS_8 P1024O, P1024E, P2048O, P2048E;
+  UNS_32 cp, lpeven, lpodd;
 
-  /* All parity bits initially 0 */
-  P1O = P1E = P2O = P2E = P4O = P4E = P8O = P8E = P16O = P16E = 0;
-  P32O = P32E = P64O = P64E = P128O = P128E = P256O = P256E = 0;
-  P512O = P512E = P1024O = P1024E = P2048O = P2048E = 0;
+  cp = lpc_eccFold(datbuf, 512 / 4, &lpeven, &lpodd);
 
-  for (idx = 0; idx < 512; idx++)
-  {
-    P1O = P1O ^ P1Otab[datbuf[idx]];
-    P1E = P1E ^ P1Etab[datbuf[idx]];
-    P2O = P2O ^ P2Otab[datbuf[idx]];
-    P2E = P2E ^ P2Etab[datbuf[idx]];
-    P4O = P4O ^ P4Otab[datbuf[idx]];
-    P4E = P4E ^ P4Etab[datbuf[idx]];
-
-    if ((idx & 0x1) == 0)
-    {
-      P8E = P8E ^ PBytetab[datbuf[idx]];
-    }
-    else
-    {
-      P8O = P8O ^ PBytetab[datbuf[idx]];
-    }
-
-    if ((idx & 0x2) == 0)
-    {
-      P16E = P16E ^ PBytetab[datbuf[idx]];
-    }
-    else
-    {
-      P16O = P16O ^ PBytetab[datbuf[idx]];
-    }
-
-    if ((idx & 0x4) == 0)
-    {
-      P32E = P32E ^ PBytetab[datbuf[idx]];
-    }
-    else
-    {
-      P32O = P32O ^ PBytetab[datbuf[idx]];
-    }
-
-    if ((idx & 0x8) == 0)
-    {
-      P64E = P64E ^ PBytetab[datbuf[idx]];
-    }
-    else
-    {
-      P64O = P64O ^ PBytetab[datbuf[idx]];
-    }
-
-    if ((idx & 0x10) == 0)
-    {
-      P128E = P128E ^ PBytetab[datbuf[idx]];
-    }
-    else
-    {
-      P128O = P128O ^ PBytetab[datbuf[idx]];
-    }
-
-    if ((idx & 0x20) == 0)
-    {
-      P256E = P256E ^ PBytetab[datbuf[idx]];
-    }
-    else
-    {
-      P256O = P256O ^ PBytetab[datbuf[idx]];
-    }
+  /* Column parities are CP1, CP2, CP4 in bits 0 to 2 and row parities
+     are P8 to P2048 in bits 3 to 11 */
+  *eccbuf = (UNS_16) ((lpeven << 3) | (cp & 0x1) |
+                      ((cp >> 1) & 0x2) | ((cp >> 2) & 0x4));
+  eccbuf++;
+  *eccbuf = (UNS_16) ((lpodd << 3) | ((cp >> 1) & 0x1) |
+                      ((cp >> 2) & 0x2) | ((cp >> 3) & 0x4));
 
-    if ((idx & 0x40) == 0)
-    {
-      P512E = P512E ^ PBytetab[datbuf[idx]];
-    }
-    else
-    {
-      P512O = P512O ^ PBytetab[datbuf[idx]];
-    }
+  return 1;
+}
 
-    if ((idx & 0x80) == 0)
-    {
-      P1024E = P1024E ^ PBytetab[datbuf[idx]];
-    }
-    else
-    {
-      P1024O = P1024O ^ PBytetab[datbuf[idx]];
-    }
+/***********************************************************************
+ *
+ * Function: lpc_eccgenerate256
+ *
+ * Purpose: Generate a software ECC for a 256 byte block of data
+ *
+ * Processing:
+ *     Generate the row and column parities a word at a time and
+ *     interleave the even and odd row parities above the column
+ *     parities.
+ *
+ * Parameters:
+ *  datbuf : 256 byte block of data
+ *
+ * Outputs: None
+ *
+ * Returns: The 22-bit ECC in the same layout as the SLC controller
+ *          hardware ECC, with the column parities in bits 0 to 5 and
+ *          the row parities in bits 6 to 21, even then odd for each
+ *          bit.
+ *
+ * Notes: lpc_eccinittables() must be called first. The result can be
+ *        stored with slc_ecc_copy_to_buffer() and checked with
+ *        nand_slc_correct_ecc().
+ *
+ **********************************************************************/
+UNS_32 lpc_eccgenerate256(UNS_8 *datbuf)
+{
+  UNS_32 cp, lpeven, lpodd;
 
-    if ((idx & 0x100) == 0)
-    {
-      P2048E = P2048E ^ PBytetab[datbuf[idx]];
-    }
-    else
-    {
-      P2048O = P2048O ^ PBytetab[datbuf[idx]];
-    }
-  }
+  cp = lpc_eccFold(datbuf, 256 / 4, &lpeven, &lpodd);
 
-  *eccbuf = (P2048E << 11) | (P1024E << 10) | (P512E << 9) |
-            (P256E << 8) | (P128E << 7) | (P64E << 6) | (P32E << 5) |
-            (P16E << 4) | (P8E << 3) | (P4E << 2) | (P2E << 1) |
-            (P1E << 0);
-  eccbuf++;
-  *eccbuf = (P2048O << 11) | (P1024O << 10) | (P512O << 9) |
-            (P256O << 8) | (P128O << 7) | (P64O << 6) | (P32O << 5) |
-            (P16O << 4) | (P8O << 3) | (P4O << 2) | (P2O << 1) |
-            (P1O << 0);
+  /* Spread the 8 row parity bits to every other bit */
+  lpeven = (lpeven | (lpeven << 4)) & 0x0F0F;
+  lpeven = (lpeven | (lpeven << 2)) & 0x3333;
+  lpeven = (lpeven | (lpeven << 1)) & 0x5555;
+  lpodd = (lpodd | (lpodd << 4)) & 0x0F0F;
+  lpodd = (lpodd | (lpodd << 2)) & 0x3333;
+  lpodd = (lpodd | (lpodd << 1)) & 0x5555;
 
-  return 1;
+  return (((lpodd << 1) | lpeven) << 6) | cp;
 }
 
 /***********************************************************************
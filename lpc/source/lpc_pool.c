@@ -0,0 +1,331 @@
+/***********************************************************************
+ * $Id:: lpc_pool.c                                                    $
+ *
+ * Project: Fixed-size object pool manager
+ *
+ * Description:
+ *     See the header file for a description of this package.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include "lpc_types.h"
+#include "lpc_irq_fiq.h"
+#include "lpc_heap.h"
+#include "lpc_pool.h"
+
+/***********************************************************************
+ * Package defines
+ **********************************************************************/
+
+/* Pointer to NULL pool object */
+#define POOL_OBJ_NULL ((void *) 0)
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: lpc_pool_init
+ *
+ * Purpose: Setup a pool in caller supplied storage
+ *
+ * Processing:
+ *     The object size is rounded up to the alignment and to the size
+ *     of the free list link. The start of the storage is aligned, and
+ *     as many objects as fit in the remaining storage together with
+ *     their in-use bits are linked into the free list in address
+ *     order. The in-use bits follow the last object and are cleared.
+ *
+ * Parameters:
+ *     pool         : Pointer to pool control structure to setup
+ *     storage      : Pointer to storage for the objects
+ *     storage_size : Size of the storage area in bytes
+ *     obj_size     : Size of an object in bytes
+ *     align        : Object alignment in bytes, must be a power of 2
+ *                    and at least 4
+ *
+ * Outputs: None
+ *
+ * Returns: The number of objects in the pool.
+ *
+ * Notes:
+ *     Use LPC_POOL_STORAGE_SIZE to size the storage for a specific
+ *     number of objects, as it includes the in-use bits.
+ *
+ **********************************************************************/
+UNS_32 lpc_pool_init(LPC_POOL_T *pool,
+                     void *storage,
+                     UNS_32 storage_size,
+                     UNS_32 obj_size,
+                     UNS_32 align)
+{
+  UNS_8 *obj;
+  UNS_32 adjust, avail, idx;
+
+  pool->free_list = POOL_OBJ_NULL;
+  pool->num_objs = 0;
+  pool->free_count = 0;
+
+  if (align < sizeof(UNS_32))
+  {
+    align = sizeof(UNS_32);
+  }
+  pool->obj_size = LPC_POOL_OBJ_SIZE(obj_size, align);
+
+  /* Align the first object */
+  adjust = (0 - (UNS_32) (UNS_8 *) storage) & (align - 1);
+  pool->first_obj = (UNS_8 *) storage + adjust;
+
+  if (storage_size > adjust)
+  {
+    avail = storage_size - adjust;
+    pool->num_objs = avail / pool->obj_size;
+    while ((pool->num_objs > 0) &&
+           (((pool->num_objs * pool->obj_size) +
+             LPC_POOL_MAP_SIZE(pool->num_objs)) > avail))
+    {
+      pool->num_objs--;
+    }
+  }
+
+  /* The in-use bits follow the objects, word aligned as the object
+     size is a multiple of the alignment */
+  pool->in_use = (UNS_32 *) (pool->first_obj +
+                             (pool->num_objs * pool->obj_size));
+  for (idx = 0; idx < (LPC_POOL_MAP_SIZE(pool->num_objs) /
+                       sizeof(UNS_32)); idx++)
+  {
+    pool->in_use [idx] = 0;
+  }
+
+  /* An empty pool has no last object, so every free is rejected */
+  pool->last_obj = POOL_OBJ_NULL;
+  if (pool->num_objs > 0)
+  {
+    pool->last_obj = pool->first_obj +
+                     ((pool->num_objs - 1) * pool->obj_size);
+  }
+
+  /* Link all objects into the free list, last object first so the
+     list is in address order */
+  for (idx = pool->num_objs; idx > 0; idx--)
+  {
+    obj = pool->first_obj + ((idx - 1) * pool->obj_size);
+    *(void **) obj = pool->free_list;
+    pool->free_list = obj;
+  }
+  pool->free_count = pool->num_objs;
+
+  return pool->num_objs;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_pool_create
+ *
+ * Purpose: Create a pool of objects with storage from the heap
+ *
+ * Processing:
+ *     A single heap allocation is made for the pool control structure
+ *     and the object storage. The pool is then setup in the storage
+ *     following the control structure.
+ *
+ * Parameters:
+ *     num_objs : Number of objects in the pool
+ *     obj_size : Size of an object in bytes
+ *     align    : Object alignment in bytes, must be a power of 2
+ *
+ * Outputs: None
+ *
+ * Returns: A pointer to the pool, or '0' if no room is available.
+ *
+ * Notes:
+ *     The heap is only used when the pool is created, allocation from
+ *     the pool does not touch the heap.
+ *
+ **********************************************************************/
+LPC_POOL_T *lpc_pool_create(UNS_32 num_objs,
+                            UNS_32 obj_size,
+                            UNS_32 align)
+{
+  LPC_POOL_T *pool;
+  UNS_32 storage_size;
+
+  if (align < sizeof(UNS_32))
+  {
+    align = sizeof(UNS_32);
+  }
+
+  storage_size = LPC_POOL_STORAGE_SIZE(num_objs, obj_size, align);
+  pool = (LPC_POOL_T *) lpc_new(sizeof(LPC_POOL_T) + storage_size);
+  if (pool != (LPC_POOL_T *) 0)
+  {
+    lpc_pool_init(pool, (pool + 1), storage_size, obj_size, align);
+  }
+
+  return pool;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_pool_destroy
+ *
+ * Purpose: Destroy a pool created with lpc_pool_create
+ *
+ * Processing:
+ *     The pool control structure and storage are returned to the heap.
+ *
+ * Parameters:
+ *     pool : Pointer to pool returned from lpc_pool_create
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes:
+ *     Must not be used with pools setup with lpc_pool_init.
+ *
+ **********************************************************************/
+void lpc_pool_destroy(LPC_POOL_T *pool)
+{
+  if (pool != (LPC_POOL_T *) 0)
+  {
+    lpc_free(pool);
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_pool_alloc
+ *
+ * Purpose: Get an object from a pool
+ *
+ * Processing:
+ *     IRQs are masked while the first object is popped from the pool
+ *     free list and marked in use, and then restored to their previous
+ *     state.
+ *
+ * Parameters:
+ *     pool : Pointer to pool to allocate from
+ *
+ * Outputs: None
+ *
+ * Returns: A pointer to the object, or '0' if the pool is empty.
+ *
+ * Notes: Safe to call from interrupt handlers.
+ *
+ **********************************************************************/
+void *lpc_pool_alloc(LPC_POOL_T *pool)
+{
+  void *obj;
+  UNS_32 irq_state, idx;
+
+  irq_state = disable_irq();
+
+  obj = pool->free_list;
+  if (obj != POOL_OBJ_NULL)
+  {
+    pool->free_list = *(void **) obj;
+    pool->free_count--;
+
+    idx = (UNS_32) ((UNS_8 *) obj - pool->first_obj) / pool->obj_size;
+    pool->in_use [idx >> 5] |= _BIT(idx & 0x1F);
+  }
+
+  restore_exceptions(irq_state);
+
+  return obj;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_pool_free
+ *
+ * Purpose: Return an object to a pool
+ *
+ * Processing:
+ *     The object address is checked to be an object of the pool. IRQs
+ *     are masked while the in-use bit of the object is checked and
+ *     cleared and the object is pushed on the pool free list, and then
+ *     restored to their previous state.
+ *
+ * Parameters:
+ *     pool : Pointer to pool the object was allocated from
+ *     obj  : Pointer to object to return
+ *
+ * Outputs: None
+ *
+ * Returns: '1' if the object was returned, or '0' if it is not an
+ *          object of the pool or is not in use (a second free of the
+ *          same object).
+ *
+ * Notes: Safe to call from interrupt handlers.
+ *
+ **********************************************************************/
+INT_32 lpc_pool_free(LPC_POOL_T *pool, void *obj)
+{
+  UNS_32 irq_state, offset, idx, bit;
+  INT_32 status = 0;
+
+  if (((UNS_8 *) obj >= pool->first_obj) &&
+      ((UNS_8 *) obj <= pool->last_obj))
+  {
+    offset = (UNS_32) ((UNS_8 *) obj - pool->first_obj);
+    idx = offset / pool->obj_size;
+    if ((idx * pool->obj_size) == offset)
+    {
+      bit = _BIT(idx & 0x1F);
+
+      irq_state = disable_irq();
+
+      if ((pool->in_use [idx >> 5] & bit) != 0)
+      {
+        pool->in_use [idx >> 5] &= ~bit;
+        *(void **) obj = pool->free_list;
+        pool->free_list = obj;
+        pool->free_count++;
+        status = 1;
+      }
+
+      restore_exceptions(irq_state);
+    }
+  }
+
+  return status;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_pool_get_free_count
+ *
+ * Purpose: Return the number of free objects in a pool
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     pool : Pointer to pool
+ *
+ * Outputs: None
+ *
+ * Returns: The number of objects that can still be allocated.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+UNS_32 lpc_pool_get_free_count(LPC_POOL_T *pool)
+{
+  return pool->free_count;
+}
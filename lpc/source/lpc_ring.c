@@ -0,0 +1,532 @@
+/***********************************************************************
+ * $Id:: lpc_ring.c                                                    $
+ *
+ * Project: Ring buffer manager
+ *
+ * Description:
+ *     See the header file for a description of this package.
+ *
+ ***********************************************************************
+ * Software that is described herein is for illustrative purposes only
+ * which provides customers with programming information regarding the
+ * products. This software is supplied "AS IS" without any warranties.
+ * NXP Semiconductors assumes no responsibility or liability for the
+ * use of the software, conveys no license or title under any patent,
+ * copyright, or mask work right to the product. NXP Semiconductors
+ * reserves the right to make changes in the software without
+ * notification. NXP Semiconductors also make no representation or
+ * warranty that such application will be suitable for the specified
+ * use without further testing or modification.
+ **********************************************************************/
+
+#include "lpc_types.h"
+#include "lpc_ring.h"
+
+/***********************************************************************
+ * Package defines
+ **********************************************************************/
+
+/* Keeps the compiler from moving ring data accesses across updates of
+   the head and tail counts */
+#ifdef __GNUC__
+#define RING_BARRIER() __asm__ volatile ("" : : : "memory")
+#else
+#define RING_BARRIER()
+#endif
+
+/***********************************************************************
+ * Private functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: lpc_ring_copy
+ *
+ * Purpose: Copies a block of bytes
+ *
+ * Processing:
+ *     If the source, destination and size are all 32-bit aligned, the
+ *     block is copied a word at a time, otherwise a byte at a time.
+ *
+ * Parameters:
+ *     dst    : Where to copy the data
+ *     src    : Data to copy
+ *     nbytes : Number of bytes to copy
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static void lpc_ring_copy(UNS_8 *dst, const UNS_8 *src, UNS_32 nbytes)
+{
+  UNS_32 *dst32;
+  const UNS_32 *src32;
+
+  if ((((UNS_32) dst | (UNS_32) src | nbytes) & 0x3) == 0)
+  {
+    dst32 = (UNS_32 *) dst;
+    src32 = (const UNS_32 *) src;
+    nbytes = nbytes >> 2;
+    while (nbytes > 0)
+    {
+      *dst32++ = *src32++;
+      nbytes--;
+    }
+  }
+  else
+  {
+    while (nbytes > 0)
+    {
+      *dst++ = *src++;
+      nbytes--;
+    }
+  }
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ring_read
+ *
+ * Purpose: Copies data out of the ring without removing it
+ *
+ * Processing:
+ *     The number of bytes is limited to the ring count. The data is
+ *     copied in one block, or in two blocks if it wraps around the end
+ *     of the ring storage.
+ *
+ * Parameters:
+ *     ring   : Pointer to ring structure
+ *     buffer : Where to copy the data (0 = don't copy)
+ *     nbytes : Number of bytes to copy
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes available up to nbytes.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+static UNS_32 lpc_ring_read(LPC_SPSC_RING_T *ring,
+                            UNS_8 *buffer,
+                            UNS_32 nbytes)
+{
+  UNS_32 count, idx, first;
+
+  count = ring->head - ring->tail;
+  RING_BARRIER();
+  if (nbytes > count)
+  {
+    nbytes = count;
+  }
+
+  if (buffer != (UNS_8 *) 0)
+  {
+    idx = ring->tail & ring->mask;
+    first = ring->mask + 1 - idx;
+    if (first > nbytes)
+    {
+      first = nbytes;
+    }
+    lpc_ring_copy(buffer, &ring->data[idx], first);
+    lpc_ring_copy(buffer + first, ring->data, nbytes - first);
+  }
+
+  return nbytes;
+}
+
+/***********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/***********************************************************************
+ *
+ * Function: lpc_ring_init
+ *
+ * Purpose: Setup a single-producer/single-consumer ring buffer
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     ring   : Pointer to ring structure to setup
+ *     buffer : Pointer to ring storage
+ *     size   : Size of the ring storage in bytes, must be a power of 2
+ *
+ * Outputs: None
+ *
+ * Returns: _NO_ERROR if the ring was setup, or _ERROR if the size is
+ *          not a power of 2.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+STATUS lpc_ring_init(LPC_SPSC_RING_T *ring, void *buffer, UNS_32 size)
+{
+  if ((size == 0) || ((size & (size - 1)) != 0))
+  {
+    return _ERROR;
+  }
+
+  ring->head = 0;
+  ring->tail = 0;
+  ring->mask = size - 1;
+  ring->data = (UNS_8 *) buffer;
+
+  return _NO_ERROR;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ring_flush
+ *
+ * Purpose: Drain a ring buffer
+ *
+ * Processing:
+ *     The tail count is moved up to the head count.
+ *
+ * Parameters:
+ *     ring : Pointer to ring structure
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: Must only be called from the consumer side.
+ *
+ **********************************************************************/
+void lpc_ring_flush(LPC_SPSC_RING_T *ring)
+{
+  ring->tail = ring->head;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ring_count
+ *
+ * Purpose: Return the number of bytes in a ring buffer
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     ring : Pointer to ring structure
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes in the ring.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+UNS_32 lpc_ring_count(LPC_SPSC_RING_T *ring)
+{
+  return ring->head - ring->tail;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ring_space
+ *
+ * Purpose: Return the number of free bytes in a ring buffer
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     ring : Pointer to ring structure
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes that can be put in the ring.
+ *
+ * Notes: None
+ *
+ **********************************************************************/
+UNS_32 lpc_ring_space(LPC_SPSC_RING_T *ring)
+{
+  return ring->mask + 1 - (ring->head - ring->tail);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ring_put
+ *
+ * Purpose: Put data into a ring buffer
+ *
+ * Processing:
+ *     The number of bytes is limited to the free space in the ring.
+ *     The data is copied in one block, or in two blocks if it wraps
+ *     around the end of the ring storage. The head count is updated
+ *     after the data is in the ring.
+ *
+ * Parameters:
+ *     ring   : Pointer to ring structure
+ *     buffer : Data to put into the ring
+ *     nbytes : Number of bytes to put
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes put into the ring.
+ *
+ * Notes: Must only be called from the producer side.
+ *
+ **********************************************************************/
+UNS_32 lpc_ring_put(LPC_SPSC_RING_T *ring,
+                    const void *buffer,
+                    UNS_32 nbytes)
+{
+  const UNS_8 *src = (const UNS_8 *) buffer;
+  UNS_32 space, idx, first;
+
+  space = ring->mask + 1 - (ring->head - ring->tail);
+  RING_BARRIER();
+  if (nbytes > space)
+  {
+    nbytes = space;
+  }
+
+  idx = ring->head & ring->mask;
+  first = ring->mask + 1 - idx;
+  if (first > nbytes)
+  {
+    first = nbytes;
+  }
+  lpc_ring_copy(&ring->data[idx], src, first);
+  lpc_ring_copy(ring->data, src + first, nbytes - first);
+
+  RING_BARRIER();
+  ring->head += nbytes;
+
+  return nbytes;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ring_get
+ *
+ * Purpose: Get data from a ring buffer
+ *
+ * Processing:
+ *     The data is copied out of the ring and the tail count is updated
+ *     after the copy.
+ *
+ * Parameters:
+ *     ring   : Pointer to ring structure
+ *     buffer : Where to copy the data
+ *     nbytes : Number of bytes to get
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes read from the ring.
+ *
+ * Notes: Must only be called from the consumer side.
+ *
+ **********************************************************************/
+UNS_32 lpc_ring_get(LPC_SPSC_RING_T *ring,
+                    void *buffer,
+                    UNS_32 nbytes)
+{
+  nbytes = lpc_ring_read(ring, (UNS_8 *) buffer, nbytes);
+
+  RING_BARRIER();
+  ring->tail += nbytes;
+
+  return nbytes;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ring_peek
+ *
+ * Purpose: Copy data from a ring buffer without removing it
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     ring   : Pointer to ring structure
+ *     buffer : Where to copy the data
+ *     nbytes : Number of bytes to copy
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes copied.
+ *
+ * Notes: Must only be called from the consumer side.
+ *
+ **********************************************************************/
+UNS_32 lpc_ring_peek(LPC_SPSC_RING_T *ring,
+                     void *buffer,
+                     UNS_32 nbytes)
+{
+  return lpc_ring_read(ring, (UNS_8 *) buffer, nbytes);
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ring_skip
+ *
+ * Purpose: Remove data from a ring buffer
+ *
+ * Processing:
+ *     See function.
+ *
+ * Parameters:
+ *     ring   : Pointer to ring structure
+ *     nbytes : Number of bytes to remove
+ *
+ * Outputs: None
+ *
+ * Returns: The number of bytes removed.
+ *
+ * Notes: Must only be called from the consumer side.
+ *
+ **********************************************************************/
+UNS_32 lpc_ring_skip(LPC_SPSC_RING_T *ring, UNS_32 nbytes)
+{
+  nbytes = lpc_ring_read(ring, (UNS_8 *) 0, nbytes);
+
+  RING_BARRIER();
+  ring->tail += nbytes;
+
+  return nbytes;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ring_reserve
+ *
+ * Purpose: Reserve a contiguous free span in a ring buffer
+ *
+ * Processing:
+ *     The span starts at the head index and is limited to the free
+ *     space in the ring and to the end of the ring storage.
+ *
+ * Parameters:
+ *     ring : Pointer to ring structure
+ *     span : Where to return the address of the span
+ *
+ * Outputs: The span address is returned in *span.
+ *
+ * Returns: The number of bytes that can be written at *span.
+ *
+ * Notes: Must only be called from the producer side. The data is not
+ *        visible to the consumer until lpc_ring_commit() is called.
+ *
+ **********************************************************************/
+UNS_32 lpc_ring_reserve(LPC_SPSC_RING_T *ring, void **span)
+{
+  UNS_32 space, idx, first;
+
+  space = ring->mask + 1 - (ring->head - ring->tail);
+  RING_BARRIER();
+
+  idx = ring->head & ring->mask;
+  first = ring->mask + 1 - idx;
+  if (first > space)
+  {
+    first = space;
+  }
+
+  *span = (void *) &ring->data[idx];
+
+  return first;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ring_commit
+ *
+ * Purpose: Commit data written into a reserved span
+ *
+ * Processing:
+ *     The head count is updated after the data is in the ring.
+ *
+ * Parameters:
+ *     ring   : Pointer to ring structure
+ *     nbytes : Number of bytes written into the span
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: Must only be called from the producer side. nbytes must not
+ *        be larger than the size returned by lpc_ring_reserve().
+ *
+ **********************************************************************/
+void lpc_ring_commit(LPC_SPSC_RING_T *ring, UNS_32 nbytes)
+{
+  RING_BARRIER();
+  ring->head += nbytes;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ring_peek_span
+ *
+ * Purpose: Return the contiguous span of data in a ring buffer
+ *
+ * Processing:
+ *     The span starts at the tail index and is limited to the ring
+ *     count and to the end of the ring storage.
+ *
+ * Parameters:
+ *     ring : Pointer to ring structure
+ *     span : Where to return the address of the span
+ *
+ * Outputs: The span address is returned in *span.
+ *
+ * Returns: The number of bytes that can be read at *span.
+ *
+ * Notes: Must only be called from the consumer side. The data stays
+ *        in the ring until lpc_ring_release() is called.
+ *
+ **********************************************************************/
+UNS_32 lpc_ring_peek_span(LPC_SPSC_RING_T *ring, void **span)
+{
+  UNS_32 count, idx, first;
+
+  count = ring->head - ring->tail;
+  RING_BARRIER();
+
+  idx = ring->tail & ring->mask;
+  first = ring->mask + 1 - idx;
+  if (first > count)
+  {
+    first = count;
+  }
+
+  *span = (void *) &ring->data[idx];
+
+  return first;
+}
+
+/***********************************************************************
+ *
+ * Function: lpc_ring_release
+ *
+ * Purpose: Release data read from a peeked span
+ *
+ * Processing:
+ *     The tail count is updated after the data has been used.
+ *
+ * Parameters:
+ *     ring   : Pointer to ring structure
+ *     nbytes : Number of bytes to release
+ *
+ * Outputs: None
+ *
+ * Returns: Nothing
+ *
+ * Notes: Must only be called from the consumer side. nbytes must not
+ *        be larger than the size returned by lpc_ring_peek_span().
+ *
+ **********************************************************************/
+void lpc_ring_release(LPC_SPSC_RING_T *ring, UNS_32 nbytes)
+{
+  RING_BARRIER();
+  ring->tail += nbytes;
+}